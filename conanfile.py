@@ -10,8 +10,8 @@ class ImgppConan(ConanFile):
     description = "Basic C++ Image Wrapper"
     topics = ("Computer Graphics", "Computer Vision", "Image Processing")
     settings = "os", "compiler", "build_type", "arch"
-    options = {"shared": [False], "no_ext_libs": [True, False]}
-    default_options = {"shared": False, "no_ext_libs": False}
+    options = {"shared": [False], "no_ext_libs": [True, False], "stats": [True, False], "native_arch": [True, False]}
+    default_options = {"shared": False, "no_ext_libs": False, "stats": False, "native_arch": False}
     generators = "cmake"
     exports_sources = "src/*"
 
@@ -23,6 +23,10 @@ class ImgppConan(ConanFile):
         cmake = CMake(self)
         if self.options.no_ext_libs:
           cmake.definitions["IMGPP_NO_EXT_LIBS"] = True
+        if self.options.stats:
+          cmake.definitions["IMGPP_ENABLE_STATS"] = True
+        if self.options.native_arch:
+          cmake.definitions["IMGPP_NATIVE_ARCH"] = True
         if self.settings.os == 'Android':
             if 'NDK' in os.environ:
                 cmake.definitions['CMAKE_TOOLCHAIN_FILE'] = os.environ['NDK']
@@ -36,6 +40,8 @@ class ImgppConan(ConanFile):
 
     def package_info(self):
         self.cpp_info.libs = ["imgpp"]
+        if self.options.stats:
+            self.cpp_info.defines = ["IMGPP_ENABLE_STATS"]
 
     def requirements(self):
         if not self.options.no_ext_libs:
@@ -15,13 +15,29 @@ class ImgppHeaderConan(ConanFile):
 
     def package(self):
         self.copy("imgpp/algorithms.hpp", dst="include/")
+        self.copy("imgpp/allocator.hpp", dst="include/")
         self.copy("imgpp/imgpp.hpp", dst="include/")
         self.copy("imgpp/imgbase.hpp", dst="include/")
+        self.copy("imgpp/planar.hpp", dst="include/")
+        self.copy("imgpp/resize.hpp", dst="include/")
+        self.copy("imgpp/mipmap.hpp", dst="include/")
+        self.copy("imgpp/filter.hpp", dst="include/")
+        self.copy("imgpp/reduce.hpp", dst="include/")
+        self.copy("imgpp/compare.hpp", dst="include/")
         self.copy("imgpp/sampler.hpp", dst="include/")
+        self.copy("imgpp/srgb.hpp", dst="include/")
+        self.copy("imgpp/stats.hpp", dst="include/")
+        self.copy("imgpp/threadpool.hpp", dst="include/")
+        self.copy("imgpp/tiled.hpp", dst="include/")
         self.copy("imgpp/blockimg.hpp", dst="include/")
+        self.copy("imgpp/bufferpool.hpp", dst="include/")
         self.copy("imgpp/compositeimg.hpp", dst="include/")
+        self.copy("imgpp/convert.hpp", dst="include/")
+        self.copy("imgpp/copy.hpp", dst="include/")
+        self.copy("imgpp/half.hpp", dst="include/")
         self.copy("imgpp/texturedesc.hpp", dst="include/")
         self.copy("imgpp/texturehelper.hpp", dst="include/")
+        self.copy("imgpp/typedview.hpp", dst="include/")
         self.copy("imgpp/typetraits.hpp", dst="include/")
         self.copy("imgpp/glmtraits.hpp", dst="include/")
 
@@ -2,8 +2,16 @@
 #define IMGPP_ALGORITHMS_HPP
 
 #include <type_traits>
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <tuple>
 #include "imgpp.hpp"
+#include "threadpool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 namespace imgpp {
 
@@ -98,9 +106,151 @@ void ZipTransformPixel(TImgs &&imgs, TCallback callback) {
     }
   }
 }
+/**
+ * @brief Transform multiple images row by row simultaneously.
+ * @details Iterate through the rows of multiple images together. The callback is invoked once per
+ * row with pointers to the first pixel of that row in every image, so the per-pixel loop lives in
+ * user code where the compiler can vectorize it over the whole row. Every row holds w contiguous
+ * pixels; the images may differ in format but must have the same size.
+ *
+ * @param imgs an std::tuple or std::array of ImgROIs
+ * @param callback callback function receiving (y, z, w, ptrs) as argument.
+ */
+template<typename TImgs, typename TCallback>
+void ZipTransformRows(TImgs &&imgs, TCallback callback) {
+  constexpr size_t num_imgs = std::tuple_size<typename std::remove_reference<TImgs>::type>::value;
+  std::array<uint8_t*, num_imgs> ptrs;
+
+  uint32_t w = std::get<0>(imgs).Width();
+  uint32_t h = std::get<0>(imgs).Height();
+  uint32_t d = std::get<0>(imgs).Depth();
+
+  for (uint32_t z = 0; z < d; z++) {
+    for (uint32_t y = 0; y < h; y++) {
+
+      static_for<0, num_imgs>([&ptrs, &imgs, y, z](auto idx) {
+        ptrs[idx] = (uint8_t*)std::get<idx.value>(imgs).PtrAt(0, y, z, 0);
+      });
+
+      callback(y, z, w, ptrs);
+    }
+  }
+}
+
+/**
+ * @brief Visit the rows of an ROI.
+ * @details Single image counterpart of ZipTransformRows().
+ *
+ * @param roi ROI to iterate.
+ * @param callback callback function receiving (y, z, w, row) as argument, row pointing to w
+ * contiguous pixels.
+ */
+template<typename TCallback>
+void ForEachRow(const ImgROI &roi, TCallback callback) {
+  uint32_t w = roi.Width();
+  uint32_t h = roi.Height();
+  uint32_t d = roi.Depth();
+
+  for (uint32_t z = 0; z < d; z++) {
+    for (uint32_t y = 0; y < h; y++) {
+      callback(y, z, w, (uint8_t*)roi.PtrAt(0, y, z, 0));
+    }
+  }
+}
+
+//! \brief Cache behavior of the stores issued by Fill() and FillPixel().
+enum class StoreMode: uint8_t {
+  AUTO, /*!< STREAMING for fills of at least kStreamingFillBytes, CACHED otherwise */
+  CACHED, /*!< regular stores, the filled pixels stay in cache for whatever reads them next */
+  STREAMING /*!< non-temporal stores bypassing the cache, falls back to CACHED on CPUs without them */
+};
+
+//! Fills of at least this many bytes outgrow a typical last level cache.
+enum : uint64_t { kStreamingFillBytes = 32 * 1024 * 1024 };
+
+namespace detail {
+
+enum : size_t { kFillVector = 16, kMaxFillPixel = 64 };
+
+//! Repeat the pixel_bytes long pattern over n bytes, pixel byte 0 landing on dst.
+inline void FillSpan(uint8_t *dst, size_t n, const uint8_t *pixel, size_t pixel_bytes,
+  bool streaming) {
+  // bytes up to the first vector aligned address
+  size_t head = std::min(n, (size_t)(-(uintptr_t)dst & (kFillVector - 1)));
+  for (size_t i = 0; i < head; i++) {
+    dst[i] = pixel[i % pixel_bytes];
+  }
+  // whole vectors: the pattern repeats every lcm(pixel_bytes, kFillVector) bytes
+  size_t period = pixel_bytes;
+  while (period % kFillVector != 0) {
+    period += pixel_bytes;
+  }
+  alignas(kFillVector) uint8_t pattern[kFillVector * kMaxFillPixel];
+  for (size_t i = 0; i < period; i++) {
+    pattern[i] = pixel[(head + i) % pixel_bytes];
+  }
+  size_t i = head;
+  size_t j = 0;
+  size_t body_end = head + (n - head) / kFillVector * kFillVector;
+#if defined(__SSE2__) || defined(_M_X64)
+  if (streaming) {
+    for (; i < body_end; i += kFillVector) {
+      _mm_stream_si128((__m128i*)(dst + i), _mm_load_si128((const __m128i*)(pattern + j)));
+      j = j + kFillVector == period ? 0 : j + kFillVector;
+    }
+    _mm_sfence();
+  }
+#endif
+  for (; i < body_end; i += kFillVector) {
+    memcpy(dst + i, pattern + j, kFillVector);
+    j = j + kFillVector == period ? 0 : j + kFillVector;
+  }
+  for (; i < n; i++) {
+    dst[i] = pixel[i % pixel_bytes];
+  }
+}
+
+//! Fill every pixel of roi with the pixel_bytes at pixel, the pixel size of roi.
+inline void FillPattern(ImgROI &roi, const uint8_t *pixel, size_t pixel_bytes, StoreMode mode) {
+  size_t row_bytes = pixel_bytes * roi.Width();
+  uint64_t total = (uint64_t)row_bytes * roi.Height() * roi.Depth();
+  if (total == 0) {
+    return;
+  }
+  bool streaming = mode == StoreMode::STREAMING
+    || (mode == StoreMode::AUTO && total >= kStreamingFillBytes);
+  bool uniform = std::all_of(pixel, pixel + pixel_bytes, [pixel](uint8_t b) { return b == pixel[0]; });
+  auto fill = [=](uint8_t *dst, size_t n) {
+    if (uniform) {
+      memset(dst, pixel[0], n);  // memset picks its own store strategy
+    } else if (pixel_bytes <= kMaxFillPixel) {
+      FillSpan(dst, n, pixel, pixel_bytes, streaming);
+    } else {
+      for (size_t i = 0; i < n; i += pixel_bytes) {
+        memcpy(dst + i, pixel, pixel_bytes);
+      }
+    }
+  };
+
+  // rows and slices without padding between them are filled as a single span
+  if (roi.Pitch() == (int64_t)row_bytes && roi.SlicePitch() == (uint64_t)row_bytes * roi.Height()) {
+    fill(roi.GetData(), (size_t)total);
+    return;
+  }
+  for (uint32_t z = 0; z < roi.Depth(); z++) {
+    for (uint32_t y = 0; y < roi.Height(); y++) {
+      fill((uint8_t*)roi.PtrAt(0, y, z, 0), row_bytes);
+    }
+  }
+}
+
+}
+
 /**
  * @brief Fill ROI with value.
  * @details Fill every channel of every pixel of the same value.
+ * If T matches the channel size, whole rows are filled with wide stores, or memset when all bytes
+ * of the value are the same (e.g. zeros).
  *
  * @param roi ROI to fill.
  * @param val value to fill.
@@ -112,6 +262,15 @@ void Fill(ImgROI &roi, T val) {
   uint32_t d = roi.Depth();
   uint32_t ch = roi.Channel();
 
+  if (sizeof(T) * 8 == roi.BPC() && sizeof(T) * ch <= detail::kMaxFillPixel) {
+    uint8_t pixel[detail::kMaxFillPixel];
+    for (uint32_t c = 0; c < ch; c++) {
+      memcpy(pixel + c * sizeof(T), &val, sizeof(T));
+    }
+    detail::FillPattern(roi, pixel, sizeof(T) * ch, StoreMode::AUTO);
+    return;
+  }
+
   uint8_t *ptr = 0;
   uint8_t step = roi.BPC() >> 3;
 
@@ -127,6 +286,169 @@ void Fill(ImgROI &roi, T val) {
   }
 }
 
+/**
+ * @brief Fill every pixel of ROI with the same pixel value.
+ * @details The pixel is broadcast into a repeating pattern written with wide stores. Byte uniform
+ * pixels are written with memset. Padding between rows is left untouched.
+ *
+ * @param roi ROI to fill.
+ * @param pixel value of one pixel, any trivially copyable type (e.g. a struct) with the size of a
+ * pixel of roi.
+ * @param mode whether to bypass the cache, by default only for fills larger than kStreamingFillBytes.
+ * @return false if the size of TPixel doesn't match the pixel size of roi.
+ */
+template<typename TPixel>
+bool FillPixel(ImgROI &roi, const TPixel &pixel, StoreMode mode = StoreMode::AUTO) {
+  static_assert(std::is_trivially_copyable<TPixel>::value, "pixel must be trivially copyable");
+  if (sizeof(TPixel) != (size_t)((roi.BPC() * roi.Channel()) >> 3)) {
+    return false;
+  }
+  detail::FillPattern(roi, (const uint8_t*)&pixel, sizeof(TPixel), mode);
+  return true;
+}
+
+/**
+ * @brief Fill every pixel of ROI with the channel values of a pixel, e.g. an RGBA color.
+ *
+ * @param roi ROI to fill.
+ * @param pixel values of all channels of one pixel.
+ * @param mode whether to bypass the cache, by default only for fills larger than kStreamingFillBytes.
+ * @return false if T and C don't match the channel size and count of roi.
+ */
+template<typename T, size_t C>
+bool Fill(ImgROI &roi, const std::array<T, C> &pixel, StoreMode mode = StoreMode::AUTO) {
+  if (roi.Channel() != C || roi.BPC() != sizeof(T) * 8) {
+    return false;
+  }
+  return FillPixel(roi, pixel, mode);
+}
+
+namespace detail {
+
+enum : uint32_t { kBandsPerThread = 4 };  //!< a few bands per thread give stealing room to balance
+
+/**
+ * @brief Split the rows of an image of height h and depth d into bands and run each on executor.
+ * @details Volumes with enough slices are split into runs of whole slices, everything else into
+ * row bands within each slice. The split only depends on h, d and executor.Concurrency(), so a
+ * given executor always hands the same rows to the same band.
+ *
+ * @param band callback receiving (y_begin, y_end, z_begin, z_end), half-open ranges.
+ */
+template<typename TBand>
+void ForEachBand(uint32_t h, uint32_t d, Executor &executor, const TBand &band) {
+  uint64_t target = (uint64_t)executor.Concurrency() * kBandsPerThread;
+  if (h == 0 || d == 0) {
+    return;
+  }
+  if (d >= target || h == 1) {
+    size_t num_bands = (size_t)std::min<uint64_t>(d, target);
+    executor.Run(num_bands, [&](size_t b) {
+      band(0u, h, (uint32_t)(d * b / num_bands), (uint32_t)(d * (b + 1) / num_bands));
+    });
+  } else {
+    uint32_t per_slice = (uint32_t)std::min<uint64_t>(h, (target + d - 1) / d);
+    executor.Run((size_t)d * per_slice, [&](size_t b) {
+      uint32_t z = (uint32_t)(b / per_slice);
+      uint64_t i = b % per_slice;
+      band((uint32_t)(h * i / per_slice), (uint32_t)(h * (i + 1) / per_slice), z, z + 1);
+    });
+  }
+}
+
+//! the rows [y_begin, y_end) of the slices [z_begin, z_end) of every ROI, as an std::tuple
+template<typename TImgs>
+auto SubBand(const TImgs &imgs, uint32_t y_begin, uint32_t y_end, uint32_t z_begin, uint32_t z_end) {
+  return std::apply([=](const auto &... roi) {
+    return std::make_tuple(ImgROI(roi, 0, y_begin, z_begin, roi.Width() - 1, y_end - 1, z_end - 1)...);
+  }, imgs);
+}
+
+}
+
+/**
+ * @brief Multithreaded ZipTransform().
+ * @details The images are split into row bands (whole slices for volumes) which run as tasks on
+ * executor. Coordinates passed to the callback are the same as with ZipTransform(). The callback
+ * object is shared by all threads and is invoked concurrently for different rows, so it must be
+ * safe to call from several threads at once; its call operator must be const.
+ *
+ * @param imgs an std::tuple or std::array of ImgROIs
+ * @param callback callback function receiving (x, y, z, c, ptrs) as argument.
+ * @param executor executor running the bands, DefaultThreadPool() if not specified.
+ */
+template<typename TImgs, typename TCallback>
+void ParallelZipTransform(TImgs &&imgs, const TCallback &callback,
+  Executor &executor = DefaultThreadPool()) {
+  const auto &first = std::get<0>(imgs);
+  detail::ForEachBand(first.Height(), first.Depth(), executor,
+    [&imgs, &callback](uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+      ZipTransform(detail::SubBand(imgs, y0, y1, z0, z1),
+        [&callback, y0, z0](uint32_t x, uint32_t y, uint32_t z, uint32_t c, auto &ptrs) {
+          callback(x, y + y0, z + z0, c, ptrs);
+        });
+    });
+}
+
+/**
+ * @brief Multithreaded ZipTransformPixel(), see ParallelZipTransform() for the callback contract.
+ *
+ * @param imgs an std::tuple or std::array of ImgROIs
+ * @param callback callback function receiving (x, y, z, ptrs) as argument.
+ * @param executor executor running the bands, DefaultThreadPool() if not specified.
+ */
+template<typename TImgs, typename TCallback>
+void ParallelZipTransformPixel(TImgs &&imgs, const TCallback &callback,
+  Executor &executor = DefaultThreadPool()) {
+  const auto &first = std::get<0>(imgs);
+  detail::ForEachBand(first.Height(), first.Depth(), executor,
+    [&imgs, &callback](uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+      ZipTransformPixel(detail::SubBand(imgs, y0, y1, z0, z1),
+        [&callback, y0, z0](uint32_t x, uint32_t y, uint32_t z, auto &ptrs) {
+          callback(x, y + y0, z + z0, ptrs);
+        });
+    });
+}
+
+/**
+ * @brief Multithreaded ZipTransformRows(), see ParallelZipTransform() for the callback contract.
+ *
+ * @param imgs an std::tuple or std::array of ImgROIs
+ * @param callback callback function receiving (y, z, w, ptrs) as argument.
+ * @param executor executor running the bands, DefaultThreadPool() if not specified.
+ */
+template<typename TImgs, typename TCallback>
+void ParallelZipTransformRows(TImgs &&imgs, const TCallback &callback,
+  Executor &executor = DefaultThreadPool()) {
+  const auto &first = std::get<0>(imgs);
+  detail::ForEachBand(first.Height(), first.Depth(), executor,
+    [&imgs, &callback](uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+      ZipTransformRows(detail::SubBand(imgs, y0, y1, z0, z1),
+        [&callback, y0, z0](uint32_t y, uint32_t z, uint32_t w, auto &ptrs) {
+          callback(y + y0, z + z0, w, ptrs);
+        });
+    });
+}
+
+/**
+ * @brief Multithreaded ForEachRow(), see ParallelZipTransform() for the callback contract.
+ *
+ * @param roi ROI to iterate.
+ * @param callback callback function receiving (y, z, w, row) as argument.
+ * @param executor executor running the bands, DefaultThreadPool() if not specified.
+ */
+template<typename TCallback>
+void ParallelForEachRow(const ImgROI &roi, const TCallback &callback,
+  Executor &executor = DefaultThreadPool()) {
+  detail::ForEachBand(roi.Height(), roi.Depth(), executor,
+    [&roi, &callback](uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+      ForEachRow(ImgROI(roi, 0, y0, z0, roi.Width() - 1, y1 - 1, z1 - 1),
+        [&callback, y0, z0](uint32_t y, uint32_t z, uint32_t w, uint8_t *row) {
+          callback(y + y0, z + z0, w, row);
+        });
+    });
+}
+
 } //namespace imgpp
 
 #endif
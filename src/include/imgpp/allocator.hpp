@@ -0,0 +1,231 @@
+#ifndef IMGPP_ALLOCATOR_HPP
+#define IMGPP_ALLOCATOR_HPP
+
+/*! \file allocator.hpp */
+
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace imgpp {
+
+//! \brief Default alignment (in bytes) of pixel buffers, wide enough for AVX-512 loads/stores.
+enum : uint32_t { kDefaultAlignment = 64 };
+
+//! \brief Allocator is the runtime interface ImgBuffer uses to obtain and release pixel memory.
+
+//! Implementations must be thread-safe. An allocator is held by std::shared_ptr in every buffer
+//! it allocated, so it always outlives the memory it handed out.
+class Allocator {
+public:
+  virtual ~Allocator() {}
+
+  //! \brief Allocate length bytes aligned to at least alignment bytes.
+  //! \param length number of bytes requested, may be 0.
+  //! \param alignment power-of-two alignment in bytes.
+  //! \return pointer to the memory. Throws std::bad_alloc on failure.
+  virtual void *Allocate(size_t length, size_t alignment) = 0;
+
+  //! \brief Allocate length zero-filled bytes aligned to at least alignment bytes.
+  //! Implementations backed by fresh OS pages should override this so that zero pages are
+  //! supplied lazily instead of being written up front.
+  virtual void *AllocateZeroed(size_t length, size_t alignment) {
+    void *ptr = Allocate(length, alignment);
+    memset(ptr, 0, length);
+    return ptr;
+  }
+
+  //! \brief Release memory previously returned by Allocate() or AllocateZeroed() with the same length.
+  virtual void Deallocate(void *ptr, size_t length) = 0;
+};
+
+//! \brief Allocator returning memory aligned to kDefaultAlignment (or more) from the C runtime heap.
+
+//! On POSIX systems, buffers of kMapThreshold bytes or more are anonymous mappings instead, which
+//! the OS zero-fills lazily: AllocateZeroed() on them costs nothing until pages are touched.
+class AlignedAllocator: public Allocator {
+public:
+  enum : size_t { kMapThreshold = 4 * 1024 * 1024 };
+
+  void *Allocate(size_t length, size_t alignment) override {
+    if (alignment < kDefaultAlignment) {
+      alignment = kDefaultAlignment;
+    }
+#if !defined(_WIN32)
+    if (length >= kMapThreshold) {
+      return Map(length, alignment);
+    }
+#endif
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t padded = (length + alignment - 1) / alignment * alignment;
+    if (padded == 0) {
+      padded = alignment;
+    }
+#if defined(_WIN32)
+    void *ptr = _aligned_malloc(padded, alignment);
+#else
+    void *ptr = std::aligned_alloc(alignment, padded);
+#endif
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+  void *AllocateZeroed(size_t length, size_t alignment) override {
+    void *ptr = Allocate(length, alignment);
+#if !defined(_WIN32)
+    if (length >= kMapThreshold) {
+      return ptr;  // fresh anonymous pages read as zero
+    }
+#endif
+    memset(ptr, 0, length);
+    return ptr;
+  }
+
+  void Deallocate(void *ptr, size_t length) override {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    if (length >= kMapThreshold) {
+      munmap(ptr, PageRound(length));
+    } else {
+      std::free(ptr);
+    }
+#endif
+  }
+
+private:
+#if !defined(_WIN32)
+  enum : size_t { kPageSize = 4096 };
+
+  static size_t PageRound(size_t length) {
+    return (length + kPageSize - 1) / kPageSize * kPageSize;
+  }
+
+  static void *Map(size_t length, size_t alignment) {
+    size_t mapped = PageRound(length);
+    size_t extra = alignment > kPageSize ? alignment : 0;  // mappings are only page aligned
+    uint8_t *ptr = (uint8_t*)mmap(nullptr, mapped + extra, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    if (extra != 0) {
+      // trim the mapping to [aligned, aligned + mapped)
+      uint8_t *aligned = (uint8_t*)(((uintptr_t)ptr + alignment - 1) / alignment * alignment);
+      if (aligned != ptr) {
+        munmap(ptr, aligned - ptr);
+      }
+      size_t tail = (ptr + mapped + extra) - (aligned + mapped);
+      if (tail != 0) {
+        munmap(aligned + mapped, tail);
+      }
+      ptr = aligned;
+    }
+    return ptr;
+  }
+#endif
+};
+
+//! \brief Allocator backing large buffers with page-granular anonymous mappings.
+
+//! Buffers of at least threshold bytes are mapped directly from the OS and, on Linux, advised
+//! with MADV_HUGEPAGE so that transparent huge pages cut TLB misses on 100+ MB images.
+//! Mapped buffers are page aligned. Smaller requests and platforms without mmap fall back to
+//! AlignedAllocator.
+class HugePageAllocator: public Allocator {
+public:
+  //! \param threshold minimum buffer size in bytes to be served by a dedicated mapping.
+  explicit HugePageAllocator(size_t threshold = kDefaultThreshold): threshold_(threshold) {}
+
+  void *Allocate(size_t length, size_t alignment) override {
+#if defined(_WIN32)
+    return fallback_.Allocate(length, alignment);
+#else
+    if (length < threshold_) {
+      return fallback_.Allocate(length, alignment);
+    }
+    void *ptr = mmap(nullptr, MappedLength(length), PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+#if defined(MADV_HUGEPAGE)
+    madvise(ptr, MappedLength(length), MADV_HUGEPAGE);
+#endif
+    return ptr;
+#endif
+  }
+
+  void *AllocateZeroed(size_t length, size_t alignment) override {
+#if !defined(_WIN32)
+    if (length >= threshold_) {
+      return Allocate(length, alignment);  // fresh anonymous pages read as zero
+    }
+#endif
+    return fallback_.AllocateZeroed(length, alignment);
+  }
+
+  void Deallocate(void *ptr, size_t length) override {
+#if defined(_WIN32)
+    fallback_.Deallocate(ptr, length);
+#else
+    if (length < threshold_) {
+      fallback_.Deallocate(ptr, length);
+    } else {
+      munmap(ptr, MappedLength(length));
+    }
+#endif
+  }
+
+  size_t Threshold() const { return threshold_; }
+
+private:
+  enum : size_t {
+    kHugePageSize = 2 * 1024 * 1024,
+    kDefaultThreshold = 32 * 1024 * 1024
+  };
+
+  static size_t MappedLength(size_t length) {
+    return (length + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  }
+
+  size_t threshold_;
+  AlignedAllocator fallback_;
+};
+
+namespace detail {
+inline std::shared_ptr<Allocator> &DefaultAllocatorSlot() {
+  static std::shared_ptr<Allocator> allocator = std::make_shared<AlignedAllocator>();
+  return allocator;
+}
+}
+
+//! \brief Get the allocator used by ImgBuffers that were not given one explicitly.
+inline std::shared_ptr<Allocator> DefaultAllocator() {
+  return detail::DefaultAllocatorSlot();
+}
+
+//! \brief Replace the process-wide default allocator. Passing nullptr restores AlignedAllocator.
+
+//! Not synchronized with concurrent allocations: call it during start-up.
+//! Buffers already allocated keep a reference to the allocator that created them.
+inline void SetDefaultAllocator(std::shared_ptr<Allocator> allocator) {
+  if (!allocator) {
+    allocator = std::make_shared<AlignedAllocator>();
+  }
+  detail::DefaultAllocatorSlot() = std::move(allocator);
+}
+
+}
+
+#endif // IMGPP_ALLOCATOR_HPP
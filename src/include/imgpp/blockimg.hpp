@@ -27,14 +27,16 @@ struct BlockSize {
 //! BlockImgROI is a view into an ImgBuffer or a plain C-style buffer which contains img data in blocks
 
 //! BlockImgROI doesn't "own" the buffer memory, hence the user must make sure the pointer buffer_ is valid before accesing data.
+//! Like ImgROI, the pitch is signed; with a negative pitch, data_ points to the last row of blocks.
 class BlockImgROI {
 public:
   friend class BlockImg;
+  friend class ImgBase<BlockImgROI>;
 
   BlockImgROI() {}
 
   BlockImgROI(uint8_t *src, const BlockSize &block_size,
-    uint32_t w, uint32_t h, uint32_t depth, uint32_t pitch, uint32_t slice_pitch) {
+    uint32_t w, uint32_t h, uint32_t depth, int64_t pitch, uint64_t slice_pitch) {
     if (block_size.block_bytes != 0 && w != 0 && h != 0 && depth != 0) {
       Init(src, block_size, w, h, depth, pitch, slice_pitch);
     }
@@ -44,8 +46,8 @@ public:
     if (block_size.block_bytes != 0 && w != 0 && h != 0 && depth != 0) {
       uint32_t horizontal_block_num = (w + block_size.block_width - 1) / block_size.block_width;
       uint32_t vertical_block_num = (h + block_size.block_height - 1) / block_size.block_height;
-      uint32_t pitch = horizontal_block_num * block_size.block_bytes;
-      uint32_t slice_pitch = pitch * vertical_block_num;
+      uint64_t pitch = (uint64_t)horizontal_block_num * block_size.block_bytes;
+      uint64_t slice_pitch = pitch * vertical_block_num;
       Init(src, block_size, w, h, depth, pitch, slice_pitch);
     }
   }
@@ -72,19 +74,19 @@ public:
   }
 
   void *BlockAt(uint32_t block_x, uint32_t block_y) {
-    return data_ + block_y * pitch_ + block_x * block_size_.block_bytes;
+    return data_ + block_y * pitch_ + (size_t)block_x * block_size_.block_bytes;
   }
 
   const void *BlockAt(uint32_t block_x, uint32_t block_y) const {
-    return data_ + block_y * pitch_ + block_x * block_size_.block_bytes;
+    return data_ + block_y * pitch_ + (size_t)block_x * block_size_.block_bytes;
   }
 
   void *BlockAt(uint32_t block_x, uint32_t block_y, uint32_t z) {
-    return data_ + z * slice_pitch_ + block_y * pitch_ + block_x * block_size_.block_bytes;
+    return data_ + z * slice_pitch_ + block_y * pitch_ + (size_t)block_x * block_size_.block_bytes;
   }
 
   const void *BlockAt(uint32_t block_x, uint32_t block_y, uint32_t z) const {
-    return data_ + z * slice_pitch_ + block_y * pitch_ + block_x * block_size_.block_bytes;
+    return data_ + z * slice_pitch_ + block_y * pitch_ + (size_t)block_x * block_size_.block_bytes;
   }
 
   const BlockSize &BlkSize() const {
@@ -103,11 +105,12 @@ public:
     return depth_;
   }
 
-  uint32_t Pitch() const {
+  //! \brief Bytes from one row of blocks to the next, negative if block rows go backwards in memory.
+  int64_t Pitch() const {
     return pitch_;
   }
 
-  uint32_t SlicePitch() const {
+  uint64_t SlicePitch() const {
     return slice_pitch_;
   }
 
@@ -131,18 +134,18 @@ public:
     return data_;
   }
 
-  static uint32_t CalcPitch(const BlockSize &block_size, uint32_t w) {
+  static uint64_t CalcPitch(const BlockSize &block_size, uint32_t w) {
     if (block_size.block_bytes == 0) {
       return 0;
     }
     auto horizontal_block_num = (w + block_size.block_width - 1) / block_size.block_width;
-    return horizontal_block_num * block_size.block_bytes;
+    return (uint64_t)horizontal_block_num * block_size.block_bytes;
   }
 
 private:
   void Init(uint8_t *src, const BlockSize &block_size,
     uint32_t w, uint32_t h, uint32_t depth,
-    uint32_t pitch, uint32_t slice_pitch) {
+    int64_t pitch, uint64_t slice_pitch) {
     data_ = src;
     block_size_ = block_size;
     width_ = w;
@@ -168,31 +171,61 @@ private:
     uint32_t dimensions_[5] = {0, 0, 0, 0, 0};
   };
 
-  uint32_t pitch_{0};
-  uint32_t slice_pitch_{0};
+  int64_t pitch_{0};
+  uint64_t slice_pitch_{0};
 };
 
-inline bool CopyData(BlockImgROI &dst, const BlockImgROI &src) {
+namespace detail {
+
+//! CopyData() body for block ROIs, on the calling thread or, given one, split across an executor
+template<typename... TExecutor>
+bool CopyBlockROI(BlockImgROI &dst, const BlockImgROI &src, TExecutor&... executor) {
   if (src.BlkSize() != dst.BlkSize() || src.Width() > dst.Width() || src.Height() > dst.Height()
     || src.Depth() > dst.Depth()) {
     return false;
   }
 
-  uint32_t src_pitch = BlockImgROI::CalcPitch(src.BlkSize(), src.Width());
-  for (uint32_t z = 0; z < src.Depth(); ++z) {
-    for (uint32_t y = 0; y < src.VerticalBlockNum(); ++y) {
-      memcpy(dst.BlockAt(0, y, z), src.BlockAt(0, y, z), src_pitch);
-    }
+  size_t src_pitch = (size_t)BlockImgROI::CalcPitch(src.BlkSize(), src.Width());
+  uint32_t block_rows = src.VerticalBlockNum();
+  uint64_t slice_length = src_pitch * block_rows;
+  bool contiguous = src.Pitch() == (int64_t)src_pitch && dst.Pitch() == (int64_t)src_pitch
+    && (src.Depth() == 1 || (src.SlicePitch() == slice_length && dst.SlicePitch() == slice_length));
+  if (contiguous) {
+    // one span for all block rows and slices
+    CopyBytes(dst.BlockAt(0, 0, 0), src.BlockAt(0, 0, 0), (size_t)(slice_length * src.Depth()), executor...);
+    return true;
   }
+  CopyRows((uint64_t)block_rows * src.Depth(), src_pitch,
+    [&dst, block_rows](uint64_t row) {
+      return dst.BlockAt(0, (uint32_t)(row % block_rows), (uint32_t)(row / block_rows));
+    },
+    [&src, block_rows](uint64_t row) {
+      return src.BlockAt(0, (uint32_t)(row % block_rows), (uint32_t)(row / block_rows));
+    }, executor...);
   return true;
 }
 
+}
+
+//! \brief Copy the blocks of src into dst on the calling thread, as one span when both are packed.
+inline bool CopyData(BlockImgROI &dst, const BlockImgROI &src) {
+  return detail::CopyBlockROI(dst, src);
+}
+
+//! \brief CopyData() with copies of at least kParallelCopyBytes split across executor.
+inline bool CopyData(BlockImgROI &dst, const BlockImgROI &src, Executor &executor) {
+  return detail::CopyBlockROI(dst, src, executor);
+}
+
 //! BlockImg holds a 2D or 3D block image using ImgBuffer and a BlockImgROI
 class BlockImg: public ImgBase<BlockImgROI> {
 public:
   BlockImg() {}
   ~BlockImg() {}
 
+  //! Wraps blocks already held by buffer, described by roi. No data is copied.
+  BlockImg(ImgBuffer buffer, const BlockImgROI &roi): ImgBase(std::move(buffer), roi) {}
+
   BlockImg(const BlockSize &block_size, uint32_t w, uint32_t h, uint32_t depth = 1) {
     SetSize(block_size, w, h, depth);
   }
@@ -203,6 +236,7 @@ public:
       return;
     }
     buffer_.SetSize(entire_img_.slice_pitch_ * entire_img_.depth_);
+    buffer_.Unshare(false);  // contents are undefined after resizing
     entire_img_.data_ = buffer_.GetBuffer();
   }
 
@@ -212,6 +246,7 @@ public:
 
   bool CopyFrom(const BlockImgROI &src_roi) {
     SetSizeLike(src_roi);
+    Unshare(false);
     return CopyData(entire_img_, src_roi);
   }
 };
@@ -0,0 +1,154 @@
+#ifndef IMGPP_BUFFERPOOL_HPP
+#define IMGPP_BUFFERPOOL_HPP
+
+/*! \file bufferpool.hpp */
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <imgpp/allocator.hpp>
+
+namespace imgpp {
+
+//! \brief Counters describing how well an ImgBufferPool serves its requests.
+struct PoolStats {
+  uint64_t hits{0}; /*!< allocations served from a cached buffer */
+  uint64_t misses{0}; /*!< allocations forwarded to the upstream allocator */
+  uint64_t evictions{0}; /*!< released buffers handed back upstream to respect the byte budget */
+  uint64_t cached_bytes{0}; /*!< bytes currently held by the pool */
+  uint64_t cached_buffers{0}; /*!< number of buffers currently held by the pool */
+};
+
+//! \brief ImgBufferPool is a thread-safe Allocator recycling released buffers by size bucket.
+
+//! Requests are rounded up to a bucket size (4 buckets per power of two, at least 4 KiB), so a
+//! buffer released by one image can serve the next image of a similar size. Buffers return to the
+//! pool when the last std::shared_ptr reference to them drops. The pool never holds more than
+//! capacity bytes; the largest cached buffers are evicted first.
+//!
+//! The pool is opt-in: install it with ImgBase::SetAllocator(), ImgBuffer::SetAllocator(), or
+//! process-wide with SetDefaultAllocator() so that every Img, BlockImg and codec draws from it.
+class ImgBufferPool: public Allocator {
+public:
+  //! \param capacity maximum number of bytes cached by the pool.
+  //! \param upstream allocator serving misses, nullptr for AlignedAllocator.
+  explicit ImgBufferPool(size_t capacity, std::shared_ptr<Allocator> upstream = nullptr)
+    : capacity_(capacity), upstream_(std::move(upstream)) {
+    if (!upstream_) {
+      upstream_ = std::make_shared<AlignedAllocator>();
+    }
+  }
+
+  ~ImgBufferPool() {
+    Clear();
+  }
+
+  void *Allocate(size_t length, size_t alignment) override {
+    size_t bucket = BucketSize(length);
+    void *ptr = TakeCached(bucket, alignment);
+    return ptr != nullptr ? ptr : upstream_->Allocate(bucket, alignment);
+  }
+
+  void *AllocateZeroed(size_t length, size_t alignment) override {
+    size_t bucket = BucketSize(length);
+    void *ptr = TakeCached(bucket, alignment);
+    if (ptr != nullptr) {
+      memset(ptr, 0, length);  // recycled memory is dirty
+      return ptr;
+    }
+    return upstream_->AllocateZeroed(bucket, alignment);
+  }
+
+  void Deallocate(void *ptr, size_t length) override {
+    size_t bucket = BucketSize(length);
+    std::vector<std::pair<size_t, void*>> evicted;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (bucket > capacity_) {
+        stats_.evictions += 1;
+        evicted.emplace_back(bucket, ptr);
+      } else {
+        while (stats_.cached_bytes + bucket > capacity_) {
+          auto largest = std::prev(free_.end());
+          evicted.push_back(*largest);
+          stats_.cached_bytes -= largest->first;
+          stats_.cached_buffers -= 1;
+          stats_.evictions += 1;
+          free_.erase(largest);
+        }
+        free_.emplace(bucket, ptr);
+        stats_.cached_bytes += bucket;
+        stats_.cached_buffers += 1;
+      }
+    }
+    for (auto &block: evicted) {
+      upstream_->Deallocate(block.second, block.first);
+    }
+  }
+
+  //! \brief Snapshot of the pool counters.
+  PoolStats Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  //! \brief Release every cached buffer to the upstream allocator. Counters are kept.
+  void Clear() {
+    std::multimap<size_t, void*> blocks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocks.swap(free_);
+      stats_.cached_bytes = 0;
+      stats_.cached_buffers = 0;
+    }
+    for (auto &block: blocks) {
+      upstream_->Deallocate(block.second, block.first);
+    }
+  }
+
+  size_t Capacity() const { return capacity_; }
+
+  //! \brief Size actually allocated for a request of length bytes.
+  static size_t BucketSize(size_t length) {
+    if (length <= kMinBucket) {
+      return kMinBucket;
+    }
+    uint32_t log2 = 0;
+    for (size_t v = length - 1; v > 1; v >>= 1) {
+      ++log2;
+    }
+    size_t step = size_t(1) << (log2 - 2);
+    return (length + step - 1) / step * step;
+  }
+
+private:
+  enum : size_t { kMinBucket = 4096 };
+
+  //! cached buffer of the given bucket size and alignment, nullptr on a miss
+  void *TakeCached(size_t bucket, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = free_.equal_range(bucket);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (alignment == 0 || (uintptr_t)it->second % alignment == 0) {
+        void *ptr = it->second;
+        free_.erase(it);
+        stats_.hits += 1;
+        stats_.cached_bytes -= bucket;
+        stats_.cached_buffers -= 1;
+        return ptr;
+      }
+    }
+    stats_.misses += 1;
+    return nullptr;
+  }
+
+  size_t capacity_;
+  std::shared_ptr<Allocator> upstream_;
+  mutable std::mutex mutex_;
+  std::multimap<size_t, void*> free_;  //!< cached buffers keyed by bucket size
+  PoolStats stats_;
+};
+
+}
+
+#endif // IMGPP_BUFFERPOOL_HPP
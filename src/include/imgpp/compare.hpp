@@ -0,0 +1,374 @@
+#ifndef IMGPP_COMPARE_HPP
+#define IMGPP_COMPARE_HPP
+
+/*! \file compare.hpp
+ *  \brief Difference metrics of two ImgROIs: maximum absolute difference, MSE, PSNR and SSIM.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <imgpp/convert.hpp>
+#include <imgpp/half.hpp>
+#include <imgpp/reduce.hpp>
+#include <imgpp/resize.hpp>
+
+namespace imgpp {
+
+//! \brief Options of Compare().
+struct CompareOptions {
+  //! Compute the SSIM too, a second pass several times as costly as the others.
+  bool ssim{false};
+  //! Stop as soon as an absolute difference exceeds this.
+  double max_abs_diff_limit{INFINITY};
+  //! Stop as soon as the mean squared error is known to exceed this.
+  double mse_limit{INFINITY};
+  //! Stop as soon as the SSIM is known to fall below this.
+  double ssim_limit{-INFINITY};
+  //! Largest signal value for PSNR and the SSIM constants, 0 for the maximum of integer channel types
+  //! and 1 for float channels.
+  double peak{0.0};
+};
+
+//! \brief Difference metrics over all channels, see Compare().
+struct CompareResult {
+  double max_abs_diff{0.0};
+  double mse{0.0};      //!< mean squared difference
+  double psnr{INFINITY}; //!< 10 log10(peak^2 / mse) in dB, infinite for equal images
+  double ssim{NAN};     //!< mean SSIM of the 8x8 windows, NaN if not computed
+  bool stopped{false};  //!< a limit was passed, the metrics cover the values compared before stopping
+};
+
+namespace detail {
+
+enum : uint32_t {
+  kSSIMWindow = 8,   //!< width and height of the SSIM windows
+  kSSIMChunk = 1024  //!< windows summed at a time, their sums staying in L1
+};
+
+//! difference totals of a run of values
+struct DiffTotals {
+  double max_abs{0.0};
+  double squares{0.0};
+  double count{0.0};
+};
+
+//! x += v, returning the new value
+inline double AtomicAdd(std::atomic<double> &x, double v) {
+  double old = x.load(std::memory_order_relaxed);
+  while (!x.compare_exchange_weak(old, old + v, std::memory_order_relaxed)) {
+  }
+  return old + v;
+}
+
+//! a NaN or larger max
+inline double NaNMax(double x, double v) {
+  return v > x || v != v ? v : x;
+}
+
+/**
+ * @brief Add the differences of n values of a and b, at most kReduceChunk, to the totals.
+ * @details Value i goes to lane i % 16 in the lane types of ReduceLanes(), exact integers up to
+ * 16 bits and doubles otherwise. A NaN difference makes the maximum and the squares NaN.
+ */
+template<typename T>
+void DiffChunk(const T *a, const T *b, size_t n, DiffTotals &totals) {
+  using Lane = ReduceLane<T>;
+  using Value = typename Lane::Value;
+  constexpr uint32_t kLanes = 16;
+  std::array<Value, kLanes> peak{};
+  std::array<typename Lane::Square, kLanes> squares{};
+  auto add = [&](uint32_t l, T x, T y) {
+    Value d = (Value)x - (Value)y;
+    d = d < 0 ? -d : d;
+    peak[l] = d > peak[l] || d != d ? d : peak[l];
+    squares[l] += Lane::Squared(d);
+  };
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (uint32_t l = 0; l < kLanes; l++) {
+      add(l, a[i + l], b[i + l]);
+    }
+  }
+  for (uint32_t l = 0; i < n; i++, l++) {
+    add(l, a[i], b[i]);
+  }
+  for (uint32_t l = 0; l < kLanes; l++) {
+    totals.max_abs = NaNMax(totals.max_abs, (double)peak[l]);
+    totals.squares += (double)squares[l];
+  }
+  totals.count += (double)n;
+}
+
+//! Differences of one row of len values of type T.
+template<ChannelType T>
+void DiffRow(const void *a, const void *b, size_t len, DiffTotals &totals) {
+  for (size_t i = 0; i < len; i += kReduceChunk) {
+    size_t n = std::min((size_t)kReduceChunk, len - i);
+    if constexpr (T == ChannelType::F16) {
+      float x[kReduceChunk];
+      float y[kReduceChunk];
+      HalfToFloat(x, (const Half*)a + i, n);
+      HalfToFloat(y, (const Half*)b + i, n);
+      DiffChunk(x, y, n, totals);
+    } else {
+      using TValue = typename Channel<T>::type;
+      DiffChunk((const TValue*)a + i, (const TValue*)b + i, n, totals);
+    }
+  }
+}
+
+//! SSIM totals of a run of windows
+struct SSIMTotals {
+  double sum{0.0};
+  double count{0.0};
+};
+
+//! Add, or subtract, a row of x, y, x^2, y^2 and xy to the five moment columns of len values at s.
+template<bool kAdd>
+void AddMoments(const float *x, const float *y, size_t len, double *s) {
+  for (size_t i = 0; i < len; i++) {
+    double p = x[i];
+    double q = y[i];
+    if constexpr (kAdd) {
+      s[i] += p;
+      s[len + i] += q;
+      s[2 * len + i] += p * p;
+      s[3 * len + i] += q * q;
+      s[4 * len + i] += p * q;
+    } else {
+      s[i] -= p;
+      s[len + i] -= q;
+      s[2 * len + i] -= p * p;
+      s[3 * len + i] -= q * q;
+      s[4 * len + i] -= p * q;
+    }
+  }
+}
+
+/**
+ * @brief dst[i] = src[i] + src[i + c] + ... + src[i + (width - 1) c] for n windows.
+ * @details 8 wide windows add pairs, then pairs of pairs and so on, three vectorized passes
+ * through pairs of n + 6c values; narrower windows add their values one by one.
+ */
+inline void WindowSums(double *dst, const double *src, size_t n, size_t c, uint32_t width, double *pairs) {
+  if (width == kSSIMWindow) {
+    for (size_t i = 0; i < n + 6 * c; i++) {
+      pairs[i] = src[i] + src[i + c];
+    }
+    for (size_t i = 0; i < n + 4 * c; i++) {
+      pairs[i] += pairs[i + 2 * c];
+    }
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = pairs[i] + pairs[i + 4 * c];
+    }
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = 0.0;
+  }
+  for (uint32_t k = 0; k < width; k++) {
+    for (size_t i = 0; i < n; i++) {
+      dst[i] += src[i + k * c];
+    }
+  }
+}
+
+/**
+ * @brief Add the SSIM of the windows on rows [y0, y1) of slice z to the totals, until stop().
+ * @details Window rows span window_h image rows from their own. Columns of the running sums of a,
+ * b, a^2, b^2 and ab over the window rows advance one image row at a time; WindowSums() of the
+ * columns, kSSIMChunk windows at a time, give the sums of every window per channel, and each
+ * takes a few vectorized double operations to its SSIM. stop(row sum, windows) is asked after
+ * each row of windows.
+ */
+template<ChannelType T, typename TStop>
+void SSIMRows(const ImgROI &a, const ImgROI &b, uint32_t z, uint32_t y0, uint32_t y1, uint32_t window_w,
+  uint32_t window_h, double c1, double c2, SSIMTotals &totals, const TStop &stop) {
+  uint32_t c = a.Channel();
+  size_t len = (size_t)a.Width() * c;
+  size_t windows = (size_t)(a.Width() - window_w + 1) * c;
+  double inv_n = 1.0 / ((double)window_w * window_h);
+  std::vector<float> buffer(2 * len);
+  std::vector<double> columns(5 * len, 0.0);
+  std::vector<double> sums(5 * kSSIMChunk);
+  std::vector<double> pairs(kSSIMChunk + (size_t)kSSIMWindow * c);
+  std::vector<double> ssim(kSSIMChunk);
+  auto row = [&](uint32_t y, auto add) {
+    const float *x = DecodeResizeRow<T>(a.PtrAt(0, y, z, 0), len, buffer.data());
+    const float *v = DecodeResizeRow<T>(b.PtrAt(0, y, z, 0), len, buffer.data() + len);
+    AddMoments<decltype(add)::value>(x, v, len, columns.data());
+  };
+  for (uint32_t y = y0; y < y0 + window_h - 1; y++) {
+    row(y, std::true_type());
+  }
+  for (uint32_t y = y0; y < y1; y++) {
+    row(y + window_h - 1, std::true_type());
+    std::array<double, 8> lanes{};
+    for (size_t i0 = 0; i0 < windows; i0 += kSSIMChunk) {
+      size_t n = std::min((size_t)kSSIMChunk, windows - i0);
+      for (size_t k = 0; k < 5; k++) {
+        WindowSums(sums.data() + k * kSSIMChunk, columns.data() + k * len + i0, n, c, window_w, pairs.data());
+      }
+      const double *sa = sums.data();
+      const double *sb = sa + kSSIMChunk;
+      const double *saa = sb + kSSIMChunk;
+      const double *sbb = saa + kSSIMChunk;
+      const double *sab = sbb + kSSIMChunk;
+      for (size_t i = 0; i < n; i++) {
+        double ma = sa[i] * inv_n;
+        double mb = sb[i] * inv_n;
+        double va = saa[i] * inv_n - ma * ma;
+        double vb = sbb[i] * inv_n - mb * mb;
+        double cov = sab[i] * inv_n - ma * mb;
+        ssim[i] = (2.0 * ma * mb + c1) * (2.0 * cov + c2) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+      }
+      size_t i = 0;
+      for (; i + 8 <= n; i += 8) {
+        for (size_t l = 0; l < 8; l++) {
+          lanes[l] += ssim[i + l];
+        }
+      }
+      for (; i < n; i++) {
+        lanes[0] += ssim[i];
+      }
+    }
+    double row_sum = 0.0;
+    for (double lane: lanes) {
+      row_sum += lane;
+    }
+    totals.sum += row_sum;
+    totals.count += (double)windows;
+    if (stop(row_sum, (double)windows)) {
+      return;
+    }
+    row(y, std::false_type());
+  }
+}
+
+}
+
+/**
+ * @brief Maximum absolute difference, mean squared error, PSNR and optionally SSIM of a and b.
+ * @details Metrics are taken over every value of every channel. The differences of rows are
+ * split into runs on executor, adding into lanes of vector registers, exact integers for channels
+ * up to 16 bits and doubles for the others. The SSIM is the mean over every channel and slice of
+ * the SSIM of 8x8 windows, with constants (0.01 peak)^2 and (0.03 peak)^2, after Wang et al. 2004;
+ * windows shrink to smaller images, values are taken as floats. Each limit of options is checked
+ * after every row; once passed, the runs stop and result.stopped is set, so a regression gate pays
+ * only up to the first failure. Partial results of the runs merge in a fixed order. NaN differences
+ * make the maximum and the MSE NaN, which passes any limit.
+ *
+ * @param a ROI of any integer or float channel type.
+ * @param b ROI of the size and format of a.
+ * @param result receives the metrics.
+ * @param options which metrics to compute, limits and peak value.
+ * @param executor executor running large comparisons, DefaultThreadPool() if not specified.
+ * @return false if a is empty, of an unsupported format or of another size or format than b.
+ */
+inline bool Compare(const ImgROI &a, const ImgROI &b, CompareResult &result,
+  const CompareOptions &options = CompareOptions(), Executor &executor = DefaultThreadPool()) {
+  ChannelType type = GetChannelType(a);
+  if (type == ChannelType::UNKNOWN || type != GetChannelType(b) || a.Width() != b.Width()
+    || a.Height() != b.Height() || a.Depth() != b.Depth() || a.Channel() != b.Channel() || a.Width() == 0
+    || a.Height() == 0 || a.Depth() == 0 || a.Channel() == 0) {
+    return false;
+  }
+  result = CompareResult();
+  uint32_t c = a.Channel();
+  size_t len = (size_t)a.Width() * c;
+  double count = (double)len * a.Height() * a.Depth();
+  double peak = options.peak > 0.0 ? options.peak : (double)detail::ChannelMax(type);
+  size_t num_tasks = detail::ReduceTasks(a, executor);
+  std::atomic<bool> stop(false);
+  std::atomic<double> squares(0.0);
+  bool gate_mse = options.mse_limit < INFINITY;
+  double squares_limit = options.mse_limit * count;
+  std::vector<detail::DiffTotals> partial(num_tasks);
+  detail::DispatchChannelType(type, [&](auto channel_type) {
+    constexpr ChannelType kType = decltype(channel_type)::value;
+    detail::RunReduceTasks(a, num_tasks, executor, [&](size_t t, uint32_t y, uint32_t z) {
+      if (stop.load(std::memory_order_relaxed)) {
+        return;
+      }
+      detail::DiffTotals &totals = partial[t];
+      double before = totals.squares;
+      detail::DiffRow<kType>(a.PtrAt(0, y, z, 0), b.PtrAt(0, y, z, 0), len, totals);
+      if (!(totals.max_abs <= options.max_abs_diff_limit)
+        || (gate_mse && !(detail::AtomicAdd(squares, totals.squares - before) <= squares_limit))) {
+        stop.store(true, std::memory_order_relaxed);
+      }
+    });
+  });
+  detail::DiffTotals total;
+  for (const detail::DiffTotals &p: partial) {
+    total.max_abs = detail::NaNMax(total.max_abs, p.max_abs);
+    total.squares += p.squares;
+    total.count += p.count;
+  }
+  result.stopped = stop.load();
+  result.max_abs_diff = total.max_abs;
+  result.mse = total.squares / total.count;
+  result.psnr = 10.0 * std::log10(peak * peak / result.mse);
+  if (!options.ssim || result.stopped) {
+    return true;
+  }
+
+  // windows of rows r, row r % rows of slice r / rows, split into runs like the rows above
+  uint32_t window_w = std::min((uint32_t)detail::kSSIMWindow, a.Width());
+  uint32_t window_h = std::min((uint32_t)detail::kSSIMWindow, a.Height());
+  uint32_t rows = a.Height() - window_h + 1;
+  uint64_t window_rows = (uint64_t)rows * a.Depth();
+  double windows = (double)window_rows * (a.Width() - window_w + 1) * c;
+  double c1 = (0.01 * peak) * (0.01 * peak);
+  double c2 = (0.03 * peak) * (0.03 * peak);
+  bool gate_ssim = options.ssim_limit > -INFINITY;
+  double deficit_limit = (1.0 - options.ssim_limit) * windows;
+  std::atomic<double> deficit(0.0);
+  num_tasks = (size_t)std::min<uint64_t>(num_tasks, window_rows);
+  std::vector<detail::SSIMTotals> ssim(num_tasks);
+  auto check = [&](double sum, double n) {
+    // every window missing from a perfect 1 counts against the limit
+    if (gate_ssim && !(detail::AtomicAdd(deficit, n - sum) <= deficit_limit)) {
+      stop.store(true, std::memory_order_relaxed);
+    }
+    return stop.load(std::memory_order_relaxed);
+  };
+  detail::DispatchChannelType(type, [&](auto channel_type) {
+    constexpr ChannelType kType = decltype(channel_type)::value;
+    auto run = [&](size_t t) {
+      uint64_t r = window_rows * t / num_tasks;
+      uint64_t end = window_rows * (t + 1) / num_tasks;
+      while (r < end && !stop.load(std::memory_order_relaxed)) {
+        uint32_t z = (uint32_t)(r / rows);
+        uint32_t y0 = (uint32_t)(r % rows);
+        uint32_t y1 = (uint32_t)std::min<uint64_t>(rows, y0 + end - r);
+        detail::SSIMRows<kType>(a, b, z, y0, y1, window_w, window_h, c1, c2, ssim[t], check);
+        r += y1 - y0;
+      }
+    };
+    if (num_tasks > 1) {
+      executor.Run(num_tasks, run);
+    } else {
+      run(0);
+    }
+  });
+  detail::SSIMTotals total_ssim;
+  for (const detail::SSIMTotals &p: ssim) {
+    total_ssim.sum += p.sum;
+    total_ssim.count += p.count;
+  }
+  result.stopped = stop.load();
+  result.ssim = total_ssim.sum / total_ssim.count;
+  return true;
+}
+
+}
+
+#endif // IMGPP_COMPARE_HPP
@@ -31,6 +31,8 @@ public:
   }
 
   //! \brief Specifies texture description, dimensions and alignment of a uncompressed texture.
+  //! All ROIs get their shape right away, with no data until SetData() or Allocate().
+  //! Buffers held by the image are released.
   //! \param desc specify texture format and usage
   //! \param levels number of mipmap levels
   //! \param layers number of images in an image array
@@ -57,13 +59,20 @@ public:
     faces_ = faces;
     alignment_ = alignment;
     std::vector<ImgROI> rois(levels * layers * faces);
-    uint32_t pitch = ImgROI::CalcPitch(width, c, bpc, alignment);
+    uint64_t pitch = ImgROI::CalcPitch(width, c, bpc, alignment);
     rois[0] = ImgROI(nullptr, width, height, depth, c, bpc,
       pitch, pitch * height, std::get<3>(pixel_desc), std::get<4>(pixel_desc));
+    for (size_t i = 1; i < rois.size(); ++i) {
+      rois[i] = LevelROI(rois[0], (uint32_t)(i / (layers * faces)), nullptr);
+    }
     rois_ = std::move(rois);
+    buffers_.clear();
+    offsets_.clear();
   }
 
   //! \brief Specifies texture description, dimensions and alignment of a compressed texture.
+  //! All ROIs get their shape right away, with no data until SetData() or Allocate().
+  //! Buffers held by the image are released.
   //! \param desc specify texture format and usage
   //! \param levels number of mipmap levels
   //! \param layers number of images in an image array
@@ -81,7 +90,70 @@ public:
       std::vector<BlockImgROI> rois(levels * layers * faces);
       const BlockSize &block_size = GetBlockSize(tex_desc_.format);
       rois[0] = BlockImgROI(nullptr, block_size, width, height, depth);
+      for (size_t i = 1; i < rois.size(); ++i) {
+        rois[i] = LevelBlockROI(rois[0], (uint32_t)(i / (layers * faces)), nullptr);
+      }
       rois_ = std::move(rois);
+      buffers_.clear();
+      offsets_.clear();
+    }
+  }
+
+  //! \brief Allocate one buffer holding every level/layer/face and point all ROIs into it.
+  //!
+  //! Faces are laid out level by level, then layer by layer, then face by face (the KTX order),
+  //! each starting at a multiple of face_alignment bytes. Any buffer previously held is released.
+  //! Call after SetSize() or SetBCSize().
+  //! \param face_alignment byte alignment of each face, a power of two. With KTX alignment (4),
+  //! the faces of a level are contiguous.
+  //! \param allocator allocator serving the buffer, nullptr for DefaultAllocator().
+  //! \return false if the image has not been sized.
+  bool Allocate(uint32_t face_alignment = kDefaultAlignment,
+    std::shared_ptr<Allocator> allocator = nullptr) {
+    if (tex_desc_.format == FORMAT_UNDEFINED || levels_ * layers_ * faces_ == 0
+      || face_alignment == 0 || (face_alignment & (face_alignment - 1)) != 0) {
+      return false;
+    }
+    std::vector<uint64_t> offsets(levels_ * layers_ * faces_);
+    uint64_t total = 0;
+    for (uint32_t level = 0; level < levels_; ++level) {
+      uint64_t face_size = FaceSize(level);
+      for (uint32_t i = 0; i < layers_ * faces_; ++i) {
+        total = (total + face_alignment - 1) / face_alignment * face_alignment;
+        offsets[level * layers_ * faces_ + i] = total;
+        total += face_size;
+      }
+    }
+
+    ImgBuffer arena(total, std::move(allocator));
+    uint8_t *data = arena.GetBuffer();
+    for (uint32_t level = 0; level < levels_; ++level) {
+      for (uint32_t layer = 0; layer < layers_; ++layer) {
+        for (uint32_t face = 0; face < faces_; ++face) {
+          SetData(data + offsets[level * layers_ * faces_ + layer * faces_ + face], level, layer, face);
+        }
+      }
+    }
+    buffers_.clear();
+    buffers_.push_back(std::move(arena));
+    offsets_ = std::move(offsets);
+    return true;
+  }
+
+  //! \brief Byte offset of a level/layer/face in the buffer created by Allocate().
+  //! Only valid after a successful Allocate(), e.g. for staging the buffer to the GPU in one copy.
+  uint64_t Offset(uint32_t level, uint32_t layer, uint32_t face) const {
+    return offsets_[level * layers_ * faces_ + layer * faces_ + face];
+  }
+
+  //! \brief Size in bytes of a single face (all depth slices) of the given level.
+  uint64_t FaceSize(uint32_t level) const {
+    if (IsCompressed()) {
+      const BlockImgROI &roi = BlockROI(level, 0, 0);
+      return roi.SlicePitch() * roi.Depth();
+    } else {
+      const ImgROI &roi = ROI(level, 0, 0);
+      return roi.SlicePitch() * roi.Depth();
     }
   }
 
@@ -97,21 +169,10 @@ public:
     }
     if (IsCompressed()) {
       auto &rois = std::get<std::vector<BlockImgROI>>(rois_);
-      uint32_t width = std::max(rois[0].Width() >> level, 1u);
-      uint32_t height = std::max(rois[0].Height() >> level, 1u);
-      uint32_t depth = std::max(rois[0].Depth() >> level, 1u);
-      rois[level * layers_ * faces_ + layer * faces_ + face] =
-        BlockImgROI(data, rois[0].BlkSize(), width, height, depth);
+      rois[level * layers_ * faces_ + layer * faces_ + face] = LevelBlockROI(rois[0], level, data);
     } else {
       auto &rois = std::get<std::vector<ImgROI>>(rois_);
-      uint32_t width = std::max(rois[0].Width() >> level, 1u);
-      uint32_t height = std::max(rois[0].Height() >> level, 1u);
-      uint32_t depth = std::max(rois[0].Depth() >> level, 1u);
-      uint32_t pitch = ImgROI::CalcPitch(width, rois[0].Channel(), rois[0].BPC(), alignment_);
-      rois[level * layers_ * faces_ + layer * faces_ + face] =
-        ImgROI(data, width, height, depth,
-          rois[0].Channel(), rois[0].BPC(), pitch, pitch * height,
-          rois[0].IsFloat(), rois[0].IsSigned());
+      rois[level * layers_ * faces_ + layer * faces_ + face] = LevelROI(rois[0], level, data);
     }
   }
 
@@ -166,7 +227,26 @@ public:
   }
 
 private:
+  //! ROI of a mipmap level, shaped after the level 0 ROI base
+  ImgROI LevelROI(const ImgROI &base, uint32_t level, uint8_t *data) const {
+    uint32_t width = std::max(base.Width() >> level, 1u);
+    uint32_t height = std::max(base.Height() >> level, 1u);
+    uint32_t depth = std::max(base.Depth() >> level, 1u);
+    uint64_t pitch = ImgROI::CalcPitch(width, base.Channel(), base.BPC(), alignment_);
+    return ImgROI(data, width, height, depth, base.Channel(), base.BPC(), pitch, pitch * height,
+      base.IsFloat(), base.IsSigned());
+  }
+
+  //! BlockROI of a mipmap level, shaped after the level 0 BlockROI base
+  BlockImgROI LevelBlockROI(const BlockImgROI &base, uint32_t level, uint8_t *data) const {
+    uint32_t width = std::max(base.Width() >> level, 1u);
+    uint32_t height = std::max(base.Height() >> level, 1u);
+    uint32_t depth = std::max(base.Depth() >> level, 1u);
+    return BlockImgROI(data, base.BlkSize(), width, height, depth);
+  }
+
   std::vector<ImgBuffer> buffers_; /*!< a vector of ImgBuffers holding img data */
+  std::vector<uint64_t> offsets_; /*!< offset of each level/layer/face in the arena, see Allocate() */
   std::variant<std::vector<ImgROI>, std::vector<BlockImgROI>> rois_; /*!< a vector of either ImgROI or BlockImgROI depends on texture format */
   TextureDesc tex_desc_;
   uint32_t levels_{0}; /*!< mipmap levels */
@@ -0,0 +1,486 @@
+#ifndef IMGPP_CONVERT_HPP
+#define IMGPP_CONVERT_HPP
+
+/*! \file convert.hpp
+ *  \brief Pixel format conversion between ImgROIs: bit depth, normalization, channels and swizzles.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <imgpp/copy.hpp>
+#include <imgpp/half.hpp>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace imgpp {
+
+//! \brief Channel type of an ImgROI as understood by Convert().
+enum class ChannelType: uint8_t {
+  U8, S8, U16, S16, U32, S32, F16, F32,
+  UNKNOWN /*!< any other combination of BPC, IsFloat() and IsSigned(), e.g. 64 bit channels */
+};
+
+//! \brief Channel type of roi, from its BPC(), IsFloat() and IsSigned().
+inline ChannelType GetChannelType(const ImgROI &roi) {
+  if (roi.IsFloat()) {
+    return roi.BPC() == 16 ? ChannelType::F16 : roi.BPC() == 32 ? ChannelType::F32 : ChannelType::UNKNOWN;
+  }
+  switch (roi.BPC()) {
+  case 8: return roi.IsSigned() ? ChannelType::S8 : ChannelType::U8;
+  case 16: return roi.IsSigned() ? ChannelType::S16 : ChannelType::U16;
+  case 32: return roi.IsSigned() ? ChannelType::S32 : ChannelType::U32;
+  default: return ChannelType::UNKNOWN;
+  }
+}
+
+//! Special ConvertOptions::swizzle entries, the others are source channel indices.
+enum : int8_t {
+  kSwizzleAuto = -1, //!< default mapping, see ConvertOptions::swizzle
+  kSwizzleZero = -2, //!< constant 0
+  kSwizzleOne = -3   //!< constant 1, i.e. the maximum of normalized integer channels
+};
+
+//! \brief Options of Convert().
+struct ConvertOptions {
+  //! Integer channels of the source are UNORM/SNORM and map to [0, 1] / [-1, 1]. Set to false for
+  //! UINT/SINT data, whose values are converted as is.
+  bool src_normalized{true};
+  //! Integer channels of the destination are UNORM/SNORM. Values out of range are clamped.
+  bool dst_normalized{true};
+  //! Source channel of each destination channel, or kSwizzleZero / kSwizzleOne.
+  //! kSwizzleAuto keeps channel c for c < source channels, replicates a single source channel
+  //! into RGB, and fills a missing alpha with 1 and other missing channels with 0.
+  std::array<int8_t, 4> swizzle{{kSwizzleAuto, kSwizzleAuto, kSwizzleAuto, kSwizzleAuto}};
+};
+
+//! Swizzle swapping the red and blue channels, RGBA <-> BGRA.
+constexpr std::array<int8_t, 4> kSwizzleBGRA{{2, 1, 0, 3}};
+
+namespace detail {
+
+template<ChannelType T> struct Channel;
+template<> struct Channel<ChannelType::U8> { using type = uint8_t; };
+template<> struct Channel<ChannelType::S8> { using type = int8_t; };
+template<> struct Channel<ChannelType::U16> { using type = uint16_t; };
+template<> struct Channel<ChannelType::S16> { using type = int16_t; };
+template<> struct Channel<ChannelType::U32> { using type = uint32_t; };
+template<> struct Channel<ChannelType::S32> { using type = int32_t; };
+template<> struct Channel<ChannelType::F16> { using type = uint16_t; };
+template<> struct Channel<ChannelType::F32> { using type = float; };
+
+//! Run fn with the ChannelType of type as a template argument.
+template<typename TFn>
+void DispatchChannelType(ChannelType type, const TFn &fn) {
+  switch (type) {
+  case ChannelType::U8: fn(std::integral_constant<ChannelType, ChannelType::U8>()); break;
+  case ChannelType::S8: fn(std::integral_constant<ChannelType, ChannelType::S8>()); break;
+  case ChannelType::U16: fn(std::integral_constant<ChannelType, ChannelType::U16>()); break;
+  case ChannelType::S16: fn(std::integral_constant<ChannelType, ChannelType::S16>()); break;
+  case ChannelType::U32: fn(std::integral_constant<ChannelType, ChannelType::U32>()); break;
+  case ChannelType::S32: fn(std::integral_constant<ChannelType, ChannelType::S32>()); break;
+  case ChannelType::F16: fn(std::integral_constant<ChannelType, ChannelType::F16>()); break;
+  case ChannelType::F32: fn(std::integral_constant<ChannelType, ChannelType::F32>()); break;
+  default: break;
+  }
+}
+
+//! Per conversion constants: the float domain runs [0, 1] / [-1, 1] for normalized channels.
+struct ConvertPlan {
+  float src_max{1.0f}; //!< source value to float domain, divided for results exact to the last bit
+  float src_min{-INFINITY}; //!< lower bound in the float domain, -1 for SNORM
+  float dst_scale{1.0f}; //!< float domain to destination value
+  float dst_lo{0.0f}; //!< clamp range of integer destination values, exactly representable
+  float dst_hi{0.0f};
+  uint32_t src_channels{0};
+  uint32_t dst_channels{0};
+  std::array<int8_t, 4> swizzle{};
+};
+
+template<ChannelType T>
+inline float Decode(typename Channel<T>::type v, const ConvertPlan &plan) {
+  if constexpr (T == ChannelType::F16) {
+    return HalfBitsToFloat(v);
+  } else if constexpr (T == ChannelType::F32) {
+    return v;
+  } else if constexpr (std::is_signed<typename Channel<T>::type>::value) {
+    return std::max((float)v / plan.src_max, plan.src_min);  // SNORM -128 is -1 too
+  } else {
+    return (float)v / plan.src_max;
+  }
+}
+
+template<ChannelType T>
+inline typename Channel<T>::type Encode(float f, const ConvertPlan &plan) {
+  using TValue = typename Channel<T>::type;
+  if constexpr (T == ChannelType::F16) {
+    return FloatToHalfBits(f);
+  } else if constexpr (T == ChannelType::F32) {
+    return f;
+  } else {
+    // NaNs encode as 0, casting them to an integer is undefined
+    float v = f * plan.dst_scale;
+    v = std::min(std::max(v == v ? v : 0.0f, plan.dst_lo), plan.dst_hi);
+    if constexpr (std::is_signed<TValue>::value) {
+      return (TValue)(v + (v < 0.0f ? -0.5f : 0.5f));
+    } else {
+      return (TValue)(v + 0.5f);
+    }
+  }
+}
+
+//! Element-wise conversion of n channels with identical layout.
+template<ChannelType S, ChannelType D>
+void ConvertSpan(uint8_t *dst, const uint8_t *src, size_t n, const ConvertPlan &plan) {
+  using TSrc = typename Channel<S>::type;
+  using TDst = typename Channel<D>::type;
+  const TSrc *s = (const TSrc*)src;
+  TDst *d = (TDst*)dst;
+  if constexpr (S == ChannelType::U16 && D == ChannelType::U8) {
+    if (plan.src_max != 1.0f && plan.dst_scale != 1.0f) {
+      for (size_t i = 0; i < n; i++) {
+        d[i] = (uint8_t)((s[i] * 255u + 32895u) >> 16);  // exact round(v * 255 / 65535)
+      }
+      return;
+    }
+  }
+  if constexpr (S == ChannelType::U8 && D == ChannelType::U16) {
+    if (plan.src_max != 1.0f && plan.dst_scale != 1.0f) {
+      for (size_t i = 0; i < n; i++) {
+        d[i] = (uint16_t)(s[i] * 257u);
+      }
+      return;
+    }
+  }
+  if constexpr (S == ChannelType::F16 || D == ChannelType::F16) {
+    // f16 goes through a float chunk converted in bulk
+    enum : size_t { kChunk = 1024 };
+    float values[kChunk];
+    for (size_t i0 = 0; i0 < n; i0 += kChunk) {
+      size_t m = std::min<size_t>(kChunk, n - i0);
+      const float *f = values;
+      if constexpr (S == ChannelType::F16) {
+        HalfToFloat(values, (const Half*)(s + i0), m);
+      } else if constexpr (S == ChannelType::F32) {
+        f = (const float*)(s + i0);
+      } else {
+        for (size_t i = 0; i < m; i++) {
+          values[i] = Decode<S>(s[i0 + i], plan);
+        }
+      }
+      if constexpr (D == ChannelType::F16) {
+        FloatToHalf((Half*)(d + i0), f, m);
+      } else {
+        for (size_t i = 0; i < m; i++) {
+          d[i0 + i] = Encode<D>(f[i], plan);
+        }
+      }
+    }
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    d[i] = Encode<D>(Decode<S>(s[i], plan), plan);
+  }
+}
+
+using SpanKernel = void (*)(uint8_t*, const uint8_t*, size_t, const ConvertPlan&);
+
+enum : size_t { kNumChannelTypes = (size_t)ChannelType::UNKNOWN };
+
+template<size_t S, size_t... Ds>
+constexpr std::array<SpanKernel, kNumChannelTypes> SpanKernelRow(std::index_sequence<Ds...>) {
+  return {{&ConvertSpan<(ChannelType)S, (ChannelType)Ds>...}};
+}
+
+template<size_t... Ss>
+constexpr std::array<std::array<SpanKernel, kNumChannelTypes>, kNumChannelTypes>
+SpanKernelTable(std::index_sequence<Ss...>) {
+  return {{SpanKernelRow<Ss>(std::make_index_sequence<kNumChannelTypes>())...}};
+}
+
+//! ConvertSpan() instantiated for every (source, destination) channel type pair
+inline SpanKernel GetSpanKernel(ChannelType src, ChannelType dst) {
+  static constexpr auto table = SpanKernelTable(std::make_index_sequence<kNumChannelTypes>());
+  return table[(size_t)src][(size_t)dst];
+}
+
+//! Shuffle of pixels x .. w - 1 with the channel counts fixed, one lookup per channel.
+template<typename T, uint32_t SC, uint32_t DC>
+void ShufflePixels(T *d, const T *s, uint32_t x, uint32_t w, const std::array<int8_t, 4> &swizzle,
+  T one) {
+  // source pixel followed by the constants 0 and 1, so that every channel is a plain load
+  uint32_t idx[DC];
+  for (uint32_t c = 0; c < DC; c++) {
+    idx[c] = swizzle[c] >= 0 ? (uint32_t)swizzle[c] : swizzle[c] == kSwizzleZero ? SC : SC + 1;
+  }
+  T pixel[SC + 2];
+  pixel[SC] = T(0);
+  pixel[SC + 1] = one;
+  for (; x < w; x++) {
+    for (uint32_t c = 0; c < SC; c++) {
+      pixel[c] = s[x * SC + c];
+    }
+    for (uint32_t c = 0; c < DC; c++) {
+      d[x * DC + c] = pixel[idx[c]];
+    }
+  }
+}
+
+template<typename T, uint32_t SC>
+void ShufflePixels(T *d, const T *s, uint32_t x, uint32_t w, uint32_t dc,
+  const std::array<int8_t, 4> &swizzle, T one) {
+  switch (dc) {
+  case 1: ShufflePixels<T, SC, 1>(d, s, x, w, swizzle, one); break;
+  case 2: ShufflePixels<T, SC, 2>(d, s, x, w, swizzle, one); break;
+  case 3: ShufflePixels<T, SC, 3>(d, s, x, w, swizzle, one); break;
+  default: ShufflePixels<T, SC, 4>(d, s, x, w, swizzle, one); break;
+  }
+}
+
+//! Channel shuffle of w pixels of same sized channels; one holds the bytes of a constant 1.
+template<typename T>
+void ShuffleRow(uint8_t *dst, const uint8_t *src, uint32_t w, const ConvertPlan &plan, T one) {
+  const T *s = (const T*)src;
+  T *d = (T*)dst;
+  uint32_t sc = plan.src_channels;
+  uint32_t dc = plan.dst_channels;
+  uint32_t x = 0;
+#if defined(__SSSE3__) || (defined(__ARM_NEON) && defined(__aarch64__))
+  if constexpr (sizeof(T) == 1) {
+    // 4 pixels per step through a byte shuffle, constants OR-ed in afterwards
+    alignas(16) uint8_t mask[16];
+    alignas(16) uint8_t consts[16];
+    for (uint32_t i = 0; i < 16; i++) {
+      uint32_t p = i / dc;
+      uint32_t c = i % dc;
+      int8_t sw = p < 4 ? plan.swizzle[c] : kSwizzleZero;
+      mask[i] = sw >= 0 ? (uint8_t)(p * sc + sw) : 0x80;
+      consts[i] = p < 4 && sw == kSwizzleOne ? (uint8_t)one : 0;
+    }
+#if defined(__SSSE3__)
+    __m128i vmask = _mm_load_si128((const __m128i*)mask);
+    __m128i vconsts = _mm_load_si128((const __m128i*)consts);
+    for (; x + 4 <= w && (w - x) * sc >= 16 && (w - x) * dc >= 16; x += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(s + x * sc));
+      _mm_storeu_si128((__m128i*)(d + x * dc), _mm_or_si128(_mm_shuffle_epi8(v, vmask), vconsts));
+    }
+#else
+    uint8x16_t vmask = vld1q_u8(mask);
+    uint8x16_t vconsts = vld1q_u8(consts);
+    for (; x + 4 <= w && (w - x) * sc >= 16 && (w - x) * dc >= 16; x += 4) {
+      uint8x16_t v = vld1q_u8((const uint8_t*)(s + x * sc));
+      vst1q_u8((uint8_t*)(d + x * dc), vorrq_u8(vqtbl1q_u8(v, vmask), vconsts));
+    }
+#endif
+  }
+#endif
+  switch (sc) {
+  case 1: ShufflePixels<T, 1>(d, s, x, w, dc, plan.swizzle, one); break;
+  case 2: ShufflePixels<T, 2>(d, s, x, w, dc, plan.swizzle, one); break;
+  case 3: ShufflePixels<T, 3>(d, s, x, w, dc, plan.swizzle, one); break;
+  default: ShufflePixels<T, 4>(d, s, x, w, dc, plan.swizzle, one); break;
+  }
+}
+
+//! Any conversion: swizzle a chunk of pixels in the source format, then convert it element-wise.
+template<ChannelType S, ChannelType D>
+void ConvertSwizzleRow(uint8_t *dst, const uint8_t *src, uint32_t w, const ConvertPlan &plan) {
+  using TSrc = typename Channel<S>::type;
+  using TDst = typename Channel<D>::type;
+  enum : uint32_t { kChunk = 256 };
+  // constant 1 in the source representation, decoding to 1 in the float domain
+  TSrc one;
+  if constexpr (S == ChannelType::F16) {
+    one = 0x3c00;
+  } else if constexpr (S == ChannelType::F32) {
+    one = 1.0f;
+  } else {
+    one = plan.src_max == 1.0f ? TSrc(1) : std::numeric_limits<TSrc>::max();
+  }
+  // shuffled as TSrc, the type ConvertSpan() reads it as
+  TSrc chunk[kChunk * 4];
+  uint32_t sc = plan.src_channels;
+  uint32_t dc = plan.dst_channels;
+  for (uint32_t x0 = 0; x0 < w; x0 += kChunk) {
+    uint32_t n = std::min<uint32_t>(kChunk, w - x0);
+    ShuffleRow<TSrc>((uint8_t*)chunk, src + (size_t)x0 * sc * sizeof(TSrc), n, plan, one);
+    ConvertSpan<S, D>(dst + (size_t)x0 * dc * sizeof(TDst), (const uint8_t*)chunk, (size_t)n * dc, plan);
+  }
+}
+
+using RowKernel = void (*)(uint8_t*, const uint8_t*, uint32_t, const ConvertPlan&);
+
+template<size_t S, size_t... Ds>
+constexpr std::array<RowKernel, kNumChannelTypes> SwizzleKernelRow(std::index_sequence<Ds...>) {
+  return {{&ConvertSwizzleRow<(ChannelType)S, (ChannelType)Ds>...}};
+}
+
+template<size_t... Ss>
+constexpr std::array<std::array<RowKernel, kNumChannelTypes>, kNumChannelTypes>
+SwizzleKernelTable(std::index_sequence<Ss...>) {
+  return {{SwizzleKernelRow<Ss>(std::make_index_sequence<kNumChannelTypes>())...}};
+}
+
+inline RowKernel GetSwizzleKernel(ChannelType src, ChannelType dst) {
+  static constexpr auto table = SwizzleKernelTable(std::make_index_sequence<kNumChannelTypes>());
+  return table[(size_t)src][(size_t)dst];
+}
+
+inline bool IsSignedType(ChannelType type) {
+  return type == ChannelType::S8 || type == ChannelType::S16 || type == ChannelType::S32;
+}
+
+//! largest magnitude of an integer channel type, 1 for floats
+inline float ChannelMax(ChannelType type) {
+  switch (type) {
+  case ChannelType::U8: return 255.0f;
+  case ChannelType::S8: return 127.0f;
+  case ChannelType::U16: return 65535.0f;
+  case ChannelType::S16: return 32767.0f;
+  case ChannelType::U32: return 4294967295.0f;
+  case ChannelType::S32: return 2147483647.0f;
+  default: return 1.0f;
+  }
+}
+
+}
+
+/**
+ * @brief Convert the pixels of src into the format of dst.
+ * @details Converts between 8, 16 and 32 bit integer, f16 and f32 channels, UNORM/SNORM and plain
+ * integers, and 1 to 4 channels with any swizzle (see ConvertOptions). Float to integer
+ * conversions clamp and round to nearest. Each row runs through a kernel picked once per call
+ * for the (source, destination) channel type pair: a plain copy, an element-wise conversion, a
+ * SIMD channel shuffle for same-type swizzles, or a generic decode/swizzle/encode kernel.
+ * Conversions of at least kParallelCopyBytes run in row bands on executor.
+ *
+ * @param dst destination ROI, at least as large as src; its format selects the conversion.
+ * @param src source ROI.
+ * @param options normalization and channel mapping.
+ * @param executor executor running large conversions, DefaultThreadPool() if not specified.
+ * @return false if dst is smaller than src, a channel type is not supported, either ROI has more
+ * than 4 channels, or the swizzle refers to a missing source channel.
+ */
+inline bool Convert(ImgROI &dst, const ImgROI &src, const ConvertOptions &options = ConvertOptions(),
+  Executor &executor = DefaultThreadPool()) {
+  ChannelType src_type = GetChannelType(src);
+  ChannelType dst_type = GetChannelType(dst);
+  if (src.Width() == 0 || src.Height() == 0 || src.Depth() == 0) {
+    return src.Width() <= dst.Width() && src.Height() <= dst.Height() && src.Depth() <= dst.Depth();
+  }
+  if (src.Width() > dst.Width() || src.Height() > dst.Height() || src.Depth() > dst.Depth()
+    || src_type == ChannelType::UNKNOWN || dst_type == ChannelType::UNKNOWN
+    || src.Channel() == 0 || src.Channel() > 4 || dst.Channel() == 0 || dst.Channel() > 4) {
+    return false;
+  }
+
+  detail::ConvertPlan plan;
+  plan.src_channels = src.Channel();
+  plan.dst_channels = dst.Channel();
+  bool identity = src.Channel() == dst.Channel();
+  for (uint32_t c = 0; c < dst.Channel(); c++) {
+    int8_t sw = options.swizzle[c];
+    if (sw == kSwizzleAuto) {
+      sw = src.Channel() == 1 && c < 3 ? 0
+        : c < src.Channel() ? (int8_t)c
+        : c == 3 ? (int8_t)kSwizzleOne : (int8_t)kSwizzleZero;
+    }
+    if (sw >= (int8_t)src.Channel() || sw < kSwizzleOne) {
+      return false;
+    }
+    plan.swizzle[c] = sw;
+    identity = identity && sw == (int8_t)c;
+  }
+
+  plan.src_max = options.src_normalized ? detail::ChannelMax(src_type) : 1.0f;
+  plan.src_min = options.src_normalized && detail::IsSignedType(src_type) ? -1.0f : -INFINITY;
+  plan.dst_scale = options.dst_normalized ? detail::ChannelMax(dst_type) : 1.0f;
+  plan.dst_hi = detail::ChannelMax(dst_type);
+  plan.dst_lo = !detail::IsSignedType(dst_type) ? 0.0f
+    : options.dst_normalized ? -plan.dst_hi : -plan.dst_hi - 1.0f;
+  if (dst_type == ChannelType::U32) {
+    plan.dst_hi = 4294967040.0f;  // largest float below 2^32
+  } else if (dst_type == ChannelType::S32) {
+    plan.dst_hi = 2147483520.0f;  // largest float below 2^31
+  }
+  bool same_values = src_type == dst_type && (options.src_normalized == options.dst_normalized
+    || src_type == ChannelType::F16 || src_type == ChannelType::F32);
+
+  size_t pixel_bytes = (src.BPC() * src.Channel()) >> 3;
+  std::function<void(uint8_t*, const uint8_t*, uint32_t)> row_fn;
+  if (identity && same_values) {
+    return CopyData(dst, src, executor);
+  } else if (identity) {
+    detail::SpanKernel kernel = detail::GetSpanKernel(src_type, dst_type);
+    uint32_t c = src.Channel();
+    row_fn = [kernel, plan, c](uint8_t *d, const uint8_t *s, uint32_t w) {
+      kernel(d, s, (size_t)w * c, plan);
+    };
+  } else if (same_values) {
+    // constant 1 in the destination representation
+    float one_f = 1.0f;
+    switch (dst.BPC()) {
+    case 8: {
+      uint8_t one = (uint8_t)(options.dst_normalized ? detail::ChannelMax(dst_type) : 1.0f);
+      row_fn = [plan, one](uint8_t *d, const uint8_t *s, uint32_t w) {
+        detail::ShuffleRow<uint8_t>(d, s, w, plan, one);
+      };
+      break;
+    }
+    case 16: {
+      uint16_t one = dst_type == ChannelType::F16 ? detail::FloatToHalfBits(one_f)
+        : (uint16_t)(options.dst_normalized ? detail::ChannelMax(dst_type) : 1.0f);
+      row_fn = [plan, one](uint8_t *d, const uint8_t *s, uint32_t w) {
+        detail::ShuffleRow<uint16_t>(d, s, w, plan, one);
+      };
+      break;
+    }
+    default: {
+      uint32_t one;
+      if (dst_type == ChannelType::F32) {
+        memcpy(&one, &one_f, 4);
+      } else {
+        one = options.dst_normalized ? (dst_type == ChannelType::S32 ? 0x7fffffffu : 0xffffffffu) : 1u;
+      }
+      row_fn = [plan, one](uint8_t *d, const uint8_t *s, uint32_t w) {
+        detail::ShuffleRow<uint32_t>(d, s, w, plan, one);
+      };
+      break;
+    }
+    }
+  } else {
+    detail::RowKernel kernel = detail::GetSwizzleKernel(src_type, dst_type);
+    row_fn = [kernel, plan](uint8_t *d, const uint8_t *s, uint32_t w) {
+      kernel(d, s, w, plan);
+    };
+  }
+
+  ImgROI dst_view(dst, 0, 0, 0, src.Width() - 1, src.Height() - 1, src.Depth() - 1);
+  auto convert_row = [&row_fn](uint32_t, uint32_t, uint32_t w, auto &ptrs) {
+    row_fn(ptrs[0], ptrs[1], w);
+  };
+  uint64_t bytes = (uint64_t)pixel_bytes * src.Width() * src.Height() * src.Depth();
+  if (bytes >= kParallelCopyBytes) {
+    ParallelZipTransformRows(std::make_tuple(dst_view, src), convert_row, executor);
+  } else {
+    ZipTransformRows(std::make_tuple(dst_view, src), convert_row);
+  }
+  return true;
+}
+
+}
+
+#endif // IMGPP_CONVERT_HPP
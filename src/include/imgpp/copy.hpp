@@ -0,0 +1,144 @@
+#ifndef IMGPP_COPY_HPP
+#define IMGPP_COPY_HPP
+
+/*! \file copy.hpp
+ *  \brief Bulk memory copies behind CopyData(), ImgBuffer::CopyFrom() and the Clone() methods.
+ *
+ *  Copies only run on other threads when given an Executor explicitly.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <imgpp/threadpool.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace imgpp {
+
+enum : uint64_t {
+  kParallelCopyBytes = 16 * 1024 * 1024, //!< copies of at least this many bytes are split across threads
+  kStreamingCopyBytes = 32 * 1024 * 1024 //!< copies of at least this many bytes bypass the cache
+};
+
+namespace detail {
+
+enum : size_t { kCopyVector = 16, kMinCopyTask = 4 * 1024 * 1024 };
+
+//! memcpy with non-temporal stores where the CPU has them, the destination won't be read soon
+inline void StreamCopy(uint8_t *dst, const uint8_t *src, size_t n) {
+#if defined(__SSE2__) || defined(_M_X64)
+  size_t head = std::min(n, (size_t)(-(uintptr_t)dst & (kCopyVector - 1)));
+  memcpy(dst, src, head);
+  size_t i = head;
+  for (; i + 4 * kCopyVector <= n; i += 4 * kCopyVector) {
+    __m128i v0 = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i v1 = _mm_loadu_si128((const __m128i*)(src + i + kCopyVector));
+    __m128i v2 = _mm_loadu_si128((const __m128i*)(src + i + 2 * kCopyVector));
+    __m128i v3 = _mm_loadu_si128((const __m128i*)(src + i + 3 * kCopyVector));
+    _mm_stream_si128((__m128i*)(dst + i), v0);
+    _mm_stream_si128((__m128i*)(dst + i + kCopyVector), v1);
+    _mm_stream_si128((__m128i*)(dst + i + 2 * kCopyVector), v2);
+    _mm_stream_si128((__m128i*)(dst + i + 3 * kCopyVector), v3);
+  }
+  _mm_sfence();
+  memcpy(dst + i, src + i, n - i);
+#else
+  memcpy(dst, src, n);
+#endif
+}
+
+//! Number of tasks for a copy of total bytes, 1 below kParallelCopyBytes.
+inline size_t CopyTasks(uint64_t total, Executor &executor) {
+  if (total < kParallelCopyBytes) {
+    return 1;
+  }
+  return (size_t)std::max<uint64_t>(1, std::min<uint64_t>(executor.Concurrency(), total / kMinCopyTask));
+}
+
+/**
+ * @brief Copy n contiguous bytes on the calling thread.
+ * @details Copies of at least kStreamingCopyBytes use non-temporal stores.
+ */
+inline void CopyBytes(void *dst, const void *src, size_t n) {
+  if (n >= kStreamingCopyBytes) {
+    StreamCopy((uint8_t*)dst, (const uint8_t*)src, n);
+  } else if (n > 0) {
+    memcpy(dst, src, n);
+  }
+}
+
+/**
+ * @brief Copy n contiguous bytes, splitting large copies across executor.
+ * @details Copies of at least kParallelCopyBytes are split into equal chunks run on executor,
+ * and use non-temporal stores from kStreamingCopyBytes on.
+ */
+inline void CopyBytes(void *dst, const void *src, size_t n, Executor &executor) {
+  if (n < kParallelCopyBytes) {
+    CopyBytes(dst, src, n);
+    return;
+  }
+  bool streaming = n >= kStreamingCopyBytes;
+  size_t num_tasks = CopyTasks(n, executor);
+  executor.Run(num_tasks, [=](size_t t) {
+    // chunk boundaries on cache lines, so that neighboring tasks never share one
+    size_t begin = n * t / num_tasks / 64 * 64;
+    size_t end = t + 1 == num_tasks ? n : n * (t + 1) / num_tasks / 64 * 64;
+    if (streaming) {
+      StreamCopy((uint8_t*)dst + begin, (const uint8_t*)src + begin, end - begin);
+    } else {
+      memcpy((uint8_t*)dst + begin, (const uint8_t*)src + begin, end - begin);
+    }
+  });
+}
+
+/**
+ * @brief Copy rows of row_bytes bytes each on the calling thread.
+ * @details Row r goes from src_row(r) to dst_row(r). Copies of at least kStreamingCopyBytes in total
+ * use non-temporal stores.
+ */
+template<typename TDstRow, typename TSrcRow>
+void CopyRows(uint64_t rows, size_t row_bytes, const TDstRow &dst_row, const TSrcRow &src_row) {
+  bool streaming = rows * row_bytes >= kStreamingCopyBytes;
+  for (uint64_t r = 0; r < rows; ++r) {
+    if (streaming) {
+      StreamCopy((uint8_t*)dst_row(r), (const uint8_t*)src_row(r), row_bytes);
+    } else {
+      memcpy(dst_row(r), src_row(r), row_bytes);
+    }
+  }
+}
+
+/**
+ * @brief Copy rows of row_bytes bytes each, splitting large copies across executor.
+ * @details Row r goes from src_row(r) to dst_row(r). Large copies are split into bands of rows
+ * the same way as CopyBytes().
+ */
+template<typename TDstRow, typename TSrcRow>
+void CopyRows(uint64_t rows, size_t row_bytes, const TDstRow &dst_row, const TSrcRow &src_row,
+  Executor &executor) {
+  uint64_t total = rows * row_bytes;
+  if (total < kParallelCopyBytes) {
+    CopyRows(rows, row_bytes, dst_row, src_row);
+    return;
+  }
+  bool streaming = total >= kStreamingCopyBytes;
+  size_t num_tasks = CopyTasks(total, executor);
+  executor.Run(num_tasks, [&, streaming, num_tasks](size_t t) {
+    for (uint64_t r = rows * t / num_tasks; r < rows * (t + 1) / num_tasks; ++r) {
+      if (streaming) {
+        StreamCopy((uint8_t*)dst_row(r), (const uint8_t*)src_row(r), row_bytes);
+      } else {
+        memcpy(dst_row(r), src_row(r), row_bytes);
+      }
+    }
+  });
+}
+
+}
+
+}
+
+#endif // IMGPP_COPY_HPP
@@ -0,0 +1,487 @@
+#ifndef IMGPP_FILTER_HPP
+#define IMGPP_FILTER_HPP
+
+/*! \file filter.hpp
+ *  \brief Separable convolution and Gaussian blur.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <imgpp/convert.hpp>
+#include <imgpp/resize.hpp>
+
+namespace imgpp {
+
+//! \brief How filters read pixels outside the image, shown for a row a b c d.
+enum class BorderMode: uint8_t {
+  CLAMP,   //!< a a | a b c d | d d, the edge pixels repeat
+  REFLECT, //!< c b | a b c d | c b, mirrored at the edge pixels, which don't repeat
+  WRAP,    //!< c d | a b c d | a b, the image tiles
+  CONSTANT //!< a fixed border value
+};
+
+namespace detail {
+
+enum : uint32_t {
+  kBoxGroupRows = 4,  //!< rows filtered together by the horizontal box passes
+  kBoxBandRows = 128, //!< least rows of a box blur band, which also start 16 radii apart
+  kBoxBandRadii = 16
+};
+
+//! Gaussians this wide and wider are approximated by 3 box filters
+constexpr float kGaussianBoxSigma = 3.0f;
+
+//! index of the pixel read at i in a line of n pixels, -1 for the border value
+inline int64_t BorderIndex(int64_t i, int64_t n, BorderMode border) {
+  if (i >= 0 && i < n) {
+    return i;
+  }
+  switch (border) {
+  case BorderMode::CLAMP:
+    return i < 0 ? 0 : n - 1;
+  case BorderMode::REFLECT: {
+    if (n == 1) {
+      return 0;
+    }
+    int64_t period = 2 * (n - 1);
+    i %= period;
+    i = i < 0 ? i + period : i;
+    return i < n ? i : period - i;
+  }
+  case BorderMode::WRAP:
+    i %= n;
+    return i < 0 ? i + n : i;
+  default:
+    return -1;
+  }
+}
+
+//! One row of channel type T to floats at dst + left * c, with left and right border pixels.
+template<ChannelType T>
+void DecodePaddedRow(float *dst, const void *src, uint32_t w, uint32_t c, uint32_t left, uint32_t right,
+  BorderMode border, float border_value) {
+  float *row = dst + (size_t)left * c;
+  const float *decoded = DecodeResizeRow<T>(src, (size_t)w * c, row);
+  if (decoded != row) {
+    memcpy(row, decoded, (size_t)w * c * sizeof(float));
+  }
+  for (int64_t x = -(int64_t)left; x < (int64_t)w + right; x++) {
+    if (x == 0) {
+      x = w - 1;
+      continue;
+    }
+    int64_t from = BorderIndex(x, w, border);
+    float *to = row + x * c;
+    if (from < 0) {
+      std::fill(to, to + c, border_value);
+    } else {
+      memcpy(to, row + from * c, c * sizeof(float));
+    }
+  }
+}
+
+/**
+ * @brief Convolve the output rows [y0, y1) of slices [z0, z1) with kx and ky.
+ * @details Like ResizeBand(), source rows are filtered horizontally once into a ring of ky rows,
+ * which the output rows then combine vertically; both passes are FilterResizeColumns() calls.
+ */
+template<ChannelType T>
+void ConvolveBand(ImgROI &dst, const ImgROI &src, const std::vector<float> &kx, const std::vector<float> &ky,
+  BorderMode border, float border_value, uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  uint32_t w = src.Width();
+  uint32_t h = src.Height();
+  uint32_t c = src.Channel();
+  size_t len = (size_t)w * c;
+  uint32_t kx_size = (uint32_t)kx.size();
+  uint32_t ky_size = (uint32_t)ky.size();
+  uint32_t left = kx_size / 2;
+  uint32_t top = ky_size / 2;
+  std::vector<float> padded((size_t)(w + kx_size - 1) * c);
+  std::vector<const float*> taps(kx_size);
+  for (uint32_t t = 0; t < kx_size; t++) {
+    taps[t] = padded.data() + (size_t)t * c;
+  }
+  // outside rows of a constant border, filtered horizontally
+  float kx_sum = 0.0f;
+  for (float k: kx) {
+    kx_sum += k;
+  }
+  std::vector<float> constant_row(border == BorderMode::CONSTANT ? len : 0, border_value * kx_sum);
+  std::vector<float> ring((size_t)ky_size * len);
+  std::vector<int64_t> ring_row(ky_size, -1);
+  std::vector<const float*> rows(ky_size);
+  std::vector<float> out(len);
+  for (uint32_t z = z0; z < z1; z++) {
+    std::fill(ring_row.begin(), ring_row.end(), -1);
+    for (uint32_t y = y0; y < y1; y++) {
+      for (uint32_t t = 0; t < ky_size; t++) {
+        int64_t r = BorderIndex((int64_t)y + t - top, h, border);
+        if (r < 0) {
+          rows[t] = constant_row.data();
+          continue;
+        }
+        uint32_t slot_index = (uint32_t)(((int64_t)y + t) % ky_size);
+        float *slot = ring.data() + (size_t)slot_index * len;
+        if (ring_row[slot_index] != r) {
+          DecodePaddedRow<T>(padded.data(), src.PtrAt(0, (uint32_t)r, z, 0), w, c, left, kx_size - 1 - left,
+            border, border_value);
+          FilterResizeColumns(slot, taps.data(), kx.data(), kx_size, len);
+          ring_row[slot_index] = r;
+        }
+        rows[t] = slot;
+      }
+      FilterResizeColumns(out.data(), rows.data(), ky.data(), ky_size, len);
+      EncodeResizeRow<T>(dst.PtrAt(0, y, z, 0), out.data(), len);
+    }
+  }
+}
+
+/**
+ * @brief out(j) = scale * (in(j) + ... + in(j + width - 1)) for j < n, vectors of s values each.
+ * @details A running sum, so the cost doesn't depend on width. Its s lanes are independent
+ * chains, which is why rows are filtered in interleaved groups. A nonzero kS is the compile
+ * time s, which keeps the sums in registers.
+ */
+template<uint32_t kS, typename TIn, typename TOut>
+void BoxSum(const TIn &in, const TOut &out, uint32_t n, uint32_t s, uint32_t width, float scale) {
+#if defined(__SSE2__) || defined(_M_X64)
+  if constexpr (kS > 0 && kS % 4 == 0) {
+    constexpr uint32_t kVectors = kS / 4;
+    const __m128 factor = _mm_set1_ps(scale);
+    __m128 acc[kVectors];
+    for (uint32_t i = 0; i < kVectors; i++) {
+      acc[i] = _mm_setzero_ps();
+    }
+    for (uint32_t d = 0; d + 1 < width; d++) {
+      const float *r = in(d);
+      for (uint32_t i = 0; i < kVectors; i++) {
+        acc[i] = _mm_add_ps(acc[i], _mm_loadu_ps(r + i * 4));
+      }
+    }
+    for (uint32_t j = 0; j < n; j++) {
+      const float *add = in(j + width - 1);
+      const float *sub = in(j);
+      float *o = out(j);
+      for (uint32_t i = 0; i < kVectors; i++) {
+        __m128 sum = _mm_add_ps(acc[i], _mm_loadu_ps(add + i * 4));
+        acc[i] = _mm_sub_ps(sum, _mm_loadu_ps(sub + i * 4));
+        _mm_storeu_ps(o + i * 4, _mm_mul_ps(sum, factor));
+      }
+    }
+    return;
+  }
+#endif
+  const uint32_t lanes = kS ? kS : s;
+  std::array<float, kS ? kS : 1> fixed{};
+  std::vector<float> dynamic(kS ? 0 : lanes);
+  float *acc = kS ? fixed.data() : dynamic.data();
+  for (uint32_t d = 0; d + 1 < width; d++) {
+    const float *r = in(d);
+    for (uint32_t i = 0; i < lanes; i++) {
+      acc[i] += r[i];
+    }
+  }
+  for (uint32_t j = 0; j < n; j++) {
+    const float *add = in(j + width - 1);
+    const float *sub = in(j);
+    float *o = out(j);
+    for (uint32_t i = 0; i < lanes; i++) {
+      float sum = acc[i] + add[i];
+      o[i] = sum * scale;
+      acc[i] = sum - sub[i];
+    }
+  }
+}
+
+/**
+ * @brief Widths of 3 odd box filters whose cascade has about the variance of a Gaussian.
+ * @details Widths differ by at most 2; the mix of the two is the one closest to sigma^2, after
+ * "Fast Almost-Gaussian Filtering" by Kovesi.
+ */
+inline std::array<uint32_t, 3> GaussianBoxes(float sigma) {
+  double variance = (double)sigma * sigma;
+  uint32_t lo = (uint32_t)std::sqrt(4.0 * variance + 1.0);
+  lo -= lo % 2 == 0 ? 1 : 0;
+  std::array<uint32_t, 3> widths{lo, lo, lo};
+  double best = 1e30;
+  for (uint32_t wide = 0; wide <= 3; wide++) {
+    uint32_t hi = lo + 2;
+    double v = (wide * (hi * hi - 1.0) + (3 - wide) * (lo * lo - 1.0)) / 12.0;
+    if (std::fabs(v - variance) < best) {
+      best = std::fabs(v - variance);
+      widths = {wide > 2 ? hi : lo, wide > 1 ? hi : lo, wide > 0 ? hi : lo};
+    }
+  }
+  return widths;
+}
+
+//! acc += row, the first rows of a vertical box
+inline void BoxAccumulate(float *acc, const float *row, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    acc[i] += row[i];
+  }
+}
+
+//! one output row of a vertical box: out = scale * (acc + add), then acc += add - sub
+inline void BoxStep(float *out, float *acc, const float *add, const float *sub, size_t n, float scale) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128 factor = _mm_set1_ps(scale);
+  for (; i + 8 <= n; i += 8) {
+    __m128 sum0 = _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(add + i));
+    __m128 sum1 = _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_loadu_ps(add + i + 4));
+    _mm_storeu_ps(out + i, _mm_mul_ps(sum0, factor));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(sum1, factor));
+    _mm_storeu_ps(acc + i, _mm_sub_ps(sum0, _mm_loadu_ps(sub + i)));
+    _mm_storeu_ps(acc + i + 4, _mm_sub_ps(sum1, _mm_loadu_ps(sub + i + 4)));
+  }
+#endif
+  for (; i < n; i++) {
+    float sum = acc[i] + add[i];
+    out[i] = sum * scale;
+    acc[i] = sum - sub[i];
+  }
+}
+
+/**
+ * @brief Box blur the output rows [y0, y1) of slices [z0, z1), C channels or any count for C 0.
+ * @details Source rows from radius above to radius below the band are box filtered
+ * horizontally in interleaved groups of kBoxGroupRows, then streamed through the 3 vertical
+ * boxes, running sums over whole rows each keeping its last inputs in a ring.
+ */
+template<ChannelType T, uint32_t C>
+void BoxBlurBand(ImgROI &dst, const ImgROI &src, const std::array<uint32_t, 3> &widths, BorderMode border,
+  float border_value, uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  constexpr uint32_t kS = kBoxGroupRows * C;
+  const uint32_t c = C ? C : src.Channel();
+  const uint32_t s = kBoxGroupRows * c;
+  uint32_t w = src.Width();
+  uint32_t h = src.Height();
+  size_t len = (size_t)w * c;
+  uint32_t radius = (widths[0] + widths[1] + widths[2] - 3) / 2;
+  uint32_t padded = w + 2 * radius;
+  std::vector<float> row((size_t)padded * c);
+  std::vector<float> ping((size_t)padded * s);
+  std::vector<float> pong((size_t)padded * s);
+  // inputs of the vertical boxes, the first fed by the horizontal pass
+  std::array<std::vector<float>, 3> rings;
+  std::array<std::vector<float>, 3> acc;
+  std::array<uint32_t, 3> count;
+  for (uint32_t k = 0; k < 3; k++) {
+    rings[k].resize((size_t)widths[k] * len);
+    acc[k].resize(len);
+  }
+  std::vector<float> out(len);
+  for (uint32_t z = z0; z < z1; z++) {
+    count = {0, 0, 0};
+    for (uint32_t k = 0; k < 3; k++) {
+      std::fill(acc[k].begin(), acc[k].end(), 0.0f);
+    }
+    uint32_t num_rows = y1 - y0 + 2 * radius;
+    for (uint32_t i = 0; i < num_rows; i += kBoxGroupRows) {
+      uint32_t rows = std::min<uint32_t>(kBoxGroupRows, num_rows - i);
+      for (uint32_t g = 0; g < rows; g++) {
+        int64_t r = BorderIndex((int64_t)y0 + i + g - radius, h, border);
+        if (r < 0) {
+          std::fill(row.begin(), row.end(), border_value);
+        } else {
+          DecodePaddedRow<T>(row.data(), src.PtrAt(0, (uint32_t)r, z, 0), w, c, radius, radius, border,
+            border_value);
+        }
+        const float *from = row.data();
+        float *to = ping.data() + g * c;
+        for (size_t x = 0; x < padded; x++, from += c, to += s) {
+          for (uint32_t v = 0; v < c; v++) {
+            to[v] = from[v];
+          }
+        }
+      }
+      uint32_t n = padded;
+      float *in = ping.data();
+      float *filtered = pong.data();
+      for (uint32_t width: widths) {
+        n -= width - 1;
+        BoxSum<kS>([in, s](uint32_t j) { return in + (size_t)j * s; },
+          [filtered, s](uint32_t j) { return filtered + (size_t)j * s; }, n, s, width, 1.0f / width);
+        std::swap(in, filtered);
+      }
+      for (uint32_t g = 0; g < rows; g++) {
+        const float *from = in + g * c;
+        float *to = rings[0].data() + (size_t)(count[0] % widths[0]) * len;
+        for (size_t x = 0; x < w; x++, from += s, to += c) {
+          for (uint32_t v = 0; v < c; v++) {
+            to[v] = from[v];
+          }
+        }
+        // each box outputs a row once its ring is full, into the next ring or dst
+        for (uint32_t k = 0; k < 3; k++) {
+          uint32_t m = count[k]++;
+          const float *added = rings[k].data() + (size_t)(m % widths[k]) * len;
+          if (m + 1 < widths[k]) {
+            BoxAccumulate(acc[k].data(), added, len);
+            break;
+          }
+          const float *removed = rings[k].data() + (size_t)((m + 1) % widths[k]) * len;
+          float *result = k < 2 ? rings[k + 1].data() + (size_t)(count[k + 1] % widths[k + 1]) * len : out.data();
+          BoxStep(result, acc[k].data(), added, removed, len, 1.0f / widths[k]);
+          if (k == 2) {
+            EncodeResizeRow<T>(dst.PtrAt(0, y0 + m + 1 - widths[2], z, 0), out.data(), len);
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Gaussian blur by 3 box filters per axis.
+ * @details Bands start a fixed number of rows apart, at least kBoxBandRadii times the radius
+ * of the cascade so that the rows read above and below them stay a small overhead, and the
+ * result doesn't depend on the executor.
+ */
+template<ChannelType T, uint32_t C>
+void BoxBlur(ImgROI &dst, const ImgROI &src, const std::array<uint32_t, 3> &widths, BorderMode border,
+  float border_value, Executor &executor) {
+  uint32_t h = src.Height();
+  uint32_t d = src.Depth();
+  uint32_t radius = (widths[0] + widths[1] + widths[2] - 3) / 2;
+  uint32_t band_rows = std::max<uint32_t>(kBoxBandRows, kBoxBandRadii * radius);
+  uint32_t per_slice = (h + band_rows - 1) / band_rows;
+  auto band = [&](size_t b) {
+    uint32_t z = (uint32_t)(b / per_slice);
+    uint32_t y0 = (uint32_t)(b % per_slice) * band_rows;
+    BoxBlurBand<T, C>(dst, src, widths, border, border_value, y0, std::min(h, y0 + band_rows), z, z + 1);
+  };
+  uint64_t values = (uint64_t)src.Width() * h * d * src.Channel();
+  if (values >= kParallelResizeValues && (size_t)per_slice * d > 1) {
+    executor.Run((size_t)per_slice * d, band);
+  } else {
+    for (size_t b = 0; b < (size_t)per_slice * d; b++) {
+      band(b);
+    }
+  }
+}
+
+template<ChannelType T>
+void BoxBlur(ImgROI &dst, const ImgROI &src, const std::array<uint32_t, 3> &widths, BorderMode border,
+  float border_value, Executor &executor) {
+  switch (src.Channel()) {
+  case 1: BoxBlur<T, 1>(dst, src, widths, border, border_value, executor); break;
+  case 2: BoxBlur<T, 2>(dst, src, widths, border, border_value, executor); break;
+  case 3: BoxBlur<T, 3>(dst, src, widths, border, border_value, executor); break;
+  case 4: BoxBlur<T, 4>(dst, src, widths, border, border_value, executor); break;
+  default: BoxBlur<T, 0>(dst, src, widths, border, border_value, executor); break;
+  }
+}
+
+//! true if src and dst have the same size and a format the filters support
+inline bool IsFilterable(const ImgROI &dst, const ImgROI &src) {
+  return GetChannelType(src) != ChannelType::UNKNOWN && GetChannelType(src) == GetChannelType(dst)
+    && src.Channel() == dst.Channel() && src.Width() == dst.Width() && src.Height() == dst.Height()
+    && src.Depth() == dst.Depth();
+}
+
+}
+
+/**
+ * @brief Sampled and normalized Gaussian of radius ceil(3 * sigma), for SeparableFilter().
+ */
+inline std::vector<float> GaussianKernel(float sigma) {
+  int32_t radius = std::max(1, (int32_t)std::ceil(3.0f * sigma));
+  std::vector<float> kernel(2 * radius + 1);
+  double sum = 0.0;
+  std::vector<double> weights(kernel.size());
+  for (int32_t i = -radius; i <= radius; i++) {
+    weights[i + radius] = std::exp(-0.5 * i * i / ((double)sigma * sigma));
+    sum += weights[i + radius];
+  }
+  for (size_t i = 0; i < kernel.size(); i++) {
+    kernel[i] = (float)(weights[i] / sum);
+  }
+  return kernel;
+}
+
+/**
+ * @brief Convolve every slice of src with kernel_x along x, then with kernel_y along y.
+ * @details Pixel x of the output sums kernel_x[t] * src(x + t - kernel_x.size() / 2). Kernels
+ * are not normalized. Values are filtered in float, then rounded to nearest and clamped for
+ * integer channels; 32 bit integers keep float precision. Source rows are filtered horizontally
+ * once per band into a ring of kernel_y.size() rows, both passes in SSE2 register blocks, and
+ * outputs of at least kParallelResizeValues channel values run in row bands on executor.
+ *
+ * @param dst destination ROI of the size and format of src, not overlapping it.
+ * @param src source ROI of any integer or float channel type and any channel count.
+ * @param kernel_x horizontal kernel, at least 1 tap.
+ * @param kernel_y vertical kernel, at least 1 tap.
+ * @param border how pixels outside src are read.
+ * @param border_value the value of every channel outside src for BorderMode::CONSTANT, in the
+ * range of the channel type.
+ * @param executor executor running large filters, DefaultThreadPool() if not specified.
+ * @return false if the format or sizes differ or are not supported, or a kernel is empty.
+ */
+inline bool SeparableFilter(ImgROI &dst, const ImgROI &src, const std::vector<float> &kernel_x,
+  const std::vector<float> &kernel_y, BorderMode border = BorderMode::CLAMP, float border_value = 0.0f,
+  Executor &executor = DefaultThreadPool()) {
+  if (!detail::IsFilterable(dst, src) || kernel_x.empty() || kernel_y.empty()) {
+    return false;
+  }
+  if (src.Width() == 0 || src.Height() == 0 || src.Depth() == 0 || src.Channel() == 0) {
+    return true;
+  }
+  detail::DispatchChannelType(GetChannelType(src), [&](auto type) {
+    auto band = [&](uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+      detail::ConvolveBand<decltype(type)::value>(dst, src, kernel_x, kernel_y, border, border_value, y0, y1, z0, z1);
+    };
+    uint64_t values = (uint64_t)src.Width() * src.Height() * src.Depth() * src.Channel();
+    if (values >= detail::kParallelResizeValues) {
+      detail::ForEachBand(src.Height(), src.Depth(), executor, band);
+    } else {
+      band(0, src.Height(), 0, src.Depth());
+    }
+  });
+  return true;
+}
+
+/**
+ * @brief Gaussian blur of every slice of src.
+ * @details Below kGaussianBoxSigma this is SeparableFilter() with GaussianKernel(sigma). Wider
+ * Gaussians are approximated by 3 box filters per axis (GaussianBoxes()), whose running sums
+ * cost the same for any sigma; their variance is the closest the odd box widths allow, within a
+ * few percent at sigma 3 and closer from there. Rows are box filtered in interleaved groups and
+ * streamed through the vertical boxes in bands of fixed rows, so results don't depend on executor.
+ *
+ * @param dst destination ROI of the size and format of src, not overlapping it.
+ * @param src source ROI of any integer or float channel type and any channel count.
+ * @param sigma standard deviation in pixels, 0 copies src.
+ * @param border how pixels outside src are read.
+ * @param border_value the value of every channel outside src for BorderMode::CONSTANT.
+ * @param executor executor running large blurs, DefaultThreadPool() if not specified.
+ * @return false if the format or sizes differ or are not supported, or sigma is negative.
+ */
+inline bool GaussianBlur(ImgROI &dst, const ImgROI &src, float sigma, BorderMode border = BorderMode::CLAMP,
+  float border_value = 0.0f, Executor &executor = DefaultThreadPool()) {
+  if (!detail::IsFilterable(dst, src) || !(sigma >= 0.0f)) {
+    return false;
+  }
+  if (sigma < detail::kGaussianBoxSigma) {
+    std::vector<float> kernel = sigma > 0.0f ? GaussianKernel(sigma) : std::vector<float>{1.0f};
+    return SeparableFilter(dst, src, kernel, kernel, border, border_value, executor);
+  }
+  if (src.Width() == 0 || src.Height() == 0 || src.Depth() == 0 || src.Channel() == 0) {
+    return true;
+  }
+  std::array<uint32_t, 3> widths = detail::GaussianBoxes(sigma);
+  detail::DispatchChannelType(GetChannelType(src), [&](auto type) {
+    detail::BoxBlur<decltype(type)::value>(dst, src, widths, border, border_value, executor);
+  });
+  return true;
+}
+
+}
+
+#endif // IMGPP_FILTER_HPP
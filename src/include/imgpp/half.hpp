@@ -0,0 +1,259 @@
+#ifndef IMGPP_HALF_HPP
+#define IMGPP_HALF_HPP
+
+/*! \file half.hpp
+ *  \brief 16 bit float channels (the *16_SFLOAT formats) and bulk f16 <-> f32 conversion.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <imgpp/typetraits.hpp>
+
+#if defined(__F16C__) || defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace imgpp {
+
+namespace detail {
+
+//! Lookup tables of the scalar conversions, built at compile time.
+
+//! f16 -> f32 is mantissa[offset[e] + m] + exponent[e] for the 6 sign and exponent bits e and the
+//! 10 mantissa bits m. f32 -> f16 is base[e] + (m >> shift[e]) for the 9 sign and exponent bits
+//! e and the 24 bit mantissa m including the implicit 1, rounded to nearest even afterwards.
+struct HalfTables {
+  uint32_t mantissa[2048];
+  uint32_t exponent[64];
+  uint16_t offset[64];
+  uint16_t base[512];
+  uint8_t shift[512];
+};
+
+constexpr HalfTables MakeHalfTables() {
+  HalfTables t{};
+  for (uint32_t i = 1; i < 1024; i++) {
+    // normalize the subnormal mantissa
+    uint32_t m = i << 13;
+    uint32_t e = 0;
+    while (!(m & 0x00800000)) {
+      e -= 0x00800000;
+      m <<= 1;
+    }
+    t.mantissa[i] = (m & ~0x00800000u) | (e + 0x38800000);
+  }
+  for (uint32_t i = 1024; i < 2048; i++) {
+    t.mantissa[i] = 0x38000000 + ((i - 1024) << 13);
+  }
+  for (uint32_t i = 0; i < 64; i++) {
+    uint32_t e = i & 31;
+    uint32_t sign = i < 32 ? 0 : 0x80000000;
+    t.exponent[i] = sign + (e == 31 ? 0x47800000 : e << 23);
+    t.offset[i] = e == 0 ? 0 : 1024;
+  }
+  for (int32_t i = 0; i < 256; i++) {
+    int32_t e = i - 127;
+    uint16_t base = 0;
+    uint8_t shift = 25;  // m >> 25 and its rounding bit are 0
+    if (e >= -25 && e < -14) {  // subnormal half
+      shift = (uint8_t)(-1 - e);
+    } else if (e >= -14 && e <= 15) {  // normal half, base cancels the implicit 1
+      base = (uint16_t)((e + 14) << 10);
+      shift = 13;
+    } else if (e > 15) {  // overflow and infinity
+      base = 0x7c00;
+    }
+    t.base[i] = base;
+    t.base[i + 256] = base | 0x8000;
+    t.shift[i] = shift;
+    t.shift[i + 256] = shift;
+  }
+  return t;
+}
+
+inline constexpr HalfTables kHalfTables = MakeHalfTables();
+
+inline float HalfBitsToFloat(uint16_t h) {
+  uint32_t e = h >> 10;
+  uint32_t bits = kHalfTables.mantissa[kHalfTables.offset[e] + (h & 0x3ff)] + kHalfTables.exponent[e];
+  float f;
+  memcpy(&f, &bits, 4);
+  return f;
+}
+
+//! f32 -> f16 rounding to nearest even, infinities preserved, NaNs become a quiet NaN.
+inline uint16_t FloatToHalfBits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, 4);
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    return (uint16_t)((bits >> 16) & 0x8000) | 0x7e00;
+  }
+  uint32_t e = bits >> 23;
+  uint32_t m = (bits & 0x007fffff) | 0x00800000;
+  uint32_t shift = kHalfTables.shift[e];
+  uint32_t h = kHalfTables.base[e] + (m >> shift);
+  uint32_t round = (m >> (shift - 1)) & 1;
+  uint32_t sticky = m & ((1u << (shift - 1)) - 1);
+  h += round & ((sticky != 0) | (h & 1));  // a carry moves on to the next exponent or infinity
+  return (uint16_t)h;
+}
+
+#if !defined(__F16C__) && (defined(__SSE2__) || defined(_M_X64))
+//! 4 halves in the low 16 bits of each lane to floats, the table conversion done with masks.
+inline __m128 HalfToFloat4(__m128i h) {
+  __m128i expmant = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+  __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expmant), 16);
+  __m128i is_infnan = _mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7bff));
+  __m128i is_subnormal = _mm_cmpgt_epi32(_mm_set1_epi32(0x0400), expmant);
+  __m128i shifted = _mm_slli_epi32(expmant, 13);
+  // rebias the exponent, twice for infinities and NaNs to reach 255
+  __m128i normal = _mm_add_epi32(shifted, _mm_set1_epi32((127 - 15) << 23));
+  normal = _mm_add_epi32(normal, _mm_and_si128(is_infnan, _mm_set1_epi32((128 - 16) << 23)));
+  // subnormals: mant * 2^-24 as (2^-14 + mant * 2^-24) - 2^-14
+  __m128i magic = _mm_set1_epi32(113 << 23);
+  __m128 subnormal = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(shifted, magic)), _mm_castsi128_ps(magic));
+  __m128i bits = _mm_or_si128(_mm_and_si128(is_subnormal, _mm_castps_si128(subnormal)),
+    _mm_andnot_si128(is_subnormal, normal));
+  return _mm_castsi128_ps(_mm_or_si128(bits, sign));
+}
+
+//! 4 floats to halves in the low 16 bits of each lane, same results as FloatToHalfBits().
+inline __m128i FloatToHalf4(__m128 f) {
+  __m128i bits = _mm_castps_si128(f);
+  __m128i abs = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+  __m128i sign = _mm_srli_epi32(_mm_xor_si128(bits, abs), 16);
+  // subnormal halves: adding 2^-1 aligns the mantissa bits and rounds to nearest even
+  __m128i magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+  __m128i subnormal = _mm_sub_epi32(
+    _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(abs), _mm_castsi128_ps(magic))), magic);
+  // normal halves: rebias, add the rounding bias plus the lowest kept mantissa bit, truncate
+  __m128i odd = _mm_and_si128(_mm_srli_epi32(abs, 13), _mm_set1_epi32(1));
+  // (15 - 127) << 23 in unsigned arithmetic, shifting a negative value is undefined
+  __m128i normal = _mm_add_epi32(abs, _mm_set1_epi32((int32_t)(0u - (112u << 23) + 0xfffu)));
+  normal = _mm_srli_epi32(_mm_add_epi32(normal, odd), 13);
+  __m128i is_subnormal = _mm_cmpgt_epi32(_mm_set1_epi32(113 << 23), abs);
+  __m128i result = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal),
+    _mm_andnot_si128(is_subnormal, normal));
+  // 2^16 and above: infinity, NaNs become a quiet NaN
+  __m128i is_large = _mm_cmpgt_epi32(abs, _mm_set1_epi32(((127 + 16) << 23) - 1));
+  __m128i is_nan = _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7f800000));
+  __m128i large = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x0200)));
+  result = _mm_or_si128(_mm_and_si128(is_large, large), _mm_andnot_si128(is_large, result));
+  return _mm_or_si128(result, sign);
+}
+#endif
+
+}
+
+//! \brief 16 bit IEEE float, the channel type of the *16_SFLOAT formats.
+
+//! Storage only: arithmetic goes through the implicit conversion to float, e.g. At<Half>() and
+//! the samplers read half float ROIs as floats. Converting single values uses lookup tables;
+//! use HalfToFloat() and FloatToHalf() for whole rows.
+class Half {
+public:
+  constexpr Half() {}
+  explicit Half(float f): bits_(detail::FloatToHalfBits(f)) {}
+
+  operator float() const { return detail::HalfBitsToFloat(bits_); }
+
+  static constexpr Half FromBits(uint16_t bits) {
+    Half h;
+    h.bits_ = bits;
+    return h;
+  }
+
+  constexpr uint16_t Bits() const { return bits_; }
+
+private:
+  uint16_t bits_{0};
+};
+
+static_assert(sizeof(Half) == 2 && std::is_trivially_copyable<Half>::value,
+  "Half must have the layout of a f16 channel");
+
+template<>
+struct Interpolatable<Half> {
+  using type = float;
+};
+
+/**
+ * @brief Convert n half floats to floats.
+ * @details Uses the F16C / AVX-512 or NEON conversion instructions where the target has them,
+ * SSE2 integer code or lookup tables otherwise. The results are exact.
+ */
+inline void HalfToFloat(float *dst, const Half *src, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm256_loadu_si256((const __m256i*)(src + i));
+    _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+  }
+#endif
+#if defined(__F16C__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm_storeu_ps(dst + i, detail::HalfToFloat4(_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+    _mm_storeu_ps(dst + i + 4, detail::HalfToFloat4(_mm_unpackhi_epi16(h, _mm_setzero_si128())));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16((const uint16_t*)(src + i)))));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = detail::HalfBitsToFloat(src[i].Bits());
+  }
+}
+
+/**
+ * @brief Convert n floats to half floats, rounding to nearest even.
+ * @details Uses the F16C / AVX-512 or NEON conversion instructions where the target has them,
+ * SSE2 integer code or lookup tables otherwise. All give the same results, except for the
+ * payload bits of NaNs.
+ */
+inline void FloatToHalf(Half *dst, const float *src, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    _mm256_storeu_si256((__m256i*)(dst + i), h);
+  }
+#endif
+#if defined(__F16C__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(dst + i), h);
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  for (; i + 8 <= n; i += 8) {
+    // sign extend the 16 bit results so that the signed saturating pack keeps them as they are
+    __m128i lo = _mm_srai_epi32(_mm_slli_epi32(detail::FloatToHalf4(_mm_loadu_ps(src + i)), 16), 16);
+    __m128i hi = _mm_srai_epi32(_mm_slli_epi32(detail::FloatToHalf4(_mm_loadu_ps(src + i + 4)), 16), 16);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(lo, hi));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    vst1_u16((uint16_t*)(dst + i), vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = Half::FromBits(detail::FloatToHalfBits(src[i]));
+  }
+}
+
+}
+
+#endif // IMGPP_HALF_HPP
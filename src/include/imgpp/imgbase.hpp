@@ -4,8 +4,14 @@
 /*! \file imgbase.hpp */
 
 #include <memory>
+#include <functional>
 #include <cstdint>
 #include <cstring>
+#include <thread>
+#include <vector>
+#include <imgpp/allocator.hpp>
+#include <imgpp/copy.hpp>
+#include <imgpp/stats.hpp>
 
 namespace imgpp {
 
@@ -13,33 +19,109 @@ namespace imgpp {
 
 //! ImgBuffer uses std::shared_ptr with reference counting to hold pixel data buffers.
 //! The class destroys the smart pointer during destruction, hence reducing the reference count to the buffer by 1.
+//! Memory comes from an Allocator (DefaultAllocator() unless set otherwise) and is aligned to kDefaultAlignment.
+//!
+//! Copies of an ImgBuffer share the memory. In copy-on-write mode (SetCopyOnWrite()), a buffer that
+//! shares its memory takes a private copy before the first mutable access (non-const GetBuffer(),
+//! WriteData(), Zeros(), CopyFrom()).
 class ImgBuffer {
 public:
   ImgBuffer() : length_(0) {}
 
   //! \brief constructor setting buffer length
-  ImgBuffer(uint32_t length) {
+  //! \param length of the buffer.
+  //! \param allocator allocator serving this buffer, nullptr for DefaultAllocator().
+  ImgBuffer(uint64_t length, std::shared_ptr<Allocator> allocator = nullptr)
+    : length_(0), allocator_(std::move(allocator)) {
     SetSize(length);
   }
 
+  //! \brief constructor sharing ownership of existing memory, e.g. a file mapping.
+  //! \param data memory holding at least length bytes; its deleter runs when the last reference drops.
+  //! \param length of the buffer.
+  ImgBuffer(std::shared_ptr<uint8_t> data, uint64_t length)
+    : data_(std::move(data)), length_(length) {}
+
+  //! \brief constructor taking ownership of external memory, e.g. a capture driver frame or an arena block.
+  //! \param data memory holding at least length bytes.
+  //! \param length of the buffer.
+  //! \param deleter called once with data when the last reference to the buffer drops.
+  ImgBuffer(uint8_t *data, uint64_t length, std::function<void(uint8_t*)> deleter)
+    : data_(data, std::move(deleter)), length_(length) {}
+
+  //! \brief constructor referencing external memory owned by another object, e.g. a cv::Mat.
+  //! \param data memory holding at least length bytes.
+  //! \param length of the buffer.
+  //! \param keep_alive owner of data, released when the last reference to the buffer drops.
+  //! An empty keep_alive makes a non-owning buffer.
+  ImgBuffer(uint8_t *data, uint64_t length, const std::shared_ptr<void> &keep_alive)
+    : data_(keep_alive, data), length_(length) {}
+
   //! \brief Allocates memory of the given length, and binds it to data_.
   //! If data_ is already bound to a buffer, its reference count is reduced by 1.
   //! \param length of the buffer.
   //! \return true if succeeded, false if failed.
-  void SetSize(uint32_t length) {
+  void SetSize(uint64_t length) {
     if (length_ == length && data_.get()) {
       return;
     }
+    Allocate(length, false);
+  }
 
-    data_.reset(new uint8_t[length], std::default_delete<uint8_t[]>());
-    length_ = length;
+  //! \brief Allocates zero-filled memory of the given length, and binds it to data_.
+  //! Always takes fresh memory from the allocator, so large buffers get lazily zero-filled OS pages
+  //! instead of a memset (see Allocator::AllocateZeroed()).
+  //! \param length of the buffer.
+  void SetSizeZeroed(uint64_t length) {
+    Allocate(length, true);
   }
 
+  //! \brief Write one byte per page from num_threads threads, each covering a contiguous band.
+  //! On NUMA hosts this places the pages of each band on the node of the thread touching it
+  //! (first-touch policy). Writes zeros, so only use it on zero-filled or disposable buffers.
+  void FirstTouch(uint32_t num_threads) {
+    uint8_t *data = GetBuffer();
+    if (data == nullptr || num_threads == 0) {
+      return;
+    }
+    size_t length = (size_t)length_;
+    // bands round up to whole strides, so together they always reach the tail page
+    size_t band = ((length + num_threads - 1) / num_threads + kTouchStride - 1) / kTouchStride * kTouchStride;
+    auto touch = [data, length](size_t begin, size_t end) {
+      for (size_t i = begin; i < end && i < length; i += kTouchStride) {
+        reinterpret_cast<volatile uint8_t*>(data)[i] = 0;
+      }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(touch, band * i, band * (i + 1));
+    }
+    touch(0, band);
+    for (auto &thread: threads) {
+      thread.join();
+    }
+  }
+
+  //! \brief Set the allocator used by subsequent SetSize() calls. nullptr selects DefaultAllocator().
+  //! Memory that is already allocated is released through the allocator that created it.
+  void SetAllocator(std::shared_ptr<Allocator> allocator) {
+    allocator_ = std::move(allocator);
+  }
+
+  //! \brief Get the allocator explicitly set on this buffer, nullptr if it uses DefaultAllocator().
+  const std::shared_ptr<Allocator> &GetAllocator() const { return allocator_; }
+
   //! \brief Get length of the buffer.
-  uint32_t GetLength() const { return length_; }
+  uint64_t GetLength() const { return length_; }
 
   //! \brief Get the C-style raw pointer to the buffer. Does not affect the reference count.
-  uint8_t *GetBuffer() { return data_.get(); }
+  //! In copy-on-write mode, detaches from other owners first, see Unshare().
+  uint8_t *GetBuffer() {
+    if (cow_) {
+      Unshare();
+    }
+    return data_.get();
+  }
 
   //! \brief Get the C-style raw pointer to the buffer. Does not affect the reference count.
   const uint8_t *GetBuffer() const { return data_.get(); }
@@ -47,87 +129,202 @@ public:
   //! \brief Get a temporary shared copy of the buffer. Reference count += 1.
   std::shared_ptr<uint8_t> GetSharedBuffer() { return data_; }
 
+  //! \brief Get a view of a byte range that shares ownership of the whole buffer. No data is copied.
+  //! \param offset first byte of the range
+  //! \param length range length, offset + length must not exceed GetLength()
+  ImgBuffer SubBuffer(uint64_t offset, uint64_t length) const {
+    ImgBuffer result(std::shared_ptr<uint8_t>(data_, data_.get() + offset), length);
+    result.allocator_ = allocator_;
+    return result;
+  }
+
+  //! \brief Enable or disable copy-on-write. Copies of this buffer inherit the setting.
+  void SetCopyOnWrite(bool cow) { cow_ = cow; }
+
+  bool IsCopyOnWrite() const { return cow_; }
+
+  //! \brief Whether other buffers (or shared pointers) reference the same memory.
+  bool IsShared() const { return data_.use_count() > 1; }
+
+  //! \brief In copy-on-write mode, move shared memory to a private allocation.
+  //! \param copy_data whether to preserve the contents; false when they are about to be overwritten.
+  //! \return true if the memory moved, in which case pointers into the old memory must be rebased.
+  bool Unshare(bool copy_data = true) {
+    if (!cow_ || !data_ || data_.use_count() == 1) {
+      return false;
+    }
+    std::shared_ptr<uint8_t> shared = std::move(data_);
+    uint64_t length = length_;
+    length_ = 0;
+    SetSize(length);
+    if (copy_data) {
+      memcpy(data_.get(), shared.get(), (size_t)length);
+    }
+    return true;
+  }
+
   //! \brief Copy data from given buffer to the ImgBuffer object.
   //! \param buffer data source
   //! \param length buffer length
-  bool WriteData(const uint8_t* buffer, uint32_t length) {
+  bool WriteData(const uint8_t* buffer, uint64_t length) {
     if (length != length_) {
       return false;
     } else {
-      memcpy(data_.get(), buffer, length_ * sizeof(uint8_t));
+      Unshare(false);
+      memcpy(data_.get(), buffer, (size_t)length_);
       return true;
     }
   }
 
   //! \brief Set all pixel value to zero
   void Zeros() {
-    memset(data_.get(), 0, length_ * sizeof(uint8_t));
+    Unshare(false);
+    memset(data_.get(), 0, (size_t)length_);
   }
 
-  //! \brief Copy data from another ImgBuffer of the same size
+  //! \brief Copy data from another ImgBuffer of the same size, on the calling thread.
   void CopyFrom(const ImgBuffer &src) {
     if (length_ != src.length_) {
       SetSize(src.length_);
+    } else {
+      Unshare(false);
     }
 
-    memcpy(data_.get(), src.data_.get(), src.length_ * sizeof(uint8_t));
+    detail::CopyBytes(data_.get(), src.data_.get(), (size_t)src.length_);
   }
 
   //! \brief Create a deep copy of this ImgBuffer
   ImgBuffer Clone() {
     ImgBuffer result;
+    result.allocator_ = allocator_;
     result.CopyFrom(*this);
     return result;
   }
 
 protected:
+  enum : size_t { kTouchStride = 4096 };
+
+  void Allocate(uint64_t length, bool zeroed) {
+    // drop our reference first so that a pooling allocator can hand the same memory back
+    data_.reset();
+    length_ = 0;
+    std::shared_ptr<Allocator> allocator = allocator_ ? allocator_ : DefaultAllocator();
+    void *raw = zeroed ? allocator->AllocateZeroed((size_t)length, kDefaultAlignment)
+      : allocator->Allocate((size_t)length, kDefaultAlignment);
+    uint8_t *ptr = static_cast<uint8_t*>(raw);
+    detail::RecordAllocation(length);
+    data_.reset(ptr, [allocator, length](uint8_t *p) {
+      allocator->Deallocate(p, (size_t)length);
+      detail::RecordDeallocation(length);
+    });
+    length_ = length;
+  }
+
   std::shared_ptr<uint8_t> data_;  //!< actual memory buffer holding the data
-  uint32_t length_;  //!< buffer length
+  uint64_t length_;  //!< buffer length in bytes
+  std::shared_ptr<Allocator> allocator_;  //!< allocator for new buffers, nullptr means DefaultAllocator()
+  bool cow_{false};  //!< copy-on-write mode
 };
 
 //! \brief Img holds a 2D or 3D image using an ImgBuffer and an ImgROI.
+
+//! In copy-on-write mode (SetCopyOnWrite()), copies and Clone() share pixels until one of them is
+//! written. Mutable access goes through the non-const ROI() and Data(), which detach the image
+//! from other owners first; use CROI() for read-only access on a non-const image. ROI references
+//! and pointers obtained before a copy was made keep pointing at the shared pixels.
 template <typename TROI>
 class ImgBase {
 public:
   ImgBase() {}
   ~ImgBase() {}
 
+  //! \brief Wrap pixels already held by a buffer, e.g. one adopting external memory. No data is copied.
+  //! \param buffer buffer holding the pixels
+  //! \param roi view of the entire image, must lie inside buffer
+  ImgBase(ImgBuffer buffer, const TROI &roi): buffer_(std::move(buffer)), entire_img_(roi) {}
+
   //! \brief Deep copy from another image
   void CopyFrom(const ImgBase& src) {
+    if (&src == this) {
+      return;
+    }
     buffer_.CopyFrom(src.buffer_);
     entire_img_ = src.entire_img_;
-    entire_img_.data_ = buffer_.GetBuffer();
+    // keep the ROI's position in the buffer, e.g. the last row of a flipped view
+    entire_img_.data_ = buffer_.GetBuffer() + (src.entire_img_.data_ - src.buffer_.GetBuffer());
   }
 
-  //! \brief Create a deep copy of the current Img
+  //! \brief Create a deep copy of the current Img.
+  //! In copy-on-write mode the copy is deferred until either image is written.
   ImgBase<TROI> Clone() const {
+    if (buffer_.IsCopyOnWrite()) {
+      return *this;
+    }
     ImgBase<TROI> result;
+    result.buffer_.SetAllocator(buffer_.GetAllocator());
     result.CopyFrom(*this);
     return result;
   }
 
   //! \brief Set all pixel value to zero
   void Zeros() {
+    Unshare(false);
     buffer_.Zeros();
   }
 
+  //! \brief Enable or disable copy-on-write. Copies and clones of this image inherit the setting.
+  void SetCopyOnWrite(bool cow) {
+    buffer_.SetCopyOnWrite(cow);
+  }
+
+  bool IsCopyOnWrite() const {
+    return buffer_.IsCopyOnWrite();
+  }
+
+  //! \brief Set the allocator used when the image is (re)sized. nullptr selects DefaultAllocator().
+  void SetAllocator(std::shared_ptr<Allocator> allocator) {
+    buffer_.SetAllocator(std::move(allocator));
+  }
+
   //! \brief Returns an ROI that covers the entire image.
+  //! In copy-on-write mode, detaches the pixels from other images first.
   TROI &ROI() {
+    Unshare(true);
     return entire_img_;
   }
   const TROI &ROI() const {
     return entire_img_;
   }
 
+  //! \brief Read-only ROI, never detaches in copy-on-write mode.
+  const TROI &CROI() const {
+    return entire_img_;
+  }
+
   //! \brief Returns the member ImgBuffer object. Don't mess with this unless you know what you are doing!
+  //! In copy-on-write mode, detaches the pixels from other images first.
   ImgBuffer &Data() {
+    Unshare(true);
     return buffer_;
   }
   const ImgBuffer &Data() const {
     return buffer_;
   }
 
+  //! \brief Read-only ImgBuffer, never detaches in copy-on-write mode.
+  const ImgBuffer &CData() const {
+    return buffer_;
+  }
+
 protected:
+  //! Detach the buffer in copy-on-write mode and rebase the ROI onto the new memory.
+  void Unshare(bool copy_data) {
+    const uint8_t *old_data = static_cast<const ImgBuffer&>(buffer_).GetBuffer();
+    if (buffer_.Unshare(copy_data)) {
+      entire_img_.data_ = buffer_.GetBuffer() + (entire_img_.data_ - old_data);
+    }
+  }
+
   ImgBuffer buffer_;  //!< image buffer
   TROI entire_img_;  //!< ROI covering entire image
 };
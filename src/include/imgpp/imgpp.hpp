@@ -3,12 +3,15 @@
 
 /*! \file imgpp.hpp */
 
+#include <cstdlib>
 #include <imgpp/imgbase.hpp>
 namespace imgpp {
 
   //! ImgROI is a view into a ImgBuffer or a plain C-style buffer.
 
   //! ImgROI doesn't "own" the buffer memory, hence the user must make sure the pointer buffer_ is valid before accesing data.
+  //! The pitch is signed: with a negative pitch, data_ points to the last row in memory and rows
+  //! are visited from the end of the buffer backwards, see FlipVertical().
   class ImgROI {
   public:
     //! Give access to member variables only to the class Img for operations like Reshape()
@@ -22,12 +25,12 @@ namespace imgpp {
 
     //! Constructor for a 2D image with known dimension.
     ImgROI(uint8_t *src, uint32_t w, uint32_t h, uint32_t c,
-      uint32_t bpc, uint32_t pitch, bool is_float, bool is_signed) :
-      ImgROI(src, w, h, 1, c, bpc, pitch, pitch * h, is_float, is_signed) {}
+      uint32_t bpc, int64_t pitch, bool is_float, bool is_signed) :
+      ImgROI(src, w, h, 1, c, bpc, pitch, (uint64_t)std::abs(pitch) * h, is_float, is_signed) {}
 
     //! Constructor for a 3D image with known dimension.
     ImgROI(uint8_t *src, uint32_t w, uint32_t h, uint32_t depth, uint32_t c,
-      uint32_t bpc, uint32_t pitch,  uint32_t slice_pitch, bool is_float, bool is_signed) :
+      uint32_t bpc, int64_t pitch, uint64_t slice_pitch, bool is_float, bool is_signed) :
       data_(src), width_(w), height_(h), channel_(c), depth_(depth), bpc_(bpc),
       is_signed_(is_signed), is_float_(is_float), pitch_(pitch), slice_pitch_(slice_pitch) {}
 
@@ -65,16 +68,27 @@ namespace imgpp {
       return new_roi;
     }
 
+    //! \brief Vertically flipped view of the same pixels, with the pitch negated.
+    //! O(1), no pixel is moved: row y of the result is row Height() - 1 - y of this ROI, in every slice.
+    ImgROI FlipVertical() const {
+      ImgROI flipped(*this);
+      if (height_ > 0) {
+        flipped.data_ = data_ + (int64_t)(height_ - 1) * pitch_;
+        flipped.pitch_ = -pitch_;
+      }
+      return flipped;
+    }
+
     //! \brief Pitch calculator.
     //! \param w the width of the region.
     //! \param c the number of channels the image has
     //! \param bpc bit-depth (bits per channel, NOT bytes!)
     //! \param alignment memory alignment of the starts of each row (e.g. BMPs are aligned to 4 bytes).
     //! 0 or 1 means no alignment (or aligned to bytes).
-    static uint32_t CalcPitch(
+    static uint64_t CalcPitch(
       uint32_t w, uint32_t c, uint32_t bpc,
       uint8_t alignment = 1) {
-      return (((c * bpc * w) >> 3) + (alignment - 1)) / alignment * alignment;
+      return ((((uint64_t)c * bpc * w) >> 3) + (alignment - 1)) / alignment * alignment;
     }
 
     //! \brief 2D Accessor. Returns a reference to the pixel channel.
@@ -84,19 +98,19 @@ namespace imgpp {
     //! and doesn't affect the location it accesses.
     //! \sa PtrAt()
     template<typename T> T &At(uint32_t x, uint32_t y, uint32_t c) {
-      return *(T*)(data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
+      return *(T*)(data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
     }
 
     template<typename T> const T &At(uint32_t x, uint32_t y, uint32_t c) const {
-      return *(T*)(data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
+      return *(T*)(data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
     }
 
     template<typename T> T &At(uint32_t x, uint32_t y) {
-      return *(T*)(data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3));
+      return *(T*)(data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3));
     }
 
     template<typename T> const T &At(uint32_t x, uint32_t y) const {
-      return *(T*)(data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3));
+      return *(T*)(data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3));
     }
 
     //! \brief 2D Accessor. Returns a void * pointer to the pixel channel.
@@ -104,19 +118,19 @@ namespace imgpp {
     //! These pointer accessors don't require a type template parameter.
     //! \sa Ptr()
     void *PtrAt(uint32_t x, uint32_t y, uint32_t c) {
-      return data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
+      return data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
     }
 
     const void *PtrAt(uint32_t x, uint32_t y, uint32_t c) const {
-      return data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
+      return data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
     }
 
     void *PtrAt(uint32_t x, uint32_t y) {
-      return data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3);
+      return data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3);
     }
 
     const void *PtrAt(uint32_t x, uint32_t y) const {
-      return data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3);
+      return data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3);
     }
 
     //! \brief 2D Pixel Accessor. Returns all channels of a pixel.
@@ -124,7 +138,7 @@ namespace imgpp {
     //! Convenient function for getting values of an entire pixel.
     template<typename TPt, typename TValue = typename TPt::value_type>
     TPt Pixel(uint32_t x, uint32_t y) const {
-      auto base = data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3);
+      auto base = data_ + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3);
       TPt pt;
       for (uint32_t c = 0; c < channel_; c++) {
         pt[c] = static_cast<typename TPt::value_type>(*(TValue *)(base + c * (bpc_ >> 3)));
@@ -141,13 +155,13 @@ namespace imgpp {
     template<typename T>
     T &At(uint32_t x, uint32_t y, uint32_t z, uint32_t c) {
       return *(T*)(data_ + z * slice_pitch_ +
-        y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
+        y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
     }
 
     template<typename T>
     const T &At(uint32_t x, uint32_t y, uint32_t z, uint32_t c) const {
       return *(T*)(data_ + z * slice_pitch_
-        + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
+        + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
     }
 
     //! \brief 3D Accessor. Returns a void * pointer to the pixel channel.
@@ -156,12 +170,12 @@ namespace imgpp {
     //! \sa Ptr()
     void *PtrAt(uint32_t x, uint32_t y, uint32_t z, uint32_t c) {
       return data_ + z * slice_pitch_
-        + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
+        + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
     }
 
     const void *PtrAt(uint32_t x, uint32_t y, uint32_t z, uint32_t c) const {
       return data_ + z * slice_pitch_
-        + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
+        + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3);
     }
 
     //! \brief 3D Pixel Accessor. Returns all channels of a pixel.
@@ -170,7 +184,7 @@ namespace imgpp {
     template<typename TPt, typename TValue = typename TPt::value_type>
     TPt Pixel(uint32_t x, uint32_t y, uint32_t z) const {
       auto base = data_ + z * slice_pitch_
-      + y * pitch_ + x * ((bpc_ * channel_) >> 3);
+      + y * pitch_ + (size_t)x * ((bpc_ * channel_) >> 3);
       TPt pt;
       for (uint32_t c = 0; c < channel_; c++) {
         pt[c] = static_cast<typename TPt::value_type>(*(TValue *)(base + c * (bpc_ >> 3)));
@@ -198,11 +212,11 @@ namespace imgpp {
     //! \brief return the BIT-per-channel number of the current image
     uint8_t BPC() const { return bpc_; }
 
-    //! \brief return current image pitch (i.e. bytes from one row to the next)
-    uint32_t Pitch() const { return pitch_; }
+    //! \brief return current image pitch (i.e. bytes from one row to the next), negative for flipped views
+    int64_t Pitch() const { return pitch_; }
 
     //! \brief return current image slice pitch (i.e. bytes from one frame to the next)
-    uint32_t SlicePitch() const { return slice_pitch_; }
+    uint64_t SlicePitch() const { return slice_pitch_; }
 
     //! \brief return if the data is signed
     bool IsSigned() const { return is_signed_; }
@@ -230,31 +244,60 @@ namespace imgpp {
     uint8_t bpc_; //!<bit-depth (bits per channel, NOT bytes)
     bool is_signed_; //!<Signed/unsigned flag for integer types. Is true for floats.
     bool is_float_; //!<Flag for float types.
-    uint32_t pitch_; //!<Distance in bytes between consecutive lines
-    uint32_t slice_pitch_; //!<Distance in bytes between consecutive slices
+    int64_t pitch_; //!<Distance in bytes between consecutive lines, negative if rows go backwards in memory
+    uint64_t slice_pitch_; //!<Distance in bytes between consecutive slices
   };
 
+  namespace detail {
+    //! CopyData() body, on the calling thread or, given one, split across an executor
+    template<typename... TExecutor>
+    bool CopyROI(ImgROI &dst, const ImgROI &src, TExecutor&... executor) {
+      if (src.Width() > dst.Width() || src.Height() > dst.Height()
+        || src.Depth() > dst.Depth() || src.BPC() != dst.BPC()
+        || src.Channel() != dst.Channel()) {
+        return false;
+      }
+
+      size_t src_length = (size_t)ImgROI::CalcPitch(src.Width(), src.Channel(), src.BPC());
+      int64_t length = (int64_t)src_length;
+      uint64_t slice_length = src_length * src.Height();
+      bool contiguous = src.Pitch() == length && dst.Pitch() == length
+        && (src.Depth() == 1 || (src.SlicePitch() == slice_length && dst.SlicePitch() == slice_length));
+      if (contiguous) {
+        CopyBytes(dst.GetData(), src.GetData(), (size_t)(slice_length * src.Depth()), executor...);
+        return true;
+      }
+      uint32_t h = src.Height();
+      CopyRows((uint64_t)h * src.Depth(), src_length,
+        [&dst, h](uint64_t row) { return dst.PtrAt(0, (uint32_t)(row % h), (uint32_t)(row / h), 0); },
+        [&src, h](uint64_t row) { return src.PtrAt(0, (uint32_t)(row % h), (uint32_t)(row / h), 0); },
+        executor...);
+      return true;
+    }
+  }
+
   /*! \fn bool CopyData(ImgROI &dst, const ImgROI &src)
       \brief Copy rows from source ROI to destination ROI.
-      Padding and pitch of the destination ROI is kept.
+      Padding and pitch of the destination ROI is kept. When neither ROI has padding between the
+      copied rows and slices, the rows are copied as one span. Runs on the calling thread; large
+      copies bypass the cache, see copy.hpp.
       \param dst Target ROI.
       \param src Source ROI.
       \return true if succeeded, false if dimension doesn't match.
   */
   inline bool CopyData(ImgROI &dst, const ImgROI &src) {
-    if (src.Width() > dst.Width() || src.Height() > dst.Height()
-      || src.Depth() > dst.Depth() || src.BPC() != dst.BPC()
-      || src.Channel() != dst.Channel()) {
-      return false;
-    }
+    return detail::CopyROI(dst, src);
+  }
 
-    uint32_t src_length = ImgROI::CalcPitch(src.Width(), src.Channel(), src.BPC());
-    for (uint32_t layer = 0; layer < src.Depth(); ++layer) {
-      for (uint32_t y = 0; y < src.Height(); ++y) {
-        memcpy(dst.PtrAt(0, y, layer, 0), src.PtrAt(0, y, layer, 0), src_length);
-      }
-    }
-    return true;
+  /*! \fn bool CopyData(ImgROI &dst, const ImgROI &src, Executor &executor)
+      \brief CopyData() with copies of at least kParallelCopyBytes split across executor.
+      \param dst Target ROI.
+      \param src Source ROI.
+      \param executor executor running the parts of large copies, e.g. DefaultThreadPool().
+      \return true if succeeded, false if dimension doesn't match.
+  */
+  inline bool CopyData(ImgROI &dst, const ImgROI &src, Executor &executor) {
+    return detail::CopyROI(dst, src, executor);
   }
 
   //! Img holds a 2D or 3D image using an ImgBuffer and an ImgROI.
@@ -263,6 +306,10 @@ namespace imgpp {
     Img() {}
     Img(ImgBase base): ImgBase(std::move(base)) {}
     ~Img() {}
+
+    //! Wraps pixels already held by buffer, described by roi. No data is copied.
+    Img(ImgBuffer buffer, const ImgROI &roi): ImgBase(std::move(buffer), roi) {}
+
     Img(uint32_t w, uint32_t h, uint32_t depth, uint32_t c, uint32_t bpc,
       bool is_float = false, bool is_signed = false, uint8_t alignment = 1) {
       SetSize(w, h, depth, c, bpc, is_float, is_signed, alignment);
@@ -276,14 +323,16 @@ namespace imgpp {
     void SetSize(uint32_t w, uint32_t h, uint32_t depth,
       uint32_t c, uint32_t bpc,
       bool is_float = false, bool is_signed = false, uint8_t alignment = 1) {
-      if (w == 0 || h == 0 || depth == 0 || c == 0 || bpc == 0) {
-        return;
-      }
-      uint32_t pitch = ImgROI::CalcPitch(w, c, bpc, alignment);
-      uint32_t slice_pitch = pitch * h;
-      buffer_.SetSize(slice_pitch * depth);
-      entire_img_ = ImgROI(buffer_.GetBuffer(), w, h,
-        depth, c, bpc, pitch, slice_pitch, is_float, is_signed);
+      Resize(w, h, depth, c, bpc, is_float, is_signed, alignment, false);
+    }
+
+    //! Same as SetSize(), but always allocates fresh zero-filled memory.
+    //! Large buffers get lazily zeroed pages from the OS instead of a memset,
+    //! see Allocator::AllocateZeroed().
+    void SetSizeZeroed(uint32_t w, uint32_t h, uint32_t depth,
+      uint32_t c, uint32_t bpc,
+      bool is_float = false, bool is_signed = false, uint8_t alignment = 1) {
+      Resize(w, h, depth, c, bpc, is_float, is_signed, alignment, true);
     }
 
     //! Allocates memory and creates an ROI for the entire image,
@@ -304,7 +353,7 @@ namespace imgpp {
     //! \return true if succeeded, false if dimension don't match.
     bool ReShape(uint32_t w, uint32_t h, uint32_t depth,
       uint32_t c, uint32_t bpc, uint8_t alignment = 1) {
-      uint32_t new_pitch = ImgROI::CalcPitch(w, c, bpc, alignment);
+      uint64_t new_pitch = ImgROI::CalcPitch(w, c, bpc, alignment);
       if (new_pitch * h * depth != buffer_.GetLength()) {  //doesn't match original size
         return false;
       }
@@ -327,22 +376,47 @@ namespace imgpp {
     //! Deep copy from an ROI, ignoring the original pitch and alignment
     bool CopyFrom(const ImgROI &src_roi, uint8_t alignment = 1) {
       SetSizeLike(src_roi, alignment);
+      Unshare(false);
       return CopyData(entire_img_, src_roi);
     }
+
+  private:
+    void Resize(uint32_t w, uint32_t h, uint32_t depth, uint32_t c, uint32_t bpc,
+      bool is_float, bool is_signed, uint8_t alignment, bool zeroed) {
+      if (w == 0 || h == 0 || depth == 0 || c == 0 || bpc == 0) {
+        return;
+      }
+      uint64_t pitch = ImgROI::CalcPitch(w, c, bpc, alignment);
+      uint64_t slice_pitch = pitch * h;
+      if (zeroed) {
+        buffer_.SetSizeZeroed(slice_pitch * depth);
+      } else {
+        buffer_.SetSize(slice_pitch * depth);
+        buffer_.Unshare(false);  // contents are undefined after resizing
+      }
+      entire_img_ = ImgROI(buffer_.GetBuffer(), w, h,
+        depth, c, bpc, pitch, slice_pitch, is_float, is_signed);
+    }
   };
 
+  //! Creates a zero-filled image. Large images are not memset: their pages are zeroed lazily by
+  //! the OS on first access. touch_threads > 0 touches every page up front from that many threads,
+  //! so that on multi-socket hosts the pages are spread over the nodes of the threads that will
+  //! later process the matching bands of rows.
   inline Img Zeros(uint32_t w, uint32_t h, uint32_t depth, uint32_t c, uint32_t bpc,
-    bool is_float = false, bool is_signed = false, uint8_t alignment = 1) {
-    Img result(w, h, depth, c, bpc, is_float, is_signed, alignment);
-    result.Zeros();
+    bool is_float = false, bool is_signed = false, uint8_t alignment = 1,
+    uint32_t touch_threads = 0) {
+    Img result;
+    result.SetSizeZeroed(w, h, depth, c, bpc, is_float, is_signed, alignment);
+    if (touch_threads > 0) {
+      result.Data().FirstTouch(touch_threads);
+    }
     return result;
   }
 
-  inline Img ZerosLike(const ImgROI &src_roi) {
-    Img result;
-    result.SetSizeLike(src_roi);
-    result.Zeros();
-    return result;
+  inline Img ZerosLike(const ImgROI &src_roi, uint32_t touch_threads = 0) {
+    return Zeros(src_roi.Width(), src_roi.Height(), src_roi.Depth(), src_roi.Channel(),
+      src_roi.BPC(), src_roi.IsFloat(), src_roi.IsSigned(), 1, touch_threads);
   }
 
   /*! \fn bool Add2DBorder(Img &dst, const ImgROI &src, uint32_t border_size, uint8_t align_byte = 1)
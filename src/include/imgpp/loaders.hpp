@@ -9,7 +9,18 @@ namespace imgpp {
 
   class Img;
   class ImgROI;
+  class ImgBuffer;
   class CompositeImg;
+
+  //! \brief Map a file into memory as a private, copy-on-write ImgBuffer.
+  //!
+  //! Pages are read lazily and shared with the page cache (and other processes mapping the
+  //! same file) until written to. The mapping is released with the last reference to the buffer.
+  //! The file must not be truncated while it is mapped.
+  //! \param fn file full path
+  //! \param buffer output buffer owning the mapping
+  bool MapFile(const char *fn, ImgBuffer &buffer);
+
   //! \brief Load netbpm PPM format images.
   //!
   //! Although http://netpbm.sourceforge.net/doc/pgm.html and http://netpbm.sourceforge.net/doc/ppm.html
@@ -92,9 +103,19 @@ namespace imgpp {
   //! \param buffer bson data buffer
   //! \param length bson data buffer size
   //! \param img output imgpp::Img object filled with load data
-  bool LoadBSON(const char *buffer, uint32_t length, Img &img);
+  bool LoadBSON(const char *buffer, size_t length, Img &img);
+
+  //! \brief Deserialize Img from a memory buffer without copying the pixel data.
+  //!
+  //! The loaded image shares ownership of buffer (e.g. one returned by MapFile()) and its ROI
+  //! points straight into it. Pixel data that doesn't start on a kDefaultAlignment boundary
+  //! gets copied instead, like LoadBSON(const char*, size_t, Img&) does.
+  //! \param buffer bson data buffer
+  //! \param img output imgpp::Img object filled with load data
+  bool LoadBSON(const ImgBuffer &buffer, Img &img);
 
   //! \brief Serialize an image to a bson data buffer.
+  //! Fails for images whose document would exceed the 2 GiB int32 length of a bson document.
   //! \param img imgpp::Img to serialize
   //! \param bson output char buffer containing the serialized binary data
   bool WriteBSON(const Img &img, std::string &bson);
@@ -123,23 +144,42 @@ namespace imgpp {
   //! \param length length of the input buffer
   //! \param CompositeImg output imgpp::CompositeImg object filled with load data
   //! \param custom_data output std::unordered_map<std::string, string> object filled with kv data
-  //! \param bottom_first whether the loaded image data in memory is bottom first
+  //! \param bottom_first whether the loaded image data in memory is bottom first. Free for uncompressed
+  //! formats: the ROIs are flipped views (negative pitch) of the unmodified rows. Fails for compressed formats.
   bool LoadKTX(const char *src, size_t length, CompositeImg &img,
     std::unordered_map<std::string, std::string> &custom_data, bool bottom_first);
 
+  //! \brief Load Khronos KTX1 format images from a memory buffer without copying the image data.
+  //!
+  //! The CompositeImg keeps a reference to buffer (e.g. one returned by MapFile()) and all of its
+  //! ROIs point straight into it. Image data that doesn't start on a kDefaultAlignment boundary
+  //! (key/value data of other lengths moves it) gets copied instead.
+  //! \param buffer input buffer containing the ktx data (including the headers)
+  //! \param CompositeImg output imgpp::CompositeImg object filled with load data
+  //! \param custom_data output std::unordered_map<std::string, string> object filled with kv data
+  //! \param bottom_first whether the loaded image data in memory is bottom first. Free for uncompressed
+  //! formats: the ROIs are flipped views (negative pitch) of the unmodified rows. Fails for compressed formats.
+  bool LoadKTX(const ImgBuffer &buffer, CompositeImg &img,
+    std::unordered_map<std::string, std::string> &custom_data, bool bottom_first);
+
   //! \brief Load Khronos KTX1 format images.
+  //!
+  //! The file is memory mapped and, where it is aligned (see above), the image data is not copied.
   //! \param fn ktx file full path
   //! \param CompositeImg output imgpp::CompositeImg object filled with load data
   //! \param custom_data output std::unordered_map<std::string, string> object filled with kv data
-  //! \param bottom_first whether the loaded image data in memory is bottom first
+  //! \param bottom_first whether the loaded image data in memory is bottom first. Free for uncompressed
+  //! formats: the ROIs are flipped views (negative pitch) of the unmodified rows. Fails for compressed formats.
   bool LoadKTX(const char *fn, CompositeImg &img,
     std::unordered_map<std::string, std::string> &custom_data, bool bottom_first);
 
   //! \brief Save Khronos KTX1 format images to .ktx file.
+  //! Fails, without creating the file, if a level is too large for its 32-bit imageSize.
   //! \param fn ktx file full path
   //! \param CompositeImg input imgpp::CompositeImg object filled with load data
   //! \param custom_data input std::unordered_map<std::string, string> object filled with kv data
-  //! \param bottom_first whether the loaded image data in memory is bottom first
+  //! \param bottom_first whether rows are written bottom first, i.e. the file is vertically flipped.
+  //! Not supported for compressed formats.
   bool WriteKTX(const char *fn, const CompositeImg &img,
     const std::unordered_map<std::string, std::string> &custom_data, bool bottom_first);
 }
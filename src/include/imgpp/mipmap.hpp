@@ -0,0 +1,303 @@
+#ifndef IMGPP_MIPMAP_HPP
+#define IMGPP_MIPMAP_HPP
+
+/*! \file mipmap.hpp
+ *  \brief Mipmap chain generation for CompositeImg.
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/compositeimg.hpp>
+#include <imgpp/resize.hpp>
+#include <imgpp/texturedesc.hpp>
+#include <imgpp/texturehelper.hpp>
+
+namespace imgpp {
+
+//! \brief Number of levels of a full mipmap chain, down to 1x1x1.
+inline uint32_t MipmapLevels(uint32_t width, uint32_t height, uint32_t depth = 1) {
+  uint32_t size = std::max(std::max(width, height), depth);
+  uint32_t levels = 1;
+  while (size > 1) {
+    size >>= 1;
+    levels++;
+  }
+  return levels;
+}
+
+namespace detail {
+
+/**
+ * @brief Average 2 pixels from each of n rows (2 or 4) of 8 bit pixels, rounded to nearest.
+ * @details Sums stay in 16 bits, so the SSE2 paths add whole rows before pairing the pixels.
+ */
+template<uint32_t C>
+void HalveRowsU8(uint8_t *dst, const uint8_t *const *rows, uint32_t n, uint32_t dst_w) {
+  uint32_t shift = n == 2 ? 2 : 3;
+  uint32_t x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  __m128i zero = _mm_setzero_si128();
+  __m128i round = _mm_set1_epi16((short)n);
+  if constexpr (C == 4) {
+    // 4 output pixels from 8 source pixels of every row
+    for (; x + 4 <= dst_w; x += 4) {
+      __m128i s01 = zero, s23 = zero, s45 = zero, s67 = zero;
+      for (uint32_t r = 0; r < n; r++) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(rows[r] + x * 8));
+        __m128i b = _mm_loadu_si128((const __m128i*)(rows[r] + x * 8 + 16));
+        s01 = _mm_add_epi16(s01, _mm_unpacklo_epi8(a, zero));
+        s23 = _mm_add_epi16(s23, _mm_unpackhi_epi8(a, zero));
+        s45 = _mm_add_epi16(s45, _mm_unpacklo_epi8(b, zero));
+        s67 = _mm_add_epi16(s67, _mm_unpackhi_epi8(b, zero));
+      }
+      __m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+      __m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+      lo = _mm_srli_epi16(_mm_add_epi16(lo, round), (int)shift);
+      hi = _mm_srli_epi16(_mm_add_epi16(hi, round), (int)shift);
+      _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(lo, hi));
+    }
+  } else if constexpr (C == 1) {
+    // 8 output pixels, the even and odd bytes of 16 bit lanes
+    __m128i mask = _mm_set1_epi16(0xff);
+    for (; x + 8 <= dst_w; x += 8) {
+      __m128i sum = round;
+      for (uint32_t r = 0; r < n; r++) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(rows[r] + x * 2));
+        sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8)));
+      }
+      sum = _mm_srli_epi16(sum, (int)shift);
+      _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(sum, sum));
+    }
+  }
+#endif
+  for (; x < dst_w; x++) {
+    for (uint32_t c = 0; c < C; c++) {
+      uint32_t sum = n;
+      for (uint32_t r = 0; r < n; r++) {
+        sum += rows[r][x * 2 * C + c] + rows[r][x * 2 * C + C + c];
+      }
+      dst[x * C + c] = (uint8_t)(sum >> shift);
+    }
+  }
+}
+
+//! Average 2 pixels from each of n rows (2 or 4) of float pixels.
+template<uint32_t C>
+void HalveRowsF32(float *dst, const float *const *rows, uint32_t n, uint32_t dst_w) {
+  float scale = 0.5f / n;
+  uint32_t x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  if constexpr (C == 4) {
+    __m128 s = _mm_set1_ps(scale);
+    for (; x < dst_w; x++) {
+      __m128 sum = _mm_setzero_ps();
+      for (uint32_t r = 0; r < n; r++) {
+        sum = _mm_add_ps(sum, _mm_add_ps(_mm_loadu_ps(rows[r] + x * 8), _mm_loadu_ps(rows[r] + x * 8 + 4)));
+      }
+      _mm_storeu_ps(dst + x * 4, _mm_mul_ps(sum, s));
+    }
+  }
+#endif
+  for (; x < dst_w; x++) {
+    for (uint32_t c = 0; c < C; c++) {
+      float sum = 0.0f;
+      for (uint32_t r = 0; r < n; r++) {
+        sum += rows[r][x * 2 * C + c] + rows[r][x * 2 * C + C + c];
+      }
+      dst[x * C + c] = sum * scale;
+    }
+  }
+}
+
+//! Average 2 pixels from each of n rows (2 or 4) of 8 bit sRGB pixels, decoded as they are read.
+template<uint32_t C>
+void HalveRowsSRGB(float *dst, const uint8_t *const *rows, uint32_t n, uint32_t dst_w) {
+  const SRGBTables &t = GetSRGBTables();
+  float scale = 0.5f / n;
+  for (uint32_t x = 0; x < dst_w; x++) {
+    for (uint32_t c = 0; c < C; c++) {
+      const float *table = C == 4 && c == 3 ? t.alpha : t.to_linear;
+      float sum = 0.0f;
+      for (uint32_t r = 0; r < n; r++) {
+        sum += table[rows[r][x * 2 * C + c]] + table[rows[r][x * 2 * C + C + c]];
+      }
+      dst[x * C + c] = sum * scale;
+    }
+  }
+}
+
+/**
+ * @brief The 2x2 (2x2x2 if halve_z) box filter of the output rows [y0, y1) of slices [z0, z1),
+ * for source sizes of exactly twice the output.
+ * @details 8 bit data is averaged in integers and sRGB data in linear floats straight from the
+ * decoding table; other types are decoded to floats one source row at a time.
+ */
+template<ChannelType T, uint32_t C, bool kSRGB>
+void HalveBand(ImgROI &dst, const ImgROI &src, bool halve_z, uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  uint32_t n = halve_z ? 4 : 2;
+  size_t src_len = (size_t)src.Width() * C;
+  size_t dst_len = (size_t)dst.Width() * C;
+  constexpr bool kInteger = T == ChannelType::U8 && !kSRGB;
+  std::vector<float> decoded(kInteger || kSRGB ? 0 : src_len * n);
+  std::vector<float> out(kInteger ? 0 : dst_len);
+  const void *rows[4];
+  const float *float_rows[4];
+  for (uint32_t z = z0; z < z1; z++) {
+    for (uint32_t y = y0; y < y1; y++) {
+      for (uint32_t r = 0; r < n; r++) {
+        rows[r] = src.PtrAt(0, 2 * y + r % 2, halve_z ? 2 * z + r / 2 : z, 0);
+      }
+      void *dst_row = dst.PtrAt(0, y, z, 0);
+      if constexpr (kInteger) {
+        HalveRowsU8<C>((uint8_t*)dst_row, (const uint8_t *const *)rows, n, dst.Width());
+      } else if constexpr (kSRGB) {
+        HalveRowsSRGB<C>(out.data(), (const uint8_t *const *)rows, n, dst.Width());
+        EncodeSRGBRow<C>((uint8_t*)dst_row, out.data(), dst_len);
+      } else {
+        for (uint32_t r = 0; r < n; r++) {
+          float_rows[r] = DecodeResizeRow<T>(rows[r], src_len, decoded.data() + r * src_len);
+        }
+        HalveRowsF32<C>(out.data(), float_rows, n, dst.Width());
+        EncodeResizeRow<T>(dst_row, out.data(), dst_len);
+      }
+    }
+  }
+}
+
+template<ChannelType T, bool kSRGB>
+void HalveBand(ImgROI &dst, const ImgROI &src, bool halve_z, uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  switch (src.Channel()) {
+  case 1: HalveBand<T, 1, kSRGB>(dst, src, halve_z, y0, y1, z0, z1); break;
+  case 2: HalveBand<T, 2, kSRGB>(dst, src, halve_z, y0, y1, z0, z1); break;
+  case 3: HalveBand<T, 3, kSRGB>(dst, src, halve_z, y0, y1, z0, z1); break;
+  default: HalveBand<T, 4, kSRGB>(dst, src, halve_z, y0, y1, z0, z1); break;
+  }
+}
+
+inline void HalveBand(bool srgb, ImgROI &dst, const ImgROI &src, bool halve_z,
+  uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  switch (GetChannelType(src)) {
+  case ChannelType::U8:
+    if (srgb) {
+      HalveBand<ChannelType::U8, true>(dst, src, halve_z, y0, y1, z0, z1);
+    } else {
+      HalveBand<ChannelType::U8, false>(dst, src, halve_z, y0, y1, z0, z1);
+    }
+    break;
+  case ChannelType::U16: HalveBand<ChannelType::U16, false>(dst, src, halve_z, y0, y1, z0, z1); break;
+  case ChannelType::F16: HalveBand<ChannelType::F16, false>(dst, src, halve_z, y0, y1, z0, z1); break;
+  default: HalveBand<ChannelType::F32, false>(dst, src, halve_z, y0, y1, z0, z1); break;
+  }
+}
+
+}
+
+/**
+ * @brief Fill mipmap levels 1 and up of every layer and face, each from the level above it.
+ * @details The default box filter averages 2x2 pixels, 2x2x2 for 3D textures. Odd sizes are
+ * filtered by exact pixel coverage, e.g. 3 source pixels weighted 0.4, 0.4 and 0.2, so no
+ * row or column is dropped or counts twice. KAISER is sharper and keeps more detail in the
+ * small levels, but costs an order of magnitude more. Color channels of sRGB formats
+ * (IsSRGBFormat()) are filtered in linear space, alpha as it is. All the faces of a level are
+ * filtered together, in row bands on executor.
+ *
+ * @param img uncompressed image whose levels all have data, e.g. after SetSize() and
+ * Allocate(), with level 0 filled in. Levels are sized as SetSize() does.
+ * @param filter downsampling filter, BOX or KAISER for most uses.
+ * @param executor executor running the row bands, DefaultThreadPool() if not specified.
+ * @return false for compressed formats, formats Resize() doesn't support, or levels without data.
+ */
+inline bool GenerateMipmaps(CompositeImg &img, ResizeFilter filter = ResizeFilter::BOX,
+  Executor &executor = DefaultThreadPool()) {
+  if (img.TexDesc().format == FORMAT_UNDEFINED || img.IsCompressed() || img.Levels() == 0) {
+    return false;
+  }
+  uint32_t faces = img.Layers() * img.Faces();
+  if (faces == 0 || !detail::IsResizable(img.ROI(0, 0, 0))) {
+    return false;
+  }
+  for (uint32_t level = 0; level < img.Levels(); ++level) {
+    for (uint32_t i = 0; i < faces; ++i) {
+      if (img.ROI(level, i / img.Faces(), i % img.Faces()).GetData() == nullptr) {
+        return false;
+      }
+    }
+  }
+  bool srgb = IsSRGBFormat(img.TexDesc().format) && GetChannelType(img.ROI(0, 0, 0)) == ChannelType::U8;
+
+  for (uint32_t level = 1; level < img.Levels(); ++level) {
+    const ImgROI &src = img.ROI(level - 1, 0, 0);
+    const ImgROI &dst = img.ROI(level, 0, 0);
+    // the 2x2 box of even sizes has its own kernels, everything else goes through Resize()
+    bool halve = filter == ResizeFilter::BOX && src.Width() == 2 * dst.Width()
+      && src.Height() == 2 * dst.Height() && (src.Depth() == 2 * dst.Depth() || src.Depth() == 1);
+    detail::ResizeAxis ax, ay, az;
+    if (!halve) {
+      ax = detail::MakeResizeAxis(src.Width(), dst.Width(), filter);
+      ay = detail::MakeResizeAxis(src.Height(), dst.Height(), filter);
+      az = detail::MakeResizeAxis(src.Depth(), dst.Depth(), filter);
+    }
+    uint32_t depth = dst.Depth();
+    // the slices of all faces are banded as one volume
+    auto band = [&](uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+      for (uint32_t z = z0; z < z1; ++z) {
+        uint32_t i = z / depth;
+        ImgROI &level_dst = img.ROI(level, i / img.Faces(), i % img.Faces());
+        const ImgROI &level_src = img.ROI(level - 1, i / img.Faces(), i % img.Faces());
+        if (halve) {
+          detail::HalveBand(srgb, level_dst, level_src, src.Depth() > 1, y0, y1, z % depth, z % depth + 1);
+        } else {
+          detail::ResizeBand(srgb, level_dst, level_src, ax, ay, az, y0, y1, z % depth, z % depth + 1);
+        }
+      }
+    };
+    uint64_t values = (uint64_t)dst.Width() * dst.Height() * depth * faces * dst.Channel();
+    if (values >= detail::kParallelResizeValues) {
+      detail::ForEachBand(dst.Height(), depth * faces, executor, band);
+    } else {
+      band(0, dst.Height(), 0, depth * faces);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Build a texture with a full mipmap chain from a single image.
+ * @details Sizes dst for MipmapLevels() levels, allocates them in one buffer, copies src into
+ * level 0 and fills the rest with GenerateMipmaps(). The result can go straight to WriteKTX().
+ *
+ * @param dst receives the texture.
+ * @param src level 0, laid out as desc.format (channels, bits per channel and type). Only
+ * TARGET_3D textures take more than one slice.
+ * @param desc format and target of the texture, desc.mipmap is set.
+ * @param filter downsampling filter, see GenerateMipmaps().
+ * @param executor executor running the row bands, DefaultThreadPool() if not specified.
+ * @return false if src doesn't match desc, or GenerateMipmaps() fails.
+ */
+inline bool MakeMipmaps(CompositeImg &dst, const ImgROI &src, TextureDesc desc,
+  ResizeFilter filter = ResizeFilter::BOX, Executor &executor = DefaultThreadPool()) {
+  if (desc.format == FORMAT_UNDEFINED || IsCompressedFormat(desc.format)
+    || (src.Depth() > 1 && !IsTarget3d(desc.target))) {
+    return false;
+  }
+  const auto &pixel_desc = GetPixelDesc(desc.format);
+  if (src.Channel() != std::get<0>(pixel_desc) || src.BPC() != std::get<1>(pixel_desc)
+    || src.IsSigned() != std::get<3>(pixel_desc) || src.IsFloat() != std::get<4>(pixel_desc)) {
+    return false;
+  }
+  // rows aligned to both the 4 bytes KTX wants and the packed size of the format (SetSize needs that)
+  uint8_t packed_bytes = std::get<2>(pixel_desc);
+  uint8_t alignment = (uint8_t)std::lcm<uint32_t>(4, packed_bytes);
+  desc.mipmap = true;
+  dst.SetSize(desc, MipmapLevels(src.Width(), src.Height(), src.Depth()), 1, 1,
+    src.Width(), src.Height(), src.Depth(), alignment);
+  if (!dst.Allocate() || !CopyData(dst.ROI(0, 0, 0), src, executor)) {
+    return false;
+  }
+  return GenerateMipmaps(dst, filter, executor);
+}
+
+}
+
+#endif // IMGPP_MIPMAP_HPP
@@ -2,6 +2,7 @@
 #define IMGPP_OPENCVBINDING_HPP
 
 #include "imgpp.hpp"
+#include <memory>
 #include <opencv2/core.hpp>
 
 namespace imgpp {
@@ -82,10 +83,14 @@ namespace imgpp {
     if (depth < 0) {
       throw std::invalid_argument("No matching cv::Mat format!");
     }
+    if (roi.Pitch() < 0) {
+      throw std::invalid_argument("cv::Mat can't reference a flipped ROI!");
+    }
     int type = CV_MAKETYPE(depth, roi.Channel());
-    return cv::Mat(h, w, type, const_cast<uint8_t*>(roi.GetData()), roi.Pitch());
+    return cv::Mat(h, w, type, const_cast<uint8_t*>(roi.GetData()), (size_t)roi.Pitch());
   }
 
+  //! Non-owning view of a cv::Mat. The cv::Mat must outlive the ROI, use RefImg() otherwise.
   inline ImgROI RefROI(cv::Mat &mat) {
     uint32_t bpc = 0;
     bool is_signed = false;
@@ -94,12 +99,21 @@ namespace imgpp {
     if (bpc == 0) {
       throw std::invalid_argument("Invalid cv::Mat bit depth!");
     }
-    uint32_t pitch = (uint32_t)mat.step[0];
+    uint64_t pitch = (uint64_t)mat.step[0];
     return ImgROI(mat.data,
-      (uint32_t)mat.cols, (uint32_t)mat.rows, mat.channels(),
+      (uint32_t)mat.cols, (uint32_t)mat.rows, (uint32_t)mat.channels(),
       bpc, pitch, is_float, is_signed);
   }
 
+  //! Wrap a cv::Mat into an Img without copying. The Img buffer holds a reference to the cv::Mat,
+  //! so its refcount keeps the pixels alive for as long as the Img or any copy of its buffer.
+  inline Img RefImg(const cv::Mat &mat) {
+    auto owner = std::make_shared<cv::Mat>(mat);
+    ImgROI roi = RefROI(*owner);
+    ImgBuffer buffer(owner->data, (uint64_t)(owner->dataend - owner->data), owner);
+    return Img(std::move(buffer), roi);
+  }
+
 } //namespace imgpp
 
 #endif //IMGPP_OPENCVBINDING_HPP
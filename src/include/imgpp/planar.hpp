@@ -0,0 +1,598 @@
+#ifndef IMGPP_PLANAR_HPP
+#define IMGPP_PLANAR_HPP
+
+/*! \file planar.hpp
+ *  \brief Planar (one plane per channel) images and conversions from/to interleaved ImgROIs.
+ */
+
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace imgpp {
+
+//! PlanarROI is a view into planar image data: channel c of every pixel lives in its own plane.
+
+//! Each plane is laid out like a single channel ImgROI (rows pitch_ apart, slices slice_pitch_
+//! apart), and consecutive planes are plane_pitch_ bytes apart. Like ImgROI, a PlanarROI doesn't
+//! own its memory.
+class PlanarROI {
+public:
+  friend class PlanarImg;
+  friend class ImgBase<PlanarROI>;
+
+  //! Default constructor creating an empty region with data_ pointing to NULL.
+  PlanarROI() {}
+
+  //! \brief Constructor for a 2D or 3D planar image with known dimension.
+  //! \param src start of plane 0
+  //! \param pitch bytes between consecutive rows of a plane
+  //! \param slice_pitch bytes between consecutive slices of a plane
+  //! \param plane_pitch bytes between consecutive planes
+  PlanarROI(uint8_t *src, uint32_t w, uint32_t h, uint32_t depth, uint32_t c, uint32_t bpc,
+    uint64_t pitch, uint64_t slice_pitch, uint64_t plane_pitch, bool is_float, bool is_signed) :
+    data_(src), width_(w), height_(h), depth_(depth), channel_(c), bpc_(bpc),
+    is_signed_(is_signed), is_float_(is_float),
+    pitch_(pitch), slice_pitch_(slice_pitch), plane_pitch_(plane_pitch) {}
+
+  //! Create a new ROI of a subregion of the current ROI, covering all planes.
+  //! Range specified by closed intervals, sizes = (right-left+1, bottom-top+1, back-front+1)
+  PlanarROI SubRegion(
+    uint32_t left, uint32_t top, uint32_t front,
+    uint32_t right, uint32_t bottom, uint32_t back) {
+    return PlanarROI((uint8_t*)PtrAt(left, top, front, 0),
+      right - left + 1, bottom - top + 1, back - front + 1, channel_, bpc_,
+      pitch_, slice_pitch_, plane_pitch_, is_float_, is_signed_);
+  }
+
+  //! \brief Plane pitch calculator, same as ImgROI::CalcPitch() for a single channel.
+  static uint64_t CalcPitch(uint32_t w, uint32_t bpc, uint8_t alignment = 1) {
+    return ImgROI::CalcPitch(w, 1, bpc, alignment);
+  }
+
+  //! \brief Single channel ImgROI of plane c, sharing this ROI's memory.
+  ImgROI Plane(uint32_t c) const {
+    return ImgROI(data_ + c * plane_pitch_, width_, height_, depth_, 1, bpc_,
+      pitch_, slice_pitch_, is_float_, is_signed_);
+  }
+
+  //! \brief 2D Accessor. Returns a reference to channel c of pixel (x, y).
+  template<typename T> T &At(uint32_t x, uint32_t y, uint32_t c) {
+    return *(T*)PtrAt(x, y, 0, c);
+  }
+
+  template<typename T> const T &At(uint32_t x, uint32_t y, uint32_t c) const {
+    return *(const T*)PtrAt(x, y, 0, c);
+  }
+
+  //! \brief 3D Accessor. Returns a reference to channel c of pixel (x, y, z).
+  template<typename T> T &At(uint32_t x, uint32_t y, uint32_t z, uint32_t c) {
+    return *(T*)PtrAt(x, y, z, c);
+  }
+
+  template<typename T> const T &At(uint32_t x, uint32_t y, uint32_t z, uint32_t c) const {
+    return *(const T*)PtrAt(x, y, z, c);
+  }
+
+  //! \brief 3D Accessor. Returns a void * pointer to channel c of pixel (x, y, z).
+  void *PtrAt(uint32_t x, uint32_t y, uint32_t z, uint32_t c) {
+    return data_ + c * plane_pitch_ + z * slice_pitch_ + y * pitch_ + (size_t)x * (bpc_ >> 3);
+  }
+
+  const void *PtrAt(uint32_t x, uint32_t y, uint32_t z, uint32_t c) const {
+    return data_ + c * plane_pitch_ + z * slice_pitch_ + y * pitch_ + (size_t)x * (bpc_ >> 3);
+  }
+
+  uint32_t Width() const { return width_; }
+  uint32_t Height() const { return height_; }
+  uint32_t Depth() const { return depth_; }
+  uint32_t Channel() const { return channel_; }
+  uint8_t BPC() const { return bpc_; }
+  uint64_t Pitch() const { return pitch_; }
+  uint64_t SlicePitch() const { return slice_pitch_; }
+  uint64_t PlanePitch() const { return plane_pitch_; }
+  bool IsSigned() const { return is_signed_; }
+  bool IsFloat() const { return is_float_; }
+  const uint8_t *GetData() const { return data_; }
+  uint8_t *GetData() { return data_; }
+
+private:
+  uint8_t *data_{nullptr}; //!<Start of plane 0. NOT a smart pointer hence NOT responsible the buffer!
+  uint32_t width_{0};
+  uint32_t height_{0};
+  uint32_t depth_{0};
+  uint32_t channel_{0};
+  uint8_t bpc_{0}; //!<bit-depth (bits per channel, NOT bytes)
+  bool is_signed_{true}; //!<Signed/unsigned flag for integer types. Is true for floats.
+  bool is_float_{false}; //!<Flag for float types.
+  uint64_t pitch_{0}; //!<Distance in bytes between consecutive lines of a plane
+  uint64_t slice_pitch_{0}; //!<Distance in bytes between consecutive slices of a plane
+  uint64_t plane_pitch_{0}; //!<Distance in bytes between consecutive planes
+};
+
+//! \brief Copy rows from source planar ROI to destination planar ROI, keeping the destination pitches.
+//! \return true if succeeded, false if dimension doesn't match.
+inline bool CopyData(PlanarROI &dst, const PlanarROI &src) {
+  if (src.Width() > dst.Width() || src.Height() > dst.Height()
+    || src.Depth() > dst.Depth() || src.BPC() != dst.BPC()
+    || src.Channel() != dst.Channel()) {
+    return false;
+  }
+  for (uint32_t c = 0; c < src.Channel(); ++c) {
+    ImgROI dst_plane = dst.Plane(c);
+    CopyData(dst_plane, src.Plane(c));
+  }
+  return true;
+}
+
+//! PlanarImg holds a 2D or 3D planar image using an ImgBuffer and a PlanarROI.
+
+//! All planes live in one buffer, each plane starting on a kDefaultAlignment boundary.
+class PlanarImg: public ImgBase<PlanarROI> {
+public:
+  PlanarImg() {}
+  PlanarImg(ImgBase base): ImgBase(std::move(base)) {}
+  ~PlanarImg() {}
+
+  //! Wraps planes already held by buffer, described by roi. No data is copied.
+  PlanarImg(ImgBuffer buffer, const PlanarROI &roi): ImgBase(std::move(buffer), roi) {}
+
+  PlanarImg(uint32_t w, uint32_t h, uint32_t depth, uint32_t c, uint32_t bpc,
+    bool is_float = false, bool is_signed = false, uint8_t alignment = 1) {
+    SetSize(w, h, depth, c, bpc, is_float, is_signed, alignment);
+  }
+
+  //! Allocates memory and creates an ROI for the entire image.
+  //! \param alignment alignment of the start of each row within a plane
+  void SetSize(uint32_t w, uint32_t h, uint32_t depth, uint32_t c, uint32_t bpc,
+    bool is_float = false, bool is_signed = false, uint8_t alignment = 1) {
+    if (w == 0 || h == 0 || depth == 0 || c == 0 || bpc == 0) {
+      return;
+    }
+    uint64_t pitch = PlanarROI::CalcPitch(w, bpc, alignment);
+    uint64_t slice_pitch = pitch * h;
+    uint64_t plane_pitch = (slice_pitch * depth + kDefaultAlignment - 1)
+      / kDefaultAlignment * kDefaultAlignment;
+    buffer_.SetSize(plane_pitch * c);
+    buffer_.Unshare(false);  // contents are undefined after resizing
+    entire_img_ = PlanarROI(buffer_.GetBuffer(), w, h, depth, c, bpc,
+      pitch, slice_pitch, plane_pitch, is_float, is_signed);
+  }
+
+  //! Allocates memory for a planar image of the same size and format as an interleaved ROI
+  void SetSizeLike(const ImgROI &src_roi, uint8_t alignment = 1) {
+    SetSize(src_roi.Width(), src_roi.Height(), src_roi.Depth(), src_roi.Channel(),
+      src_roi.BPC(), src_roi.IsFloat(), src_roi.IsSigned(), alignment);
+  }
+
+  //! Allocates memory based on the size of a source planar ROI, ignoring its pitches
+  void SetSizeLike(const PlanarROI &src_roi, uint8_t alignment = 1) {
+    SetSize(src_roi.Width(), src_roi.Height(), src_roi.Depth(), src_roi.Channel(),
+      src_roi.BPC(), src_roi.IsFloat(), src_roi.IsSigned(), alignment);
+  }
+
+  //! Deep copy from a planar ROI, ignoring the original pitches
+  bool CopyFrom(const PlanarROI &src_roi, uint8_t alignment = 1) {
+    SetSizeLike(src_roi, alignment);
+    Unshare(false);
+    return CopyData(entire_img_, src_roi);
+  }
+};
+
+namespace detail {
+
+//! Planar row kernels: planes[c] points at the row of plane c, src/dst at the interleaved row.
+template<typename T, uint32_t C>
+inline void DeinterleaveRowScalar(uint8_t *const *planes, const uint8_t *src,
+  uint32_t begin, uint32_t w) {
+  const T *s = (const T*)src + (size_t)begin * C;
+  for (uint32_t x = begin; x < w; ++x) {
+    for (uint32_t c = 0; c < C; ++c) {
+      ((T*)planes[c])[x] = *s++;
+    }
+  }
+}
+
+template<typename T, uint32_t C>
+inline void InterleaveRowScalar(uint8_t *dst, const uint8_t *const *planes,
+  uint32_t begin, uint32_t w) {
+  T *d = (T*)dst + (size_t)begin * C;
+  for (uint32_t x = begin; x < w; ++x) {
+    for (uint32_t c = 0; c < C; ++c) {
+      *d++ = ((const T*)planes[c])[x];
+    }
+  }
+}
+
+template<typename T>
+inline void DeinterleaveRowScalar(uint8_t *const *planes, const uint8_t *src, uint32_t w,
+  uint32_t ch) {
+  const T *s = (const T*)src;
+  for (uint32_t x = 0; x < w; ++x) {
+    for (uint32_t c = 0; c < ch; ++c) {
+      ((T*)planes[c])[x] = *s++;
+    }
+  }
+}
+
+template<typename T>
+inline void InterleaveRowScalar(uint8_t *dst, const uint8_t *const *planes, uint32_t w,
+  uint32_t ch) {
+  T *d = (T*)dst;
+  for (uint32_t x = 0; x < w; ++x) {
+    for (uint32_t c = 0; c < ch; ++c) {
+      *d++ = ((const T*)planes[c])[x];
+    }
+  }
+}
+
+//! 8-bit RGB, 16 pixels per iteration
+inline void DeinterleaveRow8x3(uint8_t *const *planes, const uint8_t *src, uint32_t w) {
+  uint32_t x = 0;
+#if defined(__ARM_NEON)
+  for (; x + 16 <= w; x += 16) {
+    uint8x16x3_t v = vld3q_u8(src + x * 3);
+    vst1q_u8(planes[0] + x, v.val[0]);
+    vst1q_u8(planes[1] + x, v.val[1]);
+    vst1q_u8(planes[2] + x, v.val[2]);
+  }
+#elif defined(__SSSE3__)
+  const __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+  const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+  const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+  const __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+  const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+  for (; x + 16 <= w; x += 16) {
+    const __m128i *s = (const __m128i*)(src + x * 3);
+    __m128i a = _mm_loadu_si128(s);
+    __m128i b = _mm_loadu_si128(s + 1);
+    __m128i c = _mm_loadu_si128(s + 2);
+    _mm_storeu_si128((__m128i*)(planes[0] + x), _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(a, r0), _mm_shuffle_epi8(b, r1)), _mm_shuffle_epi8(c, r2)));
+    _mm_storeu_si128((__m128i*)(planes[1] + x), _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(a, g0), _mm_shuffle_epi8(b, g1)), _mm_shuffle_epi8(c, g2)));
+    _mm_storeu_si128((__m128i*)(planes[2] + x), _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(a, b0), _mm_shuffle_epi8(b, b1)), _mm_shuffle_epi8(c, b2)));
+  }
+#endif
+  DeinterleaveRowScalar<uint8_t, 3>(planes, src, x, w);
+}
+
+inline void InterleaveRow8x3(uint8_t *dst, const uint8_t *const *planes, uint32_t w) {
+  uint32_t x = 0;
+#if defined(__ARM_NEON)
+  for (; x + 16 <= w; x += 16) {
+    uint8x16x3_t v;
+    v.val[0] = vld1q_u8(planes[0] + x);
+    v.val[1] = vld1q_u8(planes[1] + x);
+    v.val[2] = vld1q_u8(planes[2] + x);
+    vst3q_u8(dst + x * 3, v);
+  }
+#elif defined(__SSSE3__)
+  const __m128i a0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+  const __m128i a1 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+  const __m128i a2 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+  const __m128i b0 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+  const __m128i b1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+  const __m128i b2 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+  const __m128i c0 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+  const __m128i c1 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+  const __m128i c2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+  for (; x + 16 <= w; x += 16) {
+    __m128i r = _mm_loadu_si128((const __m128i*)(planes[0] + x));
+    __m128i g = _mm_loadu_si128((const __m128i*)(planes[1] + x));
+    __m128i b = _mm_loadu_si128((const __m128i*)(planes[2] + x));
+    __m128i *d = (__m128i*)(dst + x * 3);
+    _mm_storeu_si128(d, _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(r, a0), _mm_shuffle_epi8(g, a1)), _mm_shuffle_epi8(b, a2)));
+    _mm_storeu_si128(d + 1, _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(r, b0), _mm_shuffle_epi8(g, b1)), _mm_shuffle_epi8(b, b2)));
+    _mm_storeu_si128(d + 2, _mm_or_si128(_mm_or_si128(
+      _mm_shuffle_epi8(r, c0), _mm_shuffle_epi8(g, c1)), _mm_shuffle_epi8(b, c2)));
+  }
+#endif
+  InterleaveRowScalar<uint8_t, 3>(dst, planes, x, w);
+}
+
+//! 8-bit RGBA, 16 pixels per iteration
+inline void DeinterleaveRow8x4(uint8_t *const *planes, const uint8_t *src, uint32_t w) {
+  uint32_t x = 0;
+#if defined(__ARM_NEON)
+  for (; x + 16 <= w; x += 16) {
+    uint8x16x4_t v = vld4q_u8(src + x * 4);
+    for (int c = 0; c < 4; ++c) {
+      vst1q_u8(planes[c] + x, v.val[c]);
+    }
+  }
+#elif defined(__SSSE3__)
+  // group the channels of 4 pixels, then transpose the 4x4 block of 32-bit groups
+  const __m128i group = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+  for (; x + 16 <= w; x += 16) {
+    const __m128i *s = (const __m128i*)(src + x * 4);
+    __m128 v0 = _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128(s), group));
+    __m128 v1 = _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128(s + 1), group));
+    __m128 v2 = _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128(s + 2), group));
+    __m128 v3 = _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128(s + 3), group));
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    _mm_storeu_ps((float*)(planes[0] + x), v0);
+    _mm_storeu_ps((float*)(planes[1] + x), v1);
+    _mm_storeu_ps((float*)(planes[2] + x), v2);
+    _mm_storeu_ps((float*)(planes[3] + x), v3);
+  }
+#endif
+  DeinterleaveRowScalar<uint8_t, 4>(planes, src, x, w);
+}
+
+inline void InterleaveRow8x4(uint8_t *dst, const uint8_t *const *planes, uint32_t w) {
+  uint32_t x = 0;
+#if defined(__ARM_NEON)
+  for (; x + 16 <= w; x += 16) {
+    uint8x16x4_t v;
+    for (int c = 0; c < 4; ++c) {
+      v.val[c] = vld1q_u8(planes[c] + x);
+    }
+    vst4q_u8(dst + x * 4, v);
+  }
+#elif defined(__SSSE3__)
+  // the channel grouping shuffle is its own inverse
+  const __m128i group = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+  for (; x + 16 <= w; x += 16) {
+    __m128 v0 = _mm_loadu_ps((const float*)(planes[0] + x));
+    __m128 v1 = _mm_loadu_ps((const float*)(planes[1] + x));
+    __m128 v2 = _mm_loadu_ps((const float*)(planes[2] + x));
+    __m128 v3 = _mm_loadu_ps((const float*)(planes[3] + x));
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    __m128i *d = (__m128i*)(dst + x * 4);
+    _mm_storeu_si128(d, _mm_shuffle_epi8(_mm_castps_si128(v0), group));
+    _mm_storeu_si128(d + 1, _mm_shuffle_epi8(_mm_castps_si128(v1), group));
+    _mm_storeu_si128(d + 2, _mm_shuffle_epi8(_mm_castps_si128(v2), group));
+    _mm_storeu_si128(d + 3, _mm_shuffle_epi8(_mm_castps_si128(v3), group));
+  }
+#endif
+  InterleaveRowScalar<uint8_t, 4>(dst, planes, x, w);
+}
+
+//! 32-bit RGBA (float or integer), 4 pixels per iteration
+inline void DeinterleaveRow32x4(uint8_t *const *planes, const uint8_t *src, uint32_t w) {
+  uint32_t x = 0;
+#if defined(__ARM_NEON)
+  for (; x + 4 <= w; x += 4) {
+    float32x4x4_t v = vld4q_f32((const float*)src + x * 4);
+    for (int c = 0; c < 4; ++c) {
+      vst1q_f32((float*)planes[c] + x, v.val[c]);
+    }
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  for (; x + 4 <= w; x += 4) {
+    const float *s = (const float*)src + x * 4;
+    __m128 v0 = _mm_loadu_ps(s);
+    __m128 v1 = _mm_loadu_ps(s + 4);
+    __m128 v2 = _mm_loadu_ps(s + 8);
+    __m128 v3 = _mm_loadu_ps(s + 12);
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    _mm_storeu_ps((float*)planes[0] + x, v0);
+    _mm_storeu_ps((float*)planes[1] + x, v1);
+    _mm_storeu_ps((float*)planes[2] + x, v2);
+    _mm_storeu_ps((float*)planes[3] + x, v3);
+  }
+#endif
+  DeinterleaveRowScalar<uint32_t, 4>(planes, src, x, w);
+}
+
+inline void InterleaveRow32x4(uint8_t *dst, const uint8_t *const *planes, uint32_t w) {
+  uint32_t x = 0;
+#if defined(__ARM_NEON)
+  for (; x + 4 <= w; x += 4) {
+    float32x4x4_t v;
+    for (int c = 0; c < 4; ++c) {
+      v.val[c] = vld1q_f32((const float*)planes[c] + x);
+    }
+    vst4q_f32((float*)dst + x * 4, v);
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  for (; x + 4 <= w; x += 4) {
+    __m128 v0 = _mm_loadu_ps((const float*)planes[0] + x);
+    __m128 v1 = _mm_loadu_ps((const float*)planes[1] + x);
+    __m128 v2 = _mm_loadu_ps((const float*)planes[2] + x);
+    __m128 v3 = _mm_loadu_ps((const float*)planes[3] + x);
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    float *d = (float*)dst + x * 4;
+    _mm_storeu_ps(d, v0);
+    _mm_storeu_ps(d + 4, v1);
+    _mm_storeu_ps(d + 8, v2);
+    _mm_storeu_ps(d + 12, v3);
+  }
+#endif
+  InterleaveRowScalar<uint32_t, 4>(dst, planes, x, w);
+}
+
+inline bool DeinterleaveRow(uint8_t *const *planes, const uint8_t *src, uint32_t w,
+  uint32_t ch, uint32_t bpc) {
+  switch (bpc) {
+  case 8:
+    if (ch == 3) {
+      DeinterleaveRow8x3(planes, src, w);
+    } else if (ch == 4) {
+      DeinterleaveRow8x4(planes, src, w);
+    } else {
+      DeinterleaveRowScalar<uint8_t>(planes, src, w, ch);
+    }
+    return true;
+  case 16:
+    DeinterleaveRowScalar<uint16_t>(planes, src, w, ch);
+    return true;
+  case 32:
+    if (ch == 4) {
+      DeinterleaveRow32x4(planes, src, w);
+    } else {
+      DeinterleaveRowScalar<uint32_t>(planes, src, w, ch);
+    }
+    return true;
+  case 64:
+    DeinterleaveRowScalar<uint64_t>(planes, src, w, ch);
+    return true;
+  default:
+    return false;
+  }
+}
+
+inline bool InterleaveRow(uint8_t *dst, const uint8_t *const *planes, uint32_t w,
+  uint32_t ch, uint32_t bpc) {
+  switch (bpc) {
+  case 8:
+    if (ch == 3) {
+      InterleaveRow8x3(dst, planes, w);
+    } else if (ch == 4) {
+      InterleaveRow8x4(dst, planes, w);
+    } else {
+      InterleaveRowScalar<uint8_t>(dst, planes, w, ch);
+    }
+    return true;
+  case 16:
+    InterleaveRowScalar<uint16_t>(dst, planes, w, ch);
+    return true;
+  case 32:
+    if (ch == 4) {
+      InterleaveRow32x4(dst, planes, w);
+    } else {
+      InterleaveRowScalar<uint32_t>(dst, planes, w, ch);
+    }
+    return true;
+  case 64:
+    InterleaveRowScalar<uint64_t>(dst, planes, w, ch);
+    return true;
+  default:
+    return false;
+  }
+}
+
+}
+
+/*! \fn bool Deinterleave(PlanarROI &dst, const ImgROI &src)
+    \brief Split an interleaved ROI (HWC) into planes (CHW).
+    8-bit RGB/RGBA and 32-bit RGBA rows use SSSE3/SSE2 or NEON when the compiler targets them.
+    \return true if succeeded, false if dimension or format doesn't match.
+*/
+inline bool Deinterleave(PlanarROI &dst, const ImgROI &src) {
+  if (src.Width() > dst.Width() || src.Height() > dst.Height()
+    || src.Depth() > dst.Depth() || src.BPC() != dst.BPC()
+    || src.Channel() != dst.Channel() || src.Channel() == 0) {
+    return false;
+  }
+  std::vector<uint8_t*> planes(src.Channel());
+  for (uint32_t z = 0; z < src.Depth(); ++z) {
+    for (uint32_t y = 0; y < src.Height(); ++y) {
+      for (uint32_t c = 0; c < src.Channel(); ++c) {
+        planes[c] = (uint8_t*)dst.PtrAt(0, y, z, c);
+      }
+      if (!detail::DeinterleaveRow(planes.data(), (const uint8_t*)src.PtrAt(0, y, z, 0),
+        src.Width(), src.Channel(), src.BPC())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*! \fn bool Interleave(ImgROI &dst, const PlanarROI &src)
+    \brief Merge planes (CHW) into an interleaved ROI (HWC), see Deinterleave().
+    \return true if succeeded, false if dimension or format doesn't match.
+*/
+inline bool Interleave(ImgROI &dst, const PlanarROI &src) {
+  if (src.Width() > dst.Width() || src.Height() > dst.Height()
+    || src.Depth() > dst.Depth() || src.BPC() != dst.BPC()
+    || src.Channel() != dst.Channel() || src.Channel() == 0) {
+    return false;
+  }
+  std::vector<const uint8_t*> planes(src.Channel());
+  for (uint32_t z = 0; z < src.Depth(); ++z) {
+    for (uint32_t y = 0; y < src.Height(); ++y) {
+      for (uint32_t c = 0; c < src.Channel(); ++c) {
+        planes[c] = (const uint8_t*)src.PtrAt(0, y, z, c);
+      }
+      if (!detail::InterleaveRow((uint8_t*)dst.PtrAt(0, y, z, 0), planes.data(),
+        src.Width(), src.Channel(), src.BPC())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//! \brief Create a planar copy of an interleaved ROI.
+inline PlanarImg ToPlanar(const ImgROI &src) {
+  PlanarImg result;
+  result.SetSizeLike(src);
+  Deinterleave(result.ROI(), src);
+  return result;
+}
+
+//! \brief Create an interleaved copy of a planar ROI.
+inline Img ToInterleaved(const PlanarROI &src) {
+  Img result(src.Width(), src.Height(), src.Depth(), src.Channel(), src.BPC(),
+    src.IsFloat(), src.IsSigned());
+  Interleave(result.ROI(), src);
+  return result;
+}
+
+/**
+ * @brief Transform multiple planar images simultaneously, one plane at a time.
+ * @details Same as ZipTransform(), but iterates plane by plane, so the innermost loop walks
+ * contiguous memory of a single channel.
+ *
+ * @param imgs an std::tuple or std::array of PlanarROIs
+ * @param callback callback function receiving (x, y, z, c, ptrs) as argument.
+ */
+template<typename TImgs, typename TCallback>
+void ZipTransformPlanes(TImgs &&imgs, TCallback callback) {
+  constexpr size_t num_imgs = std::tuple_size<typename std::remove_reference<TImgs>::type>::value;
+  std::array<uint8_t*, num_imgs> ptrs;
+  std::array<uint8_t, num_imgs> steps;
+
+  uint32_t w = std::get<0>(imgs).Width();
+  uint32_t h = std::get<0>(imgs).Height();
+  uint32_t d = std::get<0>(imgs).Depth();
+  uint32_t ch = std::get<0>(imgs).Channel();
+
+  static_for<0, num_imgs>([&steps, &imgs](auto idx) {
+    steps[idx] = std::get<idx.value>(imgs).BPC() >> 3;
+  });
+
+  for (uint32_t c = 0; c < ch; c++) {
+    for (uint32_t z = 0; z < d; z++) {
+      for (uint32_t y = 0; y < h; y++) {
+
+        static_for<0, num_imgs>([&ptrs, &imgs, y, z, c](auto idx) {
+          ptrs[idx] = (uint8_t*)std::get<idx.value>(imgs).PtrAt(0, y, z, c);
+        });
+
+        for (uint32_t x = 0; x < w; x++) {
+
+          callback(x, y, z, c, ptrs);
+
+          static_for<0, num_imgs>([&ptrs, &steps](auto idx) {
+            ptrs[idx] += steps[idx];
+          });
+        }
+      }
+    }
+  }
+}
+
+}
+
+#endif // IMGPP_PLANAR_HPP
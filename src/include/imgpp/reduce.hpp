@@ -0,0 +1,436 @@
+#ifndef IMGPP_REDUCE_HPP
+#define IMGPP_REDUCE_HPP
+
+/*! \file reduce.hpp
+ *  \brief Per channel statistics and histograms of an ImgROI.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <imgpp/convert.hpp>
+#include <imgpp/half.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace imgpp {
+
+//! \brief Statistics of one channel, see ComputeStatistics().
+struct ChannelStatistics {
+  double min{0.0};
+  double max{0.0};
+  double sum{0.0};
+  double mean{0.0};
+  double variance{0.0}; //!< population variance, the mean squared distance to mean
+};
+
+enum : uint32_t {
+  kMaxHistogramBins = 65536 //!< most bins ComputeHistogram() counts per channel
+};
+
+namespace detail {
+
+enum : uint64_t {
+  kParallelReduceValues = 256 * 1024, //!< reductions of at least this many values run on the executor
+  kReduceChunk = 16384,               //!< values between flushes of the 32 bit lane sums
+  kHistogramFlush = 1u << 30,         //!< values counted into the 32 bit tables between flushes
+  kReplicatedBins = 1024,             //!< histograms up to this many bins count into 4 tables per channel
+  kHistogramReplicas = 4
+};
+
+//! Number of tasks reducing roi, 1 below kParallelReduceValues.
+inline size_t ReduceTasks(const ImgROI &roi, Executor &executor) {
+  uint64_t rows = (uint64_t)roi.Height() * roi.Depth();
+  if (rows * roi.Width() * roi.Channel() < kParallelReduceValues) {
+    return 1;
+  }
+  return (size_t)std::max<uint64_t>(1, std::min<uint64_t>(rows, (uint64_t)executor.Concurrency() * kBandsPerThread));
+}
+
+/**
+ * @brief Run task(t, y, z) over the rows of roi, split into num_tasks runs of rows on executor.
+ * @details Rows run through the slices, row r being row y = r % Height() of slice z = r / Height();
+ * task t gets the t-th run, so partial results indexed by t merge in a fixed order.
+ */
+template<typename TTask>
+void RunReduceTasks(const ImgROI &roi, size_t num_tasks, Executor &executor, const TTask &task) {
+  uint64_t rows = (uint64_t)roi.Height() * roi.Depth();
+  auto run = [&](size_t t) {
+    for (uint64_t r = rows * t / num_tasks; r < rows * (t + 1) / num_tasks; r++) {
+      task(t, (uint32_t)(r % roi.Height()), (uint32_t)(r / roi.Height()));
+    }
+  };
+  if (num_tasks > 1) {
+    executor.Run(num_tasks, run);
+  } else {
+    run(0);
+  }
+}
+
+//! running totals of one channel, of the values relative to a shift that keeps the squares small
+struct ChannelTotals {
+  double min{INFINITY};
+  double max{-INFINITY};
+  double sum{0.0};
+  double squares{0.0};
+};
+
+//! Lane accumulators of channel values T: exact integers up to 16 bits, double otherwise.
+template<typename T, bool kSmall = std::is_integral<T>::value && sizeof(T) <= 2>
+struct ReduceLane {
+  using Value = double;
+  using Sum = double;
+  using Square = double;
+  static Square Squared(Value d) { return d * d; }
+};
+
+template<typename T>
+struct ReduceLane<T, true> {
+  using Value = int32_t;
+  using Sum = int32_t;
+  using Square = typename std::conditional<sizeof(T) == 1, uint32_t, uint64_t>::type;
+  // |d| < 2^16, so d * d fits unsigned 32 bits
+  static Square Squared(Value d) { return (Square)((uint32_t)d * (uint32_t)d); }
+};
+
+/**
+ * @brief Add n values of c interleaved channels, at most kReduceChunk, to the totals.
+ * @details Value i goes to lane i % kLanes, a multiple of c, so the lanes are independent
+ * chains the compiler keeps in vector registers; they fold into their channels at the end.
+ * Comparisons skip NaNs.
+ */
+template<typename T, uint32_t kLanes>
+void ReduceLanes(const T *p, size_t n, uint32_t c, const double *shift, ChannelTotals *totals) {
+  using Lane = ReduceLane<T>;
+  constexpr T kHighest = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+    : std::numeric_limits<T>::max();
+  constexpr T kLowest = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+    : std::numeric_limits<T>::lowest();
+  std::array<T, kLanes> lo;
+  std::array<T, kLanes> hi;
+  std::array<typename Lane::Value, kLanes> offset;
+  std::array<typename Lane::Sum, kLanes> sum{};
+  std::array<typename Lane::Square, kLanes> squares{};
+  for (uint32_t l = 0; l < kLanes; l++) {
+    lo[l] = kHighest;
+    hi[l] = kLowest;
+    offset[l] = (typename Lane::Value)shift[l % c];
+  }
+  auto add = [&](uint32_t l, T v) {
+    lo[l] = v < lo[l] ? v : lo[l];
+    hi[l] = v > hi[l] ? v : hi[l];
+    typename Lane::Value d = (typename Lane::Value)v - offset[l];
+    sum[l] += d;
+    squares[l] += Lane::Squared(d);
+  };
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (uint32_t l = 0; l < kLanes; l++) {
+      add(l, p[i + l]);
+    }
+  }
+  for (uint32_t l = 0; i < n; i++, l++) {
+    add(l, p[i]);
+  }
+  for (uint32_t l = 0; l < kLanes; l++) {
+    ChannelTotals &t = totals[l % c];
+    t.min = std::min(t.min, (double)lo[l]);
+    t.max = std::max(t.max, (double)hi[l]);
+    t.sum += (double)sum[l];
+    t.squares += (double)squares[l];
+  }
+}
+
+//! ReduceLanes() for any channel count, one value at a time
+template<typename T>
+void ReduceValues(const T *p, size_t n, uint32_t c, const double *shift, ChannelTotals *totals) {
+  for (size_t i = 0; i < n; i++) {
+    ChannelTotals &t = totals[i % c];
+    double v = (double)p[i];
+    t.min = v < t.min ? v : t.min;
+    t.max = v > t.max ? v : t.max;
+    t.sum += v - shift[i % c];
+    t.squares += (v - shift[i % c]) * (v - shift[i % c]);
+  }
+}
+
+template<typename T>
+void ReduceChunk(const T *p, size_t n, uint32_t c, const double *shift, ChannelTotals *totals) {
+  switch (c) {
+  case 1: ReduceLanes<T, 16>(p, n, c, shift, totals); break;
+  case 2: ReduceLanes<T, 16>(p, n, c, shift, totals); break;
+  case 3: ReduceLanes<T, 12>(p, n, c, shift, totals); break;
+  case 4: ReduceLanes<T, 16>(p, n, c, shift, totals); break;
+  default: ReduceValues(p, n, c, shift, totals); break;
+  }
+}
+
+//! bin of v among bins over [lo, lo + bins / scale), ends clamped, bins for NaN
+inline uint32_t HistogramBin(float v, float lo, float scale, uint32_t bins) {
+  if (v != v) {
+    return bins;
+  }
+  float t = (v - lo) * scale;
+  return t <= 0.0f ? 0 : t >= (float)bins ? bins - 1 : std::min((uint32_t)t, bins - 1);
+}
+
+//! HistogramBin() of n floats
+inline void HistogramBins(uint32_t *dst, const float *src, size_t n, float lo, float scale, uint32_t bins) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128 offset = _mm_set1_ps(lo);
+  const __m128 factor = _mm_set1_ps(scale);
+  const __m128 last = _mm_set1_ps((float)(bins - 1));
+  const __m128i nan_bin = _mm_set1_epi32((int32_t)bins);
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(src + i);
+    __m128 t = _mm_mul_ps(_mm_sub_ps(v, offset), factor);
+    __m128i bin = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), last));
+    __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(v, v));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_andnot_si128(nan, bin), _mm_and_si128(nan, nan_bin)));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = HistogramBin(src[i], lo, scale, bins);
+  }
+}
+
+/**
+ * @brief Count n values into tables of stride entries, bin(i) being the entry of value i.
+ * @details Value i counts in table i % lanes; replicated tables keep consecutive increments of
+ * the same bin from waiting on each other. A nonzero kLanes is the compile time lanes.
+ */
+template<uint32_t kLanes, typename TBin>
+void CountLanes(const TBin &bin, size_t n, uint32_t lanes, uint32_t stride, uint32_t *tables) {
+  if constexpr (kLanes > 0) {
+    lanes = kLanes;
+  }
+  size_t i = 0;
+  for (; i + lanes <= n; i += lanes) {
+    uint32_t *table = tables;
+    for (uint32_t l = 0; l < lanes; l++, table += stride) {
+      table[bin(i + l)]++;
+    }
+  }
+  for (uint32_t *table = tables; i < n; i++, table += stride) {
+    table[bin(i)]++;
+  }
+}
+
+//! CountLanes() of c channels, unrolled for the 4 tables per channel of up to 4 channels
+template<typename TBin>
+void CountBins(const TBin &bin, size_t n, uint32_t c, uint32_t lanes, uint32_t stride, uint32_t *tables) {
+  switch (lanes == kHistogramReplicas * c ? c : 0) {
+  case 1: CountLanes<kHistogramReplicas>(bin, n, lanes, stride, tables); break;
+  case 2: CountLanes<2 * kHistogramReplicas>(bin, n, lanes, stride, tables); break;
+  case 3: CountLanes<3 * kHistogramReplicas>(bin, n, lanes, stride, tables); break;
+  case 4: CountLanes<4 * kHistogramReplicas>(bin, n, lanes, stride, tables); break;
+  default: CountLanes<0>(bin, n, lanes, stride, tables); break;
+  }
+}
+
+//! true for the channel types ComputeHistogram() counts
+inline bool IsHistogrammable(ChannelType type) {
+  return type == ChannelType::U8 || type == ChannelType::U16 || type == ChannelType::F16
+    || type == ChannelType::F32;
+}
+
+}
+
+/**
+ * @brief Per channel minimum, maximum, sum, mean and variance of the pixels of roi.
+ * @details Rows are split into runs on executor, each adding its values into lanes of vector
+ * registers, exact integers for channels up to 16 bits and doubles for the others. Values are
+ * taken relative to the first pixel, which keeps the variance accurate for large means; the
+ * partial results of the runs merge in a fixed order. NaNs are skipped by the minimum and
+ * maximum and make the sum, mean and variance NaN.
+ *
+ * @param roi ROI of any integer or float channel type and any channel count.
+ * @param statistics receives Channel() entries.
+ * @param executor executor running large reductions, DefaultThreadPool() if not specified.
+ * @return false if roi is empty or of an unsupported format.
+ */
+inline bool ComputeStatistics(const ImgROI &roi, std::vector<ChannelStatistics> &statistics,
+  Executor &executor = DefaultThreadPool()) {
+  ChannelType type = GetChannelType(roi);
+  if (type == ChannelType::UNKNOWN || roi.Width() == 0 || roi.Height() == 0 || roi.Depth() == 0
+    || roi.Channel() == 0) {
+    return false;
+  }
+  uint32_t c = roi.Channel();
+  size_t len = (size_t)roi.Width() * c;
+  size_t chunk = detail::kReduceChunk / c * c;
+  size_t num_tasks = detail::ReduceTasks(roi, executor);
+  std::vector<double> shift(c);
+  std::vector<detail::ChannelTotals> partial(num_tasks * c);
+  detail::DispatchChannelType(type, [&](auto channel_type) {
+    constexpr ChannelType kType = decltype(channel_type)::value;
+    using TValue = typename std::conditional<kType == ChannelType::F16, float,
+      typename detail::Channel<kType>::type>::type;
+    for (uint32_t i = 0; i < c; i++) {
+      // the first pixel, finite for floats
+      double v = kType == ChannelType::F16 ? (double)((const Half*)roi.PtrAt(0, 0, 0, 0))[i]
+        : (double)((const typename detail::Channel<kType>::type*)roi.PtrAt(0, 0, 0, 0))[i];
+      shift[i] = std::isfinite(v) ? v : 0.0;
+    }
+    detail::RunReduceTasks(roi, num_tasks, executor, [&](size_t t, uint32_t y, uint32_t z) {
+      const uint8_t *row = (const uint8_t*)roi.PtrAt(0, y, z, 0);
+      detail::ChannelTotals *totals = partial.data() + t * c;
+      for (size_t i = 0; i < len; i += chunk) {
+        size_t n = std::min(chunk, len - i);
+        if constexpr (kType == ChannelType::F16) {
+          float buffer[detail::kReduceChunk];
+          HalfToFloat(buffer, (const Half*)row + i, n);
+          detail::ReduceChunk(buffer, n, c, shift.data(), totals);
+        } else {
+          detail::ReduceChunk((const TValue*)row + i, n, c, shift.data(), totals);
+        }
+      }
+    });
+  });
+  double count = (double)roi.Width() * roi.Height() * roi.Depth();
+  statistics.assign(c, ChannelStatistics());
+  for (uint32_t i = 0; i < c; i++) {
+    detail::ChannelTotals total;
+    for (size_t t = 0; t < num_tasks; t++) {
+      const detail::ChannelTotals &p = partial[t * c + i];
+      total.min = std::min(total.min, p.min);
+      total.max = std::max(total.max, p.max);
+      total.sum += p.sum;
+      total.squares += p.squares;
+    }
+    double mean = total.sum / count;
+    statistics[i].min = total.min;
+    statistics[i].max = total.max;
+    statistics[i].sum = total.sum + count * shift[i];
+    statistics[i].mean = shift[i] + mean;
+    statistics[i].variance = std::max(0.0, total.squares / count - mean * mean);
+  }
+  return true;
+}
+
+/**
+ * @brief Per channel histograms of the pixels of roi over [lo, hi).
+ * @details Bin b counts the values in [lo + b * (hi - lo) / bins, lo + (b + 1) * (hi - lo) / bins),
+ * values below lo count in the first bin and values from hi on in the last; NaNs are not counted.
+ * 8 and 16 bit channels find their bins in a table of every value. Rows are split into runs on
+ * executor, counting into 32 bit tables of their own, replicated for up to kReplicatedBins bins,
+ * that are added to histogram at the end.
+ *
+ * @param roi ROI of U8, U16, F16 or F32 channels.
+ * @param bins number of bins per channel, 1 to kMaxHistogramBins.
+ * @param lo lower end of the first bin.
+ * @param hi upper end of the last bin, greater than lo, with bins / (hi - lo) a finite, nonzero float.
+ * @param histogram receives Channel() * bins counts, bin b of channel c at c * bins + b.
+ * @param executor executor running large histograms, DefaultThreadPool() if not specified.
+ * @return false if the format, bins or range are not supported.
+ */
+inline bool ComputeHistogram(const ImgROI &roi, uint32_t bins, float lo, float hi, std::vector<uint64_t> &histogram,
+  Executor &executor = DefaultThreadPool()) {
+  ChannelType type = GetChannelType(roi);
+  if (!detail::IsHistogrammable(type) || bins == 0 || bins > kMaxHistogramBins || !(hi > lo)
+    || !std::isfinite(lo) || !std::isfinite(hi)) {
+    return false;
+  }
+  // bins per unit, which ranges too narrow (overflow) or too wide (underflow) for a float don't have
+  float scale = (float)bins / (hi - lo);
+  if (!std::isfinite(scale) || !(scale > 0.0f)) {
+    return false;
+  }
+  uint32_t c = roi.Channel();
+  histogram.assign((size_t)c * bins, 0);
+  if (roi.Width() == 0 || roi.Height() == 0 || roi.Depth() == 0 || c == 0) {
+    return true;
+  }
+  // bins of every 8 or 16 bit value, NaN halves to the uncounted entry bins
+  std::vector<uint32_t> lut(type == ChannelType::U8 ? 256 : type == ChannelType::F32 ? 0 : 65536);
+  for (size_t v = 0; v < lut.size(); v++) {
+    float value = type == ChannelType::F16 ? detail::HalfBitsToFloat((uint16_t)v) : (float)v;
+    lut[v] = detail::HistogramBin(value, lo, scale, bins);
+  }
+  // 8 bit values count in tables of every value, binned when merged
+  bool by_value = type == ChannelType::U8;
+  uint32_t lanes = c * (by_value || bins <= detail::kReplicatedBins ? (uint32_t)detail::kHistogramReplicas : 1);
+  uint32_t stride = by_value ? 256 : bins + 1;
+  size_t len = (size_t)roi.Width() * c;
+  size_t chunk = detail::kReduceChunk / c * c;
+  size_t num_tasks = detail::ReduceTasks(roi, executor);
+  std::mutex merge;
+  struct Counter {
+    std::vector<uint32_t> tables;
+    uint64_t counted{0};
+  };
+  std::vector<Counter> counters(num_tasks);
+  auto flush = [&](Counter &counter) {
+    std::lock_guard<std::mutex> lock(merge);
+    for (uint32_t l = 0; l < lanes; l++) {
+      const uint32_t *table = counter.tables.data() + (size_t)l * stride;
+      uint64_t *channel = histogram.data() + (size_t)(l % c) * bins;
+      if (by_value) {
+        for (uint32_t v = 0; v < 256; v++) {
+          channel[lut[v]] += table[v];
+        }
+      } else {
+        for (uint32_t b = 0; b < bins; b++) {
+          channel[b] += table[b];
+        }
+      }
+    }
+    std::fill(counter.tables.begin(), counter.tables.end(), 0);
+    counter.counted = 0;
+  };
+  detail::RunReduceTasks(roi, num_tasks, executor, [&](size_t t, uint32_t y, uint32_t z) {
+    const uint8_t *row = (const uint8_t*)roi.PtrAt(0, y, z, 0);
+    Counter &counter = counters[t];
+    if (counter.tables.empty()) {
+      counter.tables.resize((size_t)lanes * stride);
+    }
+    uint32_t *tables = counter.tables.data();
+    if (type == ChannelType::U8) {
+      detail::CountBins([row](size_t i) { return row[i]; }, len, c, lanes, stride, tables);
+    } else if (type != ChannelType::F32) {
+      const uint16_t *values = (const uint16_t*)row;
+      detail::CountBins([&](size_t i) { return lut[values[i]]; }, len, c, lanes, stride, tables);
+    } else {
+      uint32_t found[detail::kReduceChunk];
+      for (size_t i = 0; i < len; i += chunk) {
+        size_t n = std::min(chunk, len - i);
+        detail::HistogramBins(found, (const float*)row + i, n, lo, scale, bins);
+        detail::CountBins([&](size_t j) { return found[j]; }, n, c, lanes, stride, tables);
+      }
+    }
+    counter.counted += len;
+    if (counter.counted >= detail::kHistogramFlush) {
+      flush(counter);
+    }
+  });
+  for (Counter &counter: counters) {
+    if (counter.counted > 0) {
+      flush(counter);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief ComputeHistogram() over the whole range of the channel type: [0, 256) for U8,
+ * [0, 65536) for U16 and [0, 1) for float channels, whose values from 1 on count in the last bin.
+ */
+inline bool ComputeHistogram(const ImgROI &roi, uint32_t bins, std::vector<uint64_t> &histogram,
+  Executor &executor = DefaultThreadPool()) {
+  ChannelType type = GetChannelType(roi);
+  float hi = type == ChannelType::U8 ? 256.0f : type == ChannelType::U16 ? 65536.0f : 1.0f;
+  return ComputeHistogram(roi, bins, 0.0f, hi, histogram, executor);
+}
+
+}
+
+#endif // IMGPP_REDUCE_HPP
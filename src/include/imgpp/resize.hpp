@@ -0,0 +1,504 @@
+#ifndef IMGPP_RESIZE_HPP
+#define IMGPP_RESIZE_HPP
+
+/*! \file resize.hpp
+ *  \brief Separable whole-image resampling.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <imgpp/convert.hpp>
+#include <imgpp/half.hpp>
+#include <imgpp/srgb.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace imgpp {
+
+//! \brief Reconstruction filter of Resize().
+enum class ResizeFilter: uint8_t {
+  BOX,      //!< area average when shrinking, nearest neighbor when enlarging
+  BILINEAR, //!< triangle filter, bilinear interpolation when enlarging
+  BICUBIC,  //!< Catmull-Rom cubic
+  LANCZOS3, //!< Lanczos windowed sinc with 3 lobes
+  KAISER    //!< Kaiser windowed sinc with 3 lobes and alpha 4, a sharp mipmap filter
+};
+
+namespace detail {
+
+enum : uint64_t { kParallelResizeValues = 64 * 1024 };  //!< smaller outputs are resized on the caller
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kKaiserAlpha = 4.0;
+
+//! modified Bessel function of the first kind of order 0, the Kaiser window
+inline double BesselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; term > sum * 1e-12; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+inline double Sinc(double x) {
+  return x == 0.0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+}
+
+//! radius of the filter at scale 1, in source pixels
+inline double FilterSupport(ResizeFilter filter) {
+  switch (filter) {
+  case ResizeFilter::BOX: return 0.5;
+  case ResizeFilter::BILINEAR: return 1.0;
+  case ResizeFilter::BICUBIC: return 2.0;
+  default: return 3.0;
+  }
+}
+
+inline double FilterWeight(ResizeFilter filter, double x) {
+  x = std::fabs(x);
+  switch (filter) {
+  case ResizeFilter::BOX:
+    return x < 0.5 ? 1.0 : x == 0.5 ? 0.5 : 0.0;
+  case ResizeFilter::BILINEAR:
+    return std::max(1.0 - x, 0.0);
+  case ResizeFilter::BICUBIC:
+    return x < 1.0 ? (1.5 * x - 2.5) * x * x + 1.0
+      : x < 2.0 ? ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0 : 0.0;
+  case ResizeFilter::LANCZOS3:
+    return x < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+  default:
+    return x < 3.0 ? Sinc(x) * BesselI0(kKaiserAlpha * std::sqrt(1.0 - x * x / 9.0)) / BesselI0(kKaiserAlpha)
+      : 0.0;
+  }
+}
+
+/**
+ * @brief Filter taps of one axis, the same number for every output pixel.
+ * @details Output i is the sum of weights[i * taps + t] * source[start[i] + t] over t < taps.
+ * The filter is stretched by the scale when shrinking, so that every source pixel contributes.
+ * Taps outside the source are dropped and the rest renormalized, which doesn't bias the edges
+ * the way repeating the edge pixels does.
+ */
+struct ResizeAxis {
+  uint32_t taps{0};
+  std::vector<uint32_t> start;
+  std::vector<float> weights;
+  std::vector<float> weights4; //!< every weight repeated 4 times, for 4 channel rows
+};
+
+inline ResizeAxis MakeResizeAxis(uint32_t src_size, uint32_t dst_size, ResizeFilter filter) {
+  double scale = (double)src_size / dst_size;
+  double filter_scale = std::max(scale, 1.0);
+  double radius = FilterSupport(filter) * filter_scale;
+  std::vector<std::vector<double>> weights(dst_size);
+  std::vector<uint32_t> first(dst_size);
+  uint32_t taps = 1;
+  for (uint32_t i = 0; i < dst_size; i++) {
+    // pixel centers are at integer + 0.5 in both images
+    double center = (i + 0.5) * scale - 0.5;
+    int64_t lo = (int64_t)std::ceil(center - radius);
+    int64_t hi = (int64_t)std::floor(center + radius);
+    uint32_t lo_clamped = (uint32_t)std::min<int64_t>(std::max<int64_t>(lo, 0), src_size - 1);
+    uint32_t hi_clamped = (uint32_t)std::min<int64_t>(std::max<int64_t>(hi, 0), src_size - 1);
+    std::vector<double> w(hi_clamped - lo_clamped + 1, 0.0);
+    double sum = 0.0;
+    for (int64_t j = lo; j <= hi; j++) {
+      double weight;
+      if (filter == ResizeFilter::BOX && scale > 1.0) {
+        // exact coverage of the source pixel by the output pixel
+        weight = std::max(0.0, std::min(j + 0.5, center + scale / 2) - std::max(j - 0.5, center - scale / 2));
+      } else {
+        weight = FilterWeight(filter, (j - center) / filter_scale);
+      }
+      if (std::fabs(weight) < 1e-9) {
+        weight = 0.0;  // e.g. the zero crossings of the sinc at identity scale
+      }
+      if (j >= 0 && j < src_size) {
+        w[j - lo_clamped] = weight;
+        sum += weight;
+      }
+    }
+    // drop the zero taps at either end
+    size_t begin = 0;
+    size_t end = w.size();
+    while (end - begin > 1 && w[begin] == 0.0) {
+      begin++;
+    }
+    while (end - begin > 1 && w[end - 1] == 0.0) {
+      end--;
+    }
+    for (double &weight: w) {
+      weight /= sum;
+    }
+    weights[i].assign(w.begin() + begin, w.begin() + end);
+    first[i] = lo_clamped + (uint32_t)begin;
+    taps = std::max(taps, (uint32_t)weights[i].size());
+  }
+
+  ResizeAxis axis;
+  axis.taps = taps;
+  axis.start.resize(dst_size);
+  axis.weights.assign((size_t)dst_size * taps, 0.0f);
+  for (uint32_t i = 0; i < dst_size; i++) {
+    // pad to taps, moving the window back inside the source at the far edge
+    uint32_t start = std::min(first[i], src_size - taps);
+    axis.start[i] = start;
+    for (size_t t = 0; t < weights[i].size(); t++) {
+      axis.weights[(size_t)i * taps + first[i] - start + t] = (float)weights[i][t];
+    }
+  }
+  axis.weights4.resize(axis.weights.size() * 4);
+  for (size_t i = 0; i < axis.weights4.size(); i++) {
+    axis.weights4[i] = axis.weights[i / 4];
+  }
+  return axis;
+}
+
+//! One row of channel type T to floats, in the value range of T.
+template<ChannelType T>
+const float *DecodeResizeRow(const void *src, size_t n, float *buffer) {
+  if constexpr (T == ChannelType::F32) {
+    return (const float*)src;
+  } else if constexpr (T == ChannelType::F16) {
+    HalfToFloat(buffer, (const Half*)src, n);
+  } else {
+    const typename Channel<T>::type *s = (const typename Channel<T>::type*)src;
+    for (size_t i = 0; i < n; i++) {
+      buffer[i] = (float)s[i];
+    }
+  }
+  return buffer;
+}
+
+//! Floats back to channel type T, integers clamped and rounded to nearest.
+template<ChannelType T>
+void EncodeResizeRow(void *dst, const float *src, size_t n) {
+  using TValue = typename Channel<T>::type;
+  if constexpr (T == ChannelType::F32) {
+    if (dst != src) {
+      memcpy(dst, src, n * sizeof(float));
+    }
+  } else if constexpr (T == ChannelType::F16) {
+    FloatToHalf((Half*)dst, src, n);
+  } else if constexpr (sizeof(TValue) == 4) {
+    // the 32 bit limits aren't floats, clamp in double
+    TValue *d = (TValue*)dst;
+    const double lo = (double)std::numeric_limits<TValue>::lowest();
+    const double hi = (double)std::numeric_limits<TValue>::max();
+    for (size_t i = 0; i < n; i++) {
+      d[i] = (TValue)std::min(std::max(std::floor((double)src[i] + 0.5), lo), hi);
+    }
+  } else if constexpr (std::numeric_limits<TValue>::is_signed) {
+    TValue *d = (TValue*)dst;
+    const float lo = (float)std::numeric_limits<TValue>::lowest();
+    const float hi = (float)std::numeric_limits<TValue>::max();
+    for (size_t i = 0; i < n; i++) {
+      d[i] = (TValue)std::floor(std::min(std::max(src[i], lo), hi) + 0.5f);
+    }
+  } else {
+    TValue *d = (TValue*)dst;
+    const float hi = (float)std::numeric_limits<TValue>::max();
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    if constexpr (T == ChannelType::U8) {
+      // rounded like the loop below, the saturating packs clamp at 0
+      const __m128 max = _mm_set1_ps(hi);
+      const __m128 half = _mm_set1_ps(0.5f);
+      auto rounded = [&](const float *p) {
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_loadu_ps(p), max), half));
+      };
+      for (; i + 16 <= n; i += 16) {
+        __m128i a = rounded(src + i);
+        __m128i b = rounded(src + i + 4);
+        __m128i c = rounded(src + i + 8);
+        __m128i e = rounded(src + i + 12);
+        _mm_storeu_si128((__m128i*)(d + i),
+          _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, e)));
+      }
+    }
+#endif
+    for (; i < n; i++) {
+      // through int32, float to unsigned doesn't vectorize
+      d[i] = (TValue)(int32_t)(std::min(std::max(src[i], 0.0f), hi) + 0.5f);
+    }
+  }
+}
+
+//! One row of 8 bit sRGB pixels to linear floats in [0, 1], alpha of 4 channels kept linear.
+template<uint32_t C>
+const float *DecodeSRGBRow(const uint8_t *src, size_t n, float *buffer) {
+  SRGBToLinear(buffer, src, n);
+  if constexpr (C == 4) {
+    const SRGBTables &t = GetSRGBTables();
+    for (size_t i = 3; i < n; i += 4) {
+      buffer[i] = t.alpha[src[i]];
+    }
+  }
+  return buffer;
+}
+
+//! Linear floats back to 8 bit sRGB pixels, the inverse of DecodeSRGBRow().
+template<uint32_t C>
+void EncodeSRGBRow(uint8_t *dst, const float *src, size_t n) {
+  LinearToSRGB(dst, src, n);
+  if constexpr (C == 4) {
+    for (size_t i = 3; i < n; i += 4) {
+      dst[i] = (uint8_t)((src[i] > 0.0f ? std::min(src[i], 1.0f) : 0.0f) * 255.0f + 0.5f);
+    }
+  }
+}
+
+//! Horizontal pass of one row of C channel pixels.
+template<uint32_t C>
+void FilterResizeRow(float *dst, const float *src, const ResizeAxis &axis) {
+  const float *w = axis.weights.data();
+  uint32_t taps = axis.taps;
+  for (size_t x = 0; x < axis.start.size(); x++, w += taps) {
+    const float *s = src + (size_t)axis.start[x] * C;
+    float acc[C] = {};
+    for (uint32_t t = 0; t < taps; t++) {
+      for (uint32_t c = 0; c < C; c++) {
+        acc[c] += w[t] * s[t * C + c];
+      }
+    }
+    for (uint32_t c = 0; c < C; c++) {
+      dst[x * C + c] = acc[c];
+    }
+  }
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+inline __m128 LoadPixelU8x4(const uint8_t *p) {
+  int32_t bytes;
+  memcpy(&bytes, p, 4);
+  __m128i zero = _mm_setzero_si128();
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero));
+}
+
+inline __m128 LoadPixelF32x4(const float *p) {
+  return _mm_loadu_ps(p);
+}
+
+/**
+ * @brief Horizontal pass of one row of 4 channel pixels, one pixel per register.
+ * @details Source pixels are converted as they are read. Weights come pre-broadcast from
+ * axis.weights4, and two accumulators split the taps so that the adds don't wait on each other.
+ */
+template<typename TSrc, typename TLoad>
+void FilterResizeRow4(float *dst, const TSrc *src, const ResizeAxis &axis, const TLoad &load) {
+  const __m128 *w = (const __m128*)axis.weights4.data();
+  uint32_t taps = axis.taps;
+  for (size_t x = 0; x < axis.start.size(); x++, w += taps) {
+    const TSrc *s = src + (size_t)axis.start[x] * 4;
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    uint32_t t = 0;
+    for (; t + 2 <= taps; t += 2) {
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(w[t], load(s + t * 4)));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(w[t + 1], load(s + t * 4 + 4)));
+    }
+    if (t < taps) {
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(w[t], load(s + t * 4)));
+    }
+    _mm_storeu_ps(dst + x * 4, _mm_add_ps(acc0, acc1));
+  }
+}
+#endif
+
+//! Vertical pass: dst = sum of weights[t] * rows[t], n values each.
+inline void FilterResizeColumns(float *dst, const float *const *rows, const float *weights, uint32_t taps,
+  size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  // 16 values at a time summed in registers over all taps
+  for (; i + 16 <= n; i += 16) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+    for (uint32_t t = 0; t < taps; t++) {
+      __m128 w = _mm_set1_ps(weights[t]);
+      const float *r = rows[t] + i;
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(w, _mm_loadu_ps(r)));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(w, _mm_loadu_ps(r + 4)));
+      acc2 = _mm_add_ps(acc2, _mm_mul_ps(w, _mm_loadu_ps(r + 8)));
+      acc3 = _mm_add_ps(acc3, _mm_mul_ps(w, _mm_loadu_ps(r + 12)));
+    }
+    _mm_storeu_ps(dst + i, acc0);
+    _mm_storeu_ps(dst + i + 4, acc1);
+    _mm_storeu_ps(dst + i + 8, acc2);
+    _mm_storeu_ps(dst + i + 12, acc3);
+  }
+#endif
+  for (; i < n; i++) {
+    float acc = 0.0f;
+    for (uint32_t t = 0; t < taps; t++) {
+      acc += weights[t] * rows[t][i];
+    }
+    dst[i] = acc;
+  }
+}
+
+//! Horizontal pass of source row src_row into dst, decoding it first where needed.
+template<ChannelType T, uint32_t C, bool kSRGB>
+void FilterSourceRow(float *dst, const void *src_row, size_t src_len, float *buffer, const ResizeAxis &ax) {
+  const float *row;
+  if constexpr (kSRGB) {
+    row = DecodeSRGBRow<C>((const uint8_t*)src_row, src_len, buffer);
+  } else {
+#if defined(__SSE2__) || defined(_M_X64)
+    if constexpr (C == 4 && T == ChannelType::U8) {
+      FilterResizeRow4(dst, (const uint8_t*)src_row, ax, LoadPixelU8x4);
+      return;
+    }
+#endif
+    row = DecodeResizeRow<T>(src_row, src_len, buffer);
+  }
+#if defined(__SSE2__) || defined(_M_X64)
+  if constexpr (C == 4) {
+    FilterResizeRow4(dst, row, ax, LoadPixelF32x4);
+    return;
+  }
+#endif
+  FilterResizeRow<C>(dst, row, ax);
+}
+
+/**
+ * @brief Resize the output rows [y0, y1) of slices [z0, z1).
+ * @details Source rows are filtered horizontally once into a ring of ay.taps * az.taps rows,
+ * which the output rows then combine over y and z. With kSRGB, 8 bit sRGB pixels are filtered
+ * in linear space.
+ */
+template<ChannelType T, uint32_t C, bool kSRGB>
+void ResizeBand(ImgROI &dst, const ImgROI &src, const ResizeAxis &ax, const ResizeAxis &ay,
+  const ResizeAxis &az, uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  size_t src_len = (size_t)src.Width() * C;
+  size_t dst_len = (size_t)dst.Width() * C;
+  uint32_t taps = ay.taps * az.taps;
+  bool in_place = T == ChannelType::F32 && !kSRGB;
+  std::vector<float> ring((size_t)taps * dst_len);
+  std::vector<int64_t> ring_row(taps, -1);
+  std::vector<float> decoded(in_place ? 0 : src_len);
+  std::vector<float> out(in_place ? 0 : dst_len);
+  std::vector<const float*> rows(taps);
+  std::vector<float> weights(taps);
+  for (uint32_t z = z0; z < z1; z++) {
+    for (uint32_t y = y0; y < y1; y++) {
+      for (uint32_t tz = 0; tz < az.taps; tz++) {
+        uint32_t slice = az.start[z] + tz;
+        for (uint32_t ty = 0; ty < ay.taps; ty++) {
+          uint32_t r = ay.start[y] + ty;
+          uint32_t index = r % ay.taps + slice % az.taps * ay.taps;
+          int64_t key = (int64_t)slice * src.Height() + r;
+          float *slot = ring.data() + (size_t)index * dst_len;
+          if (ring_row[index] != key) {
+            FilterSourceRow<T, C, kSRGB>(slot, src.PtrAt(0, r, slice, 0), src_len, decoded.data(), ax);
+            ring_row[index] = key;
+          }
+          rows[tz * ay.taps + ty] = slot;
+          weights[tz * ay.taps + ty] = ay.weights[(size_t)y * ay.taps + ty] * az.weights[(size_t)z * az.taps + tz];
+        }
+      }
+      void *dst_row = dst.PtrAt(0, y, z, 0);
+      float *result = in_place ? (float*)dst_row : out.data();
+      FilterResizeColumns(result, rows.data(), weights.data(), taps, dst_len);
+      if constexpr (kSRGB) {
+        EncodeSRGBRow<C>((uint8_t*)dst_row, result, dst_len);
+      } else {
+        EncodeResizeRow<T>(dst_row, result, dst_len);
+      }
+    }
+  }
+}
+
+template<ChannelType T, bool kSRGB>
+void ResizeBand(ImgROI &dst, const ImgROI &src, const ResizeAxis &ax, const ResizeAxis &ay,
+  const ResizeAxis &az, uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  switch (src.Channel()) {
+  case 1: ResizeBand<T, 1, kSRGB>(dst, src, ax, ay, az, y0, y1, z0, z1); break;
+  case 2: ResizeBand<T, 2, kSRGB>(dst, src, ax, ay, az, y0, y1, z0, z1); break;
+  case 3: ResizeBand<T, 3, kSRGB>(dst, src, ax, ay, az, y0, y1, z0, z1); break;
+  default: ResizeBand<T, 4, kSRGB>(dst, src, ax, ay, az, y0, y1, z0, z1); break;
+  }
+}
+
+//! ResizeBand() for the channel type of src. srgb filters 8 bit sRGB data in linear space.
+inline void ResizeBand(bool srgb, ImgROI &dst, const ImgROI &src, const ResizeAxis &ax,
+  const ResizeAxis &ay, const ResizeAxis &az, uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+  switch (GetChannelType(src)) {
+  case ChannelType::U8:
+    if (srgb) {
+      ResizeBand<ChannelType::U8, true>(dst, src, ax, ay, az, y0, y1, z0, z1);
+    } else {
+      ResizeBand<ChannelType::U8, false>(dst, src, ax, ay, az, y0, y1, z0, z1);
+    }
+    break;
+  case ChannelType::U16: ResizeBand<ChannelType::U16, false>(dst, src, ax, ay, az, y0, y1, z0, z1); break;
+  case ChannelType::F16: ResizeBand<ChannelType::F16, false>(dst, src, ax, ay, az, y0, y1, z0, z1); break;
+  default: ResizeBand<ChannelType::F32, false>(dst, src, ax, ay, az, y0, y1, z0, z1); break;
+  }
+}
+
+//! true if Resize() supports the format of roi
+inline bool IsResizable(const ImgROI &roi) {
+  ChannelType type = GetChannelType(roi);
+  return roi.Channel() > 0 && roi.Channel() <= 4 && (type == ChannelType::U8
+    || type == ChannelType::U16 || type == ChannelType::F16 || type == ChannelType::F32);
+}
+
+}
+
+/**
+ * @brief Resample src to the size of dst.
+ * @details Separable: the filter coefficients of each axis are computed once, then every band
+ * of output rows filters the source rows it needs horizontally and combines them vertically,
+ * in float. Shrinking stretches the filter over all covered source pixels, so large ratios
+ * don't alias. 3D ROIs are resized slice by slice. Outputs of at least kParallelResizeValues
+ * channel values run in row bands on executor.
+ *
+ * @param dst destination ROI, its width and height are the target size.
+ * @param src source ROI of 8 or 16 bit unsigned, f16 or f32 channels, 1 to 4 of them.
+ * @param filter reconstruction filter.
+ * @param executor executor running large resizes, DefaultThreadPool() if not specified.
+ * @return false if src and dst differ in format, channel count or depth, or the format is not
+ * supported.
+ */
+inline bool Resize(ImgROI &dst, const ImgROI &src, ResizeFilter filter = ResizeFilter::BILINEAR,
+  Executor &executor = DefaultThreadPool()) {
+  if (GetChannelType(src) != GetChannelType(dst) || src.Channel() != dst.Channel()
+    || src.Depth() != dst.Depth() || !detail::IsResizable(src)) {
+    return false;
+  }
+  if (dst.Width() == 0 || dst.Height() == 0 || dst.Depth() == 0) {
+    return true;
+  }
+  if (src.Width() == 0 || src.Height() == 0) {
+    return false;
+  }
+  detail::ResizeAxis ax = detail::MakeResizeAxis(src.Width(), dst.Width(), filter);
+  detail::ResizeAxis ay = detail::MakeResizeAxis(src.Height(), dst.Height(), filter);
+  detail::ResizeAxis az = detail::MakeResizeAxis(src.Depth(), dst.Depth(), filter);
+  auto band = [&](uint32_t y0, uint32_t y1, uint32_t z0, uint32_t z1) {
+    detail::ResizeBand(false, dst, src, ax, ay, az, y0, y1, z0, z1);
+  };
+  uint64_t values = (uint64_t)dst.Width() * dst.Height() * dst.Depth() * dst.Channel();
+  if (values >= detail::kParallelResizeValues) {
+    detail::ForEachBand(dst.Height(), dst.Depth(), executor, band);
+  } else {
+    band(0, dst.Height(), 0, dst.Depth());
+  }
+  return true;
+}
+
+}
+
+#endif // IMGPP_RESIZE_HPP
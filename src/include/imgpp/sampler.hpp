@@ -7,16 +7,18 @@
 
 namespace imgpp {
 
-template<typename T>
-T Tex2DNN(const ImgROI &roi, float x, float y) {
+//! Nearest neighbor sample. TROI is any ROI with a 2D At<T>(x, y), e.g. ImgROI or TiledROI.
+template<typename T, typename TROI>
+T Tex2DNN(const TROI &roi, float x, float y) {
   uint32_t ui = (uint32_t)(x + 0.5f);
   uint32_t vi = (uint32_t)(y + 0.5f);
 
-  return roi.At<T>(ui, vi);
+  return roi.template At<T>(ui, vi);
 }
 
-template<typename T>
-T Tex2DBilinear(const ImgROI &roi, float x, float y) {
+//! Bilinear sample. TROI is any ROI with a 2D At<T>(x, y), e.g. ImgROI or TiledROI.
+template<typename T, typename TROI>
+T Tex2DBilinear(const TROI &roi, float x, float y) {
   uint32_t u0 = std::max((uint32_t)floor(x), 0u);
   uint32_t v0 = std::max((uint32_t)floor(y), 0u);
   uint32_t u1 = std::min(u0 + 1, roi.Width() - 1);
@@ -24,10 +26,10 @@ T Tex2DBilinear(const ImgROI &roi, float x, float y) {
   float u = x - u0;
   float v = y - v0;
 
-  auto val_u0 = roi.At<T>(u0, v0);
-  auto val_u1 = roi.At<T>(u1, v0);
-  auto val_u2 = roi.At<T>(u0, v1);
-  auto val_u3 = roi.At<T>(u1, v1);
+  auto val_u0 = roi.template At<T>(u0, v0);
+  auto val_u1 = roi.template At<T>(u1, v0);
+  auto val_u2 = roi.template At<T>(u0, v1);
+  auto val_u3 = roi.template At<T>(u1, v1);
   auto val_uv0 = static_cast<typename Interpolatable<T>::type>(val_u0) * (1.0f - u)
     + static_cast<typename Interpolatable<T>::type>(val_u1) * u;
   auto val_uv1 = static_cast<typename Interpolatable<T>::type>(val_u2) * (1.0f - u)
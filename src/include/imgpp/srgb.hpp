@@ -0,0 +1,313 @@
+#ifndef IMGPP_SRGB_HPP
+#define IMGPP_SRGB_HPP
+
+/*! \file srgb.hpp
+ *  \brief sRGB <-> linear conversion of 8 bit sRGB data, e.g. the *_SRGB texture formats.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <imgpp/copy.hpp>
+#include <imgpp/half.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace imgpp {
+
+//! \brief sRGB encoded value in [0, 1] to linear, the reference formula.
+inline float SRGBToLinear(float v) {
+  return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+//! \brief Linear value in [0, 1] to sRGB encoded, the reference formula.
+inline float LinearToSRGB(float v) {
+  return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+}
+
+namespace detail {
+
+//! linear values below kSRGBBucketMin all encode to 0, see SRGBTables
+constexpr float kSRGBBucketMin = 1.0f / 8192.0f;
+
+enum : uint32_t {
+  kSRGBBucketBase = (127 - 13) << 7,  //!< top 16 bits of kSRGBBucketMin
+  kSRGBBuckets = 13 << 7  //!< 128 buckets per power of 2 in [2^-13, 1)
+};
+
+/**
+ * @brief Lookup tables of the sRGB conversions.
+ * @details Encoding splits [2^-13, 1) into buckets by the top 16 bits of the float. Each bucket
+ * is narrow enough to hold at most one rounding threshold, the smallest value whose correctly
+ * rounded code is one more. A bucket stores its first code above bit 17 and the low 16 bits of
+ * its threshold below, or 0x10000 without one; the code of a value is then the first code, plus
+ * 1 if its low 16 bits reach the threshold.
+ */
+struct SRGBTables {
+  float to_linear[256];
+  Half to_linear_half[256];
+  float alpha[256]; //!< code / 255, for the linear alpha channel
+  Half alpha_half[256];
+  uint32_t buckets[kSRGBBuckets];
+};
+
+inline double SRGBToLinearExact(double v) {
+  return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+//! correctly rounded 8 bit code of a linear value in [0, 1]
+inline uint32_t LinearToSRGBCode(float v) {
+  double x = std::min(std::max((double)v, 0.0), 1.0);
+  double s = x <= 0.0031308 ? x * 12.92 : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+  return (uint32_t)std::floor(s * 255.0 + 0.5);
+}
+
+inline SRGBTables MakeSRGBTables() {
+  SRGBTables t;
+  for (uint32_t i = 0; i < 256; i++) {
+    t.to_linear[i] = (float)SRGBToLinearExact(i / 255.0);
+    t.to_linear_half[i] = Half(t.to_linear[i]);
+    t.alpha[i] = i / 255.0f;
+    t.alpha_half[i] = Half(t.alpha[i]);
+  }
+  uint32_t thresholds[256];
+  for (uint32_t i = 0; i < 255; i++) {
+    // the midpoint in float precision, moved to the exact switch-over of the double formula
+    float v = (float)SRGBToLinearExact((i + 0.5) / 255.0);
+    while (LinearToSRGBCode(v) > i) {
+      v = std::nextafter(v, 0.0f);
+    }
+    while (LinearToSRGBCode(v) <= i) {
+      v = std::nextafter(v, 1.0f);
+    }
+    memcpy(&thresholds[i], &v, 4);
+  }
+  thresholds[255] = 0xffffffff;
+  for (uint32_t i = 0; i < kSRGBBuckets; i++) {
+    uint32_t bits = (kSRGBBucketBase + i) << 16;
+    float v;
+    memcpy(&v, &bits, 4);
+    uint32_t code = LinearToSRGBCode(v);
+    uint32_t threshold = thresholds[code];
+    t.buckets[i] = (code << 17) | ((threshold >> 16) == (bits >> 16) ? threshold & 0xffff : 0x10000);
+  }
+  return t;
+}
+
+inline const SRGBTables &GetSRGBTables() {
+  static const SRGBTables tables = MakeSRGBTables();
+  return tables;
+}
+
+inline uint8_t EncodeSRGB(float v, const SRGBTables &t) {
+  // clamp to [2^-13, largest float below 1], NaN to 0
+  v = kSRGBBucketMin < v ? v : kSRGBBucketMin;
+  v = v < 0.99999994f ? v : 0.99999994f;
+  uint32_t bits;
+  memcpy(&bits, &v, 4);
+  uint32_t bucket = t.buckets[(bits >> 16) - kSRGBBucketBase];
+  return (uint8_t)((bucket >> 17) + ((bits & 0xffff) >= (bucket & 0x1ffff)));
+}
+
+}
+
+/**
+ * @brief Decode n sRGB codes to linear floats, through a 256 entry table.
+ * @details Uses AVX2 gathers where the target has them.
+ */
+inline void SRGBToLinear(float *dst, const uint8_t *src, size_t n) {
+  const detail::SRGBTables &t = detail::GetSRGBTables();
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+    _mm256_storeu_ps(dst + i, _mm256_i32gather_ps(t.to_linear, idx, 4));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = t.to_linear[src[i]];
+  }
+}
+
+//! \brief Decode n sRGB codes to linear half floats, through a 256 entry table.
+inline void SRGBToLinear(Half *dst, const uint8_t *src, size_t n) {
+  const detail::SRGBTables &t = detail::GetSRGBTables();
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = t.to_linear_half[src[i]];
+  }
+}
+
+/**
+ * @brief Encode n linear floats to sRGB codes, correctly rounded.
+ * @details The results match round(LinearToSRGB(v) * 255) computed in double precision for every
+ * float. Values are clamped to [0, 1], NaNs encode to 0. Takes one table lookup per value, as
+ * AVX2 gathers where the target has them, with the rest of the work in SSE2 otherwise.
+ */
+inline void LinearToSRGB(uint8_t *dst, const float *src, size_t n) {
+  const detail::SRGBTables &t = detail::GetSRGBTables();
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256 lo = _mm256_set1_ps(detail::kSRGBBucketMin);
+  const __m256 hi = _mm256_set1_ps(0.99999994f);
+  const __m256i base = _mm256_set1_epi32(detail::kSRGBBucketBase);
+  const __m256i low_mask = _mm256_set1_epi32(0xffff);
+  const __m256i threshold_mask = _mm256_set1_epi32(0x1ffff);
+  for (; i + 8 <= n; i += 8) {
+    // max() returns its second operand for NaNs
+    __m256i bits = _mm256_castps_si256(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), lo), hi));
+    __m256i index = _mm256_sub_epi32(_mm256_srli_epi32(bits, 16), base);
+    __m256i bucket = _mm256_i32gather_epi32((const int*)t.buckets, index, 4);
+    // code + 1, minus 1 where the threshold is above the value
+    __m256i below = _mm256_cmpgt_epi32(_mm256_and_si256(bucket, threshold_mask), _mm256_and_si256(bits, low_mask));
+    __m256i code = _mm256_add_epi32(_mm256_srli_epi32(bucket, 17), _mm256_add_epi32(below, _mm256_set1_epi32(1)));
+    __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(code), _mm256_extracti128_si256(code, 1));
+    _mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(words, words));
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  const __m128 lo = _mm_set1_ps(detail::kSRGBBucketMin);
+  const __m128 hi = _mm_set1_ps(0.99999994f);
+  const __m128i base = _mm_set1_epi32(detail::kSRGBBucketBase);
+  const __m128i low_mask = _mm_set1_epi32(0xffff);
+  const __m128i threshold_mask = _mm_set1_epi32(0x1ffff);
+  for (; i + 8 <= n; i += 8) {
+    // the same as the AVX2 loop with the gathers done by scalar loads, 2 x 4 values
+    alignas(16) uint32_t index[8];
+    alignas(16) uint32_t bucket[8];
+    __m128i bits[2];
+    for (int k = 0; k < 2; k++) {
+      bits[k] = _mm_castps_si128(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4 * k), lo), hi));
+      _mm_store_si128((__m128i*)index + k, _mm_sub_epi32(_mm_srli_epi32(bits[k], 16), base));
+    }
+    for (int k = 0; k < 8; k++) {
+      bucket[k] = t.buckets[index[k]];
+    }
+    __m128i code[2];
+    for (int k = 0; k < 2; k++) {
+      __m128i b = _mm_load_si128((const __m128i*)bucket + k);
+      __m128i below = _mm_cmpgt_epi32(_mm_and_si128(b, threshold_mask), _mm_and_si128(bits[k], low_mask));
+      code[k] = _mm_add_epi32(_mm_srli_epi32(b, 17), _mm_add_epi32(below, _mm_set1_epi32(1)));
+    }
+    __m128i words = _mm_packs_epi32(code[0], code[1]);
+    _mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(words, words));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = detail::EncodeSRGB(src[i], t);
+  }
+}
+
+//! \brief Encode n linear half floats to sRGB codes, correctly rounded.
+inline void LinearToSRGB(uint8_t *dst, const Half *src, size_t n) {
+  float values[1024];
+  for (size_t i0 = 0; i0 < n; i0 += 1024) {
+    size_t m = std::min<size_t>(1024, n - i0);
+    HalfToFloat(values, src + i0, m);
+    LinearToSRGB(dst + i0, values, m);
+  }
+}
+
+namespace detail {
+
+//! Run row(dst_row, src_row, width) over the rows of src, in parallel for large images.
+template<typename TRow>
+bool ForEachSRGBRow(ImgROI &dst, const ImgROI &src, const TRow &row, Executor &executor) {
+  if (src.Width() > dst.Width() || src.Height() > dst.Height() || src.Depth() > dst.Depth()
+    || src.Channel() != dst.Channel()) {
+    return false;
+  }
+  if (src.Width() == 0 || src.Height() == 0 || src.Depth() == 0) {
+    return true;
+  }
+  ImgROI dst_view(dst, 0, 0, 0, src.Width() - 1, src.Height() - 1, src.Depth() - 1);
+  auto convert_row = [&row](uint32_t, uint32_t, uint32_t w, auto &ptrs) {
+    row(ptrs[0], ptrs[1], w);
+  };
+  uint64_t bytes = (uint64_t)src.Width() * src.Height() * src.Depth() * src.Channel() * 4;
+  if (bytes >= kParallelCopyBytes) {
+    ParallelZipTransformRows(std::make_tuple(dst_view, src), convert_row, executor);
+  } else {
+    ZipTransformRows(std::make_tuple(dst_view, src), convert_row);
+  }
+  return true;
+}
+
+}
+
+/**
+ * @brief Decode 8 bit sRGB pixels to linear f32 or f16 pixels.
+ * @details As for the *_SRGB texture formats, the alpha channel of 4 channel images is stored
+ * linearly and only rescaled to [0, 1]; every other channel is decoded. Images of at least
+ * kParallelCopyBytes are converted in row bands on executor.
+ *
+ * @param dst f32 or f16 ROI with the channel count of src, at least as large as src.
+ * @param src 8 bit unsigned ROI.
+ * @return false on any other format or size.
+ */
+inline bool SRGBToLinear(ImgROI &dst, const ImgROI &src, Executor &executor = DefaultThreadPool()) {
+  if (src.BPC() != 8 || src.IsFloat() || !dst.IsFloat() || (dst.BPC() != 32 && dst.BPC() != 16)) {
+    return false;
+  }
+  uint32_t c = src.Channel();
+  bool half = dst.BPC() == 16;
+  return detail::ForEachSRGBRow(dst, src, [c, half](uint8_t *d, const uint8_t *s, uint32_t w) {
+    size_t n = (size_t)w * c;
+    const detail::SRGBTables &t = detail::GetSRGBTables();
+    if (half) {
+      SRGBToLinear((Half*)d, s, n);
+      if (c == 4) {
+        for (size_t i = 3; i < n; i += 4) {
+          ((Half*)d)[i] = t.alpha_half[s[i]];
+        }
+      }
+    } else {
+      SRGBToLinear((float*)d, s, n);
+      if (c == 4) {
+        for (size_t i = 3; i < n; i += 4) {
+          ((float*)d)[i] = t.alpha[s[i]];
+        }
+      }
+    }
+  }, executor);
+}
+
+/**
+ * @brief Encode linear f32 or f16 pixels to 8 bit sRGB pixels, correctly rounded.
+ * @details The alpha channel of 4 channel images is stored linearly, rounded to nearest; every
+ * other channel is encoded. Values are clamped to [0, 1]. Images of at least kParallelCopyBytes
+ * are converted in row bands on executor.
+ *
+ * @param dst 8 bit unsigned ROI with the channel count of src, at least as large as src.
+ * @param src f32 or f16 ROI.
+ * @return false on any other format or size.
+ */
+inline bool LinearToSRGB(ImgROI &dst, const ImgROI &src, Executor &executor = DefaultThreadPool()) {
+  if (dst.BPC() != 8 || dst.IsFloat() || !src.IsFloat() || (src.BPC() != 32 && src.BPC() != 16)) {
+    return false;
+  }
+  uint32_t c = src.Channel();
+  bool half = src.BPC() == 16;
+  return detail::ForEachSRGBRow(dst, src, [c, half](uint8_t *d, const uint8_t *s, uint32_t w) {
+    size_t n = (size_t)w * c;
+    if (half) {
+      LinearToSRGB(d, (const Half*)s, n);
+    } else {
+      LinearToSRGB(d, (const float*)s, n);
+    }
+    if (c == 4) {
+      for (size_t i = 3; i < n; i += 4) {
+        float a = half ? (float)((const Half*)s)[i] : ((const float*)s)[i];
+        d[i] = (uint8_t)((a > 0.0f ? std::min(a, 1.0f) : 0.0f) * 255.0f + 0.5f);
+      }
+    }
+  }, executor);
+}
+
+}
+
+#endif // IMGPP_SRGB_HPP
@@ -0,0 +1,255 @@
+#ifndef IMGPP_STATS_HPP
+#define IMGPP_STATS_HPP
+
+/*! \file stats.hpp
+ *  \brief Allocation and codec I/O counters.
+ *
+ *  Counting is compiled in only when IMGPP_ENABLE_STATS is defined (CMake: -DIMGPP_ENABLE_STATS=ON,
+ *  which defines it for the library and everything linking to it; OFF or unset leaves it out).
+ *  Otherwise every hook is an empty inline function and GetStats() returns zeros.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#if defined(IMGPP_ENABLE_STATS)
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace imgpp {
+
+//! \brief Codecs reporting I/O counters.
+enum class Codec: uint32_t {
+  PNG = 0,
+  JPEG,
+  BMP,
+  PPM,
+  PFM,
+  BSON,
+  KTX,
+  Count
+};
+
+inline const char *CodecName(Codec codec) {
+  static const char *names[] = {"PNG", "JPEG", "BMP", "PPM", "PFM", "BSON", "KTX"};
+  return codec < Codec::Count ? names[(uint32_t)codec] : "unknown";
+}
+
+//! \brief Counters of a single codec.
+struct CodecStats {
+  uint64_t loads{0};  /*!< number of load calls */
+  uint64_t writes{0};  /*!< number of write calls */
+  uint64_t bytes_read{0};  /*!< encoded bytes consumed by loads */
+  uint64_t bytes_written{0};  /*!< encoded bytes produced by writes */
+  uint64_t load_ns{0};  /*!< wall time spent in loads, nanoseconds */
+  uint64_t write_ns{0};  /*!< wall time spent in writes, nanoseconds */
+};
+
+//! \brief Snapshot of all counters, see GetStats().
+struct StatsSnapshot {
+  uint64_t allocations{0};  /*!< number of ImgBuffer allocations */
+  uint64_t bytes_allocated{0};  /*!< total bytes allocated by ImgBuffers */
+  uint64_t live_bytes{0};  /*!< bytes currently held by ImgBuffers */
+  uint64_t peak_bytes{0};  /*!< maximum of live_bytes since start or ResetStats() */
+  CodecStats codecs[(uint32_t)Codec::Count];
+
+  const CodecStats &operator[](Codec codec) const { return codecs[(uint32_t)codec]; }
+};
+
+//! \brief A finished codec call, passed to the stats callback.
+struct CodecEvent {
+  Codec codec;
+  bool write;  /*!< true for writes/encodes, false for loads/decodes */
+  uint64_t bytes;  /*!< encoded bytes read or written */
+  uint64_t nanoseconds;  /*!< wall time of the call */
+};
+
+using StatsCallback = std::function<void(const CodecEvent &)>;
+
+#if defined(IMGPP_ENABLE_STATS)
+
+namespace detail {
+
+struct AtomicCodecStats {
+  std::atomic<uint64_t> loads{0};
+  std::atomic<uint64_t> writes{0};
+  std::atomic<uint64_t> bytes_read{0};
+  std::atomic<uint64_t> bytes_written{0};
+  std::atomic<uint64_t> load_ns{0};
+  std::atomic<uint64_t> write_ns{0};
+};
+
+struct StatsCounters {
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes_allocated{0};
+  std::atomic<uint64_t> live_bytes{0};
+  std::atomic<uint64_t> peak_bytes{0};
+  AtomicCodecStats codecs[(uint32_t)Codec::Count];
+  std::shared_ptr<const StatsCallback> callback;  //!< accessed with std::atomic_load/store
+  std::atomic<bool> has_callback{false};  //!< skips the callback lookup on the common path
+};
+
+inline StatsCounters &Counters() {
+  static StatsCounters counters;
+  return counters;
+}
+
+inline void RecordAllocation(uint64_t length) {
+  auto &counters = Counters();
+  counters.allocations.fetch_add(1, std::memory_order_relaxed);
+  counters.bytes_allocated.fetch_add(length, std::memory_order_relaxed);
+  uint64_t live = counters.live_bytes.fetch_add(length, std::memory_order_relaxed) + length;
+  uint64_t peak = counters.peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+    !counters.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+inline void RecordDeallocation(uint64_t length) {
+  Counters().live_bytes.fetch_sub(length, std::memory_order_relaxed);
+}
+
+//! \brief Times a codec call and accumulates its I/O.
+
+//! Only the outermost scope on a thread records, so a codec delegating to another entry point
+//! (e.g. a file loader calling the memory loader) is counted once; bytes added by nested scopes
+//! go to the outermost one.
+class CodecScope {
+public:
+  CodecScope(Codec codec, bool write): codec_(codec), write_(write), outer_(Active()) {
+    if (outer_ == nullptr) {
+      Active() = this;
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~CodecScope() {
+    if (outer_ != nullptr) {
+      return;
+    }
+    Active() = nullptr;
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start_).count();
+    auto &stats = Counters().codecs[(uint32_t)codec_];
+    if (write_) {
+      stats.writes.fetch_add(1, std::memory_order_relaxed);
+      stats.bytes_written.fetch_add(bytes_, std::memory_order_relaxed);
+      stats.write_ns.fetch_add(ns, std::memory_order_relaxed);
+    } else {
+      stats.loads.fetch_add(1, std::memory_order_relaxed);
+      stats.bytes_read.fetch_add(bytes_, std::memory_order_relaxed);
+      stats.load_ns.fetch_add(ns, std::memory_order_relaxed);
+    }
+    if (Counters().has_callback.load(std::memory_order_acquire)) {
+      auto callback = std::atomic_load(&Counters().callback);
+      if (callback) {
+        (*callback)(CodecEvent{codec_, write_, bytes_, ns});
+      }
+    }
+  }
+
+  CodecScope(const CodecScope &) = delete;
+  CodecScope &operator=(const CodecScope &) = delete;
+
+  //! Add encoded bytes read or written. Negative values (failed stream positions) are ignored.
+  void AddBytes(int64_t bytes) {
+    if (bytes > 0) {
+      (outer_ != nullptr ? outer_ : this)->bytes_ += (uint64_t)bytes;
+    }
+  }
+
+private:
+  static CodecScope *&Active() {
+    static thread_local CodecScope *active = nullptr;
+    return active;
+  }
+
+  Codec codec_;
+  bool write_;
+  CodecScope *outer_;
+  uint64_t bytes_{0};
+  std::chrono::steady_clock::time_point start_;
+};
+
+}
+
+//! \brief true if the library was built with IMGPP_ENABLE_STATS.
+constexpr bool kStatsEnabled = true;
+
+//! \brief Take a snapshot of all counters. Counters are read individually, not atomically as a set.
+inline StatsSnapshot GetStats() {
+  auto &counters = detail::Counters();
+  StatsSnapshot result;
+  result.allocations = counters.allocations.load(std::memory_order_relaxed);
+  result.bytes_allocated = counters.bytes_allocated.load(std::memory_order_relaxed);
+  result.live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+  result.peak_bytes = counters.peak_bytes.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < (uint32_t)Codec::Count; ++i) {
+    auto &src = counters.codecs[i];
+    auto &dst = result.codecs[i];
+    dst.loads = src.loads.load(std::memory_order_relaxed);
+    dst.writes = src.writes.load(std::memory_order_relaxed);
+    dst.bytes_read = src.bytes_read.load(std::memory_order_relaxed);
+    dst.bytes_written = src.bytes_written.load(std::memory_order_relaxed);
+    dst.load_ns = src.load_ns.load(std::memory_order_relaxed);
+    dst.write_ns = src.write_ns.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+//! \brief Zero all counters. live_bytes is kept, and peak_bytes restarts from it.
+inline void ResetStats() {
+  auto &counters = detail::Counters();
+  counters.allocations.store(0, std::memory_order_relaxed);
+  counters.bytes_allocated.store(0, std::memory_order_relaxed);
+  counters.peak_bytes.store(counters.live_bytes.load(std::memory_order_relaxed),
+    std::memory_order_relaxed);
+  for (auto &stats: counters.codecs) {
+    stats.loads.store(0, std::memory_order_relaxed);
+    stats.writes.store(0, std::memory_order_relaxed);
+    stats.bytes_read.store(0, std::memory_order_relaxed);
+    stats.bytes_written.store(0, std::memory_order_relaxed);
+    stats.load_ns.store(0, std::memory_order_relaxed);
+    stats.write_ns.store(0, std::memory_order_relaxed);
+  }
+}
+
+//! \brief Install a callback invoked on the calling thread after every codec call.
+//! Pass nullptr to remove it. The callback must be thread-safe and should return quickly.
+inline void SetStatsCallback(StatsCallback callback) {
+  std::shared_ptr<const StatsCallback> ptr;
+  if (callback) {
+    ptr = std::make_shared<const StatsCallback>(std::move(callback));
+  }
+  bool has_callback = (bool)ptr;
+  std::atomic_store(&detail::Counters().callback, std::move(ptr));
+  detail::Counters().has_callback.store(has_callback, std::memory_order_release);
+}
+
+#else
+
+namespace detail {
+
+inline void RecordAllocation(uint64_t) {}
+inline void RecordDeallocation(uint64_t) {}
+
+class CodecScope {
+public:
+  CodecScope(Codec, bool) {}
+  void AddBytes(int64_t) {}
+};
+
+}
+
+constexpr bool kStatsEnabled = false;
+
+inline StatsSnapshot GetStats() { return StatsSnapshot(); }
+inline void ResetStats() {}
+inline void SetStatsCallback(StatsCallback) {}
+
+#endif
+
+}
+
+#endif // IMGPP_STATS_HPP
@@ -219,6 +219,47 @@ inline bool IsCompressedFormat(TextureFormat format) {
   return format >= FORMAT_BLOCK_COMPRESSION_START && format <= FORMAT_BLOCK_COMPRESSION_LAST;
 }
 
+//! \brief true for formats whose color channels are sRGB encoded, see srgb.hpp.
+inline bool IsSRGBFormat(TextureFormat format) {
+  switch (format) {
+  case FORMAT_R8_SRGB_PACK8:
+  case FORMAT_RG8_SRGB_PACK8:
+  case FORMAT_RGB8_SRGB_PACK8:
+  case FORMAT_RGBA8_SRGB_PACK8:
+  case FORMAT_RGB_DXT1_SRGB_BLOCK8:
+  case FORMAT_RGBA_DXT1_SRGB_BLOCK8:
+  case FORMAT_RGBA_DXT3_SRGB_BLOCK16:
+  case FORMAT_RGBA_DXT5_SRGB_BLOCK16:
+  case FORMAT_RGBA_BP_SRGB_BLOCK16:
+  case FORMAT_RGB_ETC2_SRGB_BLOCK8:
+  case FORMAT_RGBA_ETC2_SRGB_BLOCK8:
+  case FORMAT_RGBA_ETC2_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_4X4_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_5X4_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_5X5_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_6X5_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_6X6_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_8X5_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_8X6_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_8X8_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_10X5_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_10X6_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_10X8_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_10X10_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_12X10_SRGB_BLOCK16:
+  case FORMAT_RGBA_ASTC_12X12_SRGB_BLOCK16:
+  case FORMAT_RGB_PVRTC1_8X8_SRGB_BLOCK32:
+  case FORMAT_RGB_PVRTC1_16X8_SRGB_BLOCK32:
+  case FORMAT_RGBA_PVRTC1_8X8_SRGB_BLOCK32:
+  case FORMAT_RGBA_PVRTC1_16X8_SRGB_BLOCK32:
+  case FORMAT_RGBA_PVRTC2_4X4_SRGB_BLOCK8:
+  case FORMAT_RGBA_PVRTC2_8X4_SRGB_BLOCK8:
+    return true;
+  default:
+    return false;
+  }
+}
+
 }
 
 #endif
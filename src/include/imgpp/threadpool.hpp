@@ -0,0 +1,199 @@
+#ifndef IMGPP_THREADPOOL_HPP
+#define IMGPP_THREADPOOL_HPP
+
+/*! \file threadpool.hpp
+ *  \brief Executors running the Parallel* algorithms.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace imgpp {
+
+//! \brief Executor runs a batch of independent tasks and returns when all of them have finished.
+
+//! Implement it to run the Parallel* algorithms on an existing thread pool or job system.
+class Executor {
+public:
+  virtual ~Executor() {}
+
+  //! \brief Number of tasks that may run at the same time, used to size the work split.
+  virtual uint32_t Concurrency() const = 0;
+
+  //! \brief Call task(0) ... task(num_tasks - 1), in any order and on any thread.
+  //! Each index is run exactly once. Blocks until every task has returned.
+  virtual void Run(size_t num_tasks, const std::function<void(size_t)> &task) = 0;
+};
+
+//! \brief Work-stealing ThreadPool, the default Executor.
+
+//! Run() deals the task indices out in contiguous chunks, one chunk per thread, with the calling
+//! thread taking the first one. A thread that runs out of work steals from the back of the other
+//! threads' queues, so uneven tasks still keep every thread busy. Calls to Run() from different
+//! threads are serialized; a Run() issued from inside a task runs inline on the calling thread.
+class ThreadPool: public Executor {
+public:
+  //! \param num_threads total number of threads including the caller of Run(), 0 for one per
+  //! hardware thread. A pool of 1 runs every task on the calling thread.
+  explicit ThreadPool(uint32_t num_threads = 0) {
+    if (num_threads == 0) {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (uint32_t i = 0; i < num_threads; ++i) {
+      queues_.emplace_back(new Queue);
+    }
+    for (uint32_t i = 1; i < num_threads; ++i) {
+      workers_.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker: workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool &operator=(const ThreadPool&) = delete;
+
+  uint32_t Concurrency() const override {
+    return (uint32_t)queues_.size();
+  }
+
+  void Run(size_t num_tasks, const std::function<void(size_t)> &task) override {
+    if (queues_.size() == 1 || num_tasks <= 1 || InTask()) {
+      for (size_t i = 0; i < num_tasks; ++i) {
+        task(i);
+      }
+      return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    Job job{&task, {num_tasks}};
+    size_t num_queues = queues_.size();
+    for (size_t q = 0; q < num_queues; ++q) {
+      std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+      for (size_t i = num_tasks * q / num_queues; i < num_tasks * (q + 1) / num_queues; ++i) {
+        queues_[q]->items.push_back({&job, i});
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    InTask() = true;
+    Work(0);
+    InTask() = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&job]() { return job.remaining.load() == 0; });
+  }
+
+private:
+  struct Job {
+    const std::function<void(size_t)> *task;
+    std::atomic<size_t> remaining;
+  };
+
+  struct Item {
+    Job *job;
+    size_t index;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Item> items;
+  };
+
+  //! true while the current thread runs pool tasks
+  static bool &InTask() {
+    thread_local bool in_task = false;
+    return in_task;
+  }
+
+  void WorkerLoop(uint32_t self) {
+    InTask() = true;
+    uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this, seen]() { return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+      }
+      Work(self);
+    }
+  }
+
+  //! run tasks from our own queue, then steal from the others until every queue is empty
+  void Work(uint32_t self) {
+    Item item;
+    while (Pop(self, item) || Steal(self, item)) {
+      (*item.job->task)(item.index);
+      if (item.job->remaining.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_all();
+      }
+    }
+  }
+
+  bool Pop(uint32_t self, Item &item) {
+    Queue &queue = *queues_[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.items.empty()) {
+      return false;
+    }
+    item = queue.items.front();
+    queue.items.pop_front();
+    return true;
+  }
+
+  bool Steal(uint32_t self, Item &item) {
+    size_t num_queues = queues_.size();
+    for (size_t offset = 1; offset < num_queues; ++offset) {
+      Queue &queue = *queues_[(self + offset) % num_queues];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.items.empty()) {
+        item = queue.items.back();
+        queue.items.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues_;  //!< one per thread, index 0 belongs to the caller
+  std::vector<std::thread> workers_;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  uint64_t generation_{0};
+  bool stop_{false};
+};
+
+//! \brief Process-wide ThreadPool with one thread per hardware thread, created on first use.
+inline ThreadPool &DefaultThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+}
+
+#endif // IMGPP_THREADPOOL_HPP
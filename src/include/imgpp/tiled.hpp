@@ -0,0 +1,282 @@
+#ifndef IMGPP_TILED_HPP
+#define IMGPP_TILED_HPP
+
+/*! \file tiled.hpp
+ *  \brief 2D images stored in square tiles, for access patterns that are not row by row.
+ */
+
+#include <algorithm>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+
+namespace imgpp {
+
+//! TiledROI is a view into a 2D image stored as square tiles of interleaved pixels.
+
+//! The image is split into tiles of TileSize() x TileSize() pixels (a power of two). Tiles are
+//! stored one after the other in row-major order, and pixels inside a tile are row-major as well,
+//! so a tile occupies TileBytes() contiguous bytes and vertical neighbors are only TilePitch()
+//! bytes apart. Tiles on the right and bottom edges are padded to full size.
+//! Like ImgROI, a TiledROI doesn't own its memory.
+class TiledROI {
+public:
+  friend class TiledImg;
+  friend class ImgBase<TiledROI>;
+
+  enum : uint32_t { kDefaultTileLog2 = 6 };  //!< 64x64 pixel tiles
+
+  //! Default constructor creating an empty region with data_ pointing to NULL.
+  TiledROI() {}
+
+  //! \brief Constructor for a tiled 2D image with known dimension.
+  //! \param tile_log2 log2 of the tile edge length in pixels
+  TiledROI(uint8_t *src, uint32_t w, uint32_t h, uint32_t c, uint32_t bpc,
+    bool is_float, bool is_signed, uint32_t tile_log2 = kDefaultTileLog2) :
+    data_(src), width_(w), height_(h), channel_(c), bpc_(bpc),
+    is_signed_(is_signed), is_float_(is_float), tile_log2_(tile_log2),
+    tile_mask_((1u << tile_log2) - 1), pixel_bytes_((bpc * c) >> 3),
+    tiles_x_((w + tile_mask_) >> tile_log2), tiles_y_((h + tile_mask_) >> tile_log2),
+    tile_pitch_((uint64_t)pixel_bytes_ << tile_log2),
+    tile_bytes_(tile_pitch_ << tile_log2) {}
+
+  //! \brief Bytes needed to store a w x h image with the given pixel format and tile size.
+  static uint64_t CalcSize(uint32_t w, uint32_t h, uint32_t c, uint32_t bpc,
+    uint32_t tile_log2 = kDefaultTileLog2) {
+    uint32_t tile = 1u << tile_log2;
+    uint64_t tiles = (uint64_t)((w + tile - 1) >> tile_log2) * ((h + tile - 1) >> tile_log2);
+    return tiles * (((uint64_t)c * bpc) >> 3) * tile * tile;
+  }
+
+  //! \brief 2D Accessor. Returns a reference to the pixel channel.
+  //! The template parameter is only used to determine the type of the returned value.
+  template<typename T> T &At(uint32_t x, uint32_t y, uint32_t c) {
+    return *(T*)PtrAt(x, y, c);
+  }
+
+  template<typename T> const T &At(uint32_t x, uint32_t y, uint32_t c) const {
+    return *(const T*)PtrAt(x, y, c);
+  }
+
+  template<typename T> T &At(uint32_t x, uint32_t y) {
+    return *(T*)PtrAt(x, y);
+  }
+
+  template<typename T> const T &At(uint32_t x, uint32_t y) const {
+    return *(const T*)PtrAt(x, y);
+  }
+
+  //! \brief 2D Accessor. Returns a void * pointer to the pixel (channel).
+  void *PtrAt(uint32_t x, uint32_t y) {
+    return data_ + Offset(x, y);
+  }
+
+  const void *PtrAt(uint32_t x, uint32_t y) const {
+    return data_ + Offset(x, y);
+  }
+
+  void *PtrAt(uint32_t x, uint32_t y, uint32_t c) {
+    return data_ + Offset(x, y) + c * (bpc_ >> 3);
+  }
+
+  const void *PtrAt(uint32_t x, uint32_t y, uint32_t c) const {
+    return data_ + Offset(x, y) + c * (bpc_ >> 3);
+  }
+
+  //! \brief Pointer to the first pixel of tile (tile_x, tile_y).
+  void *TileAt(uint32_t tile_x, uint32_t tile_y) {
+    return data_ + ((uint64_t)tile_y * tiles_x_ + tile_x) * tile_bytes_;
+  }
+
+  const void *TileAt(uint32_t tile_x, uint32_t tile_y) const {
+    return data_ + ((uint64_t)tile_y * tiles_x_ + tile_x) * tile_bytes_;
+  }
+
+  //! \brief Byte offset of pixel (x, y) from the start of the image.
+  uint64_t Offset(uint32_t x, uint32_t y) const {
+    uint64_t tile = (uint64_t)(y >> tile_log2_) * tiles_x_ + (x >> tile_log2_);
+    uint32_t inner = ((y & tile_mask_) << tile_log2_) + (x & tile_mask_);
+    return tile * tile_bytes_ + (uint64_t)inner * pixel_bytes_;
+  }
+
+  uint32_t Width() const { return width_; }
+  uint32_t Height() const { return height_; }
+  uint32_t Depth() const { return 1; }
+  uint32_t Channel() const { return channel_; }
+  uint8_t BPC() const { return bpc_; }
+  bool IsSigned() const { return is_signed_; }
+  bool IsFloat() const { return is_float_; }
+
+  //! \brief Tile edge length in pixels.
+  uint32_t TileSize() const { return 1u << tile_log2_; }
+  uint32_t TileLog2() const { return tile_log2_; }
+  //! \brief Number of tile columns.
+  uint32_t TilesX() const { return tiles_x_; }
+  //! \brief Number of tile rows.
+  uint32_t TilesY() const { return tiles_y_; }
+  //! \brief Bytes from one row of a tile to the next.
+  uint64_t TilePitch() const { return tile_pitch_; }
+  //! \brief Bytes from one tile to the next.
+  uint64_t TileBytes() const { return tile_bytes_; }
+
+  const uint8_t *GetData() const { return data_; }
+  uint8_t *GetData() { return data_; }
+
+private:
+  uint8_t *data_{nullptr}; //!<Data pointer. NOT a smart pointer hence NOT responsible the buffer!
+  uint32_t width_{0};
+  uint32_t height_{0};
+  uint32_t channel_{0};
+  uint8_t bpc_{0}; //!<bit-depth (bits per channel, NOT bytes)
+  bool is_signed_{true}; //!<Signed/unsigned flag for integer types. Is true for floats.
+  bool is_float_{false}; //!<Flag for float types.
+  uint32_t tile_log2_{kDefaultTileLog2};
+  uint32_t tile_mask_{0};
+  uint32_t pixel_bytes_{0};
+  uint32_t tiles_x_{0};
+  uint32_t tiles_y_{0};
+  uint64_t tile_pitch_{0}; //!<Distance in bytes between consecutive lines of a tile
+  uint64_t tile_bytes_{0}; //!<Distance in bytes between consecutive tiles
+};
+
+//! TiledImg holds a tiled 2D image using an ImgBuffer and a TiledROI.
+class TiledImg: public ImgBase<TiledROI> {
+public:
+  TiledImg() {}
+  TiledImg(ImgBase base): ImgBase(std::move(base)) {}
+  ~TiledImg() {}
+
+  //! Wraps tiles already held by buffer, described by roi. No data is copied.
+  TiledImg(ImgBuffer buffer, const TiledROI &roi): ImgBase(std::move(buffer), roi) {}
+
+  TiledImg(uint32_t w, uint32_t h, uint32_t c, uint32_t bpc, bool is_float = false,
+    bool is_signed = false, uint32_t tile_log2 = TiledROI::kDefaultTileLog2) {
+    SetSize(w, h, c, bpc, is_float, is_signed, tile_log2);
+  }
+
+  //! Allocates memory and creates an ROI for the entire image.
+  void SetSize(uint32_t w, uint32_t h, uint32_t c, uint32_t bpc, bool is_float = false,
+    bool is_signed = false, uint32_t tile_log2 = TiledROI::kDefaultTileLog2) {
+    if (w == 0 || h == 0 || c == 0 || bpc == 0) {
+      return;
+    }
+    buffer_.SetSize(TiledROI::CalcSize(w, h, c, bpc, tile_log2));
+    buffer_.Unshare(false);  // contents are undefined after resizing
+    entire_img_ = TiledROI(buffer_.GetBuffer(), w, h, c, bpc, is_float, is_signed, tile_log2);
+  }
+
+  //! Allocates memory for a tiled image of the same size and format as a linear ROI
+  void SetSizeLike(const ImgROI &src_roi, uint32_t tile_log2 = TiledROI::kDefaultTileLog2) {
+    SetSize(src_roi.Width(), src_roi.Height(), src_roi.Channel(), src_roi.BPC(),
+      src_roi.IsFloat(), src_roi.IsSigned(), tile_log2);
+  }
+};
+
+/*! \fn bool TileData(TiledROI &dst, const ImgROI &src)
+    \brief Copy a linear (row-major) 2D ROI into a tiled ROI, one tile row segment at a time.
+    \return true if succeeded, false if dimension doesn't match.
+*/
+inline bool TileData(TiledROI &dst, const ImgROI &src) {
+  if (src.Width() != dst.Width() || src.Height() != dst.Height()
+    || src.BPC() != dst.BPC() || src.Channel() != dst.Channel()) {
+    return false;
+  }
+  size_t pixel_bytes = ((size_t)src.BPC() * src.Channel()) >> 3;
+  uint32_t tile = dst.TileSize();
+  for (uint32_t y = 0; y < src.Height(); ++y) {
+    const uint8_t *src_row = (const uint8_t*)src.PtrAt(0, y);
+    for (uint32_t x = 0; x < src.Width(); x += tile) {
+      uint32_t span = std::min(tile, src.Width() - x);
+      memcpy(dst.PtrAt(x, y), src_row + x * pixel_bytes, span * pixel_bytes);
+    }
+  }
+  return true;
+}
+
+/*! \fn bool UntileData(ImgROI &dst, const TiledROI &src)
+    \brief Copy a tiled ROI into a linear (row-major) 2D ROI, see TileData().
+    \return true if succeeded, false if dimension doesn't match.
+*/
+inline bool UntileData(ImgROI &dst, const TiledROI &src) {
+  if (src.Width() != dst.Width() || src.Height() != dst.Height()
+    || src.BPC() != dst.BPC() || src.Channel() != dst.Channel()) {
+    return false;
+  }
+  size_t pixel_bytes = ((size_t)src.BPC() * src.Channel()) >> 3;
+  uint32_t tile = src.TileSize();
+  for (uint32_t y = 0; y < src.Height(); ++y) {
+    uint8_t *dst_row = (uint8_t*)dst.PtrAt(0, y);
+    for (uint32_t x = 0; x < src.Width(); x += tile) {
+      uint32_t span = std::min(tile, src.Width() - x);
+      memcpy(dst_row + x * pixel_bytes, src.PtrAt(x, y), span * pixel_bytes);
+    }
+  }
+  return true;
+}
+
+//! \brief Create a tiled copy of a linear 2D ROI.
+inline TiledImg ToTiled(const ImgROI &src, uint32_t tile_log2 = TiledROI::kDefaultTileLog2) {
+  TiledImg result;
+  result.SetSizeLike(src, tile_log2);
+  TileData(result.ROI(), src);
+  return result;
+}
+
+//! \brief Create a linear copy of a tiled ROI.
+inline Img ToLinear(const TiledROI &src) {
+  Img result(src.Width(), src.Height(), 1, src.Channel(), src.BPC(),
+    src.IsFloat(), src.IsSigned());
+  UntileData(result.ROI(), src);
+  return result;
+}
+
+/**
+ * @brief Transform multiple tiled images simultaneously, tile by tile.
+ * @details Same as ZipTransform(), but visits the pixels tile by tile so that each step stays
+ * inside one tile of every image. All images must have the same size and tile size.
+ *
+ * @param imgs an std::tuple or std::array of TiledROIs
+ * @param callback callback function receiving (x, y, z, c, ptrs) as argument, z is always 0.
+ */
+template<typename TImgs, typename TCallback>
+void ZipTransformTiles(TImgs &&imgs, TCallback callback) {
+  constexpr size_t num_imgs = std::tuple_size<typename std::remove_reference<TImgs>::type>::value;
+  std::array<uint8_t*, num_imgs> ptrs;
+  std::array<uint8_t, num_imgs> steps;
+
+  uint32_t w = std::get<0>(imgs).Width();
+  uint32_t h = std::get<0>(imgs).Height();
+  uint32_t ch = std::get<0>(imgs).Channel();
+  uint32_t tile = std::get<0>(imgs).TileSize();
+
+  static_for<0, num_imgs>([&steps, &imgs](auto idx) {
+    steps[idx] = std::get<idx.value>(imgs).BPC() >> 3;
+  });
+
+  for (uint32_t tile_y = 0; tile_y < h; tile_y += tile) {
+    uint32_t y_end = std::min(tile_y + tile, h);
+    for (uint32_t tile_x = 0; tile_x < w; tile_x += tile) {
+      uint32_t x_end = std::min(tile_x + tile, w);
+      for (uint32_t y = tile_y; y < y_end; y++) {
+
+        static_for<0, num_imgs>([&ptrs, &imgs, tile_x, y](auto idx) {
+          ptrs[idx] = (uint8_t*)std::get<idx.value>(imgs).PtrAt(tile_x, y, 0);
+        });
+
+        for (uint32_t x = tile_x; x < x_end; x++) {
+          for (uint32_t c = 0; c < ch; c++) {
+
+            callback(x, y, 0u, c, ptrs);
+
+            static_for<0, num_imgs>([&ptrs, &steps](auto idx) {
+              ptrs[idx] += steps[idx];
+            });
+          }
+        }
+      }
+    }
+  }
+}
+
+}
+
+#endif // IMGPP_TILED_HPP
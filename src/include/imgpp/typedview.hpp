@@ -0,0 +1,239 @@
+#ifndef IMGPP_TYPEDVIEW_HPP
+#define IMGPP_TYPEDVIEW_HPP
+
+/*! \file typedview.hpp
+ *  \brief Views of an ImgROI with the channel type and count fixed at compile time.
+ */
+
+#include <array>
+#include <cmath>
+#include <tuple>
+#include <type_traits>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/algorithms.hpp>
+#include <imgpp/half.hpp>
+#include <imgpp/sampler.hpp>
+#include <imgpp/typetraits.hpp>
+
+namespace imgpp {
+
+//! \brief Contiguous range of elements, e.g. one row of a TypedView.
+template<typename T>
+class Span {
+public:
+  Span(T *data, size_t size): data_(data), size_(size) {}
+
+  T *data() const { return data_; }
+  size_t size() const { return size_; }
+  T *begin() const { return data_; }
+  T *end() const { return data_ + size_; }
+  T &operator[](size_t idx) const { return data_[idx]; }
+
+private:
+  T *data_;
+  size_t size_;
+};
+
+//! TypedView is an ImgROI whose channel type T and channel count C are compile-time constants.
+
+//! Offsets and pixel strides are constant expressions, so loops over a TypedView vectorize.
+//! The view is built from an ImgROI after a runtime format check: if the ROI's bpc, channel count,
+//! float flag or integer signedness don't match T and C, the view is empty (see Empty()). Use a const T for a
+//! read-only view of a const ImgROI. Like ImgROI, a TypedView doesn't own its memory.
+template<typename T, uint32_t C>
+class TypedView {
+public:
+  using value_type = typename std::remove_const<T>::type;
+  //! All channels of one pixel. Same size and layout as the pixel in memory.
+  using Pixel = typename std::conditional<std::is_const<T>::value,
+    const std::array<value_type, C>, std::array<value_type, C>>::type;
+
+  static constexpr uint32_t kChannels = C;
+  static constexpr uint32_t kPixelBytes = sizeof(T) * C;
+
+  TypedView() {}
+
+  //! \brief View roi as T x C. The view is empty if the format doesn't match, see Matches().
+  explicit TypedView(const ImgROI &roi) {
+    if (Matches(roi)) {
+      data_ = const_cast<uint8_t*>(roi.GetData());
+      width_ = roi.Width();
+      height_ = roi.Height();
+      depth_ = roi.Depth();
+      pitch_ = roi.Pitch();
+      slice_pitch_ = roi.SlicePitch();
+    }
+  }
+
+  //! \brief true if roi holds C channels of T.
+  //! Integer channels must match the signedness of T; float channels are signed whatever the
+  //! ROI's signed flag says, like GetChannelType() treats them.
+  static bool Matches(const ImgROI &roi) {
+    return roi.Channel() == C && roi.BPC() == sizeof(T) * 8
+      && roi.IsFloat() == (std::is_floating_point<value_type>::value
+        || std::is_same<value_type, Half>::value)
+      && (roi.IsFloat() || roi.IsSigned() == std::is_signed<value_type>::value)
+      && roi.GetData() != nullptr;
+  }
+
+  //! \brief true if the view was built from an ROI of a different format, or default constructed.
+  bool Empty() const { return data_ == nullptr; }
+
+  //! \brief Channels of row y in layer z, Width() * C elements.
+  Span<T> Row(uint32_t y, uint32_t z = 0) const {
+    return Span<T>((T*)(data_ + z * slice_pitch_ + (int64_t)y * pitch_), (size_t)width_ * C);
+  }
+
+  //! \brief Pixels of row y in layer z, Width() elements.
+  Span<Pixel> Pixels(uint32_t y, uint32_t z = 0) const {
+    return Span<Pixel>((Pixel*)(data_ + z * slice_pitch_ + (int64_t)y * pitch_), width_);
+  }
+
+  T &At(uint32_t x, uint32_t y, uint32_t c) const {
+    return Row(y)[(size_t)x * C + c];
+  }
+
+  T &At(uint32_t x, uint32_t y, uint32_t z, uint32_t c) const {
+    return Row(y, z)[(size_t)x * C + c];
+  }
+
+  Pixel &PixelAt(uint32_t x, uint32_t y, uint32_t z = 0) const {
+    return Pixels(y, z)[x];
+  }
+
+  uint32_t Width() const { return width_; }
+  uint32_t Height() const { return height_; }
+  uint32_t Depth() const { return depth_; }
+  constexpr uint32_t Channel() const { return C; }
+  constexpr uint8_t BPC() const { return sizeof(T) * 8; }
+  int64_t Pitch() const { return pitch_; }
+  uint64_t SlicePitch() const { return slice_pitch_; }
+  T *GetData() const { return (T*)data_; }
+
+private:
+  uint8_t *data_{nullptr};
+  uint32_t width_{0};
+  uint32_t height_{0};
+  uint32_t depth_{0};
+  int64_t pitch_{0};
+  uint64_t slice_pitch_{0};
+};
+
+/**
+ * @brief Fill every channel of every pixel of a typed view with the same value.
+ */
+template<typename T, uint32_t C>
+void Fill(TypedView<T, C> view, typename TypedView<T, C>::value_type val) {
+  for (uint32_t z = 0; z < view.Depth(); z++) {
+    for (uint32_t y = 0; y < view.Height(); y++) {
+      auto row = view.Row(y, z);
+      for (size_t i = 0; i < row.size(); i++) {
+        row[i] = val;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Fill every pixel of a typed view with the same pixel value.
+ */
+template<typename T, uint32_t C>
+void Fill(TypedView<T, C> view, const typename TypedView<T, C>::Pixel &val) {
+  for (uint32_t z = 0; z < view.Depth(); z++) {
+    for (uint32_t y = 0; y < view.Height(); y++) {
+      for (auto &pixel: view.Pixels(y, z)) {
+        pixel = val;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Transform multiple typed views simultaneously, channel by channel.
+ * @details Typed counterpart of ZipTransform(). The callback receives references to the
+ * matching channel of every view, without coordinates, so that the inner loop is a plain
+ * vectorizable loop over each row. All views must have the same size and channel count.
+ *
+ * @param views an std::tuple of TypedViews
+ * @param callback callback function receiving (T0 &, T1 &, ...) as argument.
+ */
+template<typename... Ts, uint32_t... Cs, typename TCallback>
+void ZipTransform(std::tuple<TypedView<Ts, Cs>...> views, TCallback callback) {
+  auto &first = std::get<0>(views);
+  for (uint32_t z = 0; z < first.Depth(); z++) {
+    for (uint32_t y = 0; y < first.Height(); y++) {
+      auto rows = std::apply([y, z](auto &... view) {
+        return std::make_tuple(view.Row(y, z).data()...);
+      }, views);
+      size_t n = (size_t)first.Width() * std::tuple_element<0, decltype(views)>::type::kChannels;
+      std::apply([n, &callback](auto... row) {
+        for (size_t i = 0; i < n; i++) {
+          callback(row[i]...);
+        }
+      }, rows);
+    }
+  }
+}
+
+/**
+ * @brief Transform multiple typed views simultaneously, pixel by pixel.
+ * @details Typed counterpart of ZipTransformPixel(). The callback receives references to the
+ * matching TypedView::Pixel of every view. Views may differ in channel count.
+ *
+ * @param views an std::tuple of TypedViews
+ * @param callback callback function receiving (Pixel0 &, Pixel1 &, ...) as argument.
+ */
+template<typename... Ts, uint32_t... Cs, typename TCallback>
+void ZipTransformPixel(std::tuple<TypedView<Ts, Cs>...> views, TCallback callback) {
+  auto &first = std::get<0>(views);
+  for (uint32_t z = 0; z < first.Depth(); z++) {
+    for (uint32_t y = 0; y < first.Height(); y++) {
+      auto rows = std::apply([y, z](auto &... view) {
+        return std::make_tuple(view.Pixels(y, z).data()...);
+      }, views);
+      uint32_t w = first.Width();
+      std::apply([w, &callback](auto... row) {
+        for (uint32_t x = 0; x < w; x++) {
+          callback(row[x]...);
+        }
+      }, rows);
+    }
+  }
+}
+
+//! Nearest neighbor sample of all channels of a typed view.
+template<typename T, uint32_t C>
+typename std::remove_const<typename TypedView<T, C>::Pixel>::type
+Tex2DNN(const TypedView<T, C> &view, float x, float y) {
+  return view.PixelAt((uint32_t)(x + 0.5f), (uint32_t)(y + 0.5f));
+}
+
+//! Bilinear sample of all channels of a typed view.
+template<typename T, uint32_t C>
+typename std::remove_const<typename TypedView<T, C>::Pixel>::type
+Tex2DBilinear(const TypedView<T, C> &view, float x, float y) {
+  using TValue = typename TypedView<T, C>::value_type;
+  using TInterp = typename Interpolatable<TValue>::type;
+  uint32_t u0 = std::max((uint32_t)floor(x), 0u);
+  uint32_t v0 = std::max((uint32_t)floor(y), 0u);
+  uint32_t u1 = std::min(u0 + 1, view.Width() - 1);
+  uint32_t v1 = std::min(v0 + 1, view.Height() - 1);
+  float u = x - u0;
+  float v = y - v0;
+
+  const auto &p00 = view.PixelAt(u0, v0);
+  const auto &p10 = view.PixelAt(u1, v0);
+  const auto &p01 = view.PixelAt(u0, v1);
+  const auto &p11 = view.PixelAt(u1, v1);
+  std::array<TValue, C> result;
+  for (uint32_t c = 0; c < C; c++) {
+    auto val_uv0 = static_cast<TInterp>(p00[c]) * (1.0f - u) + static_cast<TInterp>(p10[c]) * u;
+    auto val_uv1 = static_cast<TInterp>(p01[c]) * (1.0f - u) + static_cast<TInterp>(p11[c]) * u;
+    result[c] = static_cast<TValue>(val_uv0 * (1.0f - v) + val_uv1 * v);
+  }
+  return result;
+}
+
+}
+
+#endif // IMGPP_TYPEDVIEW_HPP
@@ -0,0 +1,83 @@
+#include <imgpp/algorithms.hpp>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+
+using namespace imgpp;
+
+int main() {
+  // padded rows, so that only the first w pixels of a row may be touched
+  Img a(13, 6, 1, 4, 8, false, false, 16);
+  Img b(13, 6, 1, 1, 16, false, false, 8);
+  ForEachRow(a.ROI(), [](uint32_t y, uint32_t, uint32_t w, uint8_t *row) {
+    for (uint32_t i = 0; i < w * 4; i++) {
+      row[i] = (uint8_t)(y + i);
+    }
+  });
+  if (a.ROI().At<uint8_t>(2, 5, 3) != 5 + 11) {
+    std::cerr << "ForEachRow failed" << std::endl;
+    return 1;
+  }
+
+  // rows of images with different formats, one of them flipped
+  ImgROI flipped = a.CROI().FlipVertical();
+  uint32_t rows = 0;
+  ZipTransformRows(std::make_tuple(b.ROI(), flipped), [&rows](uint32_t, uint32_t, uint32_t w,
+    auto &ptrs) {
+    uint16_t *dst = (uint16_t*)ptrs[0];
+    const uint8_t *src = ptrs[1];
+    for (uint32_t x = 0; x < w; x++) {
+      dst[x] = (uint16_t)(src[x * 4] + src[x * 4 + 3]);
+    }
+    rows++;
+  });
+  if (rows != 6 || b.ROI().At<uint16_t>(12, 0) != (5 + 48) + (5 + 51)
+    || b.ROI().At<uint16_t>(0, 5) != 0 + 3) {
+    std::cerr << "ZipTransformRows failed" << std::endl;
+    return 1;
+  }
+
+  // pixel fills keep the padding, at every alignment of the row start and in both store modes
+  for (StoreMode mode: {StoreMode::CACHED, StoreMode::STREAMING}) {
+    Img rgb(37, 5, 1, 3, 8, false, false, 4);
+    memset(rgb.ROI().GetData(), 9, rgb.CData().GetLength());
+    for (uint32_t left = 0; left < 17; left++) {
+      ImgROI sub = rgb.ROI().SubRegion(left, 1, 0, 36, 3, 0);
+      if (!Fill(sub, std::array<uint8_t, 3>{1, 2, 3}, mode)) {
+        std::cerr << "pixel Fill rejected a matching pixel" << std::endl;
+        return 1;
+      }
+      for (uint32_t y = 0; y < 5; y++) {
+        for (uint32_t x = 0; x < 37; x++) {
+          bool inside = x >= left && y >= 1 && y <= 3;
+          for (uint32_t c = 0; c < 3; c++) {
+            if (rgb.CROI().At<uint8_t>(x, y, c) != (inside ? c + 1 : 9)) {
+              std::cerr << "pixel Fill error at " << x << ", " << y << std::endl;
+              return 1;
+            }
+          }
+        }
+      }
+      if (((const uint8_t*)rgb.CROI().PtrAt(36, 2, 2))[1] != 9) {
+        std::cerr << "pixel Fill wrote into the padding" << std::endl;
+        return 1;
+      }
+      memset(rgb.ROI().GetData(), 9, rgb.CData().GetLength());
+    }
+  }
+
+  struct Texel { float r, g, b; };
+  Img texels(6, 6, 3, 32, true);
+  if (FillPixel(texels.ROI(), 1.0f) || !FillPixel(texels.ROI(), Texel{1.0f, 0.5f, 0.25f})
+    || texels.CROI().At<float>(5, 5, 2) != 0.25f || texels.CROI().At<float>(0, 0, 1) != 0.5f) {
+    std::cerr << "FillPixel error" << std::endl;
+    return 1;
+  }
+  Fill(texels.ROI(), 2.0f);
+  if (texels.CROI().At<float>(3, 4, 0) != 2.0f || texels.CROI().At<float>(3, 4, 2) != 2.0f) {
+    std::cerr << "scalar Fill error" << std::endl;
+    return 1;
+  }
+  return 0;
+}
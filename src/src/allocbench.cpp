@@ -0,0 +1,106 @@
+#include <imgpp/imgpp.hpp>
+#include <imgpp/blockimg.hpp>
+#include <imgpp/bufferpool.hpp>
+#include <imgpp/compositeimg.hpp>
+#include "benchutil.h"
+#include <memory>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 9 };
+
+void BenchSize(size_t length) {
+  char name[64];
+  std::snprintf(name, sizeof(name), "alloc+touch %zu MB", length >> 20);
+
+  // baseline: the former ImgBuffer::SetSize, new[] wrapped in a shared_ptr
+  double ms_alloc = bench::MedianMs(kReps, [length]() {
+    std::shared_ptr<uint8_t> data(new uint8_t[length], std::default_delete<uint8_t[]>());
+    bench::DoNotOptimize(data.get());
+  });
+  double ms_touch = bench::MedianMs(kReps, [length]() {
+    std::shared_ptr<uint8_t> data(new uint8_t[length], std::default_delete<uint8_t[]>());
+    memset(data.get(), 1, length);
+    bench::DoNotOptimize(data.get());
+  });
+  bench::Report(name, "new[] alloc", ms_alloc);
+  bench::Report(name, "new[] alloc+touch", ms_touch, (double)length);
+
+  auto run = [length, name](const char *alloc_name, const char *touch_name,
+    std::shared_ptr<Allocator> allocator) {
+    double ms_alloc = bench::MedianMs(kReps, [length, &allocator]() {
+      ImgBuffer buffer(length, allocator);
+      bench::DoNotOptimize(buffer.GetBuffer());
+    });
+    double ms_touch = bench::MedianMs(kReps, [length, &allocator]() {
+      ImgBuffer buffer(length, allocator);
+      memset(buffer.GetBuffer(), 1, length);
+      bench::DoNotOptimize(buffer.GetBuffer());
+    });
+    bench::Report(name, alloc_name, ms_alloc);
+    bench::Report(name, touch_name, ms_touch, (double)length);
+  };
+  run("aligned alloc", "aligned alloc+touch", std::make_shared<AlignedAllocator>());
+  run("hugepage alloc", "hugepage alloc+touch", std::make_shared<HugePageAllocator>(0));
+}
+
+// decode loop: a fresh Img per frame with slightly varying frame sizes
+void BenchDecodeLoop(std::shared_ptr<Allocator> allocator, const char *variant) {
+  enum { kFrames = 64 };
+  double ms = bench::MedianMs(kReps, [&allocator]() {
+    for (uint32_t i = 0; i < kFrames; ++i) {
+      Img img;
+      img.SetAllocator(allocator);
+      img.SetSize(1920 - (i % 4) * 8, 1080, 1, 3, 8);
+      memset(img.ROI().GetData(), 0, img.Data().GetLength());
+      bench::DoNotOptimize(img.ROI().GetData());
+    }
+  });
+  bench::Report("decode loop 64x 1080p", variant, ms, 1920.0 * 1080 * 3 * kFrames);
+}
+
+// 2048^2 RGBA8 cube array with a full mip chain: one buffer per face vs a single arena
+void BenchCompositeImg() {
+  enum { kLevels = 12, kLayers = 2, kFaces = 6, kSize = 2048 };
+  TextureDesc desc;
+  desc.format = FORMAT_RGBA8_UNORM_PACK8;
+  desc.target = TARGET_CUBE_ARRAY;
+  desc.mipmap = true;
+
+  double ms_faces = bench::MedianMs(kReps, [&desc]() {
+    CompositeImg img;
+    img.SetSize(desc, kLevels, kLayers, kFaces, kSize, kSize, 1, 4);
+    for (uint32_t level = 0; level < kLevels; ++level) {
+      for (uint32_t layer = 0; layer < kLayers; ++layer) {
+        for (uint32_t face = 0; face < kFaces; ++face) {
+          ImgBuffer buffer(img.FaceSize(level));
+          img.SetData(buffer.GetBuffer(), level, layer, face);
+          img.AddBuffer(std::move(buffer));
+        }
+      }
+    }
+    bench::DoNotOptimize(img.ROI(0, 0, 0).GetData());
+  });
+  double ms_arena = bench::MedianMs(kReps, [&desc]() {
+    CompositeImg img;
+    img.SetSize(desc, kLevels, kLayers, kFaces, kSize, kSize, 1, 4);
+    img.Allocate();
+    bench::DoNotOptimize(img.ROI(0, 0, 0).GetData());
+  });
+  bench::Report("cube array 2048 x12 levels", "144 face buffers", ms_faces);
+  bench::Report("cube array 2048 x12 levels", "single arena", ms_arena);
+}
+
+}
+
+int main() {
+  for (size_t mb: {1, 16, 128, 512}) {
+    BenchSize(mb << 20);
+  }
+  BenchDecodeLoop(std::make_shared<AlignedAllocator>(), "aligned");
+  BenchDecodeLoop(std::make_shared<ImgBufferPool>(size_t(64) << 20), "pool");
+  BenchCompositeImg();
+  return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef IMGPP_BENCHUTIL_H
+#define IMGPP_BENCHUTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace imgpp { namespace bench {
+
+//! Run fn reps times and return the median wall time in milliseconds.
+template<typename TFunc>
+double MedianMs(int reps, TFunc &&fn) {
+  std::vector<double> times;
+  times.reserve(reps);
+  for (int i = 0; i < reps; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+  return times[times.size() / 2];
+}
+
+//! Print one result row; bytes is the amount of memory touched per run (0 to omit throughput).
+inline void Report(const char *name, const char *variant, double ms, double bytes = 0.0) {
+  if (bytes > 0.0) {
+    std::printf("%-32s %-24s %10.3f ms %10.2f GB/s\n", name, variant, ms, bytes / ms * 1e-6);
+  } else {
+    std::printf("%-32s %-24s %10.3f ms\n", name, variant, ms);
+  }
+}
+
+//! Keep the compiler from optimizing away a computed value.
+template<typename T>
+inline void DoNotOptimize(const T &value) {
+#if defined(_MSC_VER)
+  static const void *volatile sink;
+  sink = &value;
+#else
+  asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+}}
+
+#endif
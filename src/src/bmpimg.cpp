@@ -2,6 +2,7 @@
 #include <fstream>
 #include <memory>
 #include <imgpp/imgpp.hpp>
+#include <imgpp/stats.hpp>
 
 namespace {
 
@@ -67,6 +68,7 @@ bool LoadBMP(const char *fn, Img &img, bool bottom_first) {
   if (nullptr == fn || 0 == strlen(fn)) {
     return false;
   }
+  detail::CodecScope stats(Codec::BMP, false);
 
   std::ifstream infile;
   infile.open(fn, std::ios::binary);
@@ -113,6 +115,7 @@ bool LoadBMP(const char *fn, Img &img, bool bottom_first) {
     }
   }
 
+  stats.AddBytes(infile.tellg());
   infile.close();
   return true;
 }
@@ -121,6 +124,7 @@ bool LoadBMP(const char *buffer, uint32_t length, Img &img, bool bottom_first) {
   if (nullptr == buffer || 0 == length) {
     return false;
   }
+  detail::CodecScope stats(Codec::BMP, false);
 
   BMPFileHeader bfh = {0};
   BMPInfoHeader bih = {0};
@@ -160,12 +164,14 @@ bool LoadBMP(const char *buffer, uint32_t length, Img &img, bool bottom_first) {
       p += line_len;
     }
   }
+  stats.AddBytes(p - buffer);
   return true;
 }
 
 bool WriteBMP(const char *fn, const ImgROI &roi, bool bottom_first) {
   if (nullptr == fn || 0 == strlen(fn))
     return false;
+  detail::CodecScope stats(Codec::BMP, true);
 
   std::ofstream outfile;
   outfile.open(fn, std::ios::binary);
@@ -214,6 +220,7 @@ bool WriteBMP(const char *fn, const ImgROI &roi, bool bottom_first) {
     }
   }
 
+  stats.AddBytes(outfile.tellp());
   outfile.close();
   return true;
 }
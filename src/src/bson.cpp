@@ -1,6 +1,10 @@
 #include <imgpp/loaders.hpp>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include <imgpp/imgpp.hpp>
+#include <imgpp/stats.hpp>
 
 namespace {
 
@@ -10,15 +14,20 @@ struct IMPPHeader {
   uint32_t channel{0};
   uint32_t depth{0};
   uint32_t bpc{0};
-  uint32_t pitch{0};
-  uint32_t slice_pitch{0};
+  uint64_t pitch{0};
+  uint64_t slice_pitch{0};
   bool is_signed{false}, is_float{false};
-  uint32_t buffer_length{0};
+  uint64_t buffer_length{0};
 };
 
-std::pair<std::string, int32_t> ParseElement(const char *&p) {
+// A binary element's int32 length caps it below 2 GiB; buffers are split into consecutive 1 GiB
+// chunks, leaving headroom under that limit for the element headers around them. The document's own
+// int32 length still caps the whole image below 2 GiB, larger ones fail to write.
+enum : uint64_t { kMaxChunkSize = 0x40000000 };
+
+std::pair<std::string, int64_t> ParseElement(const char *&p) {
   uint8_t type = *(uint8_t*)p;
-  if (type != 0x10 && type != 0x8) {
+  if (type != 0x10 && type != 0x12 && type != 0x8) {
     return {{}, -1};
   }
   p += 1;
@@ -30,13 +39,18 @@ std::pair<std::string, int32_t> ParseElement(const char *&p) {
   }
   p += 1;  // skip 0
 
-  int32_t result = 0;
+  int64_t result = 0;
 
   if (type == 0x8) {
     result = *p;
     p += 1;
+  } else if (type == 0x12) {
+    memcpy(&result, p, sizeof(int64_t));  // elements are packed, p need not be aligned
+    p += sizeof(int64_t);
   } else {
-    result = *(int32_t*)p;
+    int32_t value;
+    memcpy(&value, p, sizeof(value));
+    result = value;
     p += sizeof(int32_t);
   }
   return {std::move(e_name), result};
@@ -47,6 +61,7 @@ int32_t ParseDataElement(const char *&p) {
   if (type != 0x5) {
     return 0;
   }
+  p += 1;
 
   std::string e_name;
   while (*p != 0) {
@@ -55,7 +70,8 @@ int32_t ParseDataElement(const char *&p) {
   }
   p += 1;  // skip 0
 
-  int32_t buffer_len = *(int32_t*)p;
+  int32_t buffer_len;
+  memcpy(&buffer_len, p, sizeof(buffer_len));
   p += sizeof(int32_t);
 
   auto subtype = *p;
@@ -71,6 +87,22 @@ void WriteElement(const std::string &name, int32_t val, std::string &doc) {
   doc.append((char *)&val, sizeof(int32_t));
 }
 
+void WriteElement(const std::string &name, int64_t val, std::string &doc) {
+  doc.push_back('\x12');
+  doc.append(name);
+  doc.push_back('\x00');
+  doc.append((char *)&val, sizeof(int64_t));
+}
+
+// writes 32-bit integers whenever possible to stay readable by older versions
+void WriteSizeElement(const std::string &name, uint64_t val, std::string &doc) {
+  if (val <= INT32_MAX) {
+    WriteElement(name, (int32_t)val, doc);
+  } else {
+    WriteElement(name, (int64_t)val, doc);
+  }
+}
+
 void WriteElement(const std::string &name, bool val, std::string &doc) {
   doc.push_back('\x08');
   doc.append(name);
@@ -90,20 +122,74 @@ void WriteElement(const std::string &name,
   }
 }
 
+// Appends size bytes of pixel data as one binary element named "b",
+// or as chunks "b", "b1", "b2", ... if it doesn't fit in a single element.
+class DataWriter {
+public:
+  DataWriter(uint64_t size, std::string &doc): left_(size), doc_(doc) {
+    doc_.reserve(doc_.size() + size + (size / kMaxChunkSize + 1) * 16 + 1);
+  }
+
+  void Append(const char *data, uint64_t size) {
+    while (size > 0) {
+      if (chunk_left_ == 0) {
+        chunk_left_ = std::min<uint64_t>(left_, kMaxChunkSize);
+        WriteElement(chunk_index_ == 0 ? std::string("b") : "b" + std::to_string(chunk_index_),
+          nullptr, (uint32_t)chunk_left_, doc_);
+        chunk_index_ += 1;
+      }
+      uint64_t n = std::min(size, chunk_left_);
+      doc_.append(data, (size_t)n);
+      data += n;
+      size -= n;
+      chunk_left_ -= n;
+      left_ -= n;
+    }
+  }
+
+private:
+  uint64_t left_;
+  uint64_t chunk_left_{0};
+  uint32_t chunk_index_{0};
+  std::string &doc_;
+};
+
+// Terminates the document and stores its length. Fails, clearing bson, if the document is too large
+// for its int32 length field.
+bool FinishDocument(std::string &bson) {
+  bson.push_back('\x00');
+  if (bson.size() > INT32_MAX) {
+    bson.clear();
+    return false;
+  }
+  int32_t doc_length = (int32_t)bson.size();
+  memcpy((char*)bson.data(), (char*)&doc_length, sizeof(int32_t));
+  return true;
+}
+
 }
 
 namespace imgpp {
 
 enum {kNumElements = 9};  // IMPP
 
-bool LoadBSON(const char *src, uint32_t length, Img &img) {
-  auto doc_len = *(const int32_t*)src;
-  if (doc_len > (int32_t)length) {
+namespace {
+
+using Chunks = std::vector<std::pair<const char*, uint64_t>>;
+
+// parse the document header and collect the chunks holding the pixel data
+bool ParseBSON(const char *src, uint64_t length, IMPPHeader &header, Chunks &chunks) {
+  if (src == nullptr || length < sizeof(int32_t)) {
     return false;
   }
+  int32_t doc_len;
+  memcpy(&doc_len, src, sizeof(int32_t));
+  if (doc_len < 0 || (uint64_t)doc_len > length) {
+    return false;
+  }
+  const char *end = src + length;
 
   // parse header
-  IMPPHeader header;
   const char *p = src + sizeof(int32_t);
 
   for (int i = 0; i < kNumElements; ++i) {
@@ -119,9 +205,9 @@ bool LoadBSON(const char *src, uint32_t length, Img &img) {
     } else if (name == "bpc") {
       header.bpc = (uint32_t)val;
     } else if (name == "pitch") {
-      header.pitch = (uint32_t)val;
+      header.pitch = (uint64_t)val;
     } else if (name == "slice") {
-      header.slice_pitch = (uint32_t)val;
+      header.slice_pitch = (uint64_t)val;
     } else if (name == "sgn") {
       header.is_signed = (bool)val;
     } else if (name == "flt") {
@@ -131,20 +217,71 @@ bool LoadBSON(const char *src, uint32_t length, Img &img) {
     }
   }
 
-  // read data
-  header.buffer_length = ParseDataElement(p);
-  if (header.buffer_length <= 0) {
+  // read data, which may be split into several chunks
+  chunks.clear();
+  header.buffer_length = 0;
+  while (p < end && *(const uint8_t*)p == 0x5) {
+    int32_t chunk_length = ParseDataElement(p);
+    if (chunk_length <= 0 || (uint64_t)(end - p) < (uint64_t)chunk_length) {
+      return false;
+    }
+    chunks.emplace_back(p, chunk_length);
+    header.buffer_length += chunk_length;
+    p += chunk_length;
+  }
+  return !chunks.empty();
+}
+
+}
+
+bool LoadBSON(const char *src, size_t length, Img &img) {
+  detail::CodecScope stats(Codec::BSON, false);
+  IMPPHeader header;
+  Chunks chunks;
+  if (!ParseBSON(src, length, header, chunks)) {
     return false;
   }
 
-  ImgBuffer img_buf(header.buffer_length);
-  img_buf.WriteData((const uint8_t*)p, header.buffer_length);
+  ImgBuffer img_buf(header.buffer_length, img.CData().GetAllocator());
+  uint8_t *dst = img_buf.GetBuffer();
+  for (const auto &chunk: chunks) {
+    memcpy(dst, chunk.first, (size_t)chunk.second);
+    dst += chunk.second;
+  }
+  stats.AddBytes(length);
 
   ImgROI img_roi(img_buf.GetBuffer(), header.width, header.height, header.depth, header.channel,
     header.bpc, header.pitch, header.slice_pitch, header.is_float, header.is_signed);
 
-  img.ROI() = img_roi;
-  img.Data() = img_buf;
+  img_buf.SetCopyOnWrite(img.IsCopyOnWrite());
+  img = Img(std::move(img_buf), img_roi);
+
+  return true;
+}
+
+bool LoadBSON(const ImgBuffer &buffer, Img &img) {
+  detail::CodecScope stats(Codec::BSON, false);
+  IMPPHeader header;
+  Chunks chunks;
+  const char *src = (const char*)buffer.GetBuffer();
+  if (!ParseBSON(src, buffer.GetLength(), header, chunks)) {
+    return false;
+  }
+  // pixel data that isn't contiguous in the source, or doesn't start on the kDefaultAlignment
+  // boundary allocated buffers give (it follows the header wherever that ends), gets copied out
+  if (chunks.size() > 1 || (uintptr_t)chunks[0].first % kDefaultAlignment != 0) {
+    return LoadBSON(src, (size_t)buffer.GetLength(), img);
+  }
+  stats.AddBytes(buffer.GetLength());
+
+  // share the source buffer instead of copying the pixels out of it
+  ImgBuffer img_buf = buffer.SubBuffer(chunks[0].first - src, header.buffer_length);
+
+  ImgROI img_roi(img_buf.GetBuffer(), header.width, header.height, header.depth, header.channel,
+    header.bpc, header.pitch, header.slice_pitch, header.is_float, header.is_signed);
+
+  img_buf.SetCopyOnWrite(img.IsCopyOnWrite());
+  img = Img(std::move(img_buf), img_roi);
 
   return true;
 }
@@ -153,26 +290,23 @@ bool LoadBSON(const char *fn, Img &img) {
   if (fn == nullptr) {
     return false;
   }
-  std::ifstream infile(fn, std::ios::binary);
-  if (!infile.good()) {
+  detail::CodecScope stats(Codec::BSON, false);
+  ImgBuffer buffer;
+  if (!MapFile(fn, buffer)) {
     return false;
   }
-
-  infile.seekg(0, std::ios::end);
-  auto file_size = infile.tellg();
-  infile.seekg(0, std::ios::beg);
-  std::string buffer;
-  buffer.resize(file_size);
-  infile.read((char*)buffer.data(), file_size);
-  infile.close();
-
-  return LoadBSON(buffer.data(), file_size, img);
+  return LoadBSON(buffer, img);
 }
 
 
 bool WriteBSON(const Img &img, std::string &bson) {
+  detail::CodecScope stats(Codec::BSON, true);
 
   const auto &roi = img.ROI();
+  if (roi.Pitch() < 0 || roi.GetData() != img.CData().GetBuffer()) {
+    // the buffer can't be written as is, repack the rows
+    return WriteBSON(roi, bson);
+  }
   bson.clear();
   bson.append("\x00\x00\x00\x00", sizeof(int32_t));
   WriteElement("w", (int32_t)roi.Width(), bson);
@@ -180,20 +314,22 @@ bool WriteBSON(const Img &img, std::string &bson) {
   WriteElement("ch", (int32_t)roi.Channel(), bson);
   WriteElement("d", (int32_t)roi.Depth(), bson);
   WriteElement("bpc", (int32_t)roi.BPC(), bson);
-  WriteElement("pitch", (int32_t)roi.Pitch(), bson);
-  WriteElement("slice", (int32_t)roi.SlicePitch(), bson);
+  WriteSizeElement("pitch", roi.Pitch(), bson);
+  WriteSizeElement("slice", roi.SlicePitch(), bson);
   WriteElement("sgn", (int32_t)roi.IsSigned(), bson);
   WriteElement("flt", (int32_t)roi.IsFloat(), bson);
-  WriteElement("b", img.Data().GetBuffer(), img.Data().GetLength(), bson);
-  bson.push_back('\x00');
-
-  int32_t doc_length = (uint32_t)bson.size();
-  memcpy((char*)bson.data(), (char*)&doc_length, sizeof(int32_t));
+  DataWriter writer(img.CData().GetLength(), bson);
+  writer.Append((const char*)img.CData().GetBuffer(), img.CData().GetLength());
+  if (!FinishDocument(bson)) {
+    return false;
+  }
+  stats.AddBytes(bson.size());
 
   return true;
 }
 
 bool WriteBSON(const ImgROI &roi, std::string &bson) {
+  detail::CodecScope stats(Codec::BSON, true);
 
   // calc pitch
   auto pitch = ImgROI::CalcPitch(roi.Width(), roi.Channel(), roi.BPC(), 1);
@@ -206,22 +342,22 @@ bool WriteBSON(const ImgROI &roi, std::string &bson) {
   WriteElement("ch", (int32_t)roi.Channel(), bson);
   WriteElement("d", (int32_t)roi.Depth(), bson);
   WriteElement("bpc", (int32_t)roi.BPC(), bson);
-  WriteElement("pitch", (int32_t)pitch, bson);
-  WriteElement("slice", (int32_t)slice_pitch, bson);
+  WriteSizeElement("pitch", pitch, bson);
+  WriteSizeElement("slice", slice_pitch, bson);
   WriteElement("sgn", (int32_t)roi.IsSigned(), bson);
   WriteElement("flt", (int32_t)roi.IsFloat(), bson);
-  WriteElement("b", nullptr, slice_pitch * roi.Depth(), bson);
 
+  DataWriter writer(slice_pitch * roi.Depth(), bson);
   for (uint32_t z = 0; z < roi.Depth(); ++z) {
     for (uint32_t y = 0; y < roi.Height(); ++y) {
-      bson.append((const char*)roi.PtrAt(0, y, z, 0), pitch);
+      writer.Append((const char*)roi.PtrAt(0, y, z, 0), pitch);
     }
   }
 
-  bson.push_back('\x00');
-
-  int32_t doc_length = (uint32_t)bson.size();
-  memcpy((char*)bson.data(), (char*)&doc_length, sizeof(int32_t));
+  if (!FinishDocument(bson)) {
+    return false;
+  }
+  stats.AddBytes(bson.size());
 
   return true;
 }
@@ -230,15 +366,18 @@ bool WriteBSON(const char *fn, const Img &img) {
   if (fn == nullptr) {
     return false;
   }
+  detail::CodecScope stats(Codec::BSON, true);
+
+  std::string bson;
+  if (!WriteBSON(img, bson)) {
+    return false;
+  }
 
   std::ofstream outfile(fn, std::ios::binary);
   if (!outfile.good()) {
     return false;
   }
 
-  std::string bson;
-  WriteBSON(img, bson);
-
   outfile.write((char*)bson.data(), bson.size());
   outfile.close();
   return true;
@@ -248,15 +387,18 @@ bool WriteBSON(const char *fn, const ImgROI &roi) {
   if (fn == nullptr) {
     return false;
   }
+  detail::CodecScope stats(Codec::BSON, true);
+
+  std::string bson;
+  if (!WriteBSON(roi, bson)) {
+    return false;
+  }
 
   std::ofstream outfile(fn, std::ios::binary);
   if (!outfile.good()) {
     return false;
   }
 
-  std::string bson;
-  WriteBSON(roi, bson);
-
   outfile.write((char*)bson.data(), bson.size());
   outfile.close();
   return true;
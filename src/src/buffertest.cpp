@@ -0,0 +1,197 @@
+#include <imgpp/imgpp.hpp>
+#include <imgpp/blockimg.hpp>
+#include <imgpp/bufferpool.hpp>
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+class CountingAllocator: public imgpp::AlignedAllocator {
+public:
+  void *Allocate(size_t length, size_t alignment) override {
+    live_ += 1;
+    return AlignedAllocator::Allocate(length, alignment);
+  }
+
+  void Deallocate(void *ptr, size_t length) override {
+    live_ -= 1;
+    AlignedAllocator::Deallocate(ptr, length);
+  }
+
+  int Live() const { return live_; }
+
+private:
+  std::atomic<int> live_{0};
+};
+
+bool IsAligned(const void *ptr) {
+  return ((uintptr_t)ptr % imgpp::kDefaultAlignment) == 0;
+}
+
+}
+
+int main() {
+  // default allocator is aligned
+  {
+    imgpp::Img img(13, 7, 3, 8);
+    if (!IsAligned(img.ROI().GetData())) {
+      std::cerr << "default buffer is not aligned" << std::endl;
+      return 1;
+    }
+  }
+
+  // custom allocator is used by Img and BlockImg, and outlives its buffers
+  {
+    auto allocator = std::make_shared<CountingAllocator>();
+    {
+      imgpp::Img img;
+      img.SetAllocator(allocator);
+      img.SetSize(64, 64, 1, 4, 8);
+      imgpp::BlockImg block_img;
+      block_img.SetAllocator(allocator);
+      block_img.SetSize({4, 4, 16}, 64, 64, 1);
+      imgpp::Img clone = img.Clone();
+      if (allocator->Live() != 3) {
+        std::cerr << "custom allocator not used" << std::endl;
+        return 1;
+      }
+    }
+    if (allocator->Live() != 0) {
+      std::cerr << "buffers not returned to custom allocator" << std::endl;
+      return 1;
+    }
+  }
+
+  // large buffers from the huge page allocator
+  {
+    auto allocator = std::make_shared<imgpp::HugePageAllocator>(1 << 20);
+    imgpp::ImgBuffer buffer(4 << 20, allocator);
+    if (!IsAligned(buffer.GetBuffer())) {
+      std::cerr << "huge page buffer is not aligned" << std::endl;
+      return 1;
+    }
+    buffer.Zeros();
+  }
+
+  // adopted memory is released through the user deleter once the last Img referencing it drops
+  {
+    int deleted = 0;
+    uint8_t *frame = new uint8_t[16 * 16 * 4];
+    imgpp::ImgBuffer buffer(frame, 16 * 16 * 4, [&deleted](uint8_t *p) {
+      delete[] p;
+      deleted += 1;
+    });
+    imgpp::Img img(std::move(buffer), imgpp::ImgROI(frame, 16, 16, 4, 8, 64, false, false));
+    imgpp::Img copy = img;
+    img = imgpp::Img();
+    if (deleted != 0 || copy.ROI().GetData() != frame || copy.Data().GetBuffer() != frame) {
+      std::cerr << "adopted buffer released too early" << std::endl;
+      return 1;
+    }
+    copy = imgpp::Img();
+    if (deleted != 1) {
+      std::cerr << "adopted buffer not released" << std::endl;
+      return 1;
+    }
+  }
+
+  // keep-alive owner is held by the buffer and its sub-buffers
+  {
+    auto owner = std::make_shared<std::vector<uint8_t>>(1024);
+    std::weak_ptr<std::vector<uint8_t>> watcher = owner;
+    imgpp::ImgBuffer sub;
+    {
+      imgpp::ImgBuffer buffer(owner->data(), owner->size(), owner);
+      owner.reset();
+      sub = buffer.SubBuffer(512, 512);
+    }
+    if (watcher.expired() || sub.GetLength() != 512) {
+      std::cerr << "keep-alive owner released too early" << std::endl;
+      return 1;
+    }
+    sub = imgpp::ImgBuffer();
+    if (!watcher.expired()) {
+      std::cerr << "keep-alive owner not released" << std::endl;
+      return 1;
+    }
+  }
+
+  // buffer pool recycles released buffers of a similar size and respects its budget
+  {
+    auto pool = std::make_shared<imgpp::ImgBufferPool>(1 << 20);
+    {
+      imgpp::Img img;
+      img.SetAllocator(pool);
+      img.SetSize(256, 256, 1, 4, 8);  // 256 KiB, miss
+      img.SetSize(250, 256, 1, 4, 8);  // same bucket, hit on the buffer released above
+      if (pool->Stats().misses != 1 || pool->Stats().hits != 1) {
+        std::cerr << "buffer pool did not recycle buffer" << std::endl;
+        return 1;
+      }
+    }
+    auto stats = pool->Stats();
+    if (stats.cached_buffers != 1 || stats.cached_bytes != imgpp::ImgBufferPool::BucketSize(256 * 256 * 4)) {
+      std::cerr << "released buffer not cached" << std::endl;
+      return 1;
+    }
+    {
+      imgpp::ImgBuffer big(2 << 20, pool);  // larger than the whole pool
+      imgpp::ImgBuffer small_a(600 << 10, pool);
+      imgpp::ImgBuffer small_b(600 << 10, pool);
+    }
+    stats = pool->Stats();
+    if (stats.evictions < 2 || stats.cached_bytes > pool->Capacity()) {
+      std::cerr << "buffer pool exceeded its budget" << std::endl;
+      return 1;
+    }
+  }
+
+  // zero-filled allocation: small, lazily mapped, first-touched and recycled dirty buffers
+  {
+    auto all_zero = [](const imgpp::Img &img) {
+      const uint8_t *data = img.CData().GetBuffer();
+      for (uint64_t i = 0; i < img.CData().GetLength(); ++i) {
+        if (data[i] != 0) {
+          return false;
+        }
+      }
+      return true;
+    };
+    imgpp::Img small = imgpp::Zeros(13, 7, 1, 3, 8);
+    imgpp::Img large = imgpp::Zeros(1024, 1024, 1, 4, 32, true, true, 4, 3);
+    if (!all_zero(small) || !all_zero(large) || !IsAligned(large.ROI().GetData())) {
+      std::cerr << "zero-filled image not zero" << std::endl;
+      return 1;
+    }
+
+    auto pool = std::make_shared<imgpp::ImgBufferPool>(8 << 20);
+    {
+      imgpp::Img dirty;
+      dirty.SetAllocator(pool);
+      dirty.SetSize(512, 512, 1, 4, 8);
+      memset(dirty.ROI().GetData(), 0xff, dirty.Data().GetLength());
+    }
+    imgpp::Img recycled;
+    recycled.SetAllocator(pool);
+    recycled.SetSizeZeroed(512, 512, 1, 4, 8);
+    if (pool->Stats().hits != 1 || !all_zero(recycled)) {
+      std::cerr << "recycled zero-filled buffer not zero" << std::endl;
+      return 1;
+    }
+
+    // every page gets touched, the last one of a length that isn't a multiple of the bands too
+    for (uint64_t length: {4 * 4096 + 1, 4 * 4096 - 1, 7 * 4096 + 100, 100}) {
+      imgpp::ImgBuffer touched(length);
+      memset(touched.GetBuffer(), 0xff, (size_t)length);
+      touched.FirstTouch(4);
+      for (uint64_t i = 0; i < length; i += 4096) {
+        if (touched.GetBuffer()[i] != 0) {
+          std::cerr << "page at " << i << " of " << length << " bytes not touched" << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include <imgpp/imgpp.hpp>
+#include <imgpp/sampler.hpp>
 
 int main() {
   // Test clone
@@ -18,5 +19,107 @@ int main() {
       return 1;
     }
   }
+  // Test copy-on-write clone
+  {
+    imgpp::Img image(2, 2, 1, 32, true, true);
+    image.SetCopyOnWrite(true);
+    image.ROI().At<float>(0, 0) = 1.0f;
+    imgpp::Img clone = image.Clone();
+    // Shared until written.
+    if (image.CROI().GetData() != clone.CROI().GetData()) {
+      return 1;
+    }
+    clone.ROI().At<float>(0, 0) = 5.0f;
+    if (image.CROI().GetData() == clone.CROI().GetData() || !clone.IsCopyOnWrite()
+      || image.CROI().At<float>(0, 0) != 1.0f || clone.CROI().At<float>(0, 0) != 5.0f) {
+      return 1;
+    }
+    // Sole owner writes in place.
+    const uint8_t *data = clone.CROI().GetData();
+    clone.ROI().At<float>(1, 1) = 2.0f;
+    if (clone.CROI().GetData() != data) {
+      return 1;
+    }
+  }
+  // Test copy-on-write detach rebases sub-buffer views
+  {
+    imgpp::ImgBuffer buffer(64);
+    buffer.Zeros();
+    imgpp::ImgBuffer tail = buffer.SubBuffer(32, 32);
+    imgpp::Img image(tail, imgpp::ImgROI(tail.GetBuffer(), 4, 2, 1, 32, 32, true, true));
+    image.SetCopyOnWrite(true);
+    image.ROI().At<float>(3, 1) = 7.0f;
+    if (image.CROI().GetData() == tail.GetBuffer() || image.CData().GetLength() != 32
+      || image.CROI().GetData() != image.CData().GetBuffer()
+      || ((const float*)tail.GetBuffer())[7] != 0.0f || image.CROI().At<float>(3, 1) != 7.0f) {
+      return 1;
+    }
+  }
+  // Test flipped views share pixels and clone with their rows
+  {
+    imgpp::Img image(3, 4, 1, 8);
+    for (uint32_t y = 0; y < 4; ++y) {
+      for (uint32_t x = 0; x < 3; ++x) {
+        image.ROI().At<uint8_t>(x, y) = (uint8_t)(y * 3 + x);
+      }
+    }
+    imgpp::ImgROI flipped = image.CROI().FlipVertical();
+    if (flipped.Pitch() != -3 || flipped.GetData() != image.CROI().PtrAt(0, 3)
+      || flipped.At<uint8_t>(2, 0) != 11 || flipped.FlipVertical().GetData() != image.CROI().GetData()
+      || imgpp::Tex2DNN<uint8_t>(flipped, 1.0f, 1.0f) != 7) {
+      return 1;
+    }
+    imgpp::Img copy(3, 4, 1, 8);
+    if (!imgpp::CopyData(copy.ROI(), flipped) || copy.CROI().At<uint8_t>(0, 3) != 0) {
+      return 1;
+    }
+    imgpp::Img view(image.CData(), flipped);
+    imgpp::Img clone = view.Clone();
+    if (clone.CROI().Pitch() != -3 || clone.CROI().At<uint8_t>(0, 0) != 9
+      || clone.CROI().GetData() != clone.CData().GetBuffer() + 9) {
+      return 1;
+    }
+  }
+  // Test CopyData spans, rows, and the large streaming copies, on one thread and in parallel
+  {
+    imgpp::Img src(2500, 1000, 4, 4, 8, false, false, 1);
+    uint8_t *data = src.ROI().GetData();
+    for (size_t i = 0; i < src.CData().GetLength(); ++i) {
+      data[i] = (uint8_t)(i * 7 + i / 4099);
+    }
+    imgpp::Img packed(2500, 1000, 4, 4, 8, false, false, 1);
+    imgpp::Img padded(2501, 1001, 4, 4, 8, false, false, 1);
+    imgpp::ImgROI window = padded.ROI().SubRegion(1, 1, 0, 2500, 1000, 3);
+    if (!imgpp::CopyData(packed.ROI(), src.CROI()) || !imgpp::CopyData(window, src.CROI())
+      || std::memcmp(packed.CData().GetBuffer(), src.CData().GetBuffer(), src.CData().GetLength())) {
+      return 1;
+    }
+    for (uint32_t z = 0; z < 4; ++z) {
+      for (uint32_t y = 0; y < 1000; y += 333) {
+        if (std::memcmp(window.PtrAt(0, y, z, 0), src.CROI().PtrAt(0, y, z, 0), 2500 * 4)) {
+          return 1;
+        }
+      }
+    }
+    imgpp::Img clone = src.Clone();
+    if (std::memcmp(clone.CData().GetBuffer(), src.CData().GetBuffer(), src.CData().GetLength())) {
+      return 1;
+    }
+    // the same copies split across an explicit executor
+    imgpp::ThreadPool pool(4);
+    packed.Data().Zeros();
+    padded.Data().Zeros();
+    if (!imgpp::CopyData(packed.ROI(), src.CROI(), pool) || !imgpp::CopyData(window, src.CROI(), pool)
+      || std::memcmp(packed.CData().GetBuffer(), src.CData().GetBuffer(), src.CData().GetLength())) {
+      return 1;
+    }
+    for (uint32_t z = 0; z < 4; ++z) {
+      for (uint32_t y = 0; y < 1000; ++y) {
+        if (std::memcmp(window.PtrAt(0, y, z, 0), src.CROI().PtrAt(0, y, z, 0), 2500 * 4)) {
+          return 1;
+        }
+      }
+    }
+  }
   return 0;
 }
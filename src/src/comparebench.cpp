@@ -0,0 +1,98 @@
+#include <imgpp/compare.hpp>
+#include "benchutil.h"
+#include <string>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 5, kWidth = 3840, kHeight = 2160 };
+
+// maximum absolute difference and MSE through At<T>, the loop the tests used to run
+template<typename T>
+void BenchNaive(const char *name, const Img &a, const Img &b) {
+  ImgROI x = a.CROI();
+  ImgROI y = b.CROI();
+  double ms = bench::MedianMs(kReps, [&]() {
+    double max_abs = 0.0;
+    double squares = 0.0;
+    for (uint32_t j = 0; j < x.Height(); j++) {
+      for (uint32_t i = 0; i < x.Width(); i++) {
+        for (uint32_t c = 0; c < x.Channel(); c++) {
+          double d = (double)x.At<T>(i, j, 0, c) - (double)y.At<T>(i, j, 0, c);
+          max_abs = std::max(max_abs, std::fabs(d));
+          squares += d * d;
+        }
+      }
+    }
+    bench::DoNotOptimize(&squares);
+    bench::DoNotOptimize(&max_abs);
+  });
+  bench::Report(name, "max abs and MSE, At<T>", ms);
+}
+
+void BenchCompare(const char *name, const Img &a, const Img &b) {
+  ThreadPool single(1);
+  double bytes = 2.0 * (double)a.CData().GetLength();
+  for (int parallel = 0; parallel < 2; parallel++) {
+    Executor &executor = parallel ? (Executor&)DefaultThreadPool() : single;
+    const char *suffix = parallel ? ", pool" : ", 1 thread";
+    CompareResult result;
+    double ms = bench::MedianMs(kReps, [&]() {
+      Compare(a.CROI(), b.CROI(), result, CompareOptions(), executor);
+      bench::DoNotOptimize(&result);
+    });
+    bench::Report(name, (std::string("max abs and MSE") + suffix).c_str(), ms, bytes);
+    CompareOptions options;
+    options.ssim = true;
+    ms = bench::MedianMs(kReps, [&]() {
+      Compare(a.CROI(), b.CROI(), result, options, executor);
+      bench::DoNotOptimize(&result);
+    });
+    bench::Report(name, (std::string("with SSIM") + suffix).c_str(), ms, bytes);
+    // a gate failing on the first rows
+    options = CompareOptions();
+    options.max_abs_diff_limit = 0.0;
+    ms = bench::MedianMs(kReps, [&]() {
+      Compare(a.CROI(), b.CROI(), result, options, executor);
+      bench::DoNotOptimize(&result);
+    });
+    bench::Report(name, (std::string("gate, failing") + suffix).c_str(), ms, bytes);
+  }
+}
+
+// noise in a, a copy moved by -2 to 2 in b
+template<typename T>
+void FillPair(Img &a, Img &b, uint32_t modulo) {
+  T *x = (T*)a.ROI().GetData();
+  T *y = (T*)b.ROI().GetData();
+  size_t n = a.CData().GetLength() / sizeof(T);
+  uint32_t state = 1;
+  for (size_t i = 0; i < n; i++) {
+    state = state * 1664525u + 1013904223u;
+    x[i] = (T)((state >> 8) % modulo + 2);
+    y[i] = (T)(x[i] + (T)(state % 5) - 2);
+  }
+}
+
+}
+
+int main() {
+  Img rgba8_a(kWidth, kHeight, 4, 8);
+  Img rgba8_b(kWidth, kHeight, 4, 8);
+  FillPair<uint8_t>(rgba8_a, rgba8_b, 250);
+  BenchNaive<uint8_t>("RGBA8 4K", rgba8_a, rgba8_b);
+  BenchCompare("RGBA8 4K", rgba8_a, rgba8_b);
+
+  Img rgba16_a(kWidth, kHeight, 4, 16);
+  Img rgba16_b(kWidth, kHeight, 4, 16);
+  FillPair<uint16_t>(rgba16_a, rgba16_b, 65000);
+  BenchCompare("RGBA16 4K", rgba16_a, rgba16_b);
+
+  Img rgba32f_a(kWidth, kHeight, 4, 32, true, true);
+  Img rgba32f_b(kWidth, kHeight, 4, 32, true, true);
+  FillPair<float>(rgba32f_a, rgba32f_b, 1000);
+  BenchNaive<float>("RGBA32F 4K", rgba32f_a, rgba32f_b);
+  BenchCompare("RGBA32F 4K", rgba32f_a, rgba32f_b);
+  return 0;
+}
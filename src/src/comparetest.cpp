@@ -0,0 +1,185 @@
+#include <imgpp/compare.hpp>
+#include "testutil.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace imgpp;
+
+// a copy of src with every fourth value or so moved by up to amplitude
+static void FillMoved(ImgROI roi, uint32_t seed, const ImgROI &src, uint32_t amplitude) {
+  test::FillNoise(roi, seed, [&src, amplitude](uint32_t r, uint32_t x, uint32_t y, uint32_t z, uint32_t c) {
+    double offset = r % 4 == 0 ? (double)(r / 4 % (2 * amplitude + 1)) - amplitude : 0.0;
+    return test::Value(src, x, y, z, c) + offset;
+  });
+}
+
+// mean SSIM of the windows of every slice, directly in doubles
+static double ReferenceSSIM(const ImgROI &a, const ImgROI &b, double peak) {
+  uint32_t ww = std::min(a.Width(), 8u);
+  uint32_t wh = std::min(a.Height(), 8u);
+  double c1 = 0.0001 * peak * peak;
+  double c2 = 0.0009 * peak * peak;
+  double n = (double)ww * wh;
+  double sum = 0.0;
+  double count = 0.0;
+  for (uint32_t z = 0; z < a.Depth(); z++) {
+    for (uint32_t y = 0; y + wh <= a.Height(); y++) {
+      for (uint32_t x = 0; x + ww <= a.Width(); x++) {
+        for (uint32_t c = 0; c < a.Channel(); c++) {
+          double ma = 0.0, mb = 0.0;
+          for (uint32_t j = y; j < y + wh; j++) {
+            for (uint32_t i = x; i < x + ww; i++) {
+              ma += (float)test::Value(a, i, j, z, c) / n;
+              mb += (float)test::Value(b, i, j, z, c) / n;
+            }
+          }
+          double va = 0.0, vb = 0.0, cov = 0.0;
+          for (uint32_t j = y; j < y + wh; j++) {
+            for (uint32_t i = x; i < x + ww; i++) {
+              double da = (float)test::Value(a, i, j, z, c) - ma;
+              double db = (float)test::Value(b, i, j, z, c) - mb;
+              va += da * da / n;
+              vb += db * db / n;
+              cov += da * db / n;
+            }
+          }
+          sum += (2.0 * ma * mb + c1) * (2.0 * cov + c2) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+          count++;
+        }
+      }
+    }
+  }
+  return sum / count;
+}
+
+int main() {
+  // every type and channel count, against doubles, in pitched ROIs of volumes
+  ThreadPool single(1);
+  ThreadPool pool(4);
+  const struct { uint32_t bpc; bool is_float; bool is_signed; } kFormats[] = {
+    {8, false, false}, {8, false, true}, {16, false, false}, {16, false, true},
+    {32, false, false}, {32, false, true}, {16, true, true}, {32, true, true}};
+  CompareOptions with_ssim;
+  with_ssim.ssim = true;
+  for (const auto &format: kFormats) {
+    for (uint32_t channels: {1u, 3u, 4u, 5u}) {
+      Img first(43, 29, 2, channels, format.bpc, format.is_float, format.is_signed, 4);
+      Img second(41, 30, 2, channels, format.bpc, format.is_float, format.is_signed, 8);
+      test::FillNoise(first.ROI(), channels * 11 + format.bpc);
+      ImgROI a(first.CROI(), 2, 1, 0, 40, 27, 1);
+      ImgROI b(second.CROI(), 1, 2, 0, 39, 28, 1);
+      FillMoved(b, channels + format.bpc, a, 3);
+      CompareResult result;
+      CompareResult parallel;
+      if (!Compare(a, b, result, with_ssim, single) || !Compare(a, b, parallel, with_ssim, pool)) {
+        std::cerr << "Compare failed, bpc " << format.bpc << " channels " << channels << std::endl;
+        return 1;
+      }
+      double max_abs = 0.0;
+      double squares = 0.0;
+      for (uint32_t z = 0; z < a.Depth(); z++) {
+        for (uint32_t y = 0; y < a.Height(); y++) {
+          for (uint32_t x = 0; x < a.Width(); x++) {
+            for (uint32_t c = 0; c < channels; c++) {
+              double d = std::fabs(test::Value(a, x, y, z, c) - test::Value(b, x, y, z, c));
+              max_abs = std::max(max_abs, d);
+              squares += d * d;
+            }
+          }
+        }
+      }
+      double mse = squares / ((double)a.Width() * a.Height() * a.Depth() * channels);
+      double peak = format.is_float ? 1.0 : (double)detail::ChannelMax(GetChannelType(a));
+      double ssim = ReferenceSSIM(a, b, peak);
+      if (result.max_abs_diff != max_abs || std::fabs(result.mse - mse) > 1e-12 * mse || result.stopped
+        || std::fabs(result.psnr - 10.0 * std::log10(peak * peak / mse)) > 1e-9
+        || std::fabs(result.ssim - ssim) > 1e-6 || max_abs == 0.0 || parallel.max_abs_diff != result.max_abs_diff
+        || parallel.mse != result.mse || parallel.ssim != result.ssim) {
+        std::cerr << "Compare error, bpc " << format.bpc << " float " << format.is_float << " signed "
+          << format.is_signed << " channels " << channels << ": " << result.max_abs_diff << " " << result.mse
+          << " " << result.ssim << " vs " << max_abs << " " << mse << " " << ssim << std::endl;
+        return 1;
+      }
+      if (!Compare(a, a, result, with_ssim, pool) || result.max_abs_diff != 0.0 || result.mse != 0.0
+        || result.psnr != INFINITY || std::fabs(result.ssim - 1.0) > 1e-9) {
+        std::cerr << "Self compare error, bpc " << format.bpc << " channels " << channels << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // windows shrink to images smaller than 8x8
+  Img tiny_a(5, 3, 2, 8);
+  Img tiny_b(5, 3, 2, 8);
+  test::FillNoise(tiny_a.ROI(), 3);
+  FillMoved(tiny_b.ROI(), 5, tiny_a.CROI(), 40);
+  CompareResult result;
+  if (!Compare(tiny_a.CROI(), tiny_b.CROI(), result, with_ssim)
+    || std::fabs(result.ssim - ReferenceSSIM(tiny_a.CROI(), tiny_b.CROI(), 255.0)) > 1e-9) {
+    std::cerr << "Small SSIM error" << std::endl;
+    return 1;
+  }
+
+  // runs on the pool, then limits stopping them, NaNs passing any
+  Img large_a(1000, 1000, 1, 8);
+  Img large_b(1000, 1000, 1, 8);
+  test::FillNoise(large_a.ROI(), 1);
+  FillMoved(large_b.ROI(), 2, large_a.CROI(), 2);
+  CompareResult parallel;
+  if (!Compare(large_a.CROI(), large_b.CROI(), result, with_ssim, single)
+    || !Compare(large_a.CROI(), large_b.CROI(), parallel, with_ssim, pool) || result.max_abs_diff != 2.0
+    || parallel.max_abs_diff != 2.0 || parallel.mse != result.mse
+    || std::fabs(parallel.ssim - result.ssim) > 1e-12 || !(result.ssim < 1.0)) {
+    std::cerr << "Parallel compare error" << std::endl;
+    return 1;
+  }
+  CompareOptions limits;
+  limits.max_abs_diff_limit = 1.0;
+  if (!Compare(large_a.CROI(), large_b.CROI(), result, limits, pool) || !result.stopped || result.max_abs_diff != 2.0) {
+    std::cerr << "Max abs limit error" << std::endl;
+    return 1;
+  }
+  limits = CompareOptions();
+  limits.mse_limit = 0.1;
+  if (!Compare(large_a.CROI(), large_b.CROI(), result, limits, single) || !result.stopped || !(result.mse > 0.1)) {
+    std::cerr << "MSE limit error" << std::endl;
+    return 1;
+  }
+  limits.mse_limit = 2.0;
+  if (!Compare(large_a.CROI(), large_b.CROI(), result, limits, pool) || result.stopped || !(result.mse < 2.0)) {
+    std::cerr << "MSE limit pass error" << std::endl;
+    return 1;
+  }
+  limits = with_ssim;
+  limits.ssim_limit = 0.99999;
+  if (!Compare(large_a.CROI(), large_b.CROI(), result, limits, pool) || !result.stopped || !(result.ssim < 0.99999)) {
+    std::cerr << "SSIM limit error" << std::endl;
+    return 1;
+  }
+  Img floats(3, 2, 1, 32, true, true);
+  Img nans(3, 2, 1, 32, true, true);
+  for (uint32_t i = 0; i < 6; i++) {
+    floats.ROI().At<float>(i % 3, i / 3) = (float)i;
+    nans.ROI().At<float>(i % 3, i / 3) = i == 4 ? NAN : (float)i;
+  }
+  limits = CompareOptions();
+  limits.max_abs_diff_limit = 0.0;
+  if (!Compare(floats.CROI(), nans.CROI(), result, limits) || !result.stopped || !std::isnan(result.max_abs_diff)
+    || !std::isnan(result.mse)) {
+    std::cerr << "NaN compare error" << std::endl;
+    return 1;
+  }
+
+  Img other(3, 2, 1, 16, true, true);
+  Img empty(0, 2, 1, 32, true, true);
+  if (Compare(floats.CROI(), large_a.CROI(), result) || Compare(floats.CROI(), other.CROI(), result)
+    || Compare(floats.CROI(), Img(3, 2, 2, 32, true, true).CROI(), result)
+    || Compare(empty.CROI(), empty.CROI(), result)) {
+    std::cerr << "Compare format checks error" << std::endl;
+    return 1;
+  }
+
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <imgpp/convert.hpp>
+#include "benchutil.h"
+#include <cstring>
+#include <string>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 9, kWidth = 3840, kHeight = 2160 };
+
+struct Format {
+  const char *name;
+  uint32_t c;
+  uint32_t bpc;
+  bool is_float;
+};
+
+const Format kRGBA8{"RGBA8", 4, 8, false};
+const Format kRGB8{"RGB8", 3, 8, false};
+const Format kGray8{"R8", 1, 8, false};
+const Format kRGBA16{"RGBA16", 4, 16, false};
+const Format kRGBA16F{"RGBA16F", 4, 16, true};
+const Format kRGBA32F{"RGBA32F", 4, 32, true};
+const Format kRGB32F{"RGB32F", 3, 32, true};
+
+void BenchPair(const Format &src_fmt, const Format &dst_fmt, const ConvertOptions &options = ConvertOptions(),
+  const char *note = "") {
+  Img src(kWidth, kHeight, src_fmt.c, src_fmt.bpc, src_fmt.is_float, src_fmt.is_float);
+  Img dst(kWidth, kHeight, dst_fmt.c, dst_fmt.bpc, dst_fmt.is_float, dst_fmt.is_float);
+  memset(src.ROI().GetData(), 0x3c, src.CData().GetLength());
+  double bytes = (double)src.CData().GetLength() + dst.CData().GetLength();
+  double ms = bench::MedianMs(kReps, [&]() {
+    Convert(dst.ROI(), src.CROI(), options);
+    bench::DoNotOptimize(dst.CROI().GetData());
+  });
+  std::string name = std::string(src_fmt.name) + " -> " + dst_fmt.name + note;
+  bench::Report(name.c_str(), "Convert", ms, bytes);
+}
+
+// the loops Convert replaces, through At<T>
+void BenchNaive() {
+  Img rgba8(kWidth, kHeight, 4, 8), rgb8(kWidth, kHeight, 3, 8);
+  Img rgba32f(kWidth, kHeight, 4, 32, true, true);
+  memset(rgb8.ROI().GetData(), 0x3c, rgb8.CData().GetLength());
+  memset(rgba8.ROI().GetData(), 0x3c, rgba8.CData().GetLength());
+  double ms_float = bench::MedianMs(kReps, [&]() {
+    for (uint32_t y = 0; y < kHeight; y++) {
+      for (uint32_t x = 0; x < kWidth; x++) {
+        for (uint32_t c = 0; c < 4; c++) {
+          rgba32f.ROI().At<float>(x, y, c) = rgba8.CROI().At<uint8_t>(x, y, c) / 255.0f;
+        }
+      }
+    }
+    bench::DoNotOptimize(rgba32f.CROI().GetData());
+  });
+  bench::Report("RGBA8 -> RGBA32F", "At<T> loop", ms_float,
+    (double)rgba8.CData().GetLength() + rgba32f.CData().GetLength());
+  double ms_alpha = bench::MedianMs(kReps, [&]() {
+    for (uint32_t y = 0; y < kHeight; y++) {
+      for (uint32_t x = 0; x < kWidth; x++) {
+        for (uint32_t c = 0; c < 3; c++) {
+          rgba8.ROI().At<uint8_t>(x, y, c) = rgb8.CROI().At<uint8_t>(x, y, c);
+        }
+        rgba8.ROI().At<uint8_t>(x, y, 3) = 255;
+      }
+    }
+    bench::DoNotOptimize(rgba8.CROI().GetData());
+  });
+  bench::Report("RGB8 -> RGBA8", "At<T> loop", ms_alpha,
+    (double)rgb8.CData().GetLength() + rgba8.CData().GetLength());
+}
+
+}
+
+int main() {
+  BenchNaive();
+  ConvertOptions bgra;
+  bgra.swizzle = kSwizzleBGRA;
+  BenchPair(kRGBA8, kRGBA32F);
+  BenchPair(kRGBA32F, kRGBA8);
+  BenchPair(kRGBA16, kRGBA8);
+  BenchPair(kRGBA8, kRGBA16);
+  BenchPair(kRGBA8, kRGBA16F);
+  BenchPair(kRGBA16F, kRGBA32F);
+  BenchPair(kRGBA32F, kRGBA16F);
+  BenchPair(kRGB8, kRGBA8);
+  BenchPair(kRGBA8, kRGB8);
+  BenchPair(kRGBA8, kRGBA8, bgra, " (BGRA)");
+  BenchPair(kGray8, kRGBA8);
+  BenchPair(kRGB8, kRGBA32F);
+  BenchPair(kRGBA32F, kRGB32F, bgra, " (BGR)");
+  return 0;
+}
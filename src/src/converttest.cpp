@@ -0,0 +1,134 @@
+#include <imgpp/convert.hpp>
+#include <cmath>
+#include <iostream>
+
+using namespace imgpp;
+
+int main() {
+  // u8 -> f32 -> u8 round trip, every value
+  Img u8(256, 3, 1, 8);
+  for (uint32_t x = 0; x < 256; x++) {
+    for (uint32_t y = 0; y < 3; y++) {
+      u8.ROI().At<uint8_t>(x, y) = (uint8_t)x;
+    }
+  }
+  Img f32(256, 3, 1, 32, true, true);
+  Img back(256, 3, 1, 8);
+  if (!Convert(f32.ROI(), u8.CROI()) || !Convert(back.ROI(), f32.CROI())
+    || f32.CROI().At<float>(51, 2) != 51 / 255.0f || back.CROI().At<uint8_t>(200, 1) != 200) {
+    std::cerr << "u8 <-> f32 error" << std::endl;
+    return 1;
+  }
+
+  // u16 -> u8, every value
+  Img u16(65536, 1, 1, 16);
+  for (uint32_t x = 0; x < 65536; x++) {
+    u16.ROI().At<uint16_t>(x, 0) = (uint16_t)x;
+  }
+  Img narrow(65536, 1, 1, 8);
+  Convert(narrow.ROI(), u16.CROI());
+  for (uint32_t x = 0; x < 65536; x++) {
+    if (narrow.CROI().At<uint8_t>(x, 0) != (uint8_t)std::lround(x * 255.0 / 65535.0)) {
+      std::cerr << "u16 -> u8 rounding error at " << x << std::endl;
+      return 1;
+    }
+  }
+
+  // channel expansion, constant alpha and swizzles, past the 4 pixel SIMD steps
+  Img rgb(19, 2, 3, 8);
+  for (uint32_t x = 0; x < 19; x++) {
+    for (uint32_t c = 0; c < 3; c++) {
+      rgb.ROI().At<uint8_t>(x, 1, c) = (uint8_t)(x * 3 + c);
+    }
+  }
+  Img rgba(19, 2, 4, 8);
+  Img bgra(19, 2, 4, 8);
+  Img bgr(19, 2, 3, 8);
+  ConvertOptions to_bgra;
+  to_bgra.swizzle = kSwizzleBGRA;
+  if (!Convert(rgba.ROI(), rgb.CROI()) || !Convert(bgra.ROI(), rgba.CROI(), to_bgra)
+    || !Convert(bgr.ROI(), bgra.CROI())) {
+    std::cerr << "swizzle conversion failed" << std::endl;
+    return 1;
+  }
+  for (uint32_t x = 0; x < 19; x++) {
+    if (rgba.CROI().At<uint8_t>(x, 1, 3) != 255 || bgra.CROI().At<uint8_t>(x, 1, 0) != x * 3 + 2
+      || bgra.CROI().At<uint8_t>(x, 1, 2) != x * 3 || bgr.CROI().At<uint8_t>(x, 1, 1) != x * 3 + 1) {
+      std::cerr << "swizzle error at " << x << std::endl;
+      return 1;
+    }
+  }
+
+  // gray u8 into RGBA f16 and back to f32, through a padded 3D destination
+  Img gray = Zeros(5, 4, 2, 1, 8, false, false, 1);
+  gray.ROI().At<uint8_t>(4, 3, 1, 0) = 51;
+  Img half(6, 4, 2, 4, 16, true, true, 4);
+  Img hdr(6, 4, 2, 4, 32, true, true, 1);
+  if (!Convert(half.ROI(), gray.CROI()) || !Convert(hdr.ROI(), half.CROI())
+    || std::fabs(hdr.CROI().At<float>(4, 3, 1, 2) - 0.2f) > 1e-3f || hdr.CROI().At<float>(4, 3, 1, 3) != 1.0f
+    || hdr.CROI().At<float>(0, 0, 0, 0) != 0.0f) {
+    std::cerr << "gray -> f16 -> f32 error" << std::endl;
+    return 1;
+  }
+
+  // f16 encoding of normals, subnormals, overflow
+  const float values[] = {1.0f, -2.5f, 65504.0f, 1e5f, 5.9604645e-8f, 3.0e-5f, 0.333333f};
+  const float expected[] = {1.0f, -2.5f, 65504.0f, INFINITY, 5.9604645e-8f, 2.9981136e-5f, 0.33325195f};
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    float v = detail::HalfBitsToFloat(detail::FloatToHalfBits(values[i]));
+    if (v != expected[i]) {
+      std::cerr << "f16 round trip of " << values[i] << " gave " << v << std::endl;
+      return 1;
+    }
+  }
+
+  // plain integers and SNORM
+  Img s8(2, 1, 1, 8, false, true);
+  s8.ROI().At<int8_t>(0, 0) = -128;
+  s8.ROI().At<int8_t>(1, 0) = 127;
+  Img snorm(2, 1, 1, 32, true, true);
+  Img wide(2, 1, 1, 32, false, true);
+  ConvertOptions raw;
+  raw.src_normalized = false;
+  raw.dst_normalized = false;
+  if (!Convert(snorm.ROI(), s8.CROI()) || snorm.CROI().At<float>(0, 0) != -1.0f
+    || snorm.CROI().At<float>(1, 0) != 1.0f || !Convert(wide.ROI(), s8.CROI(), raw)
+    || wide.CROI().At<int32_t>(0, 0) != -128) {
+    std::cerr << "SNORM / SINT error" << std::endl;
+    return 1;
+  }
+  snorm.ROI().At<float>(0, 0) = -300.4f;
+  if (!Convert(s8.ROI(), snorm.CROI(), raw) || s8.CROI().At<int8_t>(0, 0) != -128
+    || s8.CROI().At<int8_t>(1, 0) != 1) {
+    std::cerr << "float -> SINT clamp error" << std::endl;
+    return 1;
+  }
+
+  // NaNs encode as 0 in every integer type, from f32 and f16
+  Img nans(2, 1, 1, 32, true, true);
+  nans.ROI().At<float>(0, 0) = NAN;
+  nans.ROI().At<float>(1, 0) = -NAN;
+  Img nan_u8(2, 1, 1, 8);
+  Img nan_s32(2, 1, 1, 32, false, true);
+  Img nan_f16(2, 1, 1, 16, true, true);
+  Img nan_u16(2, 1, 1, 16);
+  if (!Convert(nan_u8.ROI(), nans.CROI()) || !Convert(nan_s32.ROI(), nans.CROI(), raw)
+    || !Convert(nan_f16.ROI(), nans.CROI()) || !Convert(nan_u16.ROI(), nan_f16.CROI())
+    || nan_u8.CROI().At<uint8_t>(0, 0) != 0 || nan_u8.CROI().At<uint8_t>(1, 0) != 0
+    || nan_s32.CROI().At<int32_t>(0, 0) != 0 || nan_s32.CROI().At<int32_t>(1, 0) != 0
+    || nan_u16.CROI().At<uint16_t>(0, 0) != 0 || nan_u16.CROI().At<uint16_t>(1, 0) != 0) {
+    std::cerr << "NaN -> integer error" << std::endl;
+    return 1;
+  }
+
+  // rejected conversions
+  Img f64(2, 1, 1, 64, true, true);
+  Img small(1, 1, 1, 8);
+  ConvertOptions bad;
+  bad.swizzle[0] = 3;
+  if (Convert(f64.ROI(), s8.CROI()) || Convert(small.ROI(), s8.CROI()) || Convert(rgba.ROI(), rgb.CROI(), bad)) {
+    std::cerr << "invalid conversion accepted" << std::endl;
+    return 1;
+  }
+  return 0;
+}
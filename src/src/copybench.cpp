@@ -0,0 +1,87 @@
+#include <imgpp/imgpp.hpp>
+#include "benchutil.h"
+#include <cstring>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 9 };
+
+// baseline: the former CopyData(), one memcpy per row
+void RowCopy(ImgROI &dst, const ImgROI &src) {
+  size_t length = (size_t)ImgROI::CalcPitch(src.Width(), src.Channel(), src.BPC());
+  for (uint32_t z = 0; z < src.Depth(); ++z) {
+    for (uint32_t y = 0; y < src.Height(); ++y) {
+      memcpy(dst.PtrAt(0, y, z, 0), src.PtrAt(0, y, z, 0), length);
+    }
+  }
+}
+
+void BenchCopy(const char *name, ImgROI dst, const ImgROI &src) {
+  double bytes = (double)ImgROI::CalcPitch(src.Width(), src.Channel(), src.BPC())
+    * src.Height() * src.Depth() * 2;
+  double ms_rows = bench::MedianMs(kReps, [&]() {
+    RowCopy(dst, src);
+    bench::DoNotOptimize(dst.GetData());
+  });
+  double ms_copy = bench::MedianMs(kReps, [&]() {
+    CopyData(dst, src);
+    bench::DoNotOptimize(dst.GetData());
+  });
+  double ms_pool = bench::MedianMs(kReps, [&]() {
+    CopyData(dst, src, DefaultThreadPool());
+    bench::DoNotOptimize(dst.GetData());
+  });
+  bench::Report(name, "memcpy per row", ms_rows, bytes);
+  bench::Report(name, "CopyData", ms_copy, bytes);
+  bench::Report(name, "CopyData, pool", ms_pool, bytes);
+}
+
+void BenchAligned() {
+  for (uint32_t scale: {1u, 2u, 4u}) {
+    uint32_t w = 1920 * scale, h = 1080 * scale;
+    Img src(w, h, 4, 8), dst(w, h, 4, 8);
+    memset(src.ROI().GetData(), 7, src.CData().GetLength());
+    memset(dst.ROI().GetData(), 0, dst.CData().GetLength());
+    const char *names[] = {"aligned 2K RGBA8", "aligned 4K RGBA8", "", "aligned 8K RGBA8"};
+    BenchCopy(names[scale - 1], dst.ROI(), src.CROI());
+  }
+  Img src(7680, 4320, 4, 8);
+  memset(src.ROI().GetData(), 7, src.CData().GetLength());
+  double ms_clone = bench::MedianMs(kReps, [&src]() {
+    Img clone = src.Clone();
+    bench::DoNotOptimize(clone.CROI().GetData());
+  });
+  bench::Report("Clone 8K RGBA8", "Img::Clone", ms_clone, (double)src.CData().GetLength() * 2);
+}
+
+// both ROIs start one byte past the buffer start
+void BenchUnaligned() {
+  const uint32_t w = 7680, h = 4320;
+  ImgBuffer src_buf(ImgROI::CalcPitch(w, 4, 8) * h + 1), dst_buf(ImgROI::CalcPitch(w, 4, 8) * h + 1);
+  memset(src_buf.GetBuffer(), 7, (size_t)src_buf.GetLength());
+  memset(dst_buf.GetBuffer(), 0, (size_t)dst_buf.GetLength());
+  uint64_t pitch = ImgROI::CalcPitch(w, 4, 8);
+  ImgROI src(src_buf.GetBuffer() + 1, w, h, 4, 8, pitch, false, false);
+  ImgROI dst(dst_buf.GetBuffer() + 1, w, h, 4, 8, pitch, false, false);
+  BenchCopy("unaligned 8K RGBA8", dst, src);
+}
+
+// a 4K window of an 8K frame, row by row
+void BenchSubROI() {
+  Img src(7680, 4320, 4, 8), dst(3840, 2160, 4, 8);
+  memset(src.ROI().GetData(), 7, src.CData().GetLength());
+  memset(dst.ROI().GetData(), 0, dst.CData().GetLength());
+  ImgROI window = src.ROI().SubRegion(100, 100, 0, 100 + 3839, 100 + 2159, 0);
+  BenchCopy("4K window of 8K RGBA8", dst.ROI(), window);
+}
+
+}
+
+int main() {
+  BenchAligned();
+  BenchUnaligned();
+  BenchSubROI();
+  return 0;
+}
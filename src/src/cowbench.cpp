@@ -0,0 +1,43 @@
+#include <imgpp/imgpp.hpp>
+#include "benchutil.h"
+#include <cstring>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 9, kStages = 8, kWidth = 3840, kHeight = 2160 };
+
+// A pipeline stage that defensively clones its input and modifies one in every write_every frames.
+Img Stage(const Img &input, uint32_t stage, uint32_t write_every) {
+  Img output = input.Clone();
+  if (write_every != 0 && stage % write_every == 0) {
+    output.ROI().At<uint8_t>(0, 0, 0) = (uint8_t)stage;
+  }
+  return output;
+}
+
+void BenchPipeline(bool cow, uint32_t write_every, const char *name) {
+  Img source(kWidth, kHeight, 4, 8);
+  source.SetCopyOnWrite(cow);
+  memset(source.ROI().GetData(), 1, source.CData().GetLength());
+  double ms = bench::MedianMs(kReps, [&source, write_every]() {
+    Img img = source;
+    for (uint32_t stage = 0; stage < kStages; ++stage) {
+      img = Stage(img, stage, write_every);
+    }
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  bench::Report(name, cow ? "copy-on-write" : "eager clone", ms);
+}
+
+}
+
+int main() {
+  for (bool cow: {false, true}) {
+    BenchPipeline(cow, 0, "8 stages 4K RGBA8, read-only");
+    BenchPipeline(cow, 4, "8 stages 4K RGBA8, 2 writes");
+    BenchPipeline(cow, 1, "8 stages 4K RGBA8, all write");
+  }
+  return 0;
+}
@@ -3,6 +3,7 @@
 #include <imgpp/loadersext.hpp>
 #include <imgpp/opencvbinding.hpp>
 #include <string>
+#include <cstring>
 #include <iostream>
 #include <opencv2/imgproc.hpp>
 
@@ -33,5 +34,23 @@ int main(int argc, char *argv[]) {
   out_img.CopyFrom(out_roi);
   imgpp::Write((out_fn + ".jpg").c_str(), out_img.ROI());
 
+  // the Img keeps the cv::Mat pixels alive after the cv::Mat itself is released
+  cv::Mat kept_mat = gray_mat.clone();
+  imgpp::Img ref_img = imgpp::RefImg(kept_mat);
+  kept_mat.release();
+  imgpp::ImgROI ref_roi = ref_img.ROI();
+  imgpp::ImgROI copy_roi = out_img.ROI();
+  if (ref_roi.Width() != copy_roi.Width() || ref_roi.Height() != copy_roi.Height()) {
+    cerr << "RefImg size mismatch" << endl;
+    return 1;
+  }
+  size_t row_bytes = (size_t)ref_roi.Width() * ref_roi.Channel() * ref_roi.BPC() / 8;
+  for (uint32_t y = 0; y < ref_roi.Height(); ++y) {
+    if (memcmp(ref_roi.PtrAt(0, y, 0, 0), copy_roi.PtrAt(0, y, 0, 0), row_bytes) != 0) {
+      cerr << "RefImg lost the cv::Mat pixels" << endl;
+      return 1;
+    }
+  }
+
   return 0;
 }
\ No newline at end of file
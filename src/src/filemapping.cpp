@@ -0,0 +1,86 @@
+#include <imgpp/loaders.hpp>
+#include <imgpp/imgbase.hpp>
+#include <limits>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace imgpp {
+
+#if defined(_WIN32)
+
+bool MapFile(const char *fn, ImgBuffer &buffer) {
+  if (fn == nullptr) {
+    return false;
+  }
+  HANDLE file = CreateFileA(fn, GENERIC_READ, FILE_SHARE_READ, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0
+    || (uint64_t)file_size.QuadPart > std::numeric_limits<size_t>::max()) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return false;
+  }
+  void *view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle(mapping);  // the view keeps the mapping object alive
+  if (view == nullptr) {
+    return false;
+  }
+
+  std::shared_ptr<uint8_t> data((uint8_t*)view, [](uint8_t *p) {
+    UnmapViewOfFile(p);
+  });
+  buffer = ImgBuffer(std::move(data), (uint64_t)file_size.QuadPart);
+  return true;
+}
+
+#else
+
+bool MapFile(const char *fn, ImgBuffer &buffer) {
+  if (fn == nullptr) {
+    return false;
+  }
+  int fd = open(fn, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0
+    || (uint64_t)st.st_size > std::numeric_limits<size_t>::max()) {
+    close(fd);
+    return false;
+  }
+  size_t length = (size_t)st.st_size;
+  // private writable mapping: pages stay shared with the page cache until written
+  void *view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);  // the mapping keeps its own reference to the file
+  if (view == MAP_FAILED) {
+    return false;
+  }
+
+  std::shared_ptr<uint8_t> data((uint8_t*)view, [length](uint8_t *p) {
+    munmap(p, length);
+  });
+  buffer = ImgBuffer(std::move(data), (uint64_t)length);
+  return true;
+}
+
+#endif
+
+}
@@ -0,0 +1,86 @@
+#include <imgpp/algorithms.hpp>
+#include "benchutil.h"
+#include <array>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 15 };
+
+// baseline: the former Fill(), one channel per store
+template<typename T>
+void ChannelFill(ImgROI &roi, T val) {
+  uint8_t step = roi.BPC() >> 3;
+  for (uint32_t z = 0; z < roi.Depth(); z++) {
+    for (uint32_t y = 0; y < roi.Height(); y++) {
+      uint8_t *ptr = (uint8_t*)roi.PtrAt(0, y, z, 0);
+      for (uint32_t x = 0; x < roi.Width() * roi.Channel(); x++) {
+        *(T*)ptr = val;
+        ptr += step;
+      }
+    }
+  }
+}
+
+// the former way to fill a color: one ZipTransformPixel-like store per channel
+void ColorLoop(ImgROI &roi, const std::array<uint8_t, 4> &color) {
+  for (uint32_t y = 0; y < roi.Height(); y++) {
+    uint8_t *ptr = (uint8_t*)roi.PtrAt(0, y, 0, 0);
+    for (uint32_t x = 0; x < roi.Width(); x++) {
+      for (uint32_t c = 0; c < 4; c++) {
+        ptr[x * 4 + c] = color[c];
+      }
+    }
+  }
+}
+
+void BenchZeros() {
+  Img img(3840, 2160, 4, 32, true);
+  double bytes = (double)img.CData().GetLength();
+  double ms_channel = bench::MedianMs(kReps, [&img]() {
+    ChannelFill(img.ROI(), 0.0f);
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  double ms_fill = bench::MedianMs(kReps, [&img]() {
+    Fill(img.ROI(), 0.0f);
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  bench::Report("Fill 0 4K RGBA32F", "per channel", ms_channel, bytes);
+  bench::Report("Fill 0 4K RGBA32F", "memset", ms_fill, bytes);
+}
+
+void BenchColor(const char *name, uint32_t w, uint32_t h, uint32_t c, uint8_t alignment) {
+  Img img(w, h, 1, c, 8, false, false, alignment);
+  double bytes = (double)img.CData().GetLength();
+  const std::array<uint8_t, 4> rgba{255, 128, 64, 255};
+  const std::array<uint8_t, 3> rgb{255, 128, 64};
+  if (c == 4) {
+    double ms_loop = bench::MedianMs(kReps, [&]() {
+      ColorLoop(img.ROI(), rgba);
+      bench::DoNotOptimize(img.CROI().GetData());
+    });
+    bench::Report(name, "per channel", ms_loop, bytes);
+  }
+  for (StoreMode mode: {StoreMode::CACHED, StoreMode::STREAMING}) {
+    double ms = bench::MedianMs(kReps, [&]() {
+      if (c == 4) {
+        Fill(img.ROI(), rgba, mode);
+      } else {
+        Fill(img.ROI(), rgb, mode);
+      }
+      bench::DoNotOptimize(img.CROI().GetData());
+    });
+    bench::Report(name, mode == StoreMode::CACHED ? "pattern, cached" : "pattern, streaming", ms, bytes);
+  }
+}
+
+}
+
+int main() {
+  BenchZeros();
+  BenchColor("Fill color 4K RGBA8", 3840, 2160, 4, 1);
+  BenchColor("Fill color 8K RGBA8", 7680, 4320, 4, 1);
+  BenchColor("Fill color 4K RGB8, 4B pitch", 3841, 2160, 3, 4);
+  return 0;
+}
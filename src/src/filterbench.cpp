@@ -0,0 +1,86 @@
+#include <imgpp/filter.hpp>
+#include "benchutil.h"
+#include <string>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 3, kWidth = 3840, kHeight = 2160 };
+
+// separable per pixel loops through At<T>, the blur GaussianBlur replaces
+void BenchNaive(const Img &src, Img &dst, float sigma) {
+  std::vector<float> kernel = GaussianKernel(sigma);
+  int32_t radius = (int32_t)kernel.size() / 2;
+  Img tmp(kWidth, kHeight, 4, 32, true, true);
+  const ImgROI &in = src.CROI();
+  ImgROI &mid = tmp.ROI();
+  ImgROI &out = dst.ROI();
+  double ms = bench::MedianMs(1, [&]() {
+    for (uint32_t y = 0; y < kHeight; y++) {
+      for (uint32_t x = 0; x < kWidth; x++) {
+        for (uint32_t c = 0; c < 4; c++) {
+          float sum = 0.0f;
+          for (int32_t t = -radius; t <= radius; t++) {
+            uint32_t sx = (uint32_t)std::min(std::max((int32_t)x + t, 0), kWidth - 1);
+            sum += kernel[t + radius] * in.At<uint8_t>(sx, y, 0, c);
+          }
+          mid.At<float>(x, y, 0, c) = sum;
+        }
+      }
+    }
+    for (uint32_t y = 0; y < kHeight; y++) {
+      for (uint32_t x = 0; x < kWidth; x++) {
+        for (uint32_t c = 0; c < 4; c++) {
+          float sum = 0.0f;
+          for (int32_t t = -radius; t <= radius; t++) {
+            uint32_t sy = (uint32_t)std::min(std::max((int32_t)y + t, 0), kHeight - 1);
+            sum += kernel[t + radius] * mid.At<float>(x, sy, 0, c);
+          }
+          out.At<uint8_t>(x, y, 0, c) = (uint8_t)(std::min(std::max(sum, 0.0f), 255.0f) + 0.5f);
+        }
+      }
+    }
+    bench::DoNotOptimize(out.GetData());
+  });
+  std::string variant = "At<T> loop, sigma " + std::to_string(sigma).substr(0, 4);
+  bench::Report("RGBA8 4K Gaussian", variant.c_str(), ms);
+}
+
+void BenchBlur(const Img &src, Img &dst, float sigma, bool fir) {
+  ThreadPool single(1);
+  std::vector<float> kernel = GaussianKernel(sigma);
+  for (int parallel = 0; parallel < 2; parallel++) {
+    Executor &executor = parallel ? (Executor&)DefaultThreadPool() : single;
+    double ms = bench::MedianMs(kReps, [&]() {
+      if (fir) {
+        SeparableFilter(dst.ROI(), src.CROI(), kernel, kernel, BorderMode::CLAMP, 0.0f, executor);
+      } else {
+        GaussianBlur(dst.ROI(), src.CROI(), sigma, BorderMode::CLAMP, 0.0f, executor);
+      }
+      bench::DoNotOptimize(dst.CROI().GetData());
+    });
+    std::string variant = std::string(fir ? "SeparableFilter" : "GaussianBlur") + ", sigma "
+      + std::to_string(sigma).substr(0, 4) + (parallel ? ", pool" : ", 1 thread");
+    bench::Report("RGBA8 4K Gaussian", variant.c_str(), ms, (double)kWidth * kHeight * 8);
+  }
+}
+
+}
+
+int main() {
+  Img src(kWidth, kHeight, 4, 8);
+  Img dst(kWidth, kHeight, 4, 8);
+  for (size_t i = 0; i < src.CData().GetLength(); i++) {
+    src.ROI().GetData()[i] = (uint8_t)(i * 7919 >> 6);
+  }
+  BenchNaive(src, dst, 1.0f);
+  // the sampled kernel against the box cascade around the switch
+  for (float sigma: {2.0f, 3.0f, 5.0f}) {
+    BenchBlur(src, dst, sigma, true);
+  }
+  for (float sigma: {0.5f, 1.0f, 2.0f, 3.0f, 5.0f, 10.0f, 20.0f, 50.0f}) {
+    BenchBlur(src, dst, sigma, false);
+  }
+  return 0;
+}
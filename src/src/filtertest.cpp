@@ -0,0 +1,258 @@
+#include <imgpp/filter.hpp>
+#include "testutil.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace imgpp;
+
+const BorderMode kBorders[] = {BorderMode::CLAMP, BorderMode::REFLECT, BorderMode::WRAP, BorderMode::CONSTANT};
+
+// value of channel ch at (x, y), read through the border
+static double Fetch(const ImgROI &roi, int64_t x, int64_t y, uint32_t z, uint32_t ch, BorderMode border,
+  float border_value) {
+  int64_t bx = detail::BorderIndex(x, roi.Width(), border);
+  int64_t by = detail::BorderIndex(y, roi.Height(), border);
+  if (bx < 0 || by < 0) {
+    return border_value;
+  }
+  switch (GetChannelType(roi)) {
+  case ChannelType::U8: return roi.At<uint8_t>((uint32_t)bx, (uint32_t)by, z, ch);
+  case ChannelType::S16: return roi.At<int16_t>((uint32_t)bx, (uint32_t)by, z, ch);
+  case ChannelType::F16: return (float)roi.At<Half>((uint32_t)bx, (uint32_t)by, z, ch);
+  default: return roi.At<float>((uint32_t)bx, (uint32_t)by, z, ch);
+  }
+}
+
+// the 2D convolution, straight from the definition
+static double Reference(const ImgROI &src, const std::vector<float> &kx, const std::vector<float> &ky,
+  uint32_t x, uint32_t y, uint32_t z, uint32_t ch, BorderMode border, float border_value) {
+  double sum = 0.0;
+  for (size_t j = 0; j < ky.size(); j++) {
+    for (size_t i = 0; i < kx.size(); i++) {
+      sum += (double)kx[i] * ky[j] * Fetch(src, (int64_t)x + i - kx.size() / 2, (int64_t)y + j - ky.size() / 2, z, ch,
+        border, border_value);
+    }
+  }
+  return sum;
+}
+
+// noise of 256 levels per channel
+static void FillLevels(ImgROI roi, uint32_t seed) {
+  ChannelType type = GetChannelType(roi);
+  test::FillNoise(roi, seed, [type](uint32_t r, uint32_t, uint32_t, uint32_t, uint32_t) {
+    r >>= 16;
+    switch (type) {
+    case ChannelType::U8: return (double)r;
+    case ChannelType::S16: return r * 200.0 - 25000.0;
+    default: return r / 64.0 - 2.0;
+    }
+  });
+}
+
+int main() {
+  // border indices of a line of 4 pixels
+  const int64_t expected[4][4] = {{0, 0, 3, 3}, {2, 1, 2, 1}, {2, 3, 0, 1}, {-1, -1, -1, -1}};
+  for (int b = 0; b < 4; b++) {
+    const int64_t at[4] = {-2, -1, 4, 5};
+    for (int i = 0; i < 4; i++) {
+      if (detail::BorderIndex(at[i], 4, kBorders[b]) != expected[b][i]) {
+        std::cerr << "BorderIndex error for mode " << b << " at " << at[i] << std::endl;
+        return 1;
+      }
+    }
+  }
+  if (detail::BorderIndex(-7, 1, BorderMode::REFLECT) != 0 || detail::BorderIndex(9, 4, BorderMode::REFLECT) != 3) {
+    std::cerr << "BorderIndex reflect error" << std::endl;
+    return 1;
+  }
+
+  // arbitrary kernels against the definition, every border mode, odd and even kernel sizes
+  const std::vector<float> kx = {0.25f, -0.5f, 1.5f, 0.5f, 0.125f};
+  const std::vector<float> ky = {0.3f, 0.9f, -0.2f, 0.4f};
+  for (uint32_t bpc: {8u, 16u, 32u}) {
+    for (bool is_float: {false, true}) {
+      if ((bpc == 32 && !is_float) || (bpc == 8 && is_float)) {
+        continue;
+      }
+      bool is_signed = is_float || bpc == 16;
+      Img src(19, 7, 3, bpc, is_float, is_signed);
+      Img dst(19, 7, 3, bpc, is_float, is_signed);
+      FillLevels(src.ROI(), bpc);
+      double tolerance = is_float ? (bpc == 16 ? 0.02 : 1e-4) : 0.51;
+      for (BorderMode border: kBorders) {
+        if (!SeparableFilter(dst.ROI(), src.CROI(), kx, ky, border, 7.0f)) {
+          std::cerr << "SeparableFilter failed" << std::endl;
+          return 1;
+        }
+        for (uint32_t y = 0; y < 7; y++) {
+          for (uint32_t x = 0; x < 19; x++) {
+            for (uint32_t c = 0; c < 3; c++) {
+              double ref = Reference(src.CROI(), kx, ky, x, y, 0, c, border, 7.0f);
+              if (!is_float) {
+                ref = bpc == 8 ? std::min(std::max(ref, 0.0), 255.0) : std::min(std::max(ref, -32768.0), 32767.0);
+              }
+              double got = Fetch(dst.CROI(), x, y, 0, c, border, 0.0f);
+              if (std::fabs(got - ref) > tolerance * std::max(1.0, std::fabs(ref) * (is_float ? 1.0 : 0.0))) {
+                std::cerr << "SeparableFilter error, bpc " << bpc << " float " << is_float << " border "
+                  << (int)border << " at " << x << ", " << y << ": " << got << " vs " << ref << std::endl;
+                return 1;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // a 1 tap kernel copies every channel type
+  for (uint32_t bpc: {8u, 16u, 32u}) {
+    for (int kind = 0; kind < 3; kind++) {
+      bool is_float = kind == 2;
+      if (is_float && bpc == 8) {
+        continue;
+      }
+      Img src(13, 5, 2, bpc, is_float, kind != 0);
+      Img dst(13, 5, 2, bpc, is_float, kind != 0);
+      for (size_t i = 0; i < src.CData().GetLength(); i++) {
+        src.ROI().GetData()[i] = (uint8_t)(i * 37 + 11);
+      }
+      if (is_float && bpc == 32) {
+        ZipTransformPixel(std::make_tuple(src.ROI()), [](uint32_t x, uint32_t y, uint32_t, auto &ptrs) {
+          ((float*)ptrs[0])[0] = x * 0.5f - y;
+          ((float*)ptrs[0])[1] = -1.0f;
+        });
+      } else if (is_float) {
+        ZipTransformPixel(std::make_tuple(src.ROI()), [](uint32_t x, uint32_t y, uint32_t, auto &ptrs) {
+          ((Half*)ptrs[0])[0] = Half(x * 0.5f - y);
+          ((Half*)ptrs[0])[1] = Half(-1.0f);
+        });
+      } else if (bpc == 32) {
+        // 32 bit integers go through floats, keep them exact
+        ZipTransformPixel(std::make_tuple(src.ROI()), [](uint32_t x, uint32_t y, uint32_t, auto &ptrs) {
+          ((int32_t*)ptrs[0])[0] = (int32_t)(x * 1000 + y);
+          ((int32_t*)ptrs[0])[1] = (int32_t)y;
+        });
+      }
+      if (!SeparableFilter(dst.ROI(), src.CROI(), {1.0f}, {1.0f})
+        || memcmp(dst.CROI().GetData(), src.CROI().GetData(), src.CData().GetLength()) != 0) {
+        std::cerr << "Identity filter error, bpc " << bpc << " kind " << kind << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // Gaussians: small sigma is the sampled kernel, box cascades keep mass, constants and the variance
+  Img noise(40, 30, 4, 8);
+  Img blurred(40, 30, 4, 8);
+  Img reference(40, 30, 4, 8);
+  FillLevels(noise.ROI(), 3);
+  std::vector<float> kernel = GaussianKernel(1.5f);
+  if (kernel.size() != 11 || !GaussianBlur(blurred.ROI(), noise.CROI(), 1.5f, BorderMode::REFLECT)
+    || !SeparableFilter(reference.ROI(), noise.CROI(), kernel, kernel, BorderMode::REFLECT)
+    || memcmp(blurred.CROI().GetData(), reference.CROI().GetData(), noise.CData().GetLength()) != 0) {
+    std::cerr << "Small sigma GaussianBlur error" << std::endl;
+    return 1;
+  }
+  for (float sigma: {3.0f, 7.5f, 40.0f}) {
+    std::array<uint32_t, 3> widths = detail::GaussianBoxes(sigma);
+    double variance = 0.0;
+    for (uint32_t w: widths) {
+      variance += (w * w - 1.0) / 12.0;
+    }
+    if (std::fabs(std::sqrt(variance) / sigma - 1.0) > 0.06) {
+      std::cerr << "GaussianBoxes error at sigma " << sigma << std::endl;
+      return 1;
+    }
+    Img impulse(301, 3, 1, 32, true, true);
+    Img response(301, 3, 1, 32, true, true);
+    // a vertical line, so that the clamped rows keep it and row 1 is the 1D response
+    memset(impulse.ROI().GetData(), 0, impulse.CData().GetLength());
+    for (uint32_t y = 0; y < 3; y++) {
+      impulse.ROI().At<float>(150, y) = 1.0f;
+    }
+    GaussianBlur(response.ROI(), impulse.CROI(), sigma, BorderMode::CLAMP);
+    double mass = 0.0;
+    double second_moment = 0.0;
+    for (uint32_t x = 0; x < 301; x++) {
+      double v = response.CROI().At<float>(x, 1);
+      mass += v;
+      second_moment += v * ((double)x - 150) * ((double)x - 150);
+    }
+    if (std::fabs(mass - 1.0) > 1e-4 || std::fabs(second_moment - variance) > 1e-2 * variance) {
+      std::cerr << "Box GaussianBlur impulse error at sigma " << sigma << ": " << mass << ", "
+        << second_moment << " vs " << variance << std::endl;
+      return 1;
+    }
+    for (BorderMode border: kBorders) {
+      Img flat(35, 21, 2, 16, true, true);
+      Img flat_blurred(35, 21, 2, 16, true, true);
+      ZipTransformPixel(std::make_tuple(flat.ROI()), [](uint32_t, uint32_t, uint32_t, auto &ptrs) {
+        ((Half*)ptrs[0])[0] = Half(0.75f);
+        ((Half*)ptrs[0])[1] = Half(-3.0f);
+      });
+      float border_value = 0.75f;
+      GaussianBlur(flat_blurred.ROI(), flat.CROI(), sigma, border, border_value);
+      if (std::fabs((float)flat_blurred.CROI().At<Half>(0, 20, 0, 0) - 0.75f) > 1e-3f
+        || (border != BorderMode::CONSTANT && std::fabs((float)flat_blurred.CROI().At<Half>(17, 3, 0, 1) + 3.0f) > 1e-2f)) {
+        std::cerr << "Box GaussianBlur changes a constant image at sigma " << sigma << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // the cascade is a convolution with the 3 boxes, across bands and for 5 channels
+  Img tall(9, 300, 5, 32, true, true);
+  Img tall_blurred(9, 300, 5, 32, true, true);
+  Img tall_reference(9, 300, 5, 32, true, true);
+  FillLevels(tall.ROI(), 7);
+  std::vector<float> boxes = {1.0f};
+  for (uint32_t width: detail::GaussianBoxes(3.0f)) {
+    std::vector<float> next(boxes.size() + width - 1, 0.0f);
+    for (size_t i = 0; i < boxes.size(); i++) {
+      for (uint32_t j = 0; j < width; j++) {
+        next[i + j] += boxes[i] / width;
+      }
+    }
+    boxes = next;
+  }
+  for (BorderMode border: kBorders) {
+    GaussianBlur(tall_blurred.ROI(), tall.CROI(), 3.0f, border, 0.5f);
+    SeparableFilter(tall_reference.ROI(), tall.CROI(), boxes, boxes, border, 0.5f);
+    for (size_t i = 0; i < tall.CData().GetLength() / sizeof(float); i++) {
+      if (std::fabs(((const float*)tall_blurred.CROI().GetData())[i]
+        - ((const float*)tall_reference.CROI().GetData())[i]) > 1e-4f) {
+        std::cerr << "Box GaussianBlur differs from its kernel at value " << i << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // 3D, multithreaded bands identical to a single thread
+  ThreadPool single(1);
+  ThreadPool pool(4);
+  Img volume(300, 120, 3, 4, 8, false, false, 1);
+  FillLevels(volume.ROI(), 5);
+  for (float sigma: {1.0f, 12.0f}) {
+    Img a(300, 120, 3, 4, 8, false, false, 1);
+    Img b(300, 120, 3, 4, 8, false, false, 1);
+    if (!GaussianBlur(a.ROI(), volume.CROI(), sigma, BorderMode::WRAP, 0.0f, single)
+      || !GaussianBlur(b.ROI(), volume.CROI(), sigma, BorderMode::WRAP, 0.0f, pool)
+      || memcmp(a.CROI().GetData(), b.CROI().GetData(), a.CData().GetLength()) != 0) {
+      std::cerr << "Parallel GaussianBlur error at sigma " << sigma << std::endl;
+      return 1;
+    }
+  }
+
+  Img wrong_size(39, 30, 4, 8);
+  Img wrong_type(40, 30, 4, 16);
+  if (GaussianBlur(wrong_size.ROI(), noise.CROI(), 2.0f) || GaussianBlur(wrong_type.ROI(), noise.CROI(), 2.0f)
+    || GaussianBlur(blurred.ROI(), noise.CROI(), -1.0f) || SeparableFilter(blurred.ROI(), noise.CROI(), {}, {1.0f})) {
+    std::cerr << "Filter format checks error" << std::endl;
+    return 1;
+  }
+
+  std::cout << "ok" << std::endl;
+  return 0;
+}
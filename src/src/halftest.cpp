@@ -0,0 +1,116 @@
+#include <imgpp/half.hpp>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/sampler.hpp>
+#include <imgpp/typedview.hpp>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace imgpp;
+
+static uint32_t FloatBits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, 4);
+  return bits;
+}
+
+static float BitsFloat(uint32_t bits) {
+  float f;
+  memcpy(&f, &bits, 4);
+  return f;
+}
+
+int main() {
+  // every half, bulk and scalar, against the definition
+  std::vector<Half> halves(65536);
+  for (uint32_t i = 0; i < 65536; i++) {
+    halves[i] = Half::FromBits((uint16_t)i);
+  }
+  std::vector<float> floats(65536);
+  HalfToFloat(floats.data(), halves.data(), halves.size());
+  for (uint32_t i = 0; i < 65536; i++) {
+    uint32_t exp = (i >> 10) & 0x1f;
+    uint32_t mant = i & 0x3ff;
+    double expected = exp == 0 ? std::ldexp((double)mant, -24)
+      : exp == 31 ? (mant ? NAN : INFINITY) : std::ldexp(1024.0 + mant, (int)exp - 25);
+    if (i & 0x8000) {
+      expected = -expected;
+    }
+    float scalar = halves[i];
+    bool ok = std::isnan(expected) ? std::isnan(floats[i]) && std::isnan(scalar)
+      : floats[i] == (float)expected && FloatBits(scalar) == FloatBits(floats[i]);
+    if (!ok) {
+      std::cerr << "f16 -> f32 error at 0x" << std::hex << i << std::endl;
+      return 1;
+    }
+  }
+
+  // f32 -> f16 at and around every midpoint between neighboring finite halves
+  std::vector<float> inputs;
+  std::vector<uint16_t> expected;
+  for (uint32_t i = 0; i < 0x7bff; i++) {
+    float lo = floats[i];
+    float hi = floats[i + 1];
+    float mid = (float)(((double)lo + hi) / 2);
+    uint16_t even = (i & 1) ? (uint16_t)(i + 1) : (uint16_t)i;
+    inputs.insert(inputs.end(), {lo, mid, std::nextafter(mid, 0.0f), std::nextafter(mid, INFINITY)});
+    expected.insert(expected.end(), {(uint16_t)i, even, (uint16_t)i, (uint16_t)(i + 1)});
+  }
+  // overflow: 65520 is halfway between the largest half and the next power of 2
+  inputs.insert(inputs.end(), {65504.0f, 65519.99f, 65520.0f, 1e10f, INFINITY, 1e-8f, 2.9802322e-8f});
+  expected.insert(expected.end(), {0x7bff, 0x7bff, 0x7c00, 0x7c00, 0x7c00, 0, 0});
+  size_t positive = inputs.size();
+  for (size_t i = 0; i < positive; i++) {
+    inputs.push_back(-inputs[i]);
+    expected.push_back(expected[i] | 0x8000);
+  }
+  std::vector<Half> rounded(inputs.size());
+  FloatToHalf(rounded.data(), inputs.data(), inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (rounded[i].Bits() != expected[i] || Half(inputs[i]).Bits() != expected[i]) {
+      std::cerr << "f32 -> f16 error for " << inputs[i] << ": 0x" << std::hex
+        << rounded[i].Bits() << " / 0x" << Half(inputs[i]).Bits() << " != 0x" << expected[i] << std::endl;
+      return 1;
+    }
+  }
+
+  // bulk and scalar agree on random bit patterns, NaNs stay NaNs
+  std::mt19937 rng(7);
+  std::vector<float> random(100003);
+  for (auto &f: random) {
+    f = BitsFloat(rng());
+  }
+  std::vector<Half> random_halves(random.size());
+  FloatToHalf(random_halves.data(), random.data(), random.size());
+  for (size_t i = 0; i < random.size(); i++) {
+    Half scalar(random[i]);
+    bool ok = std::isnan(random[i]) ? std::isnan((float)scalar) && std::isnan((float)random_halves[i])
+      : scalar.Bits() == random_halves[i].Bits();
+    if (!ok) {
+      std::cerr << "bulk f32 -> f16 mismatch for 0x" << std::hex << FloatBits(random[i]) << std::endl;
+      return 1;
+    }
+  }
+
+  // half float ROIs read directly, through At<Half>, the samplers and TypedView
+  Img hdr(4, 2, 1, 16, true, true);
+  for (uint32_t y = 0; y < 2; y++) {
+    for (uint32_t x = 0; x < 4; x++) {
+      hdr.ROI().At<Half>(x, y) = Half(x * 1.5f + y * 100.0f);
+    }
+  }
+  float nn = Tex2DNN<Half>(hdr.CROI(), 2.2f, 0.9f);
+  float bilinear = Tex2DBilinear<Half>(hdr.CROI(), 1.5f, 0.5f);
+  if (nn != 103.0f || bilinear != 52.25f) {
+    std::cerr << "half sampler error: " << nn << " " << bilinear << std::endl;
+    return 1;
+  }
+  TypedView<const Half, 1> view(hdr.CROI());
+  if (view.Empty() || (float)view.At(3, 1, 0) != 104.5f || !TypedView<uint16_t, 1>(hdr.CROI()).Empty()) {
+    std::cerr << "half TypedView error" << std::endl;
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -1,6 +1,7 @@
 #include <imgpp/loaders.hpp>
 #include <imgpp/imgpp.hpp>
 #include <imgpp/loadersext.hpp>
+#include <imgpp/stats.hpp>
 #include <jpeglib.h>
 #include <jerror.h>
 #include <cstdio>
@@ -12,6 +13,7 @@ namespace imgpp {
 bool LoadJPEG(const char *fn, Img &img, bool bottom_first) {
   if (NULL == fn || 0 == strlen(fn))
     return false;
+  detail::CodecScope stats(Codec::JPEG, false);
 
   struct jpeg_decompress_struct cinfo;
   struct jpeg_error_mgr jerr;
@@ -54,6 +56,7 @@ bool LoadJPEG(const char *fn, Img &img, bool bottom_first) {
 
   jpeg_finish_decompress(&cinfo);
   jpeg_destroy_decompress(&cinfo);
+  stats.AddBytes(ftell(infile));
   fclose(infile);
   return true;
 }
@@ -66,6 +69,7 @@ bool WriteJPEGAtQuality(const char *fn, const ImgROI &roi, int quality, bool bot
   if (NULL == fn || 0 == strlen(fn) || quality <= 0 || quality > 100) {
     return false;
   }
+  detail::CodecScope stats(Codec::JPEG, true);
 
   FILE * outfile;
   if ((outfile = fopen(fn, "wb")) == NULL) {
@@ -110,6 +114,7 @@ bool WriteJPEGAtQuality(const char *fn, const ImgROI &roi, int quality, bool bot
   jpeg_finish_compress(&cinfo);
   jpeg_destroy_compress(&cinfo);
   if (outfile != NULL) {
+    stats.AddBytes(ftell(outfile));
     fclose(outfile);
   }
   return true;
@@ -120,6 +125,8 @@ bool LoadJPEG(const void *src, uint32_t length, Img &img, bool bottom_first) {
   if (src == nullptr || length == 0) {
     return false;
   }
+  detail::CodecScope stats(Codec::JPEG, false);
+  stats.AddBytes(length);
 
   struct jpeg_decompress_struct cinfo;
   struct jpeg_error_mgr jerr;
@@ -159,6 +166,7 @@ bool LoadJPEG(const void *src, uint32_t length, Img &img, bool bottom_first) {
 }
 
 uint32_t CompressJPEG(const ImgROI &roi, void *dst, uint32_t length) {
+  detail::CodecScope stats(Codec::JPEG, true);
   struct jpeg_compress_struct cinfo;
   struct jpeg_error_mgr jerr;
 
@@ -198,6 +206,7 @@ uint32_t CompressJPEG(const ImgROI &roi, void *dst, uint32_t length) {
 
   memcpy(dst, compressed_buffer, compressed_length);
   free(compressed_buffer);
+  stats.AddBytes(compressed_length);
   return compressed_length;
 }
 
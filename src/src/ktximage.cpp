@@ -1,11 +1,14 @@
 #include <algorithm>
 #include <array>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <imgpp/compositeimg.hpp>
 #include <imgpp/texturedesc.hpp>
 #include <imgpp/glhelper.hpp>
 #include <imgpp/loaders.hpp>
+#include <imgpp/stats.hpp>
 
 namespace {
 using namespace imgpp;
@@ -54,8 +57,8 @@ TextureTarget GetTarget(KTXHeader header) {
     return TARGET_2D;
 }
 
-uint32_t CalcFaceSize(const CompositeImg &composite_img, uint32_t level) {
-  uint32_t face_size = 0;
+uint64_t CalcFaceSize(const CompositeImg &composite_img, uint32_t level) {
+  uint64_t face_size = 0;
   if (composite_img.IsCompressed()) {
     // All known bc format match alignment 4
     const BlockImgROI &block_roi = composite_img.BlockROI(level, 0, 0);
@@ -65,15 +68,56 @@ uint32_t CalcFaceSize(const CompositeImg &composite_img, uint32_t level) {
     if (composite_img.Alignment() % KTX_ALIGNMENT == 0) {
       face_size = roi.SlicePitch() * roi.Depth();
     } else {
-      face_size = 4 * ((roi.Pitch() + 3 ) / 4) * roi.Height() * roi.Depth();
+      face_size = 4 * ((std::abs(roi.Pitch()) + 3 ) / 4) * roi.Height() * roi.Depth();
     }
   }
   return face_size;
 }
 
-uint32_t ComputeKTXStorageSize(const CompositeImg &composite_img,
+// the imageSize of a level: one face for cubemaps that aren't arrays, every face of every layer otherwise
+uint64_t CalcImageSize(const CompositeImg &composite_img, TextureTarget target, uint32_t level) {
+  uint64_t face_size = CalcFaceSize(composite_img, level);
+  if (target == TARGET_CUBE) {
+    return face_size;
+  }
+  return (uint64_t)composite_img.Layers() * composite_img.Faces() * face_size;
+}
+
+const uint8_t *FaceData(const CompositeImg &composite_img, uint32_t level, uint32_t layer,
+  uint32_t face) {
+  if (composite_img.IsCompressed()) {
+    return composite_img.BlockROI(level, layer, face).GetData();
+  } else {
+    return composite_img.ROI(level, layer, face).GetData();
+  }
+}
+
+// true if all faces of a level follow each other in memory without gaps, rows top first
+bool IsLevelContiguous(const CompositeImg &composite_img, uint32_t level, uint64_t face_size) {
+  if (!composite_img.IsCompressed()) {
+    for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
+      for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
+        if (composite_img.ROI(level, layer, face).Pitch() < 0) {
+          return false;
+        }
+      }
+    }
+  }
+  const uint8_t *expected = FaceData(composite_img, level, 0, 0);
+  for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
+    for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
+      if (FaceData(composite_img, level, layer, face) != expected) {
+        return false;
+      }
+      expected += face_size;
+    }
+  }
+  return true;
+}
+
+uint64_t ComputeKTXStorageSize(const CompositeImg &composite_img,
   const std::unordered_map<std::string, std::string> &custom_data) {
-  uint32_t total_size = sizeof(FOURCC_KTX10) + sizeof(KTXHeader);
+  uint64_t total_size = sizeof(FOURCC_KTX10) + sizeof(KTXHeader);
   // KeyValue Data size
   for (const auto &kv_pair: custom_data) {
     total_size += sizeof(uint32_t) +
@@ -98,13 +142,13 @@ inline std::array<uint32_t, 3> CalcExtent(const std::array<uint32_t, 3> &origina
   }
   return extent;
 }
-}
 
-namespace imgpp {
-bool LoadKTX(const char *src, size_t length, CompositeImg &composite_img,
-    std::unordered_map<std::string, std::string> &custom_data, bool bottom_first) {
-  if (bottom_first) {
-    std::cerr << "Bottom first not support yet!" << std::endl;
+// Parse the file header and key/value data. On success, data_offset is the offset of the first
+// level's image size field.
+bool ParseKTXHeader(const char *src, size_t length, KTXHeader &ktx_header, TextureDesc &desc,
+  std::array<uint32_t, 3> &original_extent,
+  std::unordered_map<std::string, std::string> &custom_data, size_t &data_offset) {
+  if (src == nullptr || length < sizeof(FOURCC_KTX10) + sizeof(KTXHeader)) {
     return false;
   }
   if (memcmp(src, FOURCC_KTX10, sizeof(FOURCC_KTX10)) != 0) {
@@ -112,7 +156,7 @@ bool LoadKTX(const char *src, size_t length, CompositeImg &composite_img,
     return false;
   }
   size_t offset = sizeof(FOURCC_KTX10);
-  KTXHeader const &ktx_header = *reinterpret_cast<KTXHeader const*>(src + offset);
+  std::memcpy(&ktx_header, src + offset, sizeof(ktx_header));
   offset += sizeof(ktx_header);
   auto texture_format = gl::TranslateFromGL(
     ktx_header.gl_internal_format,
@@ -124,20 +168,23 @@ bool LoadKTX(const char *src, size_t length, CompositeImg &composite_img,
     std::cerr << "Unknown texture format" << std::endl;
     return false;
   }
-  TextureDesc desc;
   desc.format = texture_format;
   desc.target = texture_target;
   desc.mipmap = ktx_header.number_of_mipmap_levels != 1;
-  std::array<uint32_t, 3> original_extent = {
+  original_extent = {
     std::max(ktx_header.pixel_width, 1u),
     std::max(ktx_header.pixel_height, 1u),
     std::max(ktx_header.pixel_depth, 1u)
   };
+  if (offset + ktx_header.bytes_of_key_value_data > length) {
+    return false;
+  }
   // Parse user-defined key-value data
   custom_data.clear();
   int64_t kv_left = ktx_header.bytes_of_key_value_data;
   while (kv_left > 0) {
-    uint32_t kv_size = *(uint32_t*)(src + offset);
+    uint32_t kv_size;
+    std::memcpy(&kv_size, src + offset, sizeof(uint32_t));
     offset += sizeof(uint32_t);
     uint32_t null_char_pos = 0;
     while (null_char_pos < kv_size && *(src + offset + null_char_pos) != 0) {
@@ -154,162 +201,146 @@ bool LoadKTX(const char *src, size_t length, CompositeImg &composite_img,
     offset += ((kv_size + 3) / 4) * 4;
     kv_left -= 4 + ((kv_size + 3) / 4) * 4;
   }
-  uint32_t img_data_size = length - ktx_header.bytes_of_key_value_data - sizeof(KTXHeader);
-  ImgBuffer img_buf(img_data_size);
-  std::memcpy(img_buf.GetBuffer(), src + offset, img_data_size);
-  if (IsCompressedFormat(texture_format)) {
+  data_offset = offset;
+  return true;
+}
+
+// Size composite_img and point its ROIs into buffer, which holds length bytes of image data.
+bool SetKTXData(CompositeImg &composite_img, const KTXHeader &ktx_header, const TextureDesc &desc,
+  const std::array<uint32_t, 3> &original_extent, uint8_t *buffer, size_t length) {
+  bool compressed = IsCompressedFormat(desc.format);
+  if (compressed) {
     composite_img.SetBCSize(desc, std::max(ktx_header.number_of_mipmap_levels, 1u),
       std::max(ktx_header.number_of_array_elements, 1u), std::max(ktx_header.number_of_faces, 1u),
       original_extent[0], original_extent[1], original_extent[2]);
-    int img_number = composite_img.Levels() * composite_img.Layers() * composite_img.Faces();
-    uint32_t offset = 0;
-    uint8_t *buffer = img_buf.GetBuffer();
-    for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
-      uint32_t img_size = *((uint32_t*)(buffer + offset));
-      offset += 4;
-      for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
-        for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
-          composite_img.SetData(buffer + offset, level, layer, face);
-          const BlockImgROI &block_roi = composite_img.BlockROI(level, layer, face);
-          offset += block_roi.SlicePitch() * block_roi.Depth();
-        }
-      }
-    }
   } else {
     composite_img.SetSize(desc, std::max(ktx_header.number_of_mipmap_levels, 1u),
       std::max(ktx_header.number_of_array_elements, 1u), std::max(ktx_header.number_of_faces, 1u),
       original_extent[0], original_extent[1], original_extent[2], KTX_ALIGNMENT);
-    if (composite_img.TexDesc().format == FORMAT_UNDEFINED) {
-      return false;
-    }
-    uint32_t offset = 0;
-    uint8_t *buffer = img_buf.GetBuffer();
-    for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
-      uint32_t img_size = *((uint32_t*)(buffer + offset));
-      offset += 4;
-      for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
-        for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
-          composite_img.SetData(buffer + offset, level, layer, face);
+  }
+  if (composite_img.TexDesc().format == FORMAT_UNDEFINED) {
+    return false;
+  }
+  size_t offset = 0;
+  for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
+    offset += 4;  // skip image size
+    for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
+      for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
+        composite_img.SetData(buffer + offset, level, layer, face);
+        if (compressed) {
+          const BlockImgROI &block_roi = composite_img.BlockROI(level, layer, face);
+          offset += block_roi.SlicePitch() * block_roi.Depth();
+        } else {
           const ImgROI &roi = composite_img.ROI(level, layer, face);
           offset += roi.SlicePitch() * roi.Depth();
         }
+        if (offset > length) {
+          std::cerr << "Truncated image data!" << std::endl;
+          return false;
+        }
       }
     }
   }
-  composite_img.AddBuffer(std::move(img_buf));
   return true;
 }
 
-bool LoadKTX(const char *fn, CompositeImg &composite_img,
-  std::unordered_map<std::string, std::string> &custom_data, bool bottom_first) {
-  if (bottom_first) {
-    std::cerr << "Bottom first not support yet!" << std::endl;
+// Turn every ROI into a bottom first view of the same rows. Block rows can't be flipped.
+bool FlipKTXData(CompositeImg &composite_img) {
+  if (composite_img.IsCompressed()) {
+    std::cerr << "Bottom first not supported for compressed formats!" << std::endl;
     return false;
   }
-  std::ifstream in(fn, std::ios::binary);
-  if(!in.good()) {
-    return false;
+  for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
+    for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
+      for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
+        ImgROI &roi = composite_img.ROI(level, layer, face);
+        roi = roi.FlipVertical();
+      }
+    }
   }
+  return true;
+}
+}
 
-  in.seekg(0, std::ios::end);
-  uint64_t total_size = in.tellg();
-  in.seekg(0);
-  std::vector<char> four_cc(sizeof(FOURCC_KTX10));
-  in.read((char*)four_cc.data(), four_cc.size());
-  if (memcmp(four_cc.data(), FOURCC_KTX10, four_cc.size()) != 0) {
-    std::cerr << "Unknown file format!" << std::endl;
+namespace imgpp {
+bool LoadKTX(const char *src, size_t length, CompositeImg &composite_img,
+    std::unordered_map<std::string, std::string> &custom_data, bool bottom_first) {
+  detail::CodecScope stats(Codec::KTX, false);
+  KTXHeader ktx_header;
+  TextureDesc desc;
+  std::array<uint32_t, 3> original_extent;
+  size_t offset = 0;
+  if (!ParseKTXHeader(src, length, ktx_header, desc, original_extent, custom_data, offset)) {
     return false;
   }
-  KTXHeader ktx_header;
-  in.read((char *)(&ktx_header), sizeof(KTXHeader));
-  auto texture_format = gl::TranslateFromGL(
-    ktx_header.gl_internal_format,
-    ktx_header.gl_format,
-    ktx_header.gl_base_internal_format,
-    ktx_header.gl_type);
-  auto texture_target = GetTarget(ktx_header);
-  if(texture_format == FORMAT_UNDEFINED) {
-    std::cerr << "Unknown texture format" << std::endl;
+  size_t img_data_size = length - offset;
+  ImgBuffer img_buf(img_data_size);
+  std::memcpy(img_buf.GetBuffer(), src + offset, img_data_size);
+  if (!SetKTXData(composite_img, ktx_header, desc, original_extent,
+    img_buf.GetBuffer(), img_data_size)) {
     return false;
   }
-  TextureDesc desc;
-  desc.format = texture_format;
-  desc.target = texture_target;
-  desc.mipmap = ktx_header.number_of_mipmap_levels != 1;
-  std::array<uint32_t, 3> original_extent = {
-    std::max(ktx_header.pixel_width, 1u),
-    std::max(ktx_header.pixel_height, 1u),
-    std::max(ktx_header.pixel_depth, 1u)
-  };
-  // Parse user-defined key-value data
-  custom_data.clear();
-  int64_t kv_left = ktx_header.bytes_of_key_value_data;
-  while (kv_left > 0) {
-    uint32_t kv_size = 0;
-    std::string kv_data;
-    in.read((char*)(&kv_size), sizeof(uint32_t));
-    kv_data.resize(kv_size);
-    in.read((char*)kv_data.data(), kv_size);
-    auto null_char_pos = std::find(kv_data.begin(), kv_data.end(), 0) - kv_data.begin();
+  if (bottom_first && !FlipKTXData(composite_img)) {
+    return false;
+  }
+  stats.AddBytes(offset + img_buf.GetLength());
+  composite_img.AddBuffer(std::move(img_buf));
+  return true;
+}
 
-    std::string key = kv_data.substr(0, null_char_pos);
-    std::string value = kv_data.substr(null_char_pos + 1);
-    custom_data.insert_or_assign(std::move(key), std::move(value));
-    // read padding
-    in.read((char*)kv_data.data(), 3 - (kv_size + 3) % 4);
-    kv_left -= 4 + ((kv_size + 3) / 4) * 4;
+bool LoadKTX(const ImgBuffer &buffer, CompositeImg &composite_img,
+    std::unordered_map<std::string, std::string> &custom_data, bool bottom_first) {
+  detail::CodecScope stats(Codec::KTX, false);
+  KTXHeader ktx_header;
+  TextureDesc desc;
+  std::array<uint32_t, 3> original_extent;
+  size_t offset = 0;
+  const char *src = (const char*)buffer.GetBuffer();
+  if (!ParseKTXHeader(src, buffer.GetLength(), ktx_header, desc, original_extent,
+    custom_data, offset)) {
+    return false;
   }
-  uint32_t img_data_size = total_size - ktx_header.bytes_of_key_value_data - sizeof(KTXHeader);
-  ImgBuffer img_buf(img_data_size);
-  in.read((char*)img_buf.GetBuffer(), img_data_size);
-  if (IsCompressedFormat(texture_format)) {
-    composite_img.SetBCSize(desc, std::max(ktx_header.number_of_mipmap_levels, 1u),
-      std::max(ktx_header.number_of_array_elements, 1u), std::max(ktx_header.number_of_faces, 1u),
-      original_extent[0], original_extent[1], original_extent[2]);
-    int img_number = composite_img.Levels() * composite_img.Layers() * composite_img.Faces();
-    uint32_t offset = 0;
-    uint8_t *buffer = img_buf.GetBuffer();
-    for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
-      uint32_t img_size = *((uint32_t*)(buffer + offset));
-      offset += 4;
-      for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
-        for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
-          composite_img.SetData(buffer + offset, level, layer, face);
-          const BlockImgROI &block_roi = composite_img.BlockROI(level, layer, face);
-          offset += block_roi.SlicePitch() * block_roi.Depth();
-        }
-      }
-    }
-  } else {
-    composite_img.SetSize(desc, std::max(ktx_header.number_of_mipmap_levels, 1u),
-      std::max(ktx_header.number_of_array_elements, 1u), std::max(ktx_header.number_of_faces, 1u),
-      original_extent[0], original_extent[1], original_extent[2], KTX_ALIGNMENT);
-    if (composite_img.TexDesc().format == FORMAT_UNDEFINED) {
-      return false;
-    }
-    uint32_t offset = 0;
-    uint8_t *buffer = img_buf.GetBuffer();
-    for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
-      uint32_t img_size = *((uint32_t*)(buffer + offset));
-      offset += 4;
-      for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
-        for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
-          composite_img.SetData(buffer + offset, level, layer, face);
-          const ImgROI &roi = composite_img.ROI(level, layer, face);
-          offset += roi.SlicePitch() * roi.Depth();
-        }
-      }
-    }
+  // image data off the kDefaultAlignment boundary of an allocated buffer gets copied out
+  if ((uintptr_t)(src + offset) % kDefaultAlignment != 0) {
+    return LoadKTX(src, (size_t)buffer.GetLength(), composite_img, custom_data, bottom_first);
+  }
+  // ROIs point straight into the source buffer, which the CompositeImg keeps alive
+  ImgBuffer img_buf = buffer.SubBuffer(offset, buffer.GetLength() - offset);
+  if (!SetKTXData(composite_img, ktx_header, desc, original_extent,
+    img_buf.GetBuffer(), (size_t)img_buf.GetLength())) {
+    return false;
   }
+  if (bottom_first && !FlipKTXData(composite_img)) {
+    return false;
+  }
+  stats.AddBytes(offset + img_buf.GetLength());
   composite_img.AddBuffer(std::move(img_buf));
   return true;
 }
 
+bool LoadKTX(const char *fn, CompositeImg &composite_img,
+  std::unordered_map<std::string, std::string> &custom_data, bool bottom_first) {
+  detail::CodecScope stats(Codec::KTX, false);
+  ImgBuffer buffer;
+  if (!MapFile(fn, buffer)) {
+    return false;
+  }
+  return LoadKTX(buffer, composite_img, custom_data, bottom_first);
+}
+
 bool WriteKTX(const char *fn, const CompositeImg &composite_img,
   const std::unordered_map<std::string, std::string> &custom_data, bool bottom_first) {
-  if (bottom_first) {
+  if (bottom_first && composite_img.IsCompressed()) {
+    std::cerr << "Bottom first not supported for compressed formats!" << std::endl;
     return false;
   }
+  for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
+    if (CalcImageSize(composite_img, composite_img.TexDesc().target, level) > UINT32_MAX) {
+      std::cerr << "Level " << level << " too large for a KTX imageSize!" << std::endl;
+      return false;
+    }
+  }
+  detail::CodecScope stats(Codec::KTX, true);
   std::ofstream out(fn, std::ios::binary);
   if (!out.good()) {
     return false;
@@ -318,9 +349,9 @@ bool WriteKTX(const char *fn, const CompositeImg &composite_img,
   if (desc.format == FORMAT_UNDEFINED) {
     return false;
   }
-  uint32_t total_size = ComputeKTXStorageSize(composite_img, custom_data);
-  std::vector<uint8_t> data(total_size, 0);
-  uint32_t offset = 0;
+  uint64_t total_size = ComputeKTXStorageSize(composite_img, custom_data);
+  std::vector<uint8_t> data((size_t)total_size, 0);
+  size_t offset = 0;
   std::memcpy(data.data(), FOURCC_KTX10, sizeof(FOURCC_KTX10));
   offset += sizeof(FOURCC_KTX10);
   gl::GLFormatDesc gl_desc = gl::TranslateToGL(desc.format);
@@ -366,75 +397,47 @@ bool WriteKTX(const char *fn, const CompositeImg &composite_img,
     header.bytes_of_key_value_data += sizeof(uint32_t) + 4 * ((kv_data_size + 3) / 4);
   }
 
-  if (composite_img.IsCompressed()) {
-    for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
-      uint32_t &img_size = *reinterpret_cast<uint32_t*>(data.data() + offset);
-      img_size = 0;
-      offset += sizeof(uint32_t);
-      uint32_t face_size = CalcFaceSize(composite_img, level);
-      if (desc.target == TARGET_CUBE) {
-        img_size = face_size;
-      } else {
-        img_size = composite_img.Layers() * composite_img.Faces() * face_size;
-      }
-      for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
-        for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
-          std::memcpy(data.data() + offset, composite_img.BlockROI(level, layer, face).GetData(), face_size);
-          offset += face_size;
-        }
-      }
+  uint32_t faces_per_level = composite_img.Layers() * composite_img.Faces();
+  bool packed = composite_img.IsCompressed() || composite_img.Alignment() % KTX_ALIGNMENT == 0;
+  for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
+    uint32_t &img_size = *reinterpret_cast<uint32_t*>(data.data() + offset);
+    offset += sizeof(uint32_t);
+    uint64_t face_size = CalcFaceSize(composite_img, level);
+    img_size = (uint32_t)CalcImageSize(composite_img, desc.target, level);
+    if (packed && !bottom_first && IsLevelContiguous(composite_img, level, face_size)) {
+      // e.g. a CompositeImg::Allocate() arena: the whole level in one copy
+      std::memcpy(data.data() + offset, FaceData(composite_img, level, 0, 0),
+        (size_t)(faces_per_level * face_size));
+      offset += faces_per_level * face_size;
+      continue;
     }
-  } else {
-    if (composite_img.Alignment() % KTX_ALIGNMENT == 0) {
-      for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
-        uint32_t &img_size = *reinterpret_cast<uint32_t*>(data.data() + offset);
-        img_size = 0;
-        offset += sizeof(uint32_t);
-        uint32_t face_size = CalcFaceSize(composite_img, level);
-        if (desc.target == TARGET_CUBE) {
-          img_size = face_size;
+    for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
+      for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
+        const uint8_t *face_data = FaceData(composite_img, level, layer, face);
+        if (packed && !bottom_first
+          && (composite_img.IsCompressed() || composite_img.ROI(level, layer, face).Pitch() > 0)) {
+          std::memcpy(data.data() + offset, face_data, face_size);
         } else {
-          img_size = composite_img.Layers() * composite_img.Faces() * face_size;
-        }
-        for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
-          for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
-            std::memcpy(data.data() + offset, composite_img.ROI(level, layer, face).GetData(), face_size);
-            offset += face_size;
-          }
-        }
-      }
-    } else {
-      for (uint32_t level = 0; level < composite_img.Levels(); ++level) {
-        uint32_t &img_size = *reinterpret_cast<uint32_t*>(data.data() + offset);
-        img_size = 0;
-        offset += sizeof(uint32_t);
-        uint32_t face_size = CalcFaceSize(composite_img, level);
-        uint32_t new_pitch = 4 * ((composite_img.ROI(level, 0, 0).Pitch() + 3) / 4);
-        if (desc.target == TARGET_CUBE) {
-          img_size = face_size;
-        } else {
-          img_size = composite_img.Layers() * composite_img.Faces() * face_size;
-        }
-        uint32_t depth = composite_img.ROI(0, 0, 0).Depth();
-        uint32_t height = composite_img.ROI(0, 0, 0).Height();
-        for (uint32_t layer = 0; layer < composite_img.Layers(); ++layer) {
-          for (uint32_t face = 0; face < composite_img.Faces(); ++face) {
-            uint32_t face_offset = 0;
-            const ImgROI &roi = composite_img.ROI(level, layer, face);
-            for (uint32_t z = 0; z < depth; ++z) {
-              for (uint32_t y = 0; y < height; ++y) {
-                std::memcpy(data.data() + offset + face_offset, roi.PtrAt(0, y, z, 0), roi.Pitch());
-                face_offset += new_pitch;
-              }
+          // repack rows to the 4-byte KTX row alignment, in file row order
+          const ImgROI &roi = bottom_first ? composite_img.ROI(level, layer, face).FlipVertical()
+            : composite_img.ROI(level, layer, face);
+          uint64_t row_length = std::abs(roi.Pitch());
+          uint64_t new_pitch = 4 * ((row_length + 3) / 4);
+          uint64_t face_offset = 0;
+          for (uint32_t z = 0; z < roi.Depth(); ++z) {
+            for (uint32_t y = 0; y < roi.Height(); ++y) {
+              std::memcpy(data.data() + offset + face_offset, roi.PtrAt(0, y, z, 0), row_length);
+              face_offset += new_pitch;
             }
           }
-          offset += face_size;
         }
+        offset += face_size;
       }
     }
   }
 
   out.write((char*)data.data(), data.size());
+  stats.AddBytes(data.size());
   return out.good();
 }
 }
@@ -2,7 +2,10 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <cstdio>
+#include <cstring>
 #include <imgpp/imgpp.hpp>
+#include <imgpp/compare.hpp>
 #include <imgpp/loaders.hpp>
 #include <imgpp/loadersext.hpp>
 #include <imgpp/compositeimg.hpp>
@@ -76,6 +79,89 @@ bool CheckASTC(const imgpp::CompositeImg &img, const std::unordered_map<std::str
   return true;
 }
 
+// every value of every level, layer and face of a and b equal
+bool SameImages(const imgpp::CompositeImg &a, const imgpp::CompositeImg &b) {
+  if (a.Levels() != b.Levels() || a.Layers() != b.Layers() || a.Faces() != b.Faces()) {
+    return false;
+  }
+  imgpp::CompareOptions exact;
+  exact.max_abs_diff_limit = 0.0;
+  for (uint32_t level = 0; level < a.Levels(); ++level) {
+    for (uint32_t layer = 0; layer < a.Layers(); ++layer) {
+      for (uint32_t face = 0; face < a.Faces(); ++face) {
+        imgpp::CompareResult diff;
+        if (!imgpp::Compare(a.ROI(level, layer, face), b.ROI(level, layer, face), diff, exact)
+          || diff.max_abs_diff != 0.0) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// cube array sized and allocated as a single arena, written to and read back from KTX
+bool TestArena() {
+  TextureDesc desc;
+  desc.format = FORMAT_RGBA8_UNORM_PACK8;
+  desc.target = TARGET_CUBE_ARRAY;
+  desc.mipmap = true;
+  imgpp::CompositeImg img;
+  img.SetSize(desc, 3, 2, 6, 16, 16, 1, 4);
+  if (img.ROI(2, 1, 5).Width() != 4 || img.ROI(2, 1, 5).Pitch() != 16 || img.ROI(2, 1, 5).GetData()) {
+    std::cerr << "ROIs not shaped by SetSize!" << std::endl;
+    return false;
+  }
+  if (!img.Allocate(4) || img.Buffers().size() != 1) {
+    std::cerr << "Failed to allocate arena!" << std::endl;
+    return false;
+  }
+  const uint8_t *arena = img.Buffers()[0].GetBuffer();
+  for (uint32_t level = 0; level < 3; ++level) {
+    for (uint32_t layer = 0; layer < 2; ++layer) {
+      for (uint32_t face = 0; face < 6; ++face) {
+        auto &roi = img.ROI(level, layer, face);
+        if (roi.GetData() != arena + img.Offset(level, layer, face)) {
+          std::cerr << "ROI not pointing into arena!" << std::endl;
+          return false;
+        }
+        memset(roi.GetData(), (int)(level * 16 + layer * 6 + face), img.FaceSize(level));
+      }
+    }
+  }
+  if (img.Buffers()[0].GetLength() != 12 * (16 * 16 + 8 * 8 + 4 * 4) * 4) {
+    std::cerr << "Arena size error!" << std::endl;
+    return false;
+  }
+
+  std::unordered_map<std::string, std::string> kv_data;
+  imgpp::CompositeImg loaded;
+  if (!WriteKTX("arena.ktx", img, kv_data, false) || !LoadKTX("arena.ktx", loaded, kv_data, false)) {
+    std::cerr << "Failed to write/load arena ktx!" << std::endl;
+    return false;
+  }
+  if (loaded.Levels() != 3 || loaded.Layers() != 2 || loaded.Faces() != 6) {
+    std::cerr << "Arena ktx dimensions error!" << std::endl;
+    return false;
+  }
+  if (!SameImages(img, loaded)) {
+    std::cerr << "Arena ktx data error!" << std::endl;
+    return false;
+  }
+
+  // 1100 layers of 4 MiB don't fit in the 32-bit imageSize of their level, shapes alone decide that
+  desc.target = TARGET_2D_ARRAY;
+  desc.mipmap = false;
+  imgpp::CompositeImg huge;
+  huge.SetSize(desc, 1, 1100, 1, 1024, 1024, 1, 4);
+  std::remove("huge.ktx");
+  if (WriteKTX("huge.ktx", huge, kv_data, false) || std::ifstream("huge.ktx").good()) {
+    std::cerr << "Oversized ktx level written!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
 std::vector<char> LoadKTXData(const char *fn) {
   std::ifstream in(fn, std::ios::binary);
   in.seekg(0, std::ios::end);
@@ -87,6 +173,43 @@ std::vector<char> LoadKTXData(const char *fn) {
   return data;
 }
 
+// bottom first loads are flipped views of the file rows, and writing them back flips again
+bool TestBottomFirst() {
+  imgpp::CompositeImg img;
+  std::unordered_map<std::string, std::string> kv_data;
+  if (!LoadKTX(kRGBFn, img, kv_data, true)) {
+    std::cerr << "Failed to load bottom first ktx!" << std::endl;
+    return false;
+  }
+  const auto &roi0 = img.ROI(0, 0, 0);
+  if (roi0.Pitch() >= 0 || roi0.Height() != 240) {
+    std::cerr << "Bottom first ROI is not flipped!" << std::endl;
+    return false;
+  }
+  if (roi0.At<uint8_t>(262, 239 - 43) != 255 || roi0.At<uint8_t>(915, 239 - 91) != 0) {
+    std::cerr << "Bottom first img data error!" << std::endl;
+    return false;
+  }
+  const char *fn = "test_bottom_first.ktx";
+  if (!WriteKTX(fn, img, kv_data, true)) {
+    std::cerr << "Failed to write bottom first ktx!" << std::endl;
+    return false;
+  }
+  imgpp::CompositeImg reloaded;
+  imgpp::CompositeImg original;
+  if (!LoadKTX(fn, reloaded, kv_data, false) || !CheckRGB(reloaded, kv_data)
+    || !LoadKTX(kRGBFn, original, kv_data, false) || !SameImages(original, reloaded)) {
+    std::cerr << "Bottom first round trip error!" << std::endl;
+    return false;
+  }
+  imgpp::CompositeImg astc_img;
+  if (LoadKTX(kASTC8x8Fn, astc_img, kv_data, true)) {
+    std::cerr << "Compressed formats can't be loaded bottom first!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
 int main() {
   imgpp::CompositeImg img;
   std::unordered_map<std::string, std::string> kv_data;
@@ -95,6 +218,15 @@ int main() {
     std::cerr << "Failed to load ktx from memory!" << std::endl;
     return 1;
   }
+  // a buffer holding the image data off the allocation alignment gets copied, not shared
+  imgpp::ImgBuffer unaligned(rgb_data.size() + 1);
+  memcpy(unaligned.GetBuffer() + 1, rgb_data.data(), rgb_data.size());
+  imgpp::CompositeImg copied;
+  if (!LoadKTX(unaligned.SubBuffer(1, rgb_data.size()), copied, kv_data, false) || !CheckRGB(copied, kv_data)
+    || (uintptr_t)copied.ROI(0, 0, 0).GetData() % 4 != 0) {
+    std::cerr << "Failed to load ktx from an unaligned buffer!" << std::endl;
+    return 1;
+  }
   if (!WriteKTX(kRGBFn, img, kv_data, false)) {
     std::cerr << "Failed to write ktx!" << std::endl;
     return 1;
@@ -107,6 +239,14 @@ int main() {
     return 1;
   }
 
+  if (!TestArena()) {
+    return 1;
+  }
+
+  if (!TestBottomFirst()) {
+    return 1;
+  }
+
   kv_data.clear();
   imgpp::CompositeImg astc_img;
   if (!LoadKTX(kASTC8x8Fn, astc_img, kv_data, false)) {
@@ -132,6 +132,39 @@ bool TestImg(bool bottom_first) {
   return true;
 }
 
+// loads from a buffer share it only where the pixels land on the allocation alignment
+bool TestBSONBuffer() {
+  imgpp::Img src_img;
+  if (!imgpp::LoadPPM((std::string(input_fn) + ".ppm").c_str(), src_img, false)) {
+    std::cerr << "Faied to load ppm" << std::endl;
+    return false;
+  }
+  std::string bson;
+  if (!imgpp::WriteBSON(src_img, bson)) {
+    std::cerr << "Faied to write bson" << std::endl;
+    return false;
+  }
+  size_t data_offset = bson.size() - 1 - (size_t)src_img.CData().GetLength();
+  size_t shared_offset = (imgpp::kDefaultAlignment - data_offset % imgpp::kDefaultAlignment)
+    % imgpp::kDefaultAlignment;
+  imgpp::ImgBuffer buffer(bson.size() + imgpp::kDefaultAlignment);
+  for (size_t offset: {shared_offset, shared_offset + 1, shared_offset + 4}) {
+    memcpy(buffer.GetBuffer() + offset, bson.data(), bson.size());
+    imgpp::Img img;
+    if (!imgpp::LoadBSON(buffer.SubBuffer(offset, bson.size()), img) || !CheckImg(img.ROI(), false)) {
+      std::cerr << "Faied to load bson at offset " << offset << std::endl;
+      return false;
+    }
+    const uint8_t *data = img.ROI().GetData();
+    if ((uintptr_t)data % imgpp::kDefaultAlignment != 0
+      || (data == buffer.GetBuffer() + offset + data_offset) != (offset == shared_offset)) {
+      std::cerr << "Wrong bson buffer sharing at offset " << offset << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 int main() {
   // test both bottom_first and top_first reading and writing
   if (!TestImg(false)) {
@@ -140,5 +173,8 @@ int main() {
   if (!TestImg(true)) {
     return 1;
   }
+  if (!TestBSONBuffer()) {
+    return 1;
+  }
   return 0;
 }
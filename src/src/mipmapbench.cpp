@@ -0,0 +1,73 @@
+#include <imgpp/mipmap.hpp>
+#include <imgpp/typedview.hpp>
+#include "benchutil.h"
+#include <string>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 5, kWidth = 3840, kHeight = 2160 };
+
+CompositeImg MakeChain(TextureFormat format, const Img &src) {
+  TextureDesc desc;
+  desc.format = format;
+  desc.target = TARGET_2D;
+  CompositeImg img;
+  img.SetSize(desc, MipmapLevels(kWidth, kHeight), 1, 1, kWidth, kHeight, 1, 4);
+  img.Allocate();
+  CopyData(img.ROI(0, 0, 0), src.CROI());
+  return img;
+}
+
+// per pixel 2x2 average of each level, the loop GenerateMipmaps replaces
+void BenchNaive(CompositeImg &img) {
+  double ms = bench::MedianMs(kReps, [&]() {
+    for (uint32_t level = 1; level < img.Levels(); level++) {
+      TypedView<const uint8_t, 4> in(img.ROI(level - 1, 0, 0));
+      TypedView<uint8_t, 4> out(img.ROI(level, 0, 0));
+      for (uint32_t y = 0; y < out.Height(); y++) {
+        for (uint32_t x = 0; x < out.Width(); x++) {
+          uint32_t x1 = std::min(2 * x + 1, in.Width() - 1);
+          uint32_t y1 = std::min(2 * y + 1, in.Height() - 1);
+          for (uint32_t c = 0; c < 4; c++) {
+            out.PixelAt(x, y)[c] = (uint8_t)((in.PixelAt(2 * x, 2 * y)[c] + in.PixelAt(x1, 2 * y)[c]
+              + in.PixelAt(2 * x, y1)[c] + in.PixelAt(x1, y1)[c] + 2) / 4);
+          }
+        }
+      }
+    }
+    bench::DoNotOptimize(img.ROI(1, 0, 0).GetData());
+  });
+  bench::Report("RGBA8 4K mip chain", "2x2 average loop", ms);
+}
+
+void BenchGenerate(CompositeImg &img, ResizeFilter filter, const char *name) {
+  ThreadPool single(1);
+  for (int parallel = 0; parallel < 2; parallel++) {
+    Executor &executor = parallel ? (Executor&)DefaultThreadPool() : single;
+    double ms = bench::MedianMs(kReps, [&]() {
+      GenerateMipmaps(img, filter, executor);
+      bench::DoNotOptimize(img.ROI(1, 0, 0).GetData());
+    });
+    std::string variant = std::string(name) + (parallel ? ", pool" : ", 1 thread");
+    bench::Report("RGBA8 4K mip chain", variant.c_str(), ms);
+  }
+}
+
+}
+
+int main() {
+  Img src(kWidth, kHeight, 4, 8);
+  for (size_t i = 0; i < src.CData().GetLength(); i++) {
+    src.ROI().GetData()[i] = (uint8_t)(i * 7919 >> 6);
+  }
+  CompositeImg unorm = MakeChain(FORMAT_RGBA8_UNORM_PACK8, src);
+  CompositeImg srgb = MakeChain(FORMAT_RGBA8_SRGB_PACK8, src);
+  BenchNaive(unorm);
+  BenchGenerate(unorm, ResizeFilter::BOX, "box");
+  BenchGenerate(srgb, ResizeFilter::BOX, "box sRGB");
+  BenchGenerate(unorm, ResizeFilter::KAISER, "kaiser");
+  BenchGenerate(srgb, ResizeFilter::KAISER, "kaiser sRGB");
+  return 0;
+}
@@ -0,0 +1,178 @@
+#include <imgpp/mipmap.hpp>
+#include <imgpp/loaders.hpp>
+#include <imgpp/srgb.hpp>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+using namespace imgpp;
+
+static TextureDesc Desc(TextureFormat format, TextureTarget target) {
+  TextureDesc desc;
+  desc.format = format;
+  desc.target = target;
+  return desc;
+}
+
+static bool SameLevels(const CompositeImg &a, const CompositeImg &b) {
+  for (uint32_t level = 0; level < a.Levels(); level++) {
+    for (uint32_t layer = 0; layer < a.Layers(); layer++) {
+      for (uint32_t face = 0; face < a.Faces(); face++) {
+        const ImgROI &ra = a.ROI(level, layer, face);
+        const ImgROI &rb = b.ROI(level, layer, face);
+        for (uint32_t z = 0; z < ra.Depth(); z++) {
+          for (uint32_t y = 0; y < ra.Height(); y++) {
+            if (memcmp(ra.PtrAt(0, y, z, 0), rb.PtrAt(0, y, z, 0), (size_t)ra.Width() * ra.Channel() * ra.BPC() / 8)) {
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  if (MipmapLevels(1, 1) != 1 || MipmapLevels(256, 256) != 9 || MipmapLevels(37, 20) != 6
+    || MipmapLevels(4, 4, 16) != 5) {
+    std::cerr << "MipmapLevels error" << std::endl;
+    return 1;
+  }
+
+  // constant images stay constant down to 1x1 for odd sizes, every format and filter
+  for (TextureFormat format: {FORMAT_RGBA8_UNORM_PACK8, FORMAT_RGB8_SRGB_PACK8, FORMAT_R16_UNORM_PACK16,
+    FORMAT_RG16_SFLOAT_PACK16, FORMAT_RGBA32_SFLOAT_PACK32}) {
+    const auto &pixel_desc = GetPixelDesc(format);
+    uint32_t c = std::get<0>(pixel_desc);
+    uint32_t bpc = std::get<1>(pixel_desc);
+    bool is_float = std::get<4>(pixel_desc);
+    Img src(37, 20, c, bpc, is_float, is_float);
+    ZipTransformPixel(std::make_tuple(src.ROI()), [&](uint32_t, uint32_t, uint32_t, auto &ptrs) {
+      for (uint32_t i = 0; i < c; i++) {
+        if (is_float) {
+          bpc == 16 ? (void)(((Half*)ptrs[0])[i] = Half(0.75f)) : (void)(((float*)ptrs[0])[i] = 0.75f);
+        } else {
+          bpc == 16 ? (void)(((uint16_t*)ptrs[0])[i] = 777) : (void)(ptrs[0][i] = 99);
+        }
+      }
+    });
+    for (ResizeFilter filter: {ResizeFilter::BOX, ResizeFilter::KAISER}) {
+      CompositeImg mips;
+      if (!MakeMipmaps(mips, src.CROI(), Desc(format, TARGET_2D), filter) || mips.Levels() != 6
+        || !mips.TexDesc().mipmap) {
+        std::cerr << "MakeMipmaps failed on format " << format << std::endl;
+        return 1;
+      }
+      for (uint32_t level = 0; level < 6; level++) {
+        const ImgROI &roi = mips.ROI(level, 0, 0);
+        if (roi.Width() != std::max(37u >> level, 1u) || roi.Height() != std::max(20u >> level, 1u)
+          || roi.Pitch() % 4 != 0 || roi.Pitch() % std::get<2>(pixel_desc) != 0
+          || memcmp(roi.PtrAt(roi.Width() - 1, roi.Height() - 1, 0, 0), src.CROI().PtrAt(0, 0, 0, 0),
+          c * bpc / 8) != 0) {
+          std::cerr << "Constant mipmap error at level " << level << " of format " << format << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+
+  // box filter: 2x2 averages, exact coverage for odd sizes
+  Img ramp(5, 2, 1, 8);
+  for (uint32_t x = 0; x < 5; x++) {
+    ramp.ROI().At<uint8_t>(x, 0) = (uint8_t)(x * 50);
+    ramp.ROI().At<uint8_t>(x, 1) = (uint8_t)(x * 50 + 2);
+  }
+  CompositeImg ramp_mips;
+  MakeMipmaps(ramp_mips, ramp.CROI(), Desc(FORMAT_R8_UNORM_PACK8, TARGET_2D));
+  // (0 * 0.4 + 50 * 0.4 + 100 * 0.2) + 1 and (100 * 0.2 + 150 * 0.4 + 200 * 0.4) + 1
+  if (ramp_mips.Levels() != 3 || ramp_mips.ROI(1, 0, 0).At<uint8_t>(0, 0) != 41
+    || ramp_mips.ROI(1, 0, 0).At<uint8_t>(1, 0) != 161) {
+    std::cerr << "Odd size box filter error" << std::endl;
+    return 1;
+  }
+
+  // sRGB formats average in linear space, alpha as it is
+  for (TextureFormat format: {FORMAT_RGBA8_UNORM_PACK8, FORMAT_RGBA8_SRGB_PACK8}) {
+    Img checker(8, 8, 4, 8);
+    ZipTransformPixel(std::make_tuple(checker.ROI()), [](uint32_t x, uint32_t y, uint32_t, auto &ptrs) {
+      uint8_t v = (x + y) % 2 ? 255 : 0;
+      ptrs[0][0] = ptrs[0][1] = ptrs[0][2] = ptrs[0][3] = v;
+    });
+    CompositeImg mips;
+    MakeMipmaps(mips, checker.CROI(), Desc(format, TARGET_2D));
+    const ImgROI &level1 = mips.ROI(1, 0, 0);
+    uint8_t color = format == FORMAT_RGBA8_SRGB_PACK8 ? 188 : 128;
+    if (level1.At<uint8_t>(3, 2, 0) != color || level1.At<uint8_t>(3, 2, 3) != 128
+      || mips.ROI(3, 0, 0).At<uint8_t>(0, 0, 2) != color) {
+      std::cerr << "sRGB mipmap error" << std::endl;
+      return 1;
+    }
+  }
+
+  // 3D textures average across slices too
+  Img volume(4, 4, 4, 4, 8, false, false, 1);
+  ZipTransformPixel(std::make_tuple(volume.ROI()), [](uint32_t, uint32_t, uint32_t z, auto &ptrs) {
+    ptrs[0][0] = ptrs[0][1] = ptrs[0][2] = ptrs[0][3] = (uint8_t)(z * 40);
+  });
+  CompositeImg volume_mips;
+  if (!MakeMipmaps(volume_mips, volume.CROI(), Desc(FORMAT_RGBA8_UNORM_PACK8, TARGET_3D))
+    || volume_mips.Levels() != 3 || volume_mips.ROI(1, 0, 0).Depth() != 2
+    || volume_mips.ROI(1, 0, 0).At<uint8_t>(1, 1, 0, 0) != 20 || volume_mips.ROI(1, 0, 0).At<uint8_t>(0, 0, 1, 0) != 100
+    || volume_mips.ROI(2, 0, 0).At<uint8_t>(0, 0, 0, 3) != 60) {
+    std::cerr << "3D mipmap error" << std::endl;
+    return 1;
+  }
+  if (MakeMipmaps(volume_mips, volume.CROI(), Desc(FORMAT_RGBA8_UNORM_PACK8, TARGET_2D))) {
+    std::cerr << "A 2D texture can't take several slices" << std::endl;
+    return 1;
+  }
+
+  // cube arrays: every face filtered, banded across faces the same as on one thread
+  CompositeImg cubes[2];
+  ThreadPool single(1);
+  ThreadPool pool(4);
+  for (uint32_t i = 0; i < 2; i++) {
+    cubes[i].SetSize(Desc(FORMAT_RGBA8_SRGB_PACK8, TARGET_CUBE_ARRAY), 8, 2, 6, 128, 128, 1, 4);
+    cubes[i].Allocate(4);
+    for (uint32_t face = 0; face < 12; face++) {
+      ZipTransformPixel(std::make_tuple(cubes[i].ROI(0, face / 6, face % 6)),
+        [face](uint32_t x, uint32_t y, uint32_t, auto &ptrs) {
+          ptrs[0][0] = (uint8_t)(face * 20);
+          ptrs[0][1] = (uint8_t)(x * y);
+          ptrs[0][2] = (uint8_t)(x ^ y);
+          ptrs[0][3] = 255;
+        });
+    }
+    if (!GenerateMipmaps(cubes[i], ResizeFilter::KAISER, i ? (Executor&)pool : (Executor&)single)) {
+      std::cerr << "GenerateMipmaps failed on a cube array" << std::endl;
+      return 1;
+    }
+  }
+  if (!SameLevels(cubes[0], cubes[1]) || cubes[0].ROI(7, 1, 5).At<uint8_t>(0, 0, 0) != 220) {
+    std::cerr << "Cube array mipmap error" << std::endl;
+    return 1;
+  }
+
+  // the result goes straight to KTX
+  std::unordered_map<std::string, std::string> kv_data;
+  CompositeImg loaded;
+  if (!WriteKTX("mipmaps.ktx", cubes[1], kv_data, false) || !LoadKTX("mipmaps.ktx", loaded, kv_data, false)
+    || loaded.Levels() != 8 || loaded.Layers() != 2 || loaded.Faces() != 6 || !SameLevels(loaded, cubes[1])) {
+    std::cerr << "Mipmap KTX round trip error" << std::endl;
+    return 1;
+  }
+
+  // compressed formats and levels without data
+  CompositeImg bad;
+  bad.SetBCSize(Desc(FORMAT_RGBA_DXT5_UNORM_BLOCK16, TARGET_2D), 3, 1, 1, 16, 16, 1);
+  CompositeImg unallocated;
+  unallocated.SetSize(Desc(FORMAT_RGBA8_UNORM_PACK8, TARGET_2D), 3, 1, 1, 16, 16, 1, 4);
+  if (GenerateMipmaps(bad) || GenerateMipmaps(unallocated)) {
+    std::cerr << "GenerateMipmaps accepted an unsupported image" << std::endl;
+    return 1;
+  }
+
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include <imgpp/algorithms.hpp>
+#include <imgpp/threadpool.hpp>
+#include "benchutil.h"
+#include <cstring>
+#include <string>
+#include <tuple>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 5 };
+
+// premultiply RGB by alpha, per pixel
+void BenchScaling(const char *name, uint32_t w, uint32_t h) {
+  Img src(w, h, 4, 8), dst(w, h, 4, 8);
+  memset(src.ROI().GetData(), 180, src.CData().GetLength());
+  double bytes = (double)src.CData().GetLength() * 2;
+  auto premultiply = [](uint32_t, uint32_t, uint32_t, auto &ptrs) {
+    const uint8_t *s = ptrs[1];
+    uint8_t *d = ptrs[0];
+    for (uint32_t c = 0; c < 3; c++) {
+      d[c] = (uint8_t)((s[c] * s[3] + 127) / 255);
+    }
+    d[3] = s[3];
+  };
+
+  double ms_serial = bench::MedianMs(kReps, [&]() {
+    ZipTransformPixel(std::make_tuple(dst.ROI(), src.CROI()), premultiply);
+    bench::DoNotOptimize(dst.CROI().GetData());
+  });
+  bench::Report(name, "ZipTransformPixel", ms_serial, bytes);
+
+  for (uint32_t threads: {1u, 2u, 4u, 8u, 16u, 32u}) {
+    ThreadPool pool(threads);
+    double ms = bench::MedianMs(kReps, [&]() {
+      ParallelZipTransformPixel(std::make_tuple(dst.ROI(), src.CROI()), premultiply, pool);
+      bench::DoNotOptimize(dst.CROI().GetData());
+    });
+    std::string variant = "parallel, " + std::to_string(threads) + " threads";
+    bench::Report(name, variant.c_str(), ms, bytes);
+  }
+}
+
+}
+
+int main() {
+  BenchScaling("premultiply 4K RGBA8", 3840, 2160);
+  BenchScaling("premultiply 8K RGBA8", 7680, 4320);
+  return 0;
+}
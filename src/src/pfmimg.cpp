@@ -2,6 +2,7 @@
 #include <fstream>
 #include <string>
 #include <imgpp/imgpp.hpp>
+#include <imgpp/stats.hpp>
 #include "stringparser.h"
 
 namespace {
@@ -111,6 +112,7 @@ bool LoadPFM(const char *fn, Img &img, bool bottom_first) {
   if (nullptr == fn || 0 == strlen(fn)) {
     return false;
   }
+  detail::CodecScope stats(Codec::PFM, false);
 
   std::ifstream infile;
   infile.open(fn, std::ios::binary);
@@ -143,6 +145,7 @@ bool LoadPFM(const char *fn, Img &img, bool bottom_first) {
     }
   }
 
+  stats.AddBytes(infile.tellg());
   return infile.good();
 }
 
@@ -150,6 +153,7 @@ bool LoadPFM(const char *buffer, uint32_t length, Img &img, bool bottom_first) {
   if (buffer == nullptr || length == 0) {
     return false;
   }
+  detail::CodecScope stats(Codec::PFM, false);
 
   int32_t width = 0, height = 0;
   int channels = 0;
@@ -180,6 +184,7 @@ bool LoadPFM(const char *buffer, uint32_t length, Img &img, bool bottom_first) {
     }
   }
 
+  stats.AddBytes(p - buffer);
   return p <= buffer + length;
 }
 
@@ -187,6 +192,7 @@ bool WritePFM(const char *fn, const ImgROI &roi, bool bottom_first) {
   if (nullptr == fn || 0 == strlen(fn)) {
     return false;
   }
+  detail::CodecScope stats(Codec::PFM, true);
 
   std::ofstream outfile;
   outfile.open(fn, std::ios::binary);
@@ -219,6 +225,7 @@ bool WritePFM(const char *fn, const ImgROI &roi, bool bottom_first) {
     }
   }
 
+  stats.AddBytes(outfile.tellp());
   outfile.close();
   return outfile.good();
 }
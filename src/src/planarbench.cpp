@@ -0,0 +1,74 @@
+#include <imgpp/planar.hpp>
+#include "benchutil.h"
+#include <cstring>
+#include <string>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 15, kWidth = 3840, kHeight = 2160 };
+
+// baseline: per-pixel At<> loops
+template<typename T>
+void NaiveDeinterleave(PlanarROI &dst, const ImgROI &src) {
+  for (uint32_t y = 0; y < src.Height(); ++y) {
+    for (uint32_t x = 0; x < src.Width(); ++x) {
+      for (uint32_t c = 0; c < src.Channel(); ++c) {
+        dst.At<T>(x, y, c) = src.At<T>(x, y, c);
+      }
+    }
+  }
+}
+
+template<typename T>
+void NaiveInterleave(ImgROI &dst, const PlanarROI &src) {
+  for (uint32_t y = 0; y < src.Height(); ++y) {
+    for (uint32_t x = 0; x < src.Width(); ++x) {
+      for (uint32_t c = 0; c < src.Channel(); ++c) {
+        dst.At<T>(x, y, c) = src.At<T>(x, y, 0, c);
+      }
+    }
+  }
+}
+
+template<typename T>
+void Bench(const char *name, uint32_t c, bool is_float) {
+  Img hwc(kWidth, kHeight, c, sizeof(T) * 8, is_float);
+  memset(hwc.ROI().GetData(), 1, hwc.CData().GetLength());
+  PlanarImg chw;
+  chw.SetSizeLike(hwc.CROI());
+  double bytes = (double)hwc.CData().GetLength() * 2;
+
+  double ms_naive = bench::MedianMs(kReps, [&]() {
+    NaiveDeinterleave<T>(chw.ROI(), hwc.CROI());
+    bench::DoNotOptimize(chw.CROI().GetData());
+  });
+  double ms_simd = bench::MedianMs(kReps, [&]() {
+    Deinterleave(chw.ROI(), hwc.CROI());
+    bench::DoNotOptimize(chw.CROI().GetData());
+  });
+  std::string hwc_name = std::string(name) + " HWC->CHW";
+  bench::Report(hwc_name.c_str(), "At<> loop", ms_naive, bytes);
+  bench::Report(hwc_name.c_str(), "Deinterleave", ms_simd, bytes);
+
+  ms_naive = bench::MedianMs(kReps, [&]() {
+    NaiveInterleave<T>(hwc.ROI(), chw.CROI());
+    bench::DoNotOptimize(hwc.CROI().GetData());
+  });
+  ms_simd = bench::MedianMs(kReps, [&]() {
+    Interleave(hwc.ROI(), chw.CROI());
+    bench::DoNotOptimize(hwc.CROI().GetData());
+  });
+  std::string chw_name = std::string(name) + " CHW->HWC";
+  bench::Report(chw_name.c_str(), "At<> loop", ms_naive, bytes);
+  bench::Report(chw_name.c_str(), "Interleave", ms_simd, bytes);
+}
+
+}
+
+int main() {
+  Bench<uint8_t>("4K RGB8", 3, false);
+  Bench<float>("4K RGBA32F", 4, true);
+  return 0;
+}
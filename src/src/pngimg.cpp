@@ -1,6 +1,7 @@
 #include <imgpp/loaders.hpp>
 #include <png.h>
 #include <imgpp/imgpp.hpp>
+#include <imgpp/stats.hpp>
 
 namespace imgpp {
 
@@ -13,6 +14,7 @@ namespace imgpp {
     if (nullptr == fn || 0 == strlen(fn)) {
       return false;
     }
+    detail::CodecScope stats(Codec::PNG, false);
 
     png_structp png_ptr;
     png_infop info_ptr;
@@ -109,6 +111,7 @@ namespace imgpp {
 
     png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
 
+    stats.AddBytes(ftell(fp));
     fclose(fp);
     delete []row_pointers;
     return true;
@@ -117,6 +120,7 @@ namespace imgpp {
   bool WritePNG(const char *fn, const ImgROI &roi, bool bottom_first) {
     if (nullptr == fn || 0 == strlen(fn))
       return false;
+    detail::CodecScope stats(Codec::PNG, true);
 
     /* create file */
     FILE *fp = fopen(fn, "wb");
@@ -205,6 +209,7 @@ namespace imgpp {
     /* cleanup heap allocation */
     delete []row_pointers;
 
+    stats.AddBytes(ftell(fp));
     fclose(fp);
     return true;
   }
@@ -241,6 +246,7 @@ namespace imgpp {
   void png_flush_buffer(png_structp) {}
 
   size_t CompressPNG(const ImgROI& roi, void *dst, size_t length) {
+    detail::CodecScope stats(Codec::PNG, true);
     /* initialize stuff */
     png_structp png_ptr;
     png_infop info_ptr;
@@ -326,13 +332,16 @@ namespace imgpp {
     /* cleanup heap allocation */
     delete[]row_pointers;
 
-    return (png_io.buffer != nullptr) ? (length - png_io.length_left) : 0;
+    size_t compressed_length = (png_io.buffer != nullptr) ? (length - png_io.length_left) : 0;
+    stats.AddBytes(compressed_length);
+    return compressed_length;
   }
 
   bool LoadPNG(void *src, uint32_t length, Img &img, bool bottom_first) {
     if (src == nullptr || length == 0) {
       return false;
     }
+    detail::CodecScope stats(Codec::PNG, false);
 
     png_structp png_ptr;
     png_infop info_ptr;
@@ -422,6 +431,7 @@ namespace imgpp {
 
     png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
 
+    stats.AddBytes(length - png_io.length_left);
     delete []row_pointers;
     return true;
   }
@@ -3,6 +3,7 @@
 #include <fstream>
 #include <string>
 #include <imgpp/imgpp.hpp>
+#include <imgpp/stats.hpp>
 #include "stringparser.h"
 
 namespace {
@@ -112,6 +113,7 @@ bool LoadPPM(const char *fn, Img &img, bool bottom_first) {
   if (nullptr == fn || 0 == strlen(fn)) {
     return false;
   }
+  detail::CodecScope stats(Codec::PPM, false);
 
   std::ifstream infile(fn, std::ios::binary);
   if (!infile.good()) {
@@ -142,6 +144,7 @@ bool LoadPPM(const char *fn, Img &img, bool bottom_first) {
     }
   }
 
+  stats.AddBytes(infile.tellg());
   infile.close();
   return infile.good();
 }
@@ -150,6 +153,7 @@ bool LoadPPM(const char *buffer, uint32_t length, Img &img, bool bottom_first) {
   if (buffer == 0 || 0 == length) {
     return false;
   }
+  detail::CodecScope stats(Codec::PPM, false);
 
   int width = 0, height = 0;
   int channel = 0;
@@ -178,12 +182,14 @@ bool LoadPPM(const char *buffer, uint32_t length, Img &img, bool bottom_first) {
     }
   }
 
+  stats.AddBytes(p - buffer);
   return p <= buffer + length;
 }
 
 bool WritePPM(const char *fn, const ImgROI &roi, bool bottom_first) {
   if (nullptr == fn || 0 == strlen(fn))
     return false;
+  detail::CodecScope stats(Codec::PPM, true);
 
   std::ofstream outfile;
   outfile.open(fn, std::ios::binary);
@@ -203,7 +209,7 @@ bool WritePPM(const char *fn, const ImgROI &roi, bool bottom_first) {
 
   outfile << roi.Width() << " " << roi.Height() << "\n" << ((1UL << roi.BPC()) - 1) << "\n";
 
-  int line_len = (int)roi.Pitch();
+  int line_len = (int)ImgROI::CalcPitch(roi.Width(), roi.Channel(), roi.BPC());
 
   // pgm and ppm are both stored from top to bottom
   if (bottom_first) {
@@ -218,6 +224,7 @@ bool WritePPM(const char *fn, const ImgROI &roi, bool bottom_first) {
       outfile.write(p, line_len);
     }
   }
+  stats.AddBytes(outfile.tellp());
   outfile.close();
   return outfile.good();
 }
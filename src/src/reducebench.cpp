@@ -0,0 +1,96 @@
+#include <imgpp/reduce.hpp>
+#include "benchutil.h"
+#include <string>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 5, kWidth = 3840, kHeight = 2160 };
+
+// statistics and 256 bin histograms through a ZipTransformPixel lambda, the code reduce.hpp replaces
+template<typename T>
+void BenchNaive(const char *name, const Img &img, double max) {
+  uint32_t c = img.CROI().Channel();
+  double ms = bench::MedianMs(kReps, [&]() {
+    std::vector<double> lo(c, 1e300), hi(c, -1e300), sum(c, 0.0), squares(c, 0.0);
+    ZipTransformPixel(std::make_tuple(img.CROI()), [&](uint32_t, uint32_t, uint32_t, auto &ptrs) {
+      for (uint32_t i = 0; i < c; i++) {
+        double v = ((const T*)ptrs[0])[i];
+        lo[i] = std::min(lo[i], v);
+        hi[i] = std::max(hi[i], v);
+        sum[i] += v;
+        squares[i] += v * v;
+      }
+    });
+    bench::DoNotOptimize(squares.data());
+  });
+  bench::Report(name, "statistics, ZipTransform", ms);
+  ms = bench::MedianMs(kReps, [&]() {
+    std::vector<uint64_t> histogram(c * 256, 0);
+    ZipTransformPixel(std::make_tuple(img.CROI()), [&](uint32_t, uint32_t, uint32_t, auto &ptrs) {
+      for (uint32_t i = 0; i < c; i++) {
+        double t = ((const T*)ptrs[0])[i] * 256.0 / max;
+        histogram[i * 256 + (uint32_t)std::min(std::max(t, 0.0), 255.0)]++;
+      }
+    });
+    bench::DoNotOptimize(histogram.data());
+  });
+  bench::Report(name, "histogram, ZipTransform", ms);
+}
+
+void BenchReduce(const char *name, const Img &img, int reps) {
+  ThreadPool single(1);
+  double bytes = (double)img.CData().GetLength();
+  for (int parallel = 0; parallel < 2; parallel++) {
+    Executor &executor = parallel ? (Executor&)DefaultThreadPool() : single;
+    const char *suffix = parallel ? ", pool" : ", 1 thread";
+    std::vector<ChannelStatistics> statistics;
+    double ms = bench::MedianMs(reps, [&]() {
+      ComputeStatistics(img.CROI(), statistics, executor);
+      bench::DoNotOptimize(statistics.data());
+    });
+    bench::Report(name, (std::string("statistics") + suffix).c_str(), ms, bytes);
+    std::vector<uint64_t> histogram;
+    ms = bench::MedianMs(reps, [&]() {
+      ComputeHistogram(img.CROI(), 256, histogram, executor);
+      bench::DoNotOptimize(histogram.data());
+    });
+    bench::Report(name, (std::string("histogram") + suffix).c_str(), ms, bytes);
+  }
+}
+
+template<typename T>
+void FillNoise(Img &img, uint32_t modulo, float scale) {
+  T *data = (T*)img.ROI().GetData();
+  size_t n = img.CData().GetLength() / sizeof(T);
+  uint32_t state = 1;
+  for (size_t i = 0; i < n; i++) {
+    state = state * 1664525u + 1013904223u;
+    data[i] = (T)((state >> 8) % modulo * scale);
+  }
+}
+
+}
+
+int main() {
+  Img rgba8(kWidth, kHeight, 4, 8);
+  FillNoise<uint8_t>(rgba8, 256, 1.0f);
+  BenchNaive<uint8_t>("RGBA8 4K", rgba8, 256.0);
+  BenchReduce("RGBA8 4K", rgba8, kReps);
+
+  Img rgba16(kWidth, kHeight, 4, 16);
+  FillNoise<uint16_t>(rgba16, 65536, 1.0f);
+  BenchReduce("RGBA16 4K", rgba16, kReps);
+
+  Img rgba32f(kWidth, kHeight, 4, 32, true, true);
+  FillNoise<float>(rgba32f, 1 << 20, 1.0f / (1 << 20));
+  BenchNaive<float>("RGBA32F 4K", rgba32f, 1.0);
+  BenchReduce("RGBA32F 4K", rgba32f, kReps);
+
+  // the 100 MP RGB8 auto exposure case
+  Img rgb8(10000, 10000, 3, 8);
+  FillNoise<uint8_t>(rgb8, 256, 1.0f);
+  BenchReduce("RGB8 100MP", rgb8, 3);
+  return 0;
+}
@@ -0,0 +1,163 @@
+#include <imgpp/reduce.hpp>
+#include "testutil.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace imgpp;
+
+// test::NoiseValue(), but f32 channels far from zero in fine steps, where float sums lose precision
+static void FillStatsNoise(ImgROI roi, uint32_t seed) {
+  ChannelType type = GetChannelType(roi);
+  test::FillNoise(roi, seed, [type](uint32_t r, uint32_t, uint32_t, uint32_t, uint32_t) {
+    return type == ChannelType::F32 ? 1000.0 + (r % 100000) / 1000.0 : test::NoiseValue(type, r);
+  });
+}
+
+int main() {
+  // statistics of every type and 1 to 5 channels against doubles, in a pitched ROI of a volume
+  ThreadPool single(1);
+  ThreadPool pool(4);
+  const struct { uint32_t bpc; bool is_float; bool is_signed; } kFormats[] = {
+    {8, false, false}, {8, false, true}, {16, false, false}, {16, false, true},
+    {32, false, false}, {32, false, true}, {16, true, true}, {32, true, true}};
+  for (const auto &format: kFormats) {
+    for (uint32_t channels = 1; channels <= 5; channels++) {
+      Img volume(131, 67, 3, channels, format.bpc, format.is_float, format.is_signed, 4);
+      FillStatsNoise(volume.ROI(), channels * 7 + format.bpc);
+      ImgROI roi(volume.CROI(), 5, 3, 0, 129, 60, 2);
+      std::vector<ChannelStatistics> statistics;
+      std::vector<ChannelStatistics> parallel;
+      if (!ComputeStatistics(roi, statistics, single) || !ComputeStatistics(roi, parallel, pool)
+        || statistics.size() != channels) {
+        std::cerr << "ComputeStatistics failed, bpc " << format.bpc << " channels " << channels << std::endl;
+        return 1;
+      }
+      for (uint32_t c = 0; c < channels; c++) {
+        double lo = INFINITY;
+        double hi = -INFINITY;
+        double sum = 0.0;
+        double count = (double)roi.Width() * roi.Height() * roi.Depth();
+        for (uint32_t z = 0; z < roi.Depth(); z++) {
+          for (uint32_t y = 0; y < roi.Height(); y++) {
+            for (uint32_t x = 0; x < roi.Width(); x++) {
+              double v = test::Value(roi, x, y, z, c);
+              lo = std::min(lo, v);
+              hi = std::max(hi, v);
+              sum += v;
+            }
+          }
+        }
+        double mean = sum / count;
+        double squares = 0.0;
+        for (uint32_t z = 0; z < roi.Depth(); z++) {
+          for (uint32_t y = 0; y < roi.Height(); y++) {
+            for (uint32_t x = 0; x < roi.Width(); x++) {
+              squares += (test::Value(roi, x, y, z, c) - mean) * (test::Value(roi, x, y, z, c) - mean);
+            }
+          }
+        }
+        double variance = squares / count;
+        const ChannelStatistics &s = statistics[c];
+        const ChannelStatistics &p = parallel[c];
+        if (s.min != lo || s.max != hi || std::fabs(s.sum - sum) > 1e-9 * std::fabs(sum) + 1e-6
+          || std::fabs(s.mean - mean) > 1e-9 * std::fabs(mean) + 1e-9
+          || std::fabs(s.variance - variance) > 1e-6 * variance + 1e-9
+          || p.min != s.min || p.max != s.max || std::fabs(p.variance - s.variance) > 1e-6 * variance + 1e-9) {
+          std::cerr << "Statistics error, bpc " << format.bpc << " float " << format.is_float << " signed "
+            << format.is_signed << " channel " << c << " of " << channels << ": " << s.min << " " << s.max << " "
+            << s.mean << " " << s.variance << " vs " << lo << " " << hi << " " << mean << " " << variance << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+
+  // integer sums are exact
+  Img bytes(1000, 1000, 1, 8);
+  memset(bytes.ROI().GetData(), 255, bytes.CData().GetLength());
+  std::vector<ChannelStatistics> statistics;
+  ComputeStatistics(bytes.CROI(), statistics, pool);
+  if (statistics[0].sum != 255e6 || statistics[0].mean != 255.0 || statistics[0].variance != 0.0) {
+    std::cerr << "Exact statistics error" << std::endl;
+    return 1;
+  }
+
+  // NaNs are skipped by min and max only
+  Img floats(3, 2, 1, 32, true, true);
+  for (uint32_t i = 0; i < 6; i++) {
+    floats.ROI().At<float>(i % 3, i / 3) = i == 4 ? NAN : (float)i;
+  }
+  ComputeStatistics(floats.CROI(), statistics);
+  if (statistics[0].min != 0.0 || statistics[0].max != 5.0 || !std::isnan(statistics[0].mean)) {
+    std::cerr << "NaN statistics error" << std::endl;
+    return 1;
+  }
+
+  // histograms against direct counts, default and explicit ranges, replicated and plain tables
+  for (const auto &format: {kFormats[0], kFormats[2], kFormats[6], kFormats[7]}) {
+    for (uint32_t channels: {1u, 3u, 4u, 5u}) {
+      Img volume(97, 45, 2, channels, format.bpc, format.is_float, format.is_signed, 4);
+      FillStatsNoise(volume.ROI(), channels + format.bpc);
+      ImgROI roi(volume.CROI(), 2, 1, 0, 90, 44, 1);
+      bool is_float = format.is_float;
+      float lo = is_float ? -10.0f : format.bpc == 8 ? 20.0f : 1000.0f;
+      float hi = is_float ? 1020.0f : format.bpc == 8 ? 200.0f : 60000.0f;
+      for (uint32_t bins: {1u, 7u, 256u, 5000u}) {
+        std::vector<uint64_t> histogram;
+        std::vector<uint64_t> parallel;
+        if (!ComputeHistogram(roi, bins, lo, hi, histogram, single)
+          || !ComputeHistogram(roi, bins, lo, hi, parallel, pool) || histogram != parallel
+          || histogram.size() != (size_t)channels * bins) {
+          std::cerr << "ComputeHistogram failed, bpc " << format.bpc << " bins " << bins << std::endl;
+          return 1;
+        }
+        std::vector<uint64_t> expected(histogram.size(), 0);
+        for (uint32_t z = 0; z < roi.Depth(); z++) {
+          for (uint32_t y = 0; y < roi.Height(); y++) {
+            for (uint32_t x = 0; x < roi.Width(); x++) {
+              for (uint32_t c = 0; c < channels; c++) {
+                // bins are found in float
+                float t = ((float)test::Value(roi, x, y, z, c) - lo) * ((float)bins / (hi - lo));
+                uint32_t b = t < 0.0f ? 0 : t >= (float)bins ? bins - 1 : std::min((uint32_t)t, bins - 1);
+                expected[(size_t)c * bins + b]++;
+              }
+            }
+          }
+        }
+        if (histogram != expected) {
+          std::cerr << "Histogram error, bpc " << format.bpc << " float " << is_float << " channels " << channels
+            << " bins " << bins << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+
+  // full range of 8 bits, NaNs not counted
+  std::vector<uint64_t> histogram;
+  if (!ComputeHistogram(bytes.CROI(), 256, histogram, pool) || histogram[255] != 1000000) {
+    std::cerr << "Full range histogram error" << std::endl;
+    return 1;
+  }
+  if (!ComputeHistogram(floats.CROI(), 4, 0.0f, 4.0f, histogram) || histogram != std::vector<uint64_t>{1, 1, 1, 2}) {
+    std::cerr << "Float histogram error" << std::endl;
+    return 1;
+  }
+
+  Img wrong(4, 4, 1, 32);
+  Img empty(0, 4, 1, 8);
+  if (ComputeHistogram(wrong.CROI(), 16, histogram) || ComputeHistogram(bytes.CROI(), 0, histogram)
+    || ComputeHistogram(bytes.CROI(), kMaxHistogramBins + 1, histogram)
+    || ComputeHistogram(bytes.CROI(), 16, 5.0f, 5.0f, histogram)
+    || ComputeHistogram(floats.CROI(), 4, 0.0f, std::numeric_limits<float>::denorm_min(), histogram)
+    || ComputeHistogram(floats.CROI(), 4, -3e38f, 3e38f, histogram) || ComputeStatistics(empty.CROI(), statistics)) {
+    std::cerr << "Reduction format checks error" << std::endl;
+    return 1;
+  }
+
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include <imgpp/resize.hpp>
+#include <imgpp/typedview.hpp>
+#include "benchutil.h"
+#include <string>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 5, kWidth = 3840, kHeight = 2160 };
+
+const char *kFilterNames[] = {"box", "bilinear", "bicubic", "lanczos3"};
+
+// per pixel Tex2DBilinear, the loop Resize replaces
+void BenchNaive(const Img &src, Img &dst, const char *name) {
+  TypedView<const uint8_t, 4> in(src.CROI());
+  TypedView<uint8_t, 4> out(dst.ROI());
+  float sx = (float)in.Width() / out.Width();
+  float sy = (float)in.Height() / out.Height();
+  double ms = bench::MedianMs(kReps, [&]() {
+    for (uint32_t y = 0; y < out.Height(); y++) {
+      for (uint32_t x = 0; x < out.Width(); x++) {
+        out.PixelAt(x, y) = Tex2DBilinear(in, (x + 0.5f) * sx - 0.5f, (y + 0.5f) * sy - 0.5f);
+      }
+    }
+    bench::DoNotOptimize(out.GetData());
+  });
+  bench::Report(name, "Tex2DBilinear loop", ms);
+}
+
+void BenchResize(const Img &src, Img &dst, const char *name) {
+  ThreadPool single(1);
+  for (int filter = 0; filter < 4; filter++) {
+    for (int parallel = 0; parallel < 2; parallel++) {
+      Executor &executor = parallel ? (Executor&)DefaultThreadPool() : single;
+      double ms = bench::MedianMs(kReps, [&]() {
+        Resize(dst.ROI(), src.CROI(), (ResizeFilter)filter, executor);
+        bench::DoNotOptimize(dst.CROI().GetData());
+      });
+      std::string variant = std::string(kFilterNames[filter]) + (parallel ? ", pool" : ", 1 thread");
+      bench::Report(name, variant.c_str(), ms);
+    }
+  }
+}
+
+}
+
+int main() {
+  Img src(kWidth, kHeight, 4, 8);
+  for (size_t i = 0; i < src.CData().GetLength(); i++) {
+    src.ROI().GetData()[i] = (uint8_t)(i * 7919 >> 6);
+  }
+  Img thumb(256, 144, 4, 8);
+  Img half(kWidth / 2, kHeight / 2, 4, 8);
+  BenchNaive(src, thumb, "RGBA8 4K -> 256x144");
+  BenchResize(src, thumb, "RGBA8 4K -> 256x144");
+  BenchNaive(src, half, "RGBA8 4K -> 1920x1080");
+  BenchResize(src, half, "RGBA8 4K -> 1920x1080");
+
+  Img srcf(kWidth, kHeight, 4, 32, true, true);
+  Img halff(kWidth / 2, kHeight / 2, 4, 32, true, true);
+  Convert(srcf.ROI(), src.CROI());
+  double ms = bench::MedianMs(kReps, [&]() {
+    Resize(halff.ROI(), srcf.CROI(), ResizeFilter::BILINEAR);
+    bench::DoNotOptimize(halff.CROI().GetData());
+  });
+  bench::Report("RGBA32F 4K -> 1920x1080", "bilinear, pool", ms);
+  return 0;
+}
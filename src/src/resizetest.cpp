@@ -0,0 +1,148 @@
+#include <imgpp/resize.hpp>
+#include <cmath>
+#include <iostream>
+
+using namespace imgpp;
+
+namespace {
+
+const ResizeFilter kFilters[] = {
+  ResizeFilter::BOX, ResizeFilter::BILINEAR, ResizeFilter::BICUBIC, ResizeFilter::LANCZOS3,
+  ResizeFilter::KAISER
+};
+
+bool TestConstant(uint32_t c, uint32_t bpc, bool is_float) {
+  Img src(23, 17, c, bpc, is_float, is_float);
+  for (uint32_t y = 0; y < 17; y++) {
+    for (uint32_t x = 0; x < 23; x++) {
+      for (uint32_t ch = 0; ch < c; ch++) {
+        if (!is_float) {
+          bpc == 8 ? (void)(src.ROI().At<uint8_t>(x, y, ch) = 77) : (void)(src.ROI().At<uint16_t>(x, y, ch) = 777);
+        } else {
+          bpc == 16 ? (void)(src.ROI().At<Half>(x, y, ch) = Half(0.75f)) : (void)(src.ROI().At<float>(x, y, ch) = 0.75f);
+        }
+      }
+    }
+  }
+  for (ResizeFilter filter: kFilters) {
+    for (uint32_t w: {1u, 5u, 23u, 61u}) {
+      Img dst(w, 40 - w / 2, c, bpc, is_float, is_float);
+      if (!Resize(dst.ROI(), src.CROI(), filter)) {
+        return false;
+      }
+      for (uint32_t y = 0; y < dst.CROI().Height(); y++) {
+        for (uint32_t x = 0; x < dst.CROI().Width(); x++) {
+          for (uint32_t ch = 0; ch < c; ch++) {
+            float v = !is_float ? (bpc == 8 ? dst.CROI().At<uint8_t>(x, y, ch) : dst.CROI().At<uint16_t>(x, y, ch))
+              : (bpc == 16 ? (float)dst.CROI().At<Half>(x, y, ch) : dst.CROI().At<float>(x, y, ch));
+            float expected = !is_float ? (bpc == 8 ? 77.0f : 777.0f) : 0.75f;
+            if (std::fabs(v - expected) > 1e-5f * expected) {
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+}
+
+int main() {
+  // every format keeps a constant image constant, enlarged and shrunk, with every filter
+  for (uint32_t c = 1; c <= 4; c++) {
+    if (!TestConstant(c, 8, false) || !TestConstant(c, 16, false) || !TestConstant(c, 16, true)
+      || !TestConstant(c, 32, true)) {
+      std::cerr << "constant image error, " << c << " channels" << std::endl;
+      return 1;
+    }
+  }
+
+  // box halving is the rounded 2x2 average, identity size is a copy
+  Img src(64, 48, 3, 8);
+  for (uint32_t y = 0; y < 48; y++) {
+    for (uint32_t x = 0; x < 64; x++) {
+      for (uint32_t c = 0; c < 3; c++) {
+        src.ROI().At<uint8_t>(x, y, c) = (uint8_t)((x * 13 + y * 29 + c * 71) % 256);
+      }
+    }
+  }
+  Img half(32, 24, 3, 8);
+  Resize(half.ROI(), src.CROI(), ResizeFilter::BOX);
+  for (uint32_t y = 0; y < 24; y++) {
+    for (uint32_t x = 0; x < 32; x++) {
+      uint32_t sum = 0;
+      for (uint32_t k = 0; k < 4; k++) {
+        sum += src.CROI().At<uint8_t>(2 * x + k % 2, 2 * y + k / 2, 1);
+      }
+      if (std::abs((int)half.CROI().At<uint8_t>(x, y, 1) * 4 - (int)sum) > 2) {
+        std::cerr << "box halving error at " << x << ", " << y << std::endl;
+        return 1;
+      }
+    }
+  }
+  for (ResizeFilter filter: kFilters) {
+    Img same(64, 48, 3, 8);
+    Resize(same.ROI(), src.CROI(), filter);
+    if (memcmp(same.CROI().GetData(), src.CROI().GetData(), src.CData().GetLength()) != 0) {
+      std::cerr << "identity resize error, filter " << (int)filter << std::endl;
+      return 1;
+    }
+  }
+
+  // a large ratio averages the whole footprint instead of aliasing on a 1 pixel pattern
+  Img stripes(1000, 4, 1, 8);
+  for (uint32_t y = 0; y < 4; y++) {
+    for (uint32_t x = 0; x < 1000; x++) {
+      stripes.ROI().At<uint8_t>(x, y) = x % 2 ? 255 : 0;
+    }
+  }
+  for (ResizeFilter filter: kFilters) {
+    Img small(10, 1, 1, 8);
+    Resize(small.ROI(), stripes.CROI(), filter);
+    for (uint32_t x = 0; x < 10; x++) {
+      if (std::abs((int)small.CROI().At<uint8_t>(x, 0) - 128) > 2) {
+        std::cerr << "large ratio aliasing, filter " << (int)filter << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // bilinear enlargement of a ramp interpolates it
+  Img ramp(8, 1, 1, 32, true, true);
+  for (uint32_t x = 0; x < 8; x++) {
+    ramp.ROI().At<float>(x, 0) = (float)x;
+  }
+  Img ramp4(32, 3, 1, 32, true, true);
+  Resize(ramp4.ROI(), ramp.CROI(), ResizeFilter::BILINEAR);
+  for (uint32_t x = 2; x < 30; x++) {
+    if (std::fabs(ramp4.CROI().At<float>(x, 2) - ((x + 0.5f) / 4 - 0.5f)) > 1e-5f) {
+      std::cerr << "bilinear ramp error at " << x << std::endl;
+      return 1;
+    }
+  }
+
+  // 3D slices, multithreaded bands identical to a single thread, format checks
+  Img volume(300, 200, 2, 4, 8, false, false, 1);
+  for (size_t i = 0; i < volume.CData().GetLength(); i++) {
+    volume.ROI().GetData()[i] = (uint8_t)(i * 7919 >> 4);
+  }
+  Img a(130, 90, 2, 4, 8, false, false, 1);
+  Img b(130, 90, 2, 4, 8, false, false, 1);
+  ThreadPool single(1), pool(3);
+  if (!Resize(a.ROI(), volume.CROI(), ResizeFilter::LANCZOS3, single)
+    || !Resize(b.ROI(), volume.CROI(), ResizeFilter::LANCZOS3, pool)
+    || memcmp(a.CROI().GetData(), b.CROI().GetData(), a.CData().GetLength()) != 0) {
+    std::cerr << "parallel resize error" << std::endl;
+    return 1;
+  }
+  Img wrong_depth(130, 90, 4, 8);
+  Img wrong_type(130, 90, 2, 4, 16, false, false, 1);
+  if (Resize(wrong_depth.ROI(), volume.CROI()) || Resize(wrong_type.ROI(), volume.CROI())) {
+    std::cerr << "resize format check error" << std::endl;
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
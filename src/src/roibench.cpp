@@ -0,0 +1,89 @@
+#include <imgpp/imgpp.hpp>
+#include "benchutil.h"
+#include <cstring>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 15, kWidth = 3840, kHeight = 2160 };
+
+// reference: the former ImgROI accessors, with 32-bit pitch and offset arithmetic
+struct ROI32 {
+  const uint8_t *data_;
+  uint32_t channel_;
+  uint32_t bpc_;
+  uint32_t pitch_;
+
+  template<typename T> const T &At(uint32_t x, uint32_t y, uint32_t c) const {
+    return *(T*)(data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3) + c * (bpc_ >> 3));
+  }
+
+  const void *PtrAt(uint32_t x, uint32_t y) const {
+    return data_ + y * pitch_ + x * ((bpc_ * channel_) >> 3);
+  }
+};
+
+void BenchAt(const ImgROI &roi) {
+  const ROI32 ref{roi.GetData(), roi.Channel(), roi.BPC(), (uint32_t)roi.Pitch()};
+  double bytes = (double)kWidth * kHeight * 4;
+
+  double ms_ref = bench::MedianMs(kReps, [&ref]() {
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+      for (uint32_t x = 0; x < kWidth; ++x) {
+        sum += ref.At<uint8_t>(x, y, 0) + ref.At<uint8_t>(x, y, 3);
+      }
+    }
+    bench::DoNotOptimize(sum);
+  });
+  double ms_at = bench::MedianMs(kReps, [&roi]() {
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+      for (uint32_t x = 0; x < kWidth; ++x) {
+        sum += roi.At<uint8_t>(x, y, 0) + roi.At<uint8_t>(x, y, 3);
+      }
+    }
+    bench::DoNotOptimize(sum);
+  });
+  bench::Report("At<uint8_t> 4K RGBA8", "32-bit offsets", ms_ref, bytes);
+  bench::Report("At<uint8_t> 4K RGBA8", "ImgROI (64-bit)", ms_at, bytes);
+}
+
+void BenchPtrAt(const ImgROI &roi) {
+  const ROI32 ref{roi.GetData(), roi.Channel(), roi.BPC(), (uint32_t)roi.Pitch()};
+  double bytes = (double)kWidth * kHeight * 4;
+
+  double ms_ref = bench::MedianMs(kReps, [&ref]() {
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+      for (uint32_t x = 0; x < kWidth; ++x) {
+        const uint8_t *p = (const uint8_t*)ref.PtrAt(x, y);
+        sum += p[0] + p[1] + p[2] + p[3];
+      }
+    }
+    bench::DoNotOptimize(sum);
+  });
+  double ms_ptr = bench::MedianMs(kReps, [&roi]() {
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+      for (uint32_t x = 0; x < kWidth; ++x) {
+        const uint8_t *p = (const uint8_t*)roi.PtrAt(x, y);
+        sum += p[0] + p[1] + p[2] + p[3];
+      }
+    }
+    bench::DoNotOptimize(sum);
+  });
+  bench::Report("PtrAt<uint8_t> 4K RGBA8", "32-bit offsets", ms_ref, bytes);
+  bench::Report("PtrAt<uint8_t> 4K RGBA8", "ImgROI (64-bit)", ms_ptr, bytes);
+}
+
+}
+
+int main() {
+  Img img(kWidth, kHeight, 1, 4, 8, false, false, 1);
+  memset(img.ROI().GetData(), 1, img.Data().GetLength());
+  BenchAt(img.ROI());
+  BenchPtrAt(img.ROI());
+  return 0;
+}
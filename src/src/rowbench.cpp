@@ -0,0 +1,62 @@
+#include <imgpp/algorithms.hpp>
+#include "benchutil.h"
+#include <cstring>
+#include <tuple>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 15, kWidth = 3840, kHeight = 2160 };
+
+// dst = src * alpha + dst * (1 - alpha), in 8 bit fixed point
+enum : uint32_t { kAlpha = 77 };
+
+inline uint8_t Blend(uint8_t src, uint8_t dst) {
+  return (uint8_t)((src * kAlpha + dst * (256 - kAlpha)) >> 8);
+}
+
+void BenchBlend() {
+  Img a(kWidth, kHeight, 4, 8), b(kWidth, kHeight, 4, 8);
+  memset(a.ROI().GetData(), 200, a.CData().GetLength());
+  memset(b.ROI().GetData(), 10, b.CData().GetLength());
+  double bytes = (double)a.CData().GetLength() * 3;
+
+  double ms_channel = bench::MedianMs(kReps, [&]() {
+    ZipTransform(std::make_tuple(b.ROI(), a.CROI()), [](uint32_t, uint32_t, uint32_t, uint32_t,
+      auto &ptrs) {
+      *ptrs[0] = Blend(*ptrs[1], *ptrs[0]);
+    });
+    bench::DoNotOptimize(b.CROI().GetData());
+  });
+  double ms_pixel = bench::MedianMs(kReps, [&]() {
+    ZipTransformPixel(std::make_tuple(b.ROI(), a.CROI()), [](uint32_t, uint32_t, uint32_t,
+      auto &ptrs) {
+      for (uint32_t c = 0; c < 4; c++) {
+        ptrs[0][c] = Blend(ptrs[1][c], ptrs[0][c]);
+      }
+    });
+    bench::DoNotOptimize(b.CROI().GetData());
+  });
+  double ms_row = bench::MedianMs(kReps, [&]() {
+    ZipTransformRows(std::make_tuple(b.ROI(), a.CROI()), [](uint32_t, uint32_t, uint32_t w,
+      auto &ptrs) {
+      uint8_t *dst = ptrs[0];
+      const uint8_t *src = ptrs[1];
+      for (uint32_t i = 0; i < w * 4; i++) {
+        dst[i] = Blend(src[i], dst[i]);
+      }
+    });
+    bench::DoNotOptimize(b.CROI().GetData());
+  });
+  bench::Report("blend 4K RGBA8", "ZipTransform", ms_channel, bytes);
+  bench::Report("blend 4K RGBA8", "ZipTransformPixel", ms_pixel, bytes);
+  bench::Report("blend 4K RGBA8", "ZipTransformRows", ms_row, bytes);
+}
+
+}
+
+int main() {
+  BenchBlend();
+  return 0;
+}
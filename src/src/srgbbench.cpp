@@ -0,0 +1,72 @@
+#include <imgpp/srgb.hpp>
+#include "benchutil.h"
+#include <cmath>
+#include <cstring>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 9, kWidth = 3840, kHeight = 2160 };
+
+}
+
+int main() {
+  Img srgb(kWidth, kHeight, 4, 8);
+  Img hdr(kWidth, kHeight, 4, 32, true, true);
+  Img hdr_half(kWidth, kHeight, 4, 16, true, true);
+  uint8_t *data = srgb.ROI().GetData();
+  for (size_t i = 0; i < srgb.CData().GetLength(); i++) {
+    data[i] = (uint8_t)(i * 37 >> 3);
+  }
+  double bytes_float = (double)srgb.CData().GetLength() + hdr.CData().GetLength();
+  double bytes_half = (double)srgb.CData().GetLength() + hdr_half.CData().GetLength();
+  size_t n = (size_t)kWidth * kHeight * 4;
+
+  // the powf loops these kernels replace
+  double ms = bench::MedianMs(kReps, [&]() {
+    const uint8_t *s = srgb.CROI().GetData();
+    float *d = (float*)hdr.ROI().GetData();
+    for (size_t i = 0; i < n; i++) {
+      d[i] = SRGBToLinear(s[i] / 255.0f);
+    }
+    bench::DoNotOptimize(d);
+  });
+  bench::Report("sRGB8 -> linear f32", "powf loop", ms, bytes_float);
+  ms = bench::MedianMs(kReps, [&]() {
+    const float *s = (const float*)hdr.CROI().GetData();
+    uint8_t *d = srgb.ROI().GetData();
+    for (size_t i = 0; i < n; i++) {
+      d[i] = (uint8_t)(std::min(std::max(LinearToSRGB(s[i]), 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+    bench::DoNotOptimize(d);
+  });
+  bench::Report("linear f32 -> sRGB8", "powf loop", ms, bytes_float);
+
+  ThreadPool single(1);
+  for (int parallel = 0; parallel < 2; parallel++) {
+    Executor &executor = parallel ? (Executor&)DefaultThreadPool() : single;
+    const char *variant = parallel ? "ImgROI, pool" : "ImgROI, 1 thread";
+    ms = bench::MedianMs(kReps, [&]() {
+      SRGBToLinear(hdr.ROI(), srgb.CROI(), executor);
+      bench::DoNotOptimize(hdr.CROI().GetData());
+    });
+    bench::Report("sRGB8 -> linear f32", variant, ms, bytes_float);
+    ms = bench::MedianMs(kReps, [&]() {
+      SRGBToLinear(hdr_half.ROI(), srgb.CROI(), executor);
+      bench::DoNotOptimize(hdr_half.CROI().GetData());
+    });
+    bench::Report("sRGB8 -> linear f16", variant, ms, bytes_half);
+    ms = bench::MedianMs(kReps, [&]() {
+      LinearToSRGB(srgb.ROI(), hdr.CROI(), executor);
+      bench::DoNotOptimize(srgb.CROI().GetData());
+    });
+    bench::Report("linear f32 -> sRGB8", variant, ms, bytes_float);
+    ms = bench::MedianMs(kReps, [&]() {
+      LinearToSRGB(srgb.ROI(), hdr_half.CROI(), executor);
+      bench::DoNotOptimize(srgb.CROI().GetData());
+    });
+    bench::Report("linear f16 -> sRGB8", variant, ms, bytes_half);
+  }
+  return 0;
+}
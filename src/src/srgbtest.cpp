@@ -0,0 +1,121 @@
+#include <imgpp/srgb.hpp>
+#include <imgpp/texturedesc.hpp>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace imgpp;
+
+static uint32_t ReferenceCode(float v) {
+  double x = std::min(std::max((double)v, 0.0), 1.0);
+  double s = x <= 0.0031308 ? x * 12.92 : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+  return (uint32_t)std::floor(s * 255.0 + 0.5);
+}
+
+int main() {
+  // decoding: every code against the reference formula
+  uint8_t codes[256];
+  for (uint32_t i = 0; i < 256; i++) {
+    codes[i] = (uint8_t)i;
+  }
+  float linear[256];
+  Half linear_half[256];
+  SRGBToLinear(linear, codes, 256);
+  SRGBToLinear(linear_half, codes, 256);
+  for (uint32_t i = 0; i < 256; i++) {
+    double v = i / 255.0;
+    float expected = (float)(v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4));
+    if (linear[i] != expected || linear_half[i].Bits() != Half(expected).Bits()
+      || std::fabs(SRGBToLinear(i / 255.0f) - expected) > 1e-6f) {
+      std::cerr << "sRGB -> linear error at " << i << std::endl;
+      return 1;
+    }
+  }
+
+  // encoding: a sweep over the floats of [0, 1] and every value next to a rounding threshold
+  std::vector<float> inputs;
+  for (uint32_t bits = 0; bits <= 0x3f800000; bits += 61) {
+    float v;
+    memcpy(&v, &bits, 4);
+    inputs.push_back(v);
+  }
+  for (uint32_t i = 0; i < 255; i++) {
+    double s = (i + 0.5) / 255.0;
+    float mid = (float)(s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4));
+    float v = mid;
+    for (int k = 0; k < 4; k++) {
+      v = std::nextafter(v, 0.0f);
+    }
+    for (int k = 0; k < 9; k++, v = std::nextafter(v, 1.0f)) {
+      inputs.push_back(v);
+    }
+  }
+  std::vector<uint8_t> encoded(inputs.size());
+  LinearToSRGB(encoded.data(), inputs.data(), inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (encoded[i] != ReferenceCode(inputs[i])) {
+      std::cerr << "linear -> sRGB error for " << inputs[i] << ": " << (int)encoded[i]
+        << " != " << ReferenceCode(inputs[i]) << std::endl;
+      return 1;
+    }
+  }
+  float special[] = {-1.0f, -0.0f, 1.0f, 1.5f, INFINITY, -INFINITY, NAN, 1e-30f, 0.5f};
+  uint8_t special_codes[9];
+  LinearToSRGB(special_codes, special, 9);
+  uint8_t expected_special[] = {0, 0, 255, 255, 255, 0, 0, 0, 188};
+  if (memcmp(special_codes, expected_special, 9) != 0) {
+    std::cerr << "linear -> sRGB clamp error" << std::endl;
+    return 1;
+  }
+
+  // every code survives a round trip through f32 and f16
+  uint8_t back[256];
+  LinearToSRGB(back, linear, 256);
+  uint8_t back_half[256];
+  LinearToSRGB(back_half, linear_half, 256);
+  if (memcmp(back, codes, 256) != 0 || memcmp(back_half, codes, 256) != 0) {
+    std::cerr << "sRGB round trip error" << std::endl;
+    return 1;
+  }
+
+  // ROI operations keep alpha linear
+  Img srgb(37, 5, 4, 8);
+  for (uint32_t y = 0; y < 5; y++) {
+    for (uint32_t x = 0; x < 37; x++) {
+      for (uint32_t c = 0; c < 4; c++) {
+        srgb.ROI().At<uint8_t>(x, y, c) = (uint8_t)(x * 7 + y * 3 + c * 50);
+      }
+    }
+  }
+  Img hdr(37, 5, 4, 32, true, true);
+  Img hdr_half(37, 5, 4, 16, true, true);
+  Img srgb_back(37, 5, 4, 8);
+  Img srgb_back_half(37, 5, 4, 8);
+  if (!SRGBToLinear(hdr.ROI(), srgb.CROI()) || !SRGBToLinear(hdr_half.ROI(), srgb.CROI())
+    || !LinearToSRGB(srgb_back.ROI(), hdr.CROI()) || !LinearToSRGB(srgb_back_half.ROI(), hdr_half.CROI())) {
+    std::cerr << "sRGB ROI conversion failed" << std::endl;
+    return 1;
+  }
+  uint8_t a = srgb.CROI().At<uint8_t>(20, 4, 3);
+  uint8_t r = srgb.CROI().At<uint8_t>(20, 4, 0);
+  if (hdr.CROI().At<float>(20, 4, 3) != a / 255.0f || hdr.CROI().At<float>(20, 4, 0) != linear[r]
+    || (float)hdr_half.CROI().At<Half>(20, 4, 3) != (float)Half(a / 255.0f)
+    || memcmp(srgb_back.CROI().GetData(), srgb.CROI().GetData(), srgb.CData().GetLength()) != 0
+    || memcmp(srgb_back_half.CROI().GetData(), srgb.CROI().GetData(), srgb.CData().GetLength()) != 0) {
+    std::cerr << "sRGB ROI round trip error" << std::endl;
+    return 1;
+  }
+  Img wrong(37, 5, 3, 32, true, true);
+  if (SRGBToLinear(wrong.ROI(), srgb.CROI()) || LinearToSRGB(hdr.ROI(), srgb.CROI())) {
+    std::cerr << "sRGB ROI format check error" << std::endl;
+    return 1;
+  }
+
+  if (!IsSRGBFormat(FORMAT_RGBA8_SRGB_PACK8) || !IsSRGBFormat(FORMAT_RGBA_ASTC_8X8_SRGB_BLOCK16)
+    || IsSRGBFormat(FORMAT_RGBA8_UNORM_PACK8)) {
+    std::cerr << "IsSRGBFormat error" << std::endl;
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include <imgpp/imgpp.hpp>
+#include <imgpp/stats.hpp>
+#include "benchutil.h"
+
+// Built twice: statsbench (counters compiled out) and statsbench_enabled (IMGPP_ENABLE_STATS).
+// Compare the two outputs to see the cost of the atomic counters.
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 15, kIterations = 1 << 20 };
+
+const char *Variant() {
+  return kStatsEnabled ? "stats enabled" : "stats disabled";
+}
+
+// small-buffer churn, the worst case for per-allocation overhead
+void BenchSmallBuffers() {
+  double ms = bench::MedianMs(kReps, []() {
+    for (uint32_t i = 0; i < kIterations / 16; ++i) {
+      ImgBuffer buffer(256);
+      bench::DoNotOptimize(buffer.GetBuffer());
+    }
+  });
+  bench::Report("ImgBuffer alloc/free 256 B", Variant(), ms);
+}
+
+void BenchCodecScope() {
+  double ms = bench::MedianMs(kReps, []() {
+    for (uint32_t i = 0; i < kIterations; ++i) {
+      detail::CodecScope stats(Codec::PNG, false);
+      stats.AddBytes(i);
+    }
+  });
+  bench::Report("codec scope 1M calls", Variant(), ms);
+}
+
+// a realistic frame: allocation plus a full pass over the pixels
+void BenchFrame() {
+  double ms = bench::MedianMs(kReps, []() {
+    for (uint32_t i = 0; i < 16; ++i) {
+      Img img(1920, 1080, 4, 8);
+      memset(img.ROI().GetData(), (int)i, img.Data().GetLength());
+      bench::DoNotOptimize(img.ROI().GetData());
+    }
+  });
+  bench::Report("16x 1080p RGBA8 alloc+fill", Variant(), ms, 1920.0 * 1080 * 4 * 16);
+}
+
+}
+
+int main() {
+  BenchSmallBuffers();
+  BenchCodecScope();
+  BenchFrame();
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include <imgpp/imgpp.hpp>
+#include <imgpp/stats.hpp>
+#include <iostream>
+#include <vector>
+
+using namespace imgpp;
+
+int main() {
+  ResetStats();
+
+  // allocation counters follow ImgBuffer lifetimes
+  {
+    Img a(64, 64, 4, 8);
+    {
+      Img b(32, 32, 1, 8);
+      auto stats = GetStats();
+      if (stats.allocations != 2 || stats.bytes_allocated != 64 * 64 * 4 + 32 * 32
+        || stats.live_bytes != 64 * 64 * 4 + 32 * 32) {
+        std::cerr << "allocation counters wrong" << std::endl;
+        return 1;
+      }
+    }
+    auto stats = GetStats();
+    if (stats.live_bytes != 64 * 64 * 4 || stats.peak_bytes != 64 * 64 * 4 + 32 * 32) {
+      std::cerr << "live/peak counters wrong" << std::endl;
+      return 1;
+    }
+  }
+  if (GetStats().live_bytes != 0) {
+    std::cerr << "live bytes not released" << std::endl;
+    return 1;
+  }
+
+  // adopted memory is not counted as allocated by imgpp
+  {
+    std::vector<uint8_t> external(256);
+    ImgBuffer buffer(external.data(), external.size(), std::shared_ptr<void>());
+    if (GetStats().allocations != 2) {
+      std::cerr << "adopted buffer counted as allocation" << std::endl;
+      return 1;
+    }
+  }
+
+  // nested codec scopes are counted once, with bytes going to the outermost call
+  std::vector<CodecEvent> events;
+  SetStatsCallback([&events](const CodecEvent &event) { events.push_back(event); });
+  {
+    detail::CodecScope outer(Codec::BSON, false);
+    outer.AddBytes(-1);
+    {
+      detail::CodecScope inner(Codec::BSON, false);
+      inner.AddBytes(100);
+    }
+    outer.AddBytes(20);
+  }
+  {
+    detail::CodecScope write(Codec::PNG, true);
+    write.AddBytes(7);
+  }
+  SetStatsCallback(nullptr);
+  {
+    detail::CodecScope ignored(Codec::PNG, true);
+  }
+
+  auto stats = GetStats();
+  if (stats[Codec::BSON].loads != 1 || stats[Codec::BSON].bytes_read != 120
+    || stats[Codec::PNG].writes != 2 || stats[Codec::PNG].bytes_written != 7
+    || stats[Codec::PNG].loads != 0) {
+    std::cerr << "codec counters wrong" << std::endl;
+    return 1;
+  }
+  if (events.size() != 2 || events[0].codec != Codec::BSON || events[0].write
+    || events[0].bytes != 120 || events[1].codec != Codec::PNG || !events[1].write) {
+    std::cerr << "stats callback not invoked as expected" << std::endl;
+    return 1;
+  }
+
+  ResetStats();
+  stats = GetStats();
+  if (stats.allocations != 0 || stats[Codec::BSON].loads != 0) {
+    std::cerr << "counters not reset" << std::endl;
+    return 1;
+  }
+  return 0;
+}
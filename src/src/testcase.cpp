@@ -1,5 +1,6 @@
 #include <imgpp/imgpp.hpp>
 #include <imgpp/blockimg.hpp>
+#include <imgpp/compare.hpp>
 #include <imgpp/loaders.hpp>
 #include <imgpp/loadersext.hpp>
 #include <imgpp/sampler.hpp>
@@ -44,13 +45,13 @@ int main(int argc, char *argv[]) {
     return 1;  // test failed
   }
 
-  for (uint32_t y = 0; y < img.ROI().Height(); ++y) {
-    for (uint32_t x = 0; x < img.ROI().Width(); ++x) {
-      if (img.ROI().At<uint8_t>(x, y, 0) != img_bson.ROI().At<uint8_t>(x, y, 0)) {
-        std::cerr << "checking bson value failed!" << std::endl;
-        return 1;
-      }
-    }
+  // every channel of every pixel survives, stopping at the first difference
+  imgpp::CompareOptions exact;
+  exact.max_abs_diff_limit = 0.0;
+  imgpp::CompareResult diff;
+  if (!imgpp::Compare(img.ROI(), img_bson.ROI(), diff, exact) || diff.max_abs_diff != 0.0) {
+    std::cerr << "checking bson value failed!" << std::endl;
+    return 1;
   }
 
   return 0;
@@ -0,0 +1,89 @@
+#ifndef IMGPP_TESTUTIL_H
+#define IMGPP_TESTUTIL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <imgpp/imgpp.hpp>
+#include <imgpp/convert.hpp>
+#include <imgpp/half.hpp>
+
+namespace imgpp { namespace test {
+
+//! v clamped to the range of T, then converted (toward zero for integers).
+template<typename T>
+T Saturate(double v) {
+  return (T)std::min(std::max(v, (double)std::numeric_limits<T>::lowest()),
+    (double)std::numeric_limits<T>::max());
+}
+
+//! Store v in channel ch of the pixel at (x, y, z), saturated to the range of the channel type.
+inline void SetValue(ImgROI &roi, uint32_t x, uint32_t y, uint32_t z, uint32_t ch, double v) {
+  switch (GetChannelType(roi)) {
+  case ChannelType::U8: roi.At<uint8_t>(x, y, z, ch) = Saturate<uint8_t>(v); break;
+  case ChannelType::S8: roi.At<int8_t>(x, y, z, ch) = Saturate<int8_t>(v); break;
+  case ChannelType::U16: roi.At<uint16_t>(x, y, z, ch) = Saturate<uint16_t>(v); break;
+  case ChannelType::S16: roi.At<int16_t>(x, y, z, ch) = Saturate<int16_t>(v); break;
+  case ChannelType::U32: roi.At<uint32_t>(x, y, z, ch) = Saturate<uint32_t>(v); break;
+  case ChannelType::S32: roi.At<int32_t>(x, y, z, ch) = Saturate<int32_t>(v); break;
+  case ChannelType::F16: roi.At<Half>(x, y, z, ch) = Half((float)v); break;
+  default: roi.At<float>(x, y, z, ch) = (float)v; break;
+  }
+}
+
+//! Channel ch of the pixel at (x, y, z) as a double.
+inline double Value(const ImgROI &roi, uint32_t x, uint32_t y, uint32_t z, uint32_t ch) {
+  switch (GetChannelType(roi)) {
+  case ChannelType::U8: return roi.At<uint8_t>(x, y, z, ch);
+  case ChannelType::S8: return roi.At<int8_t>(x, y, z, ch);
+  case ChannelType::U16: return roi.At<uint16_t>(x, y, z, ch);
+  case ChannelType::S16: return roi.At<int16_t>(x, y, z, ch);
+  case ChannelType::U32: return roi.At<uint32_t>(x, y, z, ch);
+  case ChannelType::S32: return roi.At<int32_t>(x, y, z, ch);
+  case ChannelType::F16: return (float)roi.At<Half>(x, y, z, ch);
+  default: return roi.At<float>(x, y, z, ch);
+  }
+}
+
+//! Noise value of a channel type from a 24-bit random r: the whole range of 8 and 16 bit channels,
+//! 32 bit integers far from zero, and floats in [-20, 44) on a 1/64 grid.
+inline double NoiseValue(ChannelType type, uint32_t r) {
+  switch (type) {
+  case ChannelType::U8: return (uint8_t)r;
+  case ChannelType::S8: return (int8_t)r;
+  case ChannelType::U16: return (uint16_t)r;
+  case ChannelType::S16: return (int16_t)r;
+  case ChannelType::U32: return 4000000000.0 + r % 1000;
+  case ChannelType::S32: return (int32_t)(r * 200u - 2000000000u);
+  default: return (r % 4096) / 64.0 - 20.0;
+  }
+}
+
+//! Fill the channels of roi, in memory order, with gen(r, x, y, z, ch), where r is the next 24-bit
+//! number of a linear congruential generator seeded with seed. Values go through SetValue().
+template<typename TGen>
+void FillNoise(ImgROI roi, uint32_t seed, const TGen &gen) {
+  uint32_t state = seed;
+  for (uint32_t z = 0; z < roi.Depth(); z++) {
+    for (uint32_t y = 0; y < roi.Height(); y++) {
+      for (uint32_t x = 0; x < roi.Width(); x++) {
+        for (uint32_t c = 0; c < roi.Channel(); c++) {
+          state = state * 1664525u + 1013904223u;
+          SetValue(roi, x, y, z, c, gen(state >> 8, x, y, z, c));
+        }
+      }
+    }
+  }
+}
+
+//! Fill the channels of roi with NoiseValue() noise.
+inline void FillNoise(ImgROI roi, uint32_t seed) {
+  ChannelType type = GetChannelType(roi);
+  FillNoise(roi, seed, [type](uint32_t r, uint32_t, uint32_t, uint32_t, uint32_t) {
+    return NoiseValue(type, r);
+  });
+}
+
+}}
+
+#endif
@@ -0,0 +1,96 @@
+#include <imgpp/algorithms.hpp>
+#include <imgpp/copy.hpp>
+#include <imgpp/threadpool.hpp>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+using namespace imgpp;
+
+namespace {
+
+// runs tasks in order on the calling thread, recording how the work was split
+class SerialExecutor: public Executor {
+public:
+  uint32_t Concurrency() const override { return 2; }
+  void Run(size_t num_tasks, const std::function<void(size_t)> &task) override {
+    tasks += num_tasks;
+    for (size_t i = 0; i < num_tasks; ++i) {
+      task(i);
+    }
+  }
+  size_t tasks{0};
+};
+
+}
+
+int main() {
+  ThreadPool pool(4);
+
+  // every index runs exactly once, including from nested Run() calls
+  std::vector<std::atomic<int>> counts(1000);
+  for (auto &count: counts) {
+    count = 0;
+  }
+  pool.Run(counts.size() / 10, [&pool, &counts](size_t i) {
+    pool.Run(10, [&counts, i](size_t j) { counts[i * 10 + j]++; });
+  });
+  for (auto &count: counts) {
+    if (count != 1) {
+      std::cerr << "ThreadPool ran a task " << count << " times" << std::endl;
+      return 1;
+    }
+  }
+
+  // coordinates match the serial algorithms, for 2D and 3D images
+  for (uint32_t depth: {1u, 3u, 40u}) {
+    Img img(33, 21, depth, 1, 32, false, false, 1);
+    Img rows(33, 21, depth, 1, 32, false, false, 1);
+    ParallelZipTransformPixel(std::make_tuple(img.ROI()),
+      [](uint32_t x, uint32_t y, uint32_t z, auto &ptrs) {
+        *(uint32_t*)ptrs[0] = x + y * 100 + z * 10000;
+      }, pool);
+    ParallelForEachRow(rows.ROI(), [](uint32_t y, uint32_t z, uint32_t w, uint8_t *row) {
+      for (uint32_t x = 0; x < w; x++) {
+        ((uint32_t*)row)[x] = x + y * 100 + z * 10000;
+      }
+    }, pool);
+    std::atomic<uint32_t> mismatches{0};
+    ParallelZipTransform(std::make_tuple(img.CROI(), rows.CROI()),
+      [&mismatches](uint32_t x, uint32_t y, uint32_t z, uint32_t, auto &ptrs) {
+        if (*(uint32_t*)ptrs[0] != x + y * 100 + z * 10000 || *(uint32_t*)ptrs[1] != *(uint32_t*)ptrs[0]) {
+          mismatches++;
+        }
+      }, pool);
+    if (mismatches != 0 || img.CROI().At<uint32_t>(32, 20, depth - 1, 0) != 32 + 2000 + (depth - 1) * 10000) {
+      std::cerr << "parallel transform mismatch, depth " << depth << std::endl;
+      return 1;
+    }
+  }
+
+  // user supplied executor, the split only depends on its concurrency
+  SerialExecutor serial;
+  Img img(8, 100, 4, 8);
+  ParallelZipTransformRows(std::make_tuple(img.ROI()), [](uint32_t y, uint32_t, uint32_t w, auto &ptrs) {
+    for (uint32_t i = 0; i < w * 4; i++) {
+      ptrs[0][i] = (uint8_t)y;
+    }
+  }, serial);
+  if (serial.tasks != 2 * 4 || img.CROI().At<uint8_t>(7, 99, 3) != 99) {
+    std::cerr << "executor split error" << std::endl;
+    return 1;
+  }
+  // large copies split across the pool, with chunk boundaries off the buffer alignment
+  std::vector<uint8_t> src(kStreamingCopyBytes + 4099), dst(src.size());
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = (uint8_t)(i * 13 + i / 251);
+  }
+  detail::CopyBytes(dst.data() + 1, src.data() + 3, src.size() - 3, pool);
+  if (std::memcmp(dst.data() + 1, src.data() + 3, src.size() - 3) != 0) {
+    std::cerr << "parallel copy error" << std::endl;
+    return 1;
+  }
+  return 0;
+}
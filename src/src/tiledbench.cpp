@@ -0,0 +1,159 @@
+#include <imgpp/tiled.hpp>
+#include <imgpp/sampler.hpp>
+#include "benchutil.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 5, kSize = 8192, kSamples = 1 << 22 };
+
+// naive transpose, written the same way for both layouts
+template<typename TROI>
+void Transpose(TROI &dst, const TROI &src) {
+  for (uint32_t y = 0; y < src.Height(); ++y) {
+    for (uint32_t x = 0; x < src.Width(); ++x) {
+      dst.template At<uint32_t>(y, x) = src.template At<uint32_t>(x, y);
+    }
+  }
+}
+
+// transpose in 64x64 blocks, the usual fix for row-major images
+void TransposeBlocked(ImgROI &dst, const ImgROI &src) {
+  for (uint32_t by = 0; by < src.Height(); by += 64) {
+    for (uint32_t bx = 0; bx < src.Width(); bx += 64) {
+      for (uint32_t y = by; y < by + 64; ++y) {
+        for (uint32_t x = bx; x < bx + 64; ++x) {
+          dst.At<uint32_t>(y, x) = src.At<uint32_t>(x, y);
+        }
+      }
+    }
+  }
+}
+
+// tiled: each source tile maps to exactly one destination tile
+void TransposeTiles(TiledROI &dst, const TiledROI &src) {
+  uint32_t tile = src.TileSize();
+  for (uint32_t ty = 0; ty < src.TilesY(); ++ty) {
+    for (uint32_t tx = 0; tx < src.TilesX(); ++tx) {
+      const uint32_t *s = (const uint32_t*)src.TileAt(tx, ty);
+      uint32_t *d = (uint32_t*)dst.TileAt(ty, tx);
+      for (uint32_t y = 0; y < tile; ++y) {
+        for (uint32_t x = 0; x < tile; ++x) {
+          d[x * tile + y] = s[y * tile + x];
+        }
+      }
+    }
+  }
+}
+
+// rotate by 30 degrees around the center with bilinear sampling
+template<typename TROI>
+float Rotate(const TROI &src, uint32_t step) {
+  const float cs = std::cos(0.5236f), sn = std::sin(0.5236f);
+  float center = kSize * 0.5f, sum = 0.0f;
+  for (uint32_t y = 0; y < kSize; y += step) {
+    for (uint32_t x = 0; x < kSize; ++x) {
+      float u = cs * (x - center) - sn * (y - center) + center;
+      float v = sn * (x - center) + cs * (y - center) + center;
+      if (u >= 0.0f && v >= 0.0f && u < kSize - 1 && v < kSize - 1) {
+        sum += Tex2DBilinear<float>(src, u, v);
+      }
+    }
+  }
+  return sum;
+}
+
+template<typename TROI>
+float RandomSample(const TROI &src, const std::vector<float> &coords) {
+  float sum = 0.0f;
+  for (size_t i = 0; i < coords.size(); i += 2) {
+    sum += Tex2DBilinear<float>(src, coords[i], coords[i + 1]);
+  }
+  return sum;
+}
+
+void BenchTranspose() {
+  Img src(kSize, kSize, 4, 8), dst(kSize, kSize, 4, 8);
+  memset(src.ROI().GetData(), 1, src.CData().GetLength());
+  TiledImg tiled_src = ToTiled(src.CROI()), tiled_dst = ToTiled(dst.CROI());
+  double bytes = (double)src.CData().GetLength() * 2;
+
+  double ms_linear = bench::MedianMs(kReps, [&]() {
+    Transpose(dst.ROI(), src.CROI());
+    bench::DoNotOptimize(dst.CROI().GetData());
+  });
+  double ms_tiled = bench::MedianMs(kReps, [&]() {
+    Transpose(tiled_dst.ROI(), tiled_src.CROI());
+    bench::DoNotOptimize(tiled_dst.CROI().GetData());
+  });
+  double ms_blocked = bench::MedianMs(kReps, [&]() {
+    TransposeBlocked(dst.ROI(), src.CROI());
+    bench::DoNotOptimize(dst.CROI().GetData());
+  });
+  double ms_tiles = bench::MedianMs(kReps, [&]() {
+    TransposeTiles(tiled_dst.ROI(), tiled_src.CROI());
+    bench::DoNotOptimize(tiled_dst.CROI().GetData());
+  });
+  double ms_to_tiled = bench::MedianMs(kReps, [&]() {
+    TileData(tiled_src.ROI(), src.CROI());
+    bench::DoNotOptimize(tiled_src.CROI().GetData());
+  });
+  double ms_to_linear = bench::MedianMs(kReps, [&]() {
+    UntileData(dst.ROI(), tiled_src.CROI());
+    bench::DoNotOptimize(dst.CROI().GetData());
+  });
+  bench::Report("transpose 8K RGBA8", "row-major", ms_linear, bytes);
+  bench::Report("transpose 8K RGBA8", "64x64 tiles", ms_tiled, bytes);
+  bench::Report("transpose 8K RGBA8", "row-major, 64x64 blocks", ms_blocked, bytes);
+  bench::Report("transpose 8K RGBA8", "tiles, tile by tile", ms_tiles, bytes);
+  bench::Report("8K RGBA8 conversion", "TileData", ms_to_tiled, bytes);
+  bench::Report("8K RGBA8 conversion", "UntileData", ms_to_linear, bytes);
+}
+
+void BenchSampling() {
+  Img src(kSize, kSize, 1, 32, true);
+  for (uint32_t y = 0; y < kSize; ++y) {
+    float *row = (float*)src.ROI().PtrAt(0, y);
+    for (uint32_t x = 0; x < kSize; ++x) {
+      row[x] = (float)((x ^ y) & 0xff);
+    }
+  }
+  TiledImg tiled = ToTiled(src.CROI());
+
+  double ms_linear = bench::MedianMs(kReps, [&]() {
+    bench::DoNotOptimize(Rotate(src.CROI(), 4));
+  });
+  double ms_tiled = bench::MedianMs(kReps, [&]() {
+    bench::DoNotOptimize(Rotate(tiled.CROI(), 4));
+  });
+  bench::Report("rotate 30deg 8K R32F bilinear", "row-major", ms_linear);
+  bench::Report("rotate 30deg 8K R32F bilinear", "64x64 tiles", ms_tiled);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> dist(0.0f, kSize - 1.0f);
+  std::vector<float> coords(kSamples * 2);
+  for (auto &coord: coords) {
+    coord = dist(rng);
+  }
+  ms_linear = bench::MedianMs(kReps, [&]() {
+    bench::DoNotOptimize(RandomSample(src.CROI(), coords));
+  });
+  ms_tiled = bench::MedianMs(kReps, [&]() {
+    bench::DoNotOptimize(RandomSample(tiled.CROI(), coords));
+  });
+  bench::Report("4M random bilinear 8K R32F", "row-major", ms_linear);
+  bench::Report("4M random bilinear 8K R32F", "64x64 tiles", ms_tiled);
+}
+
+}
+
+int main() {
+  BenchTranspose();
+  BenchSampling();
+  return 0;
+}
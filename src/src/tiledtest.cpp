@@ -0,0 +1,80 @@
+#include <imgpp/tiled.hpp>
+#include <imgpp/sampler.hpp>
+#include <iostream>
+#include <tuple>
+
+using namespace imgpp;
+
+int main() {
+  // sizes that are not multiples of the tile size
+  Img linear(150, 70, 3, 8);
+  for (uint32_t y = 0; y < linear.ROI().Height(); ++y) {
+    for (uint32_t x = 0; x < linear.ROI().Width(); ++x) {
+      for (uint32_t c = 0; c < 3; ++c) {
+        linear.ROI().At<uint8_t>(x, y, c) = (uint8_t)(x * 3 + y * 5 + c);
+      }
+    }
+  }
+
+  TiledImg tiled = ToTiled(linear.ROI(), 5);
+  if (tiled.ROI().TilesX() != 5 || tiled.ROI().TilesY() != 3
+    || tiled.Data().GetLength() != 5 * 3 * 32 * 32 * 3) {
+    std::cerr << "tiled layout wrong" << std::endl;
+    return 1;
+  }
+  for (uint32_t y = 0; y < 70; ++y) {
+    for (uint32_t x = 0; x < 150; ++x) {
+      for (uint32_t c = 0; c < 3; ++c) {
+        if (tiled.ROI().At<uint8_t>(x, y, c) != linear.ROI().At<uint8_t>(x, y, c)) {
+          std::cerr << "tiled accessor mismatch" << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+  if (tiled.ROI().PtrAt(32, 1) != (uint8_t*)tiled.ROI().TileAt(1, 0) + tiled.ROI().TilePitch()) {
+    std::cerr << "tile addressing wrong" << std::endl;
+    return 1;
+  }
+
+  Img back = ToLinear(tiled.ROI());
+  for (uint32_t y = 0; y < 70; ++y) {
+    if (memcmp(back.ROI().PtrAt(0, y), linear.ROI().PtrAt(0, y), 150 * 3) != 0) {
+      std::cerr << "tiled round trip failed" << std::endl;
+      return 1;
+    }
+  }
+
+  // samplers work on tiled ROIs
+  Img gray(100, 100, 1, 32, true);
+  for (uint32_t y = 0; y < 100; ++y) {
+    for (uint32_t x = 0; x < 100; ++x) {
+      gray.ROI().At<float>(x, y) = (float)(x * y);
+    }
+  }
+  TiledImg tiled_gray = ToTiled(gray.ROI());
+  if (Tex2DBilinear<float>(tiled_gray.ROI(), 63.5f, 64.25f)
+    != Tex2DBilinear<float>(gray.ROI(), 63.5f, 64.25f)) {
+    std::cerr << "tiled bilinear sample mismatch" << std::endl;
+    return 1;
+  }
+
+  // tile-by-tile zip transform visits every pixel channel once
+  TiledImg counts(150, 70, 3, 8, false, false, 5);
+  counts.Zeros();
+  ZipTransformTiles(std::make_tuple(counts.ROI(), tiled.ROI()),
+    [](uint32_t x, uint32_t y, uint32_t, uint32_t c, auto &ptrs) {
+    *ptrs[0] += 1 + (*ptrs[1] == (uint8_t)(x * 3 + y * 5 + c) ? 0 : 1);
+  });
+  for (uint32_t y = 0; y < 70; ++y) {
+    for (uint32_t x = 0; x < 150; ++x) {
+      for (uint32_t c = 0; c < 3; ++c) {
+        if (counts.ROI().At<uint8_t>(x, y, c) != 1) {
+          std::cerr << "ZipTransformTiles failed" << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
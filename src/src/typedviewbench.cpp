@@ -0,0 +1,78 @@
+#include <imgpp/typedview.hpp>
+#include "benchutil.h"
+#include <cstring>
+#include <tuple>
+
+using namespace imgpp;
+
+namespace {
+
+enum { kReps = 15, kWidth = 3840, kHeight = 2160 };
+
+void BenchFill() {
+  Img img(kWidth, kHeight, 4, 32, true);
+  double bytes = (double)img.CData().GetLength();
+  double ms_roi = bench::MedianMs(kReps, [&img]() {
+    Fill(img.ROI(), 0.5f);
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  double ms_typed = bench::MedianMs(kReps, [&img]() {
+    Fill(TypedView<float, 4>(img.ROI()), 0.5f);
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  bench::Report("Fill 4K RGBA32F", "ImgROI", ms_roi, bytes);
+  bench::Report("Fill 4K RGBA32F", "TypedView", ms_typed, bytes);
+}
+
+void BenchZipTransform() {
+  Img a(kWidth, kHeight, 4, 32, true), b(kWidth, kHeight, 4, 32, true);
+  memset(a.ROI().GetData(), 0, a.CData().GetLength());
+  memset(b.ROI().GetData(), 0, b.CData().GetLength());
+  double bytes = (double)a.CData().GetLength() * 3;
+  double ms_roi = bench::MedianMs(kReps, [&]() {
+    ZipTransform(std::make_tuple(a.ROI(), b.CROI()), [](uint32_t, uint32_t, uint32_t, uint32_t,
+      auto &ptrs) {
+      *(float*)ptrs[0] = *(float*)ptrs[0] * 0.5f + *(const float*)ptrs[1];
+    });
+    bench::DoNotOptimize(a.CROI().GetData());
+  });
+  double ms_typed = bench::MedianMs(kReps, [&]() {
+    ZipTransform(std::make_tuple(TypedView<float, 4>(a.ROI()),
+      TypedView<const float, 4>(b.CROI())), [](float &dst, float src) {
+      dst = dst * 0.5f + src;
+    });
+    bench::DoNotOptimize(a.CROI().GetData());
+  });
+  bench::Report("a = a * 0.5 + b 4K RGBA32F", "ZipTransform ImgROI", ms_roi, bytes);
+  bench::Report("a = a * 0.5 + b 4K RGBA32F", "ZipTransform TypedView", ms_typed, bytes);
+
+  Img gray(kWidth, kHeight, 1, 8);
+  Img rgb(kWidth, kHeight, 3, 8);
+  memset(rgb.ROI().GetData(), 100, rgb.CData().GetLength());
+  bytes = (double)gray.CData().GetLength() * 4;
+  ms_roi = bench::MedianMs(kReps, [&]() {
+    ZipTransformPixel(std::make_tuple(gray.ROI(), rgb.CROI()), [](uint32_t, uint32_t, uint32_t,
+      auto &ptrs) {
+      const uint8_t *p = ptrs[1];
+      *ptrs[0] = (uint8_t)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
+    });
+    bench::DoNotOptimize(gray.CROI().GetData());
+  });
+  ms_typed = bench::MedianMs(kReps, [&]() {
+    ZipTransformPixel(std::make_tuple(TypedView<uint8_t, 1>(gray.ROI()),
+      TypedView<const uint8_t, 3>(rgb.CROI())), [](auto &g, const auto &p) {
+      g[0] = (uint8_t)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
+    });
+    bench::DoNotOptimize(gray.CROI().GetData());
+  });
+  bench::Report("RGB8 to gray 4K", "ZipTransformPixel ImgROI", ms_roi, bytes);
+  bench::Report("RGB8 to gray 4K", "ZipTransformPixel Typed", ms_typed, bytes);
+}
+
+}
+
+int main() {
+  BenchFill();
+  BenchZipTransform();
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include <imgpp/typedview.hpp>
+#include <iostream>
+#include <tuple>
+
+using namespace imgpp;
+
+int main() {
+  Img rgba(17, 5, 4, 32, true);
+  Img gray(17, 5, 1, 8);
+
+  // format check
+  if (TypedView<float, 4>(rgba.ROI()).Empty() || !TypedView<float, 3>(rgba.ROI()).Empty()
+    || !TypedView<uint32_t, 4>(rgba.ROI()).Empty() || !TypedView<uint16_t, 1>(gray.ROI()).Empty()
+    || !TypedView<int8_t, 1>(gray.ROI()).Empty() || TypedView<uint8_t, 1>(gray.ROI()).Empty()
+    || TypedView<int8_t, 1>(Img(17, 5, 1, 8, false, true).ROI()).Empty()) {
+    std::cerr << "typed view format check failed" << std::endl;
+    return 1;
+  }
+
+  TypedView<float, 4> view(rgba.ROI());
+  Fill(view, {1.0f, 2.0f, 3.0f, 4.0f});
+  if (rgba.ROI().At<float>(16, 4, 3) != 4.0f || view.At(3, 2, 1) != 2.0f
+    || view.PixelAt(5, 1)[2] != 3.0f || view.Row(4).size() != 17 * 4) {
+    std::cerr << "typed view access failed" << std::endl;
+    return 1;
+  }
+
+  // element-wise zip over views with the same channel count
+  Img sum(17, 5, 4, 32, true);
+  TypedView<float, 4> sum_view(sum.ROI());
+  Fill(sum_view, 10.0f);
+  ZipTransform(std::make_tuple(sum_view, TypedView<const float, 4>(rgba.CROI())),
+    [](float &dst, float src) { dst += src; });
+  if (sum.ROI().At<float>(7, 3, 0) != 11.0f || sum.ROI().At<float>(7, 3, 3) != 14.0f) {
+    std::cerr << "typed ZipTransform failed" << std::endl;
+    return 1;
+  }
+
+  // pixel-wise zip over views with different channel counts
+  TypedView<uint8_t, 1> gray_view(gray.ROI());
+  ZipTransformPixel(std::make_tuple(gray_view, view), [](auto &g, const auto &p) {
+    g[0] = (uint8_t)(p[0] + p[1] + p[2]);
+  });
+  if (gray.ROI().At<uint8_t>(9, 2) != 6) {
+    std::cerr << "typed ZipTransformPixel failed" << std::endl;
+    return 1;
+  }
+
+  // typed bilinear sampling agrees with the ImgROI sampler
+  for (uint32_t y = 0; y < 5; ++y) {
+    for (uint32_t x = 0; x < 17; ++x) {
+      view.At(x, y, 1) = (float)(x * y);
+    }
+  }
+  auto pixel = Tex2DBilinear(view, 3.25f, 2.5f);
+  float ref = Tex2DBilinear<float>(ImgROI(rgba.ROI().GetData() + 4, 17, 5, 4, 32,
+    rgba.ROI().Pitch(), true, true), 3.25f, 2.5f);
+  if (pixel[1] != ref || pixel[0] != 1.0f) {
+    std::cerr << "typed bilinear sample mismatch" << std::endl;
+    return 1;
+  }
+  return 0;
+}
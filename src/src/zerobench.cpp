@@ -0,0 +1,66 @@
+#include <imgpp/imgpp.hpp>
+#include "benchutil.h"
+#include <cstring>
+#include <thread>
+
+using namespace imgpp;
+
+namespace {
+
+// 1 GiB single channel float accumulator
+enum { kReps = 5, kWidth = 16384, kHeight = 16384 };
+
+const double kBytes = (double)kWidth * kHeight * 4;
+
+void BenchStartup() {
+  // baseline: the former Zeros(), allocate then memset
+  double ms_memset = bench::MedianMs(kReps, []() {
+    Img img(kWidth, kHeight, 1, 32, true);
+    img.Zeros();
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  double ms_lazy = bench::MedianMs(kReps, []() {
+    Img img = Zeros(kWidth, kHeight, 1, 1, 32, true);
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+  double ms_touch = bench::MedianMs(kReps, [threads]() {
+    Img img = Zeros(kWidth, kHeight, 1, 1, 32, true, false, 1, threads);
+    bench::DoNotOptimize(img.CROI().GetData());
+  });
+  bench::Report("Zeros 1 GiB float", "alloc+memset", ms_memset, kBytes);
+  bench::Report("Zeros 1 GiB float", "lazy zero pages", ms_lazy);
+  bench::Report("Zeros 1 GiB float", "lazy + first touch", ms_touch);
+}
+
+// accumulate into every 64th row, the case where lazily zeroed pages are never touched at all
+void BenchSparseAccumulate() {
+  auto accumulate = [](Img &img) {
+    for (uint32_t y = 0; y < kHeight; y += 64) {
+      float *row = (float*)img.ROI().PtrAt(0, y);
+      for (uint32_t x = 0; x < kWidth; ++x) {
+        row[x] += 1.0f;
+      }
+    }
+    bench::DoNotOptimize(img.CROI().GetData());
+  };
+  double ms_memset = bench::MedianMs(kReps, [&accumulate]() {
+    Img img(kWidth, kHeight, 1, 32, true);
+    img.Zeros();
+    accumulate(img);
+  });
+  double ms_lazy = bench::MedianMs(kReps, [&accumulate]() {
+    Img img = Zeros(kWidth, kHeight, 1, 1, 32, true);
+    accumulate(img);
+  });
+  bench::Report("sparse accumulate 1 GiB", "alloc+memset", ms_memset);
+  bench::Report("sparse accumulate 1 GiB", "lazy zero pages", ms_lazy);
+}
+
+}
+
+int main() {
+  BenchStartup();
+  BenchSparseAccumulate();
+  return 0;
+}